@@ -0,0 +1,641 @@
+/* GStreamer
+ * Copyright (C) <2018> Marc Leeman <marc.leeman@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Loopback benchmark for nrtp_rtpsink and nrtp_rtpsrc.
+ *
+ * Every stream sends RTP packets from a pad owned by the benchmark
+ * through nrtp_rtpsink to 127.0.0.1, where nrtp_rtpsrc receives them
+ * into a fakesink. Each packet carries its send time, so the receiver
+ * measures the end-to-end latency. The packet loss, the latency
+ * percentiles and the CPU time per packet of the whole process are
+ * written as JSON. When nrtp_rtpsrc receives with nrtp_recvsrc, the
+ * number of system calls it made per received packet is included, which
+ * compares recvmmsg() against --io-uring.
+ *
+ * With --find-max, the rate is doubled until the loss exceeds
+ * --max-loss and the highest sustained rate is then narrowed down.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include <gst/gst.h>
+#include <gst/rtp/gstrtpbuffer.h>
+
+#define BASE_PORT           43000
+#define PAYLOAD_TYPE        96
+#define CLOCK_RATE          90000
+/* Packets are generated in ticks of this length */
+#define TICK                (GST_MSECOND)
+/* Time for the last packets to arrive after sending stopped */
+#define DRAIN_TIME          (500 * GST_MSECOND)
+/* Latency histogram with 1 us buckets */
+#define HISTOGRAM_SIZE      100000
+#define FIND_MAX_STEPS      4
+
+typedef struct
+{
+  gint streams;
+  gint rate;
+  gint payload_size;
+  gint duration;
+  gint batch_size;
+  gint receive_threads;
+  gint pool_size;
+  gint latency;
+  gboolean pacing;
+  gboolean io_uring;
+  gboolean low_latency;
+  gboolean find_max;
+  gdouble max_loss;
+  gchar *output;
+} BenchConfig;
+
+typedef struct
+{
+  guint port;
+  GstElement *rtpsink;
+  GstElement *rtpsrc;
+  GstPad *srcpad;
+  guint32 ssrc;
+  guint16 seqnum;
+
+  /* Sender thread only */
+  guint64 sent;
+
+  /* Streaming thread of the receiver only, read after stopping */
+  guint64 received;
+  guint32 *histogram;
+  GstClockTime max_latency;
+} BenchStream;
+
+typedef struct
+{
+  gint rate;
+  guint64 sent;
+  guint64 received;
+  gdouble loss;
+  gdouble pps;
+  GstClockTime latency[4];
+  GstClockTime max_latency;
+  gdouble cpu_ns_per_packet;
+  /* Negative when udpsrc received the packets */
+  gdouble syscalls_per_packet;
+  gboolean io_uring;
+} BenchResult;
+
+static const gdouble percentiles[] = { 0.5, 0.9, 0.99, 0.999 };
+static const gchar *percentile_names[] = { "p50", "p90", "p99", "p999" };
+
+static GstClockTime
+bench_now (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+
+  return GST_TIMESPEC_TO_TIME (ts);
+}
+
+static GstClockTime
+bench_cpu_time (void)
+{
+  struct rusage usage;
+
+  getrusage (RUSAGE_SELF, &usage);
+
+  return GST_TIMEVAL_TO_TIME (usage.ru_utime) +
+      GST_TIMEVAL_TO_TIME (usage.ru_stime);
+}
+
+static void
+bench_handoff_cb (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    BenchStream * stream)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  GstClockTime sent, latency;
+
+  if (!gst_rtp_buffer_map (buffer, GST_MAP_READ, &rtp))
+    return;
+
+  if (gst_rtp_buffer_get_payload_len (&rtp) >= 8) {
+    sent = GST_READ_UINT64_BE (gst_rtp_buffer_get_payload (&rtp));
+    latency = bench_now () - sent;
+
+    stream->received++;
+    if (latency / GST_USECOND < HISTOGRAM_SIZE)
+      stream->histogram[latency / GST_USECOND]++;
+    stream->max_latency = MAX (stream->max_latency, latency);
+  }
+  gst_rtp_buffer_unmap (&rtp);
+}
+
+static void
+bench_pad_added_cb (GstElement * rtpsrc, GstPad * pad, BenchStream * stream)
+{
+  GstElement *pipeline = GST_ELEMENT (gst_element_get_parent (rtpsrc));
+  GstElement *sink = gst_element_factory_make ("fakesink", NULL);
+  GstPad *sinkpad;
+
+  g_object_set (sink, "sync", FALSE, "async", FALSE, "signal-handoffs", TRUE,
+      NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (bench_handoff_cb), stream);
+  gst_bin_add (GST_BIN (pipeline), sink);
+  gst_element_sync_state_with_parent (sink);
+
+  sinkpad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_link (pad, sinkpad);
+  gst_object_unref (sinkpad);
+  gst_object_unref (pipeline);
+}
+
+static GstBuffer *
+bench_create_packet (BenchStream * stream, gint payload_size,
+    GstClockTime pts)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  GstBuffer *buffer;
+  guint8 *payload;
+  GstClockTime now = bench_now ();
+
+  buffer = gst_rtp_buffer_new_allocate (payload_size, 0, 0);
+  gst_rtp_buffer_map (buffer, GST_MAP_WRITE, &rtp);
+  gst_rtp_buffer_set_payload_type (&rtp, PAYLOAD_TYPE);
+  gst_rtp_buffer_set_seq (&rtp, stream->seqnum++);
+  gst_rtp_buffer_set_ssrc (&rtp, stream->ssrc);
+  gst_rtp_buffer_set_timestamp (&rtp,
+      gst_util_uint64_scale (now, CLOCK_RATE, GST_SECOND));
+  payload = gst_rtp_buffer_get_payload (&rtp);
+  memset (payload, 0, payload_size);
+  GST_WRITE_UINT64_BE (payload, now);
+  gst_rtp_buffer_unmap (&rtp);
+
+  GST_BUFFER_PTS (buffer) = pts;
+
+  return buffer;
+}
+
+static void
+bench_stream_start (BenchStream * stream)
+{
+  GstCaps *caps;
+  GstSegment segment;
+  gchar *stream_id;
+
+  stream_id = g_strdup_printf ("rtpbench-%u", stream->port);
+  gst_pad_push_event (stream->srcpad, gst_event_new_stream_start (stream_id));
+  g_free (stream_id);
+
+  caps = gst_caps_new_simple ("application/x-rtp",
+      "media", G_TYPE_STRING, "video",
+      "clock-rate", G_TYPE_INT, CLOCK_RATE,
+      "encoding-name", G_TYPE_STRING, "H264",
+      "payload", G_TYPE_INT, PAYLOAD_TYPE, NULL);
+  gst_pad_push_event (stream->srcpad, gst_event_new_caps (caps));
+  gst_caps_unref (caps);
+
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  gst_pad_push_event (stream->srcpad, gst_event_new_segment (&segment));
+}
+
+/* Send @rate packets per second on every stream for @duration seconds,
+ * in one buffer list per stream and tick. */
+static void
+bench_send (BenchConfig * config, BenchStream * streams, gint rate,
+    GstElement * pipeline)
+{
+  GstClockTime start, end, tick, base_time;
+  GstClock *clock;
+  gint i;
+
+  clock = gst_element_get_clock (pipeline);
+  base_time = gst_element_get_base_time (pipeline);
+
+  start = bench_now ();
+  end = start + config->duration * GST_SECOND;
+
+  for (tick = start + TICK; tick <= end; tick += TICK) {
+    guint64 due = gst_util_uint64_scale (tick - start, rate, GST_SECOND);
+    GstClockTime pts = gst_clock_get_time (clock) - base_time;
+    struct timespec ts;
+
+    for (i = 0; i < config->streams; i++) {
+      BenchStream *stream = &streams[i];
+      GstBufferList *list;
+
+      if (stream->sent >= due)
+        continue;
+
+      list = gst_buffer_list_new_sized (due - stream->sent);
+      while (stream->sent < due) {
+        gst_buffer_list_add (list, bench_create_packet (stream,
+                config->payload_size, pts));
+        stream->sent++;
+      }
+      gst_pad_push_list (stream->srcpad, list);
+    }
+
+    GST_TIME_TO_TIMESPEC (tick, ts);
+    clock_nanosleep (CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+  }
+
+  gst_object_unref (clock);
+}
+
+static gboolean
+bench_check_bus (GstElement * pipeline)
+{
+  GstBus *bus = gst_element_get_bus (pipeline);
+  GstMessage *msg;
+  gboolean ok = TRUE;
+
+  while ((msg = gst_bus_pop_filtered (bus, GST_MESSAGE_ERROR))) {
+    GError *error = NULL;
+    gchar *debug = NULL;
+
+    gst_message_parse_error (msg, &error, &debug);
+    g_printerr ("Error from %s: %s (%s)\n", GST_OBJECT_NAME (msg->src),
+        error->message, GST_STR_NULL (debug));
+    g_clear_error (&error);
+    g_free (debug);
+    gst_message_unref (msg);
+    ok = FALSE;
+  }
+  gst_object_unref (bus);
+
+  return ok;
+}
+
+static gchar *
+bench_uri (BenchConfig * config, guint port, gboolean receiver)
+{
+  GString *uri = g_string_new (NULL);
+
+  g_string_append_printf (uri, "rtp://127.0.0.1:%u?batch-size=%d", port,
+      config->batch_size);
+  if (receiver) {
+    g_string_append_printf (uri, "&encoding-name=H264&latency=%d"
+        "&receive-threads=%d&pool-size=%d", config->latency,
+        config->receive_threads, config->pool_size);
+    if (config->io_uring)
+      g_string_append (uri, "&io-uring=true");
+    if (config->low_latency)
+      g_string_append (uri, "&mode=low-latency");
+  } else if (config->pacing) {
+    g_string_append (uri, "&pacing=true");
+  }
+
+  return g_string_free (uri, FALSE);
+}
+
+static void
+bench_collect (BenchConfig * config, BenchStream * streams,
+    BenchResult * result)
+{
+  guint64 counts[G_N_ELEMENTS (percentiles)];
+  guint64 seen = 0;
+  guint i, p;
+  gint s;
+
+  result->sent = 0;
+  result->received = 0;
+  result->max_latency = 0;
+  for (s = 0; s < config->streams; s++) {
+    result->sent += streams[s].sent;
+    result->received += streams[s].received;
+    result->max_latency = MAX (result->max_latency, streams[s].max_latency);
+  }
+
+  result->loss = result->sent ?
+      1.0 - (gdouble) MIN (result->received, result->sent) / result->sent : 0;
+  result->pps = (gdouble) result->received / config->duration;
+
+  for (p = 0; p < G_N_ELEMENTS (percentiles); p++) {
+    /* Percentiles beyond the histogram are reported as the maximum */
+    counts[p] = (guint64) (percentiles[p] * result->received);
+    result->latency[p] = result->max_latency;
+  }
+
+  /* Walk the histograms of all streams together */
+  p = 0;
+  for (i = 0; i < HISTOGRAM_SIZE && p < G_N_ELEMENTS (percentiles); i++) {
+    for (s = 0; s < config->streams; s++)
+      seen += streams[s].histogram[i];
+    while (p < G_N_ELEMENTS (percentiles) && seen > counts[p])
+      result->latency[p++] = i * GST_USECOND;
+  }
+}
+
+/* Adds the system calls of the nrtp_recvsrc elements inside @rtpsrc to
+ * @syscalls. Returns FALSE when udpsrc receives the packets, it does not
+ * count them. */
+static gboolean
+bench_receive_syscalls (GstElement * rtpsrc, guint64 * syscalls,
+    gboolean * io_uring)
+{
+  GstIterator *it = gst_bin_iterate_recurse (GST_BIN (rtpsrc));
+  GValue item = G_VALUE_INIT;
+  gboolean found = FALSE;
+
+  while (gst_iterator_next (it, &item) == GST_ITERATOR_OK) {
+    GstElement *element = g_value_get_object (&item);
+    GstElementFactory *factory = gst_element_get_factory (element);
+
+    if (factory && g_str_equal (GST_OBJECT_NAME (factory), "nrtp_recvsrc")) {
+      GstStructure *stats;
+      guint64 calls = 0;
+      gboolean uring = FALSE;
+
+      g_object_get (element, "stats", &stats, NULL);
+      gst_structure_get (stats, "system-calls", G_TYPE_UINT64, &calls,
+          "io-uring", G_TYPE_BOOLEAN, &uring, NULL);
+      gst_structure_free (stats);
+
+      *syscalls += calls;
+      *io_uring |= uring;
+      found = TRUE;
+    }
+    g_value_reset (&item);
+  }
+  g_value_unset (&item);
+  gst_iterator_free (it);
+
+  return found;
+}
+
+static gboolean
+bench_run (BenchConfig * config, gint rate, BenchResult * result)
+{
+  GstElement *pipeline;
+  BenchStream *streams;
+  GstClockTime cpu_start;
+  guint64 syscalls = 0;
+  gboolean ok, counted = TRUE;
+  gint i;
+
+  pipeline = gst_pipeline_new ("rtpbench");
+  streams = g_new0 (BenchStream, config->streams);
+
+  for (i = 0; i < config->streams; i++) {
+    BenchStream *stream = &streams[i];
+    GstPad *sinkpad;
+    gchar *uri;
+
+    stream->port = BASE_PORT + 2 * i;
+    stream->ssrc = g_random_int ();
+    stream->histogram = g_new0 (guint32, HISTOGRAM_SIZE);
+
+    stream->rtpsink = gst_element_factory_make ("nrtp_rtpsink", NULL);
+    stream->rtpsrc = gst_element_factory_make ("nrtp_rtpsrc", NULL);
+    if (stream->rtpsink == NULL || stream->rtpsrc == NULL) {
+      g_printerr ("nrtp_rtpsink or nrtp_rtpsrc not found\n");
+      exit (1);
+    }
+
+    uri = bench_uri (config, stream->port, FALSE);
+    g_object_set (stream->rtpsink, "uri", uri, NULL);
+    g_free (uri);
+    uri = bench_uri (config, stream->port, TRUE);
+    g_object_set (stream->rtpsrc, "uri", uri, NULL);
+    g_free (uri);
+
+    gst_bin_add_many (GST_BIN (pipeline), stream->rtpsink, stream->rtpsrc,
+        NULL);
+    g_signal_connect (stream->rtpsrc, "pad-added",
+        G_CALLBACK (bench_pad_added_cb), stream);
+
+    stream->srcpad = gst_pad_new ("src", GST_PAD_SRC);
+    gst_pad_set_active (stream->srcpad, TRUE);
+    sinkpad = gst_element_get_request_pad (stream->rtpsink, "sink_%u");
+    gst_pad_link (stream->srcpad, sinkpad);
+    gst_object_unref (sinkpad);
+  }
+
+  if (gst_element_set_state (pipeline, GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_FAILURE) {
+    bench_check_bus (pipeline);
+    exit (1);
+  }
+  gst_element_get_state (pipeline, NULL, NULL, GST_CLOCK_TIME_NONE);
+
+  for (i = 0; i < config->streams; i++)
+    bench_stream_start (&streams[i]);
+
+  cpu_start = bench_cpu_time ();
+  bench_send (config, streams, rate, pipeline);
+  g_usleep ((DRAIN_TIME + config->latency * GST_MSECOND) / GST_USECOND);
+
+  ok = bench_check_bus (pipeline);
+
+  /* Before the receivers are removed again */
+  result->io_uring = FALSE;
+  for (i = 0; i < config->streams; i++) {
+    if (!bench_receive_syscalls (streams[i].rtpsrc, &syscalls,
+            &result->io_uring))
+      counted = FALSE;
+  }
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+
+  result->rate = rate;
+  bench_collect (config, streams, result);
+  result->cpu_ns_per_packet = result->sent ?
+      (gdouble) (bench_cpu_time () - cpu_start) / result->sent : 0;
+  result->syscalls_per_packet = counted && result->received ?
+      (gdouble) syscalls / result->received : -1;
+
+  for (i = 0; i < config->streams; i++) {
+    gst_pad_set_active (streams[i].srcpad, FALSE);
+    gst_object_unref (streams[i].srcpad);
+    g_free (streams[i].histogram);
+  }
+  g_free (streams);
+  gst_object_unref (pipeline);
+
+  g_printerr ("%d pps x %d streams: %" G_GUINT64_FORMAT "/%" G_GUINT64_FORMAT
+      " received, loss %.4f%%, p99 %" G_GUINT64_FORMAT " us, %.0f ns/packet, "
+      "%.3f syscalls/packet\n", rate, config->streams, result->received,
+      result->sent, result->loss * 100, result->latency[2] / GST_USECOND,
+      result->cpu_ns_per_packet, result->syscalls_per_packet);
+
+  return ok;
+}
+
+static void
+bench_append_result (GString * json, BenchResult * result)
+{
+  guint p;
+
+  g_string_append_printf (json, "    {\n"
+      "      \"rate_pps\": %d,\n"
+      "      \"sent\": %" G_GUINT64_FORMAT ",\n"
+      "      \"received\": %" G_GUINT64_FORMAT ",\n"
+      "      \"loss\": %.6f,\n"
+      "      \"throughput_pps\": %.1f,\n"
+      "      \"cpu_ns_per_packet\": %.1f,\n"
+      "      \"io_uring\": %s,\n", result->rate, result->sent,
+      result->received, result->loss, result->pps,
+      result->cpu_ns_per_packet, result->io_uring ? "true" : "false");
+  if (result->syscalls_per_packet >= 0)
+    g_string_append_printf (json,
+        "      \"receive_syscalls_per_packet\": %.3f,\n",
+        result->syscalls_per_packet);
+  else
+    g_string_append (json, "      \"receive_syscalls_per_packet\": null,\n");
+  g_string_append (json, "      \"latency_us\": {");
+  for (p = 0; p < G_N_ELEMENTS (percentiles); p++)
+    g_string_append_printf (json, "\"%s\": %" G_GUINT64_FORMAT ", ",
+        percentile_names[p], result->latency[p] / GST_USECOND);
+  g_string_append_printf (json, "\"max\": %" G_GUINT64_FORMAT "}\n    }",
+      result->max_latency / GST_USECOND);
+}
+
+int
+main (int argc, char **argv)
+{
+  BenchConfig config = { 1, 10000, 1200, 5, 1, 1, 0, 0, FALSE, FALSE, FALSE,
+    FALSE, 0.001, NULL
+  };
+  GOptionEntry entries[] = {
+    {"streams", 's', 0, G_OPTION_ARG_INT, &config.streams,
+        "Number of streams", "N"},
+    {"rate", 'r', 0, G_OPTION_ARG_INT, &config.rate,
+        "Packets per second per stream (start rate with --find-max)", "PPS"},
+    {"payload-size", 'p', 0, G_OPTION_ARG_INT, &config.payload_size,
+        "RTP payload size in bytes", "BYTES"},
+    {"duration", 'd', 0, G_OPTION_ARG_INT, &config.duration,
+        "Seconds to send per run", "SECONDS"},
+    {"batch-size", 'b', 0, G_OPTION_ARG_INT, &config.batch_size,
+        "batch-size of both bins", "N"},
+    {"receive-threads", 't', 0, G_OPTION_ARG_INT, &config.receive_threads,
+        "receive-threads of nrtp_rtpsrc", "N"},
+    {"pool-size", 0, 0, G_OPTION_ARG_INT, &config.pool_size,
+        "pool-size of nrtp_rtpsrc", "N"},
+    {"latency", 'l', 0, G_OPTION_ARG_INT, &config.latency,
+        "Jitterbuffer latency of nrtp_rtpsrc in ms", "MS"},
+    {"pacing", 0, 0, G_OPTION_ARG_NONE, &config.pacing,
+        "Enable pacing in nrtp_rtpsink", NULL},
+    {"io-uring", 0, 0, G_OPTION_ARG_NONE, &config.io_uring,
+        "Receive with io_uring in nrtp_rtpsrc", NULL},
+    {"low-latency", 0, 0, G_OPTION_ARG_NONE, &config.low_latency,
+        "Receive without the jitterbuffer in nrtp_rtpsrc", NULL},
+    {"find-max", 'm', 0, G_OPTION_ARG_NONE, &config.find_max,
+        "Search the maximum sustained packet rate", NULL},
+    {"max-loss", 0, 0, G_OPTION_ARG_DOUBLE, &config.max_loss,
+        "Highest loss ratio of a sustained rate", "RATIO"},
+    {"output", 'o', 0, G_OPTION_ARG_FILENAME, &config.output,
+        "Write the JSON results to FILE instead of stdout", "FILE"},
+    {NULL}
+  };
+  GOptionContext *ctx;
+  GError *error = NULL;
+  GArray *results;
+  GString *json;
+  gint max_sustained = 0;
+  gboolean ok = TRUE;
+  guint i;
+
+  ctx = g_option_context_new ("- nrtp_rtpsink/nrtp_rtpsrc loopback benchmark");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &error)) {
+    g_printerr ("%s\n", error->message);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  if (config.streams < 1 || config.rate < 1 || config.duration < 1
+      || config.payload_size < 8) {
+    g_printerr ("Invalid arguments\n");
+    return 1;
+  }
+
+  results = g_array_new (FALSE, TRUE, sizeof (BenchResult));
+
+  if (config.find_max) {
+    gint good = 0, bad = 0, rate = config.rate;
+    BenchResult result;
+
+    /* Double until the loss is too high, then bisect */
+    while (bad == 0 && ok) {
+      ok = bench_run (&config, rate, &result);
+      g_array_append_val (results, result);
+      if (result.loss <= config.max_loss) {
+        good = rate;
+        rate *= 2;
+      } else {
+        bad = rate;
+      }
+    }
+    for (i = 0; i < FIND_MAX_STEPS && good > 0 && ok; i++) {
+      rate = (good + bad) / 2;
+      ok = bench_run (&config, rate, &result);
+      g_array_append_val (results, result);
+      if (result.loss <= config.max_loss)
+        good = rate;
+      else
+        bad = rate;
+    }
+    max_sustained = good;
+  } else {
+    BenchResult result;
+
+    ok = bench_run (&config, config.rate, &result);
+    g_array_append_val (results, result);
+  }
+
+  json = g_string_new ("{\n");
+  g_string_append_printf (json, "  \"benchmark\": \"rtp-loopback\",\n"
+      "  \"config\": {\"streams\": %d, \"payload_size\": %d, "
+      "\"duration\": %d, \"batch_size\": %d, \"receive_threads\": %d, "
+      "\"pool_size\": %d, \"latency_ms\": %d, \"pacing\": %s, "
+      "\"io_uring\": %s, \"low_latency\": %s},\n",
+      config.streams, config.payload_size, config.duration,
+      config.batch_size, config.receive_threads, config.pool_size,
+      config.latency, config.pacing ? "true" : "false",
+      config.io_uring ? "true" : "false",
+      config.low_latency ? "true" : "false");
+  if (config.find_max)
+    g_string_append_printf (json, "  \"max_sustained_pps\": %d,\n",
+        max_sustained);
+  g_string_append (json, "  \"runs\": [\n");
+  for (i = 0; i < results->len; i++) {
+    if (i > 0)
+      g_string_append (json, ",\n");
+    bench_append_result (json, &g_array_index (results, BenchResult, i));
+  }
+  g_string_append (json, "\n  ]\n}\n");
+
+  if (config.output) {
+    if (!g_file_set_contents (config.output, json->str, json->len, &error)) {
+      g_printerr ("Could not write %s: %s\n", config.output, error->message);
+      g_clear_error (&error);
+      ok = FALSE;
+    }
+  } else {
+    g_print ("%s", json->str);
+  }
+
+  g_string_free (json, TRUE);
+  g_array_unref (results);
+  g_free (config.output);
+
+  return ok ? 0 : 1;
+}
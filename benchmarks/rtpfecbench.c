@@ -0,0 +1,381 @@
+/* GStreamer
+ * Copyright (C) <2018> Marc Leeman <marc.leeman@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* FEC benchmark.
+ *
+ * Measures the throughput of every XOR kernel the CPU supports on
+ * payloads of --payload-size bytes, the rate at which the SMPTE 2022-1
+ * encoder of nrtp_fecenc generates the column and row FEC of a stream of
+ * --columns x --rows matrices, and the rate at which the decoder of
+ * nrtp_fecdec recovers packets when one packet of every column is lost,
+ * which is the most recovery work column FEC can do. The encoding cost is
+ * also given as the share of a CPU it takes at 100 Mbit/s. The results are
+ * written as JSON.
+ */
+
+#include <string.h>
+#include <time.h>
+
+#include <gst/gst.h>
+
+#include "gstrtp-fec.h"
+#include "gstrtp-xor.h"
+
+/* Matrices prepared up front, the decoder is reset after each pass */
+#define BENCH_MATRICES 32
+
+typedef struct
+{
+  gint payload_size;
+  gint columns;
+  gint rows;
+  gint duration;
+} BenchConfig;
+
+typedef struct
+{
+  gint n_media;
+  GstBuffer **media;
+  gboolean *lost;
+  gint n_fec;
+  GstBuffer **fec;
+} BenchStream;
+
+static GstClockTime
+bench_now (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+
+  return GST_TIMESPEC_TO_TIME (ts);
+}
+
+/* XOR throughput of @impl in bytes per second */
+static gdouble
+bench_xor (GstRtpXorImpl impl, const BenchConfig * config)
+{
+  guint8 *dst, *src;
+  GstClockTime start, elapsed, deadline;
+  guint64 bytes = 0;
+  gint i;
+
+  dst = g_malloc (config->payload_size);
+  src = g_malloc (config->payload_size);
+  for (i = 0; i < config->payload_size; i++) {
+    dst[i] = i;
+    src[i] = i * 31;
+  }
+
+  start = bench_now ();
+  deadline = start + config->duration * GST_SECOND;
+  do {
+    for (i = 0; i < 10000; i++)
+      gst_rtp_xor_with_impl (impl, dst, src, config->payload_size);
+    bytes += (guint64) 10000 *config->payload_size;
+    elapsed = bench_now () - start;
+  } while (start + elapsed < deadline);
+
+  g_free (dst);
+  g_free (src);
+
+  return (gdouble) bytes * GST_SECOND / elapsed;
+}
+
+static GstBuffer *
+bench_create_media (guint16 seq, const BenchConfig * config)
+{
+  GstBuffer *buf = gst_buffer_new_allocate (NULL, 12 + config->payload_size,
+      NULL);
+  GstMapInfo map;
+  gint i;
+
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  map.data[0] = 0x80;
+  map.data[1] = 33;
+  GST_WRITE_UINT16_BE (map.data + 2, seq);
+  GST_WRITE_UINT32_BE (map.data + 4, seq * 90);
+  GST_WRITE_UINT32_BE (map.data + 8, 0x12345678);
+  for (i = 12; i < map.size; i++)
+    map.data[i] = seq + i;
+  gst_buffer_unmap (buf, &map);
+
+  return buf;
+}
+
+/* The column FEC packet over @rows packets from @first */
+static GstBuffer *
+bench_create_fec (GstBuffer ** media, gint first, guint16 base,
+    const BenchConfig * config)
+{
+  guint8 *data;
+  guint32 ts = 0;
+  gint i, j;
+
+  data = g_malloc0 (12 + GST_RTP_FEC_HEADER_LEN + config->payload_size);
+  for (i = 0; i < config->rows; i++) {
+    GstBuffer *buf = media[first + i * config->columns];
+    GstMapInfo map;
+
+    gst_buffer_map (buf, &map, GST_MAP_READ);
+    for (j = 12; j < map.size; j++)
+      data[GST_RTP_FEC_HEADER_LEN + j] ^= map.data[j];
+    ts ^= GST_READ_UINT32_BE (map.data + 4);
+    gst_buffer_unmap (buf, &map);
+  }
+
+  data[0] = 0x80;
+  data[1] = 96;
+  GST_WRITE_UINT16_BE (data + 12, base);
+  /* The lengths are all the same, so they cancel out for an odd count */
+  GST_WRITE_UINT16_BE (data + 14, config->rows % 2 ? config->payload_size :
+      0);
+  data[16] = 0x80 | (config->rows % 2 ? 33 : 0);
+  GST_WRITE_UINT32_BE (data + 20, ts);
+  data[25] = config->columns;
+  data[26] = config->rows;
+
+  return gst_buffer_new_wrapped (data,
+      12 + GST_RTP_FEC_HEADER_LEN + config->payload_size);
+}
+
+static void
+bench_stream_init (BenchStream * stream, const BenchConfig * config)
+{
+  gint matrix_size = config->columns * config->rows;
+  gint m, c;
+
+  stream->n_media = BENCH_MATRICES * matrix_size;
+  stream->media = g_new (GstBuffer *, stream->n_media);
+  stream->lost = g_new0 (gboolean, stream->n_media);
+  stream->n_fec = BENCH_MATRICES * config->columns;
+  stream->fec = g_new (GstBuffer *, stream->n_fec);
+
+  for (m = 0; m < stream->n_media; m++)
+    stream->media[m] = bench_create_media (m, config);
+
+  for (m = 0; m < BENCH_MATRICES; m++) {
+    for (c = 0; c < config->columns; c++) {
+      gint first = m * matrix_size + c;
+
+      stream->fec[m * config->columns + c] =
+          bench_create_fec (stream->media, first, first, config);
+      /* Lose a different row in every column */
+      stream->lost[first + (c % config->rows) * config->columns] = TRUE;
+    }
+  }
+}
+
+static void
+bench_stream_clear (BenchStream * stream)
+{
+  gint i;
+
+  for (i = 0; i < stream->n_media; i++)
+    gst_buffer_unref (stream->media[i]);
+  for (i = 0; i < stream->n_fec; i++)
+    gst_buffer_unref (stream->fec[i]);
+  g_free (stream->media);
+  g_free (stream->lost);
+  g_free (stream->fec);
+}
+
+/* Generate the column and row FEC of the stream and return the number of
+ * media packets protected per second */
+static gdouble
+bench_encode (const BenchConfig * config, guint64 * media_packets,
+    guint64 * fec_packets)
+{
+  GstRtpFecEncoder *enc;
+  GQueue column = G_QUEUE_INIT, row = G_QUEUE_INIT;
+  GstClockTime start, elapsed, deadline;
+  BenchStream stream;
+  GstBuffer *buf;
+  gint i;
+
+  bench_stream_init (&stream, config);
+  enc = gst_rtp_fec_encoder_new (config->columns, config->rows);
+  *media_packets = 0;
+  *fec_packets = 0;
+
+  start = bench_now ();
+  deadline = start + config->duration * GST_SECOND;
+  do {
+    for (i = 0; i < stream.n_media; i++) {
+      gst_rtp_fec_encoder_add_media (enc, stream.media[i], &column, &row);
+      *fec_packets += column.length + row.length;
+      while ((buf = g_queue_pop_head (&column)))
+        gst_buffer_unref (buf);
+      while ((buf = g_queue_pop_head (&row)))
+        gst_buffer_unref (buf);
+    }
+    /* The sequence numbers start over */
+    gst_rtp_fec_encoder_reset (enc);
+    *media_packets += stream.n_media;
+    elapsed = bench_now () - start;
+  } while (start + elapsed < deadline);
+
+  gst_rtp_fec_encoder_free (enc);
+  bench_stream_clear (&stream);
+
+  return (gdouble) * media_packets * GST_SECOND / elapsed;
+}
+
+/* Feed the stream to the decoder, the column FEC after each matrix as a
+ * sender does, and return the number of packets recovered per second */
+static gdouble
+bench_recover (const BenchConfig * config, guint64 * media_packets,
+    guint64 * recovered)
+{
+  gint matrix_size = config->columns * config->rows;
+  GstRtpFecDecoder *dec;
+  GQueue out = G_QUEUE_INIT;
+  GstClockTime start, elapsed, deadline;
+  BenchStream stream;
+  GstBuffer *buf;
+  gint m, i;
+
+  bench_stream_init (&stream, config);
+  dec = gst_rtp_fec_decoder_new ();
+  *media_packets = 0;
+
+  start = bench_now ();
+  deadline = start + config->duration * GST_SECOND;
+  do {
+    for (m = 0; m < BENCH_MATRICES; m++) {
+      for (i = m * matrix_size; i < (m + 1) * matrix_size; i++) {
+        if (!stream.lost[i])
+          gst_rtp_fec_decoder_add_media (dec, stream.media[i], &out);
+      }
+      for (i = m * config->columns; i < (m + 1) * config->columns; i++)
+        gst_rtp_fec_decoder_add_fec (dec, stream.fec[i], &out);
+      while ((buf = g_queue_pop_head (&out)))
+        gst_buffer_unref (buf);
+    }
+    gst_rtp_fec_decoder_reset (dec);
+    *media_packets += stream.n_media;
+    elapsed = bench_now () - start;
+  } while (start + elapsed < deadline);
+
+  *recovered = gst_rtp_fec_decoder_get_recovered (dec);
+  gst_rtp_fec_decoder_free (dec);
+  bench_stream_clear (&stream);
+
+  return (gdouble) * recovered * GST_SECOND / elapsed;
+}
+
+int
+main (int argc, char **argv)
+{
+  BenchConfig config = { 1316, 10, 10, 2 };
+  gchar *output = NULL;
+  GOptionEntry entries[] = {
+    {"payload-size", 'p', 0, G_OPTION_ARG_INT, &config.payload_size,
+        "RTP payload size in bytes", "BYTES"},
+    {"columns", 'L', 0, G_OPTION_ARG_INT, &config.columns,
+        "Columns of the FEC matrix", "L"},
+    {"rows", 'D', 0, G_OPTION_ARG_INT, &config.rows,
+        "Rows of the FEC matrix", "D"},
+    {"duration", 'd', 0, G_OPTION_ARG_INT, &config.duration,
+        "Seconds per measurement", "SECONDS"},
+    {"output", 'o', 0, G_OPTION_ARG_FILENAME, &output,
+        "Write the JSON results to FILE instead of stdout", "FILE"},
+    {NULL}
+  };
+  GOptionContext *ctx;
+  GError *error = NULL;
+  GString *json;
+  guint64 media_packets, fec_packets, recovered;
+  gdouble rate, packets_at_100mbps;
+  gboolean ok = TRUE, first = TRUE;
+  gint impl;
+
+  ctx = g_option_context_new ("- SMPTE 2022-1 FEC recovery benchmark");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &error)) {
+    g_printerr ("%s\n", error->message);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  /* SMPTE 2022-1 allows up to 20 columns and rows and 100 packets */
+  if (config.payload_size < 1 || config.payload_size > 8972
+      || config.columns < 1 || config.columns > 20 || config.rows < 1
+      || config.rows > 20 || config.columns * config.rows > 100
+      || config.duration < 1) {
+    g_printerr ("Invalid arguments\n");
+    return 1;
+  }
+
+  json = g_string_new ("{\n");
+  g_string_append_printf (json, "  \"benchmark\": \"rtp-fec\",\n"
+      "  \"config\": {\"payload_size\": %d, \"columns\": %d, "
+      "\"rows\": %d, \"duration\": %d},\n  \"xor\": [\n",
+      config.payload_size, config.columns, config.rows, config.duration);
+  for (impl = 0; impl < GST_RTP_XOR_IMPL_COUNT; impl++) {
+    if (!gst_rtp_xor_impl_is_supported (impl))
+      continue;
+
+    if (!first)
+      g_string_append (json, ",\n");
+    first = FALSE;
+    g_string_append_printf (json, "    {\"kernel\": \"%s\", "
+        "\"gbytes_per_second\": %.2f}", gst_rtp_xor_impl_get_name (impl),
+        bench_xor (impl, &config) / 1e9);
+  }
+
+  rate = bench_encode (&config, &media_packets, &fec_packets);
+  /* Packets per second of 100 Mbit/s on the wire, with the IPv4, UDP and
+   * RTP headers */
+  packets_at_100mbps = 100e6 / 8 / (config.payload_size + 20 + 8 + 12);
+  g_string_append_printf (json, "\n  ],\n  \"encoding\": {\n"
+      "    \"media_packets\": %" G_GUINT64_FORMAT ",\n"
+      "    \"fec_packets\": %" G_GUINT64_FORMAT ",\n"
+      "    \"media_packets_per_second\": %.0f,\n"
+      "    \"ns_per_packet\": %.1f,\n"
+      "    \"cpu_share_at_100mbps\": %.4f\n  },\n",
+      media_packets, fec_packets, rate, 1e9 / rate,
+      packets_at_100mbps / rate);
+
+  rate = bench_recover (&config, &media_packets, &recovered);
+  g_string_append_printf (json, "  \"recovery\": {\n"
+      "    \"kernel\": \"%s\",\n"
+      "    \"media_packets\": %" G_GUINT64_FORMAT ",\n"
+      "    \"recovered\": %" G_GUINT64_FORMAT ",\n"
+      "    \"recovered_per_second\": %.0f,\n"
+      "    \"media_packets_per_second\": %.0f\n  }\n}\n",
+      gst_rtp_xor_impl_get_name (gst_rtp_xor_get_impl ()), media_packets,
+      recovered, rate, recovered ? rate * media_packets / recovered : 0.0);
+
+  if (output) {
+    if (!g_file_set_contents (output, json->str, json->len, &error)) {
+      g_printerr ("Could not write %s: %s\n", output, error->message);
+      g_clear_error (&error);
+      ok = FALSE;
+    }
+  } else {
+    g_print ("%s", json->str);
+  }
+
+  g_string_free (json, TRUE);
+  g_free (output);
+
+  return ok ? 0 : 1;
+}
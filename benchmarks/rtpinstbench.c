@@ -0,0 +1,213 @@
+/* GStreamer
+ * Copyright (C) <2018> Marc Leeman <marc.leeman@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Instantiation benchmark for nrtp_rtpsrc and nrtp_rtpsink.
+ *
+ * Creates --count elements of each, keeps them alive and measures the
+ * wall-clock time and the growth of the resident memory per element,
+ * first for the creation alone and then for bringing all of them to
+ * READY, where the internal elements are built. The results are written
+ * as JSON.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <gst/gst.h>
+
+#define BENCH_BASE_PORT 30000
+
+typedef struct
+{
+  const gchar *factory;
+  gdouble create_us;
+  gdouble create_kib;
+  gdouble ready_us;
+  gdouble ready_kib;
+  guint children;
+} BenchResult;
+
+static GstClockTime
+bench_now (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+
+  return GST_TIMESPEC_TO_TIME (ts);
+}
+
+/* Resident memory of the process in bytes, 0 when unknown */
+static guint64
+bench_rss (void)
+{
+  guint64 size, resident = 0;
+  FILE *f;
+
+  f = fopen ("/proc/self/statm", "r");
+  if (f == NULL)
+    return 0;
+  if (fscanf (f, "%" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT, &size,
+          &resident) != 2)
+    resident = 0;
+  fclose (f);
+
+  return resident * sysconf (_SC_PAGESIZE);
+}
+
+/* Growth of the resident memory since @before, it can shrink as well */
+static gdouble
+bench_kib_per_element (guint64 before, gint count)
+{
+  return (gdouble) ((gint64) bench_rss () - (gint64) before) / 1024 / count;
+}
+
+static gboolean
+bench_run (const gchar * factory, gint count, BenchResult * result)
+{
+  GstElement **elements;
+  GstClockTime start;
+  guint64 rss;
+  gboolean ok = TRUE;
+  gint i;
+
+  memset (result, 0, sizeof (BenchResult));
+  result->factory = factory;
+  elements = g_new0 (GstElement *, count);
+
+  /* Load the plugin and warm up the allocators */
+  elements[0] = gst_element_factory_make (factory, NULL);
+  if (elements[0] == NULL) {
+    g_printerr ("%s is not available\n", factory);
+    g_free (elements);
+    return FALSE;
+  }
+  gst_object_unref (elements[0]);
+
+  rss = bench_rss ();
+  start = bench_now ();
+  for (i = 0; i < count; i++)
+    elements[i] = gst_element_factory_make (factory, NULL);
+  result->create_us = (gdouble) (bench_now () - start) / GST_USECOND / count;
+  result->create_kib = bench_kib_per_element (rss, count);
+  result->children = GST_BIN_NUMCHILDREN (elements[0]);
+
+  /* Every element needs its own RTP and RTCP ports at READY */
+  for (i = 0; i < count; i++) {
+    gchar *uri = g_strdup_printf ("rtp://127.0.0.1:%d",
+        BENCH_BASE_PORT + 4 * i);
+
+    g_object_set (elements[i], "uri", uri, NULL);
+    g_free (uri);
+  }
+
+  rss = bench_rss ();
+  start = bench_now ();
+  for (i = 0; i < count && ok; i++) {
+    if (gst_element_set_state (elements[i], GST_STATE_READY) ==
+        GST_STATE_CHANGE_FAILURE) {
+      g_printerr ("%s %d failed to go to READY\n", factory, i);
+      ok = FALSE;
+    }
+  }
+  result->ready_us = (gdouble) (bench_now () - start) / GST_USECOND / count;
+  result->ready_kib = bench_kib_per_element (rss, count);
+
+  for (i = 0; i < count; i++) {
+    gst_element_set_state (elements[i], GST_STATE_NULL);
+    gst_object_unref (elements[i]);
+  }
+  g_free (elements);
+
+  return ok;
+}
+
+int
+main (int argc, char **argv)
+{
+  gint count = 200;
+  gchar *output = NULL;
+  GOptionEntry entries[] = {
+    {"count", 'n', 0, G_OPTION_ARG_INT, &count,
+        "Number of elements of each kind", "N"},
+    {"output", 'o', 0, G_OPTION_ARG_FILENAME, &output,
+        "Write the JSON results to FILE instead of stdout", "FILE"},
+    {NULL}
+  };
+  const gchar *factories[] = { "nrtp_rtpsrc", "nrtp_rtpsink" };
+  BenchResult results[G_N_ELEMENTS (factories)];
+  GOptionContext *ctx;
+  GError *error = NULL;
+  GString *json;
+  gboolean ok = TRUE;
+  guint i;
+
+  ctx = g_option_context_new ("- nrtp_rtpsrc/nrtp_rtpsink instantiation "
+      "benchmark");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &error)) {
+    g_printerr ("%s\n", error->message);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  if (count < 1 || BENCH_BASE_PORT + 4 * count > G_MAXUINT16) {
+    g_printerr ("Invalid arguments\n");
+    return 1;
+  }
+
+  json = g_string_new ("{\n");
+  g_string_append_printf (json, "  \"benchmark\": \"rtp-instantiate\",\n"
+      "  \"config\": {\"count\": %d},\n  \"elements\": [\n", count);
+  for (i = 0; i < G_N_ELEMENTS (factories) && ok; i++) {
+    BenchResult *result = &results[i];
+
+    ok = bench_run (factories[i], count, result);
+    if (i > 0)
+      g_string_append (json, ",\n");
+    g_string_append_printf (json, "    {\n"
+        "      \"factory\": \"%s\",\n"
+        "      \"children_after_create\": %u,\n"
+        "      \"create_us_per_element\": %.2f,\n"
+        "      \"create_kib_per_element\": %.2f,\n"
+        "      \"ready_us_per_element\": %.2f,\n"
+        "      \"ready_kib_per_element\": %.2f\n    }", result->factory,
+        result->children, result->create_us, result->create_kib,
+        result->ready_us, result->ready_kib);
+  }
+  g_string_append (json, "\n  ]\n}\n");
+
+  if (output) {
+    if (!g_file_set_contents (output, json->str, json->len, &error)) {
+      g_printerr ("Could not write %s: %s\n", output, error->message);
+      g_clear_error (&error);
+      ok = FALSE;
+    }
+  } else {
+    g_print ("%s", json->str);
+  }
+
+  g_string_free (json, TRUE);
+  g_free (output);
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,301 @@
+/*
+ * Table of return addresses per SSRC.
+ *
+ * The table is read for every RTCP packet that is sent, and only changes
+ * when a sender appears, moves or leaves. Readers therefore never take a
+ * lock: the table is an immutable snapshot behind an atomic pointer.
+ * Writers copy the current snapshot, modify the copy and swap the
+ * pointer. The replaced snapshot is retired to a #GstRtpEpoch, which
+ * frees it once the readers that may still use it are gone. Neither the
+ * readers nor the writers ever wait for each other.
+ */
+
+#include <string.h>
+
+#include "gstrtp-addrtable.h"
+#include "gstrtp-epoch.h"
+#include "gstrtp-utils.h"
+
+typedef struct
+{
+  guint32 ssrc;
+  GSocketAddress *addr;
+} GstRtpAddrEntry;
+
+typedef struct
+{
+  /* Sorted on ssrc */
+  GstRtpAddrEntry *entries;
+  guint n_entries;
+  /* Used for SSRCs that are not in the table */
+  GSocketAddress *fallback;
+} GstRtpAddrSnapshot;
+
+struct _GstRtpAddrTable
+{
+  GstRtpAddrSnapshot *current;
+  /* Replaced snapshots wait here for the readers */
+  GstRtpEpoch *epoch;
+
+  /* Serializes the writers */
+  GMutex lock;
+};
+
+static GstRtpAddrSnapshot *
+gst_rtp_addr_snapshot_copy (const GstRtpAddrSnapshot * snapshot, guint extra)
+{
+  GstRtpAddrSnapshot *copy;
+  guint i;
+
+  copy = g_new0 (GstRtpAddrSnapshot, 1);
+  copy->entries = g_new (GstRtpAddrEntry, snapshot->n_entries + extra);
+  copy->n_entries = snapshot->n_entries;
+  for (i = 0; i < snapshot->n_entries; i++) {
+    copy->entries[i].ssrc = snapshot->entries[i].ssrc;
+    copy->entries[i].addr = g_object_ref (snapshot->entries[i].addr);
+  }
+  if (snapshot->fallback)
+    copy->fallback = g_object_ref (snapshot->fallback);
+
+  return copy;
+}
+
+static void
+gst_rtp_addr_snapshot_free (GstRtpAddrSnapshot * snapshot)
+{
+  guint i;
+
+  for (i = 0; i < snapshot->n_entries; i++)
+    g_object_unref (snapshot->entries[i].addr);
+  g_free (snapshot->entries);
+  g_clear_object (&snapshot->fallback);
+  g_free (snapshot);
+}
+
+/* Index of @ssrc, or of the position to insert it at */
+static guint
+gst_rtp_addr_snapshot_find (const GstRtpAddrSnapshot * snapshot,
+    guint32 ssrc, gboolean * found)
+{
+  guint lo = 0, hi = snapshot->n_entries;
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+
+    if (snapshot->entries[mid].ssrc == ssrc) {
+      *found = TRUE;
+      return mid;
+    }
+    if (snapshot->entries[mid].ssrc < ssrc)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  *found = FALSE;
+  return lo;
+}
+
+/* Called with the lock, takes ownership of @snapshot */
+static void
+gst_rtp_addr_table_publish (GstRtpAddrTable * table,
+    GstRtpAddrSnapshot * snapshot)
+{
+  GstRtpAddrSnapshot *old;
+
+  old = g_atomic_pointer_get (&table->current);
+  g_atomic_pointer_set (&table->current, snapshot);
+  gst_rtp_epoch_retire (table->epoch, old,
+      (GDestroyNotify) gst_rtp_addr_snapshot_free);
+}
+
+GstRtpAddrTable *
+gst_rtp_addr_table_new (void)
+{
+  GstRtpAddrTable *table = g_new0 (GstRtpAddrTable, 1);
+
+  table->current = g_new0 (GstRtpAddrSnapshot, 1);
+  table->epoch = gst_rtp_epoch_new ();
+  g_mutex_init (&table->lock);
+
+  return table;
+}
+
+/* Must not be called while other threads use the table */
+void
+gst_rtp_addr_table_free (GstRtpAddrTable * table)
+{
+  gst_rtp_epoch_free (table->epoch);
+  gst_rtp_addr_snapshot_free (table->current);
+  g_mutex_clear (&table->lock);
+  g_free (table);
+}
+
+/**
+ * gst_rtp_addr_table_set_fallback:
+ * @table: a #GstRtpAddrTable
+ * @addr: (nullable): the address to use for unknown SSRCs
+ *
+ * Set the address that gst_rtp_addr_table_lookup() returns for SSRCs that
+ * are not in the table.
+ */
+void
+gst_rtp_addr_table_set_fallback (GstRtpAddrTable * table,
+    GSocketAddress * addr)
+{
+  GstRtpAddrSnapshot *snapshot;
+
+  g_mutex_lock (&table->lock);
+  snapshot = gst_rtp_addr_snapshot_copy (table->current, 0);
+  g_clear_object (&snapshot->fallback);
+  if (addr)
+    snapshot->fallback = g_object_ref (addr);
+  gst_rtp_addr_table_publish (table, snapshot);
+  g_mutex_unlock (&table->lock);
+}
+
+/**
+ * gst_rtp_addr_table_update:
+ * @table: a #GstRtpAddrTable
+ * @ssrc: the SSRC of the sender
+ * @addr: the address RTCP for @ssrc should be sent to
+ *
+ * Record @addr as the return address of @ssrc. When a new SSRC is added
+ * or an SSRC moves, @addr also becomes the fallback address. Updating an
+ * SSRC with the address it already has does not take any lock, so this
+ * can be called for every received packet.
+ */
+void
+gst_rtp_addr_table_update (GstRtpAddrTable * table, guint32 ssrc,
+    GSocketAddress * addr)
+{
+  GstRtpAddrSnapshot *snapshot;
+  gboolean found, unchanged;
+  guint idx, token;
+
+  g_return_if_fail (addr != NULL);
+
+  token = gst_rtp_epoch_read_begin (table->epoch);
+  snapshot = g_atomic_pointer_get (&table->current);
+  idx = gst_rtp_addr_snapshot_find (snapshot, ssrc, &found);
+  unchanged = found
+      && gst_rtp_utils_socket_address_equal (snapshot->entries[idx].addr,
+      addr);
+  gst_rtp_epoch_read_end (table->epoch, token);
+
+  if (unchanged)
+    return;
+
+  g_mutex_lock (&table->lock);
+  snapshot = gst_rtp_addr_snapshot_copy (table->current, 1);
+  idx = gst_rtp_addr_snapshot_find (snapshot, ssrc, &found);
+  if (found) {
+    g_object_unref (snapshot->entries[idx].addr);
+  } else {
+    memmove (&snapshot->entries[idx + 1], &snapshot->entries[idx],
+        (snapshot->n_entries - idx) * sizeof (GstRtpAddrEntry));
+    snapshot->entries[idx].ssrc = ssrc;
+    snapshot->n_entries++;
+  }
+  snapshot->entries[idx].addr = g_object_ref (addr);
+  g_clear_object (&snapshot->fallback);
+  snapshot->fallback = g_object_ref (addr);
+  gst_rtp_addr_table_publish (table, snapshot);
+  g_mutex_unlock (&table->lock);
+}
+
+/**
+ * gst_rtp_addr_table_remove:
+ * @table: a #GstRtpAddrTable
+ * @ssrc: the SSRC of the sender
+ *
+ * Forget the return address of @ssrc, for instance after a BYE or a
+ * timeout. The fallback address is not changed.
+ */
+void
+gst_rtp_addr_table_remove (GstRtpAddrTable * table, guint32 ssrc)
+{
+  GstRtpAddrSnapshot *snapshot;
+  gboolean found;
+  guint idx;
+
+  g_mutex_lock (&table->lock);
+  gst_rtp_addr_snapshot_find (table->current, ssrc, &found);
+  if (!found) {
+    g_mutex_unlock (&table->lock);
+    return;
+  }
+
+  snapshot = gst_rtp_addr_snapshot_copy (table->current, 0);
+  idx = gst_rtp_addr_snapshot_find (snapshot, ssrc, &found);
+  g_object_unref (snapshot->entries[idx].addr);
+  memmove (&snapshot->entries[idx], &snapshot->entries[idx + 1],
+      (snapshot->n_entries - idx - 1) * sizeof (GstRtpAddrEntry));
+  snapshot->n_entries--;
+  gst_rtp_addr_table_publish (table, snapshot);
+  g_mutex_unlock (&table->lock);
+}
+
+/**
+ * gst_rtp_addr_table_clear:
+ * @table: a #GstRtpAddrTable
+ *
+ * Remove all entries and the fallback address.
+ */
+void
+gst_rtp_addr_table_clear (GstRtpAddrTable * table)
+{
+  g_mutex_lock (&table->lock);
+  gst_rtp_addr_table_publish (table, g_new0 (GstRtpAddrSnapshot, 1));
+  g_mutex_unlock (&table->lock);
+}
+
+/**
+ * gst_rtp_addr_table_get_fallback:
+ * @table: a #GstRtpAddrTable
+ *
+ * Returns: (transfer full) (nullable): the fallback address.
+ */
+GSocketAddress *
+gst_rtp_addr_table_get_fallback (GstRtpAddrTable * table)
+{
+  GstRtpAddrSnapshot *snapshot;
+  GSocketAddress *addr;
+  guint token;
+
+  token = gst_rtp_epoch_read_begin (table->epoch);
+  snapshot = g_atomic_pointer_get (&table->current);
+  addr = snapshot->fallback ? g_object_ref (snapshot->fallback) : NULL;
+  gst_rtp_epoch_read_end (table->epoch, token);
+
+  return addr;
+}
+
+/**
+ * gst_rtp_addr_table_lookup:
+ * @table: a #GstRtpAddrTable
+ * @ssrc: the SSRC of the sender
+ *
+ * Look up the return address of @ssrc without taking a lock.
+ *
+ * Returns: (transfer full) (nullable): the address of @ssrc, the fallback
+ *   address if @ssrc is unknown, or %NULL if there is none.
+ */
+GSocketAddress *
+gst_rtp_addr_table_lookup (GstRtpAddrTable * table, guint32 ssrc)
+{
+  GstRtpAddrSnapshot *snapshot;
+  GSocketAddress *addr;
+  gboolean found;
+  guint idx, token;
+
+  token = gst_rtp_epoch_read_begin (table->epoch);
+  snapshot = g_atomic_pointer_get (&table->current);
+  idx = gst_rtp_addr_snapshot_find (snapshot, ssrc, &found);
+  addr = found ? snapshot->entries[idx].addr : snapshot->fallback;
+  if (addr)
+    g_object_ref (addr);
+  gst_rtp_epoch_read_end (table->epoch, token);
+
+  return addr;
+}
@@ -0,0 +1,25 @@
+#ifndef __GST_RTP_ADDR_TABLE_H__
+#define __GST_RTP_ADDR_TABLE_H__
+
+#include <gio/gio.h>
+#include <gst/gst.h>
+
+typedef struct _GstRtpAddrTable GstRtpAddrTable;
+
+GstRtpAddrTable * gst_rtp_addr_table_new (void);
+
+void gst_rtp_addr_table_free (GstRtpAddrTable * table);
+
+void gst_rtp_addr_table_set_fallback (GstRtpAddrTable * table, GSocketAddress * addr);
+
+void gst_rtp_addr_table_update (GstRtpAddrTable * table, guint32 ssrc, GSocketAddress * addr);
+
+void gst_rtp_addr_table_remove (GstRtpAddrTable * table, guint32 ssrc);
+
+void gst_rtp_addr_table_clear (GstRtpAddrTable * table);
+
+GSocketAddress * gst_rtp_addr_table_get_fallback (GstRtpAddrTable * table);
+
+GSocketAddress * gst_rtp_addr_table_lookup (GstRtpAddrTable * table, guint32 ssrc);
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef __GST_RTP_COUNTERS_H__
+#define __GST_RTP_COUNTERS_H__
+
+#include <gst/gst.h>
+
+typedef struct _GstRtpCounters GstRtpCounters;
+
+GstRtpCounters * gst_rtp_counters_new (guint n_counters);
+
+void gst_rtp_counters_free (GstRtpCounters * counters);
+
+void gst_rtp_counters_add (GstRtpCounters * counters, guint index, guint64 value);
+
+void gst_rtp_counters_set (GstRtpCounters * counters, guint index, guint64 value);
+
+guint64 gst_rtp_counters_get (GstRtpCounters * counters, guint index);
+
+void gst_rtp_counters_read (GstRtpCounters * counters, guint64 * values);
+
+#endif
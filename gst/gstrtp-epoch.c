@@ -0,0 +1,149 @@
+/*
+ * Deferred freeing of data that lock-free readers may still use.
+ *
+ * Readers announce themselves in the reader count of the current epoch
+ * and re-check the epoch, so that they are counted before they pick up
+ * any shared pointer. Data that a writer replaced is retired in the
+ * current epoch. When the readers of the previous epoch are gone, the
+ * data retired before it is freed and the epoch advances: readers that
+ * start from then on are counted separately and can only see the new
+ * data, so the readers of the old epoch drain however busy the data is.
+ * Neither side ever waits for the other; the last reader of an old epoch
+ * frees the data itself when no writer holds the lock.
+ */
+
+#include "gstrtp-epoch.h"
+
+typedef struct
+{
+  gpointer data;
+  GDestroyNotify notify;
+} GstRtpEpochItem;
+
+struct _GstRtpEpoch
+{
+  volatile gint epoch;
+  volatile gint readers[2];
+
+  /* Protects the retired lists */
+  GMutex lock;
+  /* Retired in the current and in the previous epoch */
+  GSList *current;
+  GSList *previous;
+  /* Whether anything is retired, also read without the lock */
+  volatile gint have_retired;
+};
+
+static void
+gst_rtp_epoch_item_free (GstRtpEpochItem * item)
+{
+  item->notify (item->data);
+  g_slice_free (GstRtpEpochItem, item);
+}
+
+/* Called with the lock */
+static void
+gst_rtp_epoch_reclaim (GstRtpEpoch * epoch)
+{
+  gint e;
+
+  while (epoch->previous || epoch->current) {
+    e = g_atomic_int_get (&epoch->epoch);
+    if (g_atomic_int_get (&epoch->readers[(e + 1) & 1]) > 0)
+      break;
+
+    /* Nobody of the previous epoch can still use what it retired, nor
+     * what was current when it started */
+    g_slist_free_full (epoch->previous,
+        (GDestroyNotify) gst_rtp_epoch_item_free);
+    epoch->previous = epoch->current;
+    epoch->current = NULL;
+    if (epoch->previous)
+      g_atomic_int_inc (&epoch->epoch);
+  }
+
+  g_atomic_int_set (&epoch->have_retired, epoch->previous
+      || epoch->current);
+}
+
+GstRtpEpoch *
+gst_rtp_epoch_new (void)
+{
+  GstRtpEpoch *epoch = g_new0 (GstRtpEpoch, 1);
+
+  g_mutex_init (&epoch->lock);
+
+  return epoch;
+}
+
+/* Must not be called while other threads use the epoch */
+void
+gst_rtp_epoch_free (GstRtpEpoch * epoch)
+{
+  g_slist_free_full (epoch->previous,
+      (GDestroyNotify) gst_rtp_epoch_item_free);
+  g_slist_free_full (epoch->current,
+      (GDestroyNotify) gst_rtp_epoch_item_free);
+  g_mutex_clear (&epoch->lock);
+  g_free (epoch);
+}
+
+/**
+ * gst_rtp_epoch_read_begin:
+ * @epoch: a #GstRtpEpoch
+ *
+ * Start a read section, the shared data may only be picked up after
+ * this. Read sections are meant to be short.
+ *
+ * Returns: the token to pass to gst_rtp_epoch_read_end()
+ */
+guint
+gst_rtp_epoch_read_begin (GstRtpEpoch * epoch)
+{
+  gint e;
+
+  while (TRUE) {
+    e = g_atomic_int_get (&epoch->epoch);
+    g_atomic_int_inc (&epoch->readers[e & 1]);
+    if (G_LIKELY (g_atomic_int_get (&epoch->epoch) == e))
+      return e & 1;
+    /* Counted in an epoch that already ended */
+    gst_rtp_epoch_read_end (epoch, e & 1);
+  }
+}
+
+void
+gst_rtp_epoch_read_end (GstRtpEpoch * epoch, guint token)
+{
+  /* The last reader of the previous epoch frees what it retired */
+  if (g_atomic_int_dec_and_test (&epoch->readers[token])
+      && g_atomic_int_get (&epoch->have_retired)
+      && g_mutex_trylock (&epoch->lock)) {
+    gst_rtp_epoch_reclaim (epoch);
+    g_mutex_unlock (&epoch->lock);
+  }
+}
+
+/**
+ * gst_rtp_epoch_retire:
+ * @epoch: a #GstRtpEpoch
+ * @data: data that new readers can no longer pick up
+ * @notify: the function that frees @data
+ *
+ * Free @data once the readers that may still use it are gone, right
+ * away when there are none.
+ */
+void
+gst_rtp_epoch_retire (GstRtpEpoch * epoch, gpointer data,
+    GDestroyNotify notify)
+{
+  GstRtpEpochItem *item = g_slice_new (GstRtpEpochItem);
+
+  item->data = data;
+  item->notify = notify;
+
+  g_mutex_lock (&epoch->lock);
+  epoch->current = g_slist_prepend (epoch->current, item);
+  gst_rtp_epoch_reclaim (epoch);
+  g_mutex_unlock (&epoch->lock);
+}
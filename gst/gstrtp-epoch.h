@@ -0,0 +1,18 @@
+#ifndef __GST_RTP_EPOCH_H__
+#define __GST_RTP_EPOCH_H__
+
+#include <gst/gst.h>
+
+typedef struct _GstRtpEpoch GstRtpEpoch;
+
+GstRtpEpoch * gst_rtp_epoch_new (void);
+
+void gst_rtp_epoch_free (GstRtpEpoch * epoch);
+
+guint gst_rtp_epoch_read_begin (GstRtpEpoch * epoch);
+
+void gst_rtp_epoch_read_end (GstRtpEpoch * epoch, guint token);
+
+void gst_rtp_epoch_retire (GstRtpEpoch * epoch, gpointer data, GDestroyNotify notify);
+
+#endif
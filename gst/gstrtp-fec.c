@@ -0,0 +1,755 @@
+/*
+ * SMPTE 2022-1 forward error correction.
+ *
+ * The sender arranges the media packets in a matrix of L columns and D
+ * rows and sends a FEC packet per column and, optionally, per row. A FEC
+ * packet carries the XOR of the packets it protects: of their payloads,
+ * padded with zeroes to the longest one, and of their lengths, payload
+ * types, timestamps and the P, X, CC and M bits of their headers. As in
+ * RFC 2733, the payload is everything after the fixed 12 byte RTP header,
+ * so CSRCs and header extensions are recovered as well. When exactly one
+ * of the protected packets is missing, XORing the FEC packet with all
+ * others gives it back.
+ *
+ * The decoder keeps the last GST_RTP_FEC_WINDOW media packets and the FEC
+ * packets that cannot be used yet because more than one of their packets
+ * is missing. Every recovered packet may complete another FEC packet, of
+ * the other direction in the matrix, so the waiting ones are retried
+ * until nothing more is recovered. A FEC packet is given up once the
+ * packets it protects drop out of the window.
+ *
+ * The encoder XORs every media packet into the parity of its column and
+ * of its row as it passes, so a FEC packet is ready as soon as the last
+ * packet it protects was added, without keeping the media packets. A gap
+ * in the sequence numbers ends the matrix early, its FEC packets then
+ * protect fewer packets.
+ */
+
+#include <string.h>
+
+#include "gstrtp-fec.h"
+#include "gstrtp-xor.h"
+
+#define RTP_HEADER_LEN 12
+
+/* Media packets kept for recovery, comfortably more than the 100 packets
+ * of the largest SMPTE 2022-1 matrix plus reordering */
+#define GST_RTP_FEC_WINDOW 256
+/* FEC packets waiting for more media */
+#define MAX_PENDING 64
+
+/* Dynamic payload type of the FEC packets, receivers tell the streams
+ * apart by port */
+#define GST_RTP_FEC_PT 96
+
+typedef struct
+{
+  GstBuffer *buffer;
+  guint16 seq;
+} GstRtpFecSlot;
+
+typedef struct
+{
+  GstRtpFecHeader header;
+  GstBuffer *buffer;
+} GstRtpFecPacket;
+
+typedef enum
+{
+  GST_RTP_FEC_WAIT,
+  GST_RTP_FEC_DONE,
+  GST_RTP_FEC_RECOVERED,
+  GST_RTP_FEC_FAILED,
+} GstRtpFecResult;
+
+/* The XOR of the packets of one row or column added so far */
+typedef struct
+{
+  guint n_packets;
+  guint16 sn_base;
+  guint16 length;
+  guint8 pt;
+  guint32 ts;
+  guint8 pxcc;
+  guint8 marker;
+
+  /* The XOR of the payloads, as long as the longest one */
+  guint8 *payload;
+  gsize size;
+  gsize allocated;
+
+  /* Of the last packet, for the FEC packet */
+  guint32 last_ts;
+  GstClockTime pts;
+  GstClockTime dts;
+} GstRtpFecParity;
+
+struct _GstRtpFecEncoder
+{
+  guint columns;
+  guint rows;
+
+  GstRtpFecParity *column;
+  GstRtpFecParity row;
+
+  /* Position of the next packet in the matrix */
+  guint index;
+  gboolean have_media;
+  guint16 next_seq;
+  guint32 ssrc;
+
+  /* Sequence numbers of the FEC streams */
+  guint16 column_seq;
+  guint16 row_seq;
+};
+
+struct _GstRtpFecDecoder
+{
+  GstRtpFecSlot media[GST_RTP_FEC_WINDOW];
+  gboolean have_media;
+  guint16 max_seq;
+  guint32 ssrc;
+
+  /* GstRtpFecPacket, oldest first */
+  GQueue pending;
+
+  guint64 recovered;
+  guint64 unrecoverable;
+};
+
+/**
+ * gst_rtp_fec_header_parse:
+ * @header: the header to fill in
+ * @data: a FEC packet, starting with its RTP header
+ * @size: the size of @data
+ *
+ * Returns: %TRUE if @data is an XOR FEC packet in the format of SMPTE
+ * 2022-1.
+ */
+gboolean
+gst_rtp_fec_header_parse (GstRtpFecHeader * header, const guint8 * data,
+    gsize size)
+{
+  const guint8 *fec = data + RTP_HEADER_LEN;
+
+  if (size < RTP_HEADER_LEN + GST_RTP_FEC_HEADER_LEN || data[0] >> 6 != 2)
+    return FALSE;
+
+  /* Only the XOR type, described by offset and NA instead of a mask */
+  if ((fec[12] >> 3 & 0x07) != 0 || fec[13] == 0 || fec[14] == 0)
+    return FALSE;
+
+  header->pxcc_recovery = data[0] & 0x3f;
+  header->marker_recovery = data[1] >> 7;
+  header->sn_base = GST_READ_UINT16_BE (fec);
+  header->length_recovery = GST_READ_UINT16_BE (fec + 2);
+  header->pt_recovery = fec[4] & 0x7f;
+  header->ts_recovery = GST_READ_UINT32_BE (fec + 8);
+  header->row = fec[12] >> 6 & 0x01;
+  header->offset = fec[13];
+  header->na = fec[14];
+
+  /* The protected packets must fit in the window */
+  return (header->na - 1) * header->offset < GST_RTP_FEC_WINDOW / 2;
+}
+
+/**
+ * gst_rtp_fec_header_write:
+ * @header: the header to write
+ * @data: a FEC packet of at least the RTP and the FEC header
+ *
+ * Write the FEC header of @header after the RTP header of @data and its
+ * recovery bits into the RTP header, the caller fills in the payload type,
+ * sequence number, timestamp and SSRC.
+ */
+void
+gst_rtp_fec_header_write (const GstRtpFecHeader * header, guint8 * data)
+{
+  guint8 *fec = data + RTP_HEADER_LEN;
+
+  data[0] = 0x80 | header->pxcc_recovery;
+  data[1] = (header->marker_recovery << 7) | (data[1] & 0x7f);
+
+  memset (fec, 0, GST_RTP_FEC_HEADER_LEN);
+  GST_WRITE_UINT16_BE (fec, header->sn_base);
+  GST_WRITE_UINT16_BE (fec + 2, header->length_recovery);
+  /* E is always set, the mask is unused with offset and NA */
+  fec[4] = 0x80 | header->pt_recovery;
+  GST_WRITE_UINT32_BE (fec + 8, header->ts_recovery);
+  fec[12] = header->row << 6;
+  fec[13] = header->offset;
+  fec[14] = header->na;
+}
+
+/**
+ * gst_rtp_fec_decoder_new:
+ *
+ * Returns: (transfer full): a new decoder for one stream.
+ */
+GstRtpFecDecoder *
+gst_rtp_fec_decoder_new (void)
+{
+  GstRtpFecDecoder *dec = g_new0 (GstRtpFecDecoder, 1);
+
+  g_queue_init (&dec->pending);
+
+  return dec;
+}
+
+static void
+gst_rtp_fec_packet_free (GstRtpFecPacket * packet)
+{
+  gst_buffer_unref (packet->buffer);
+  g_free (packet);
+}
+
+/**
+ * gst_rtp_fec_decoder_reset:
+ * @dec: the decoder
+ *
+ * Drop all kept packets, the statistics are kept.
+ */
+void
+gst_rtp_fec_decoder_reset (GstRtpFecDecoder * dec)
+{
+  GstRtpFecPacket *packet;
+  guint i;
+
+  for (i = 0; i < GST_RTP_FEC_WINDOW; i++)
+    g_clear_pointer (&dec->media[i].buffer, gst_buffer_unref);
+  while ((packet = g_queue_pop_head (&dec->pending)))
+    gst_rtp_fec_packet_free (packet);
+  dec->have_media = FALSE;
+}
+
+/**
+ * gst_rtp_fec_decoder_free:
+ * @dec: the decoder
+ */
+void
+gst_rtp_fec_decoder_free (GstRtpFecDecoder * dec)
+{
+  gst_rtp_fec_decoder_reset (dec);
+  g_free (dec);
+}
+
+static GstBuffer *
+gst_rtp_fec_decoder_lookup (GstRtpFecDecoder * dec, guint16 seq)
+{
+  GstRtpFecSlot *slot = &dec->media[seq % GST_RTP_FEC_WINDOW];
+
+  return slot->buffer && slot->seq == seq ? slot->buffer : NULL;
+}
+
+static void
+gst_rtp_fec_decoder_store (GstRtpFecDecoder * dec, guint16 seq,
+    GstBuffer * buffer)
+{
+  GstRtpFecSlot *slot = &dec->media[seq % GST_RTP_FEC_WINDOW];
+
+  gst_buffer_replace (&slot->buffer, buffer);
+  slot->seq = seq;
+
+  if (!dec->have_media || (gint16) (seq - dec->max_seq) > 0)
+    dec->max_seq = seq;
+  dec->have_media = TRUE;
+}
+
+/* TRUE when the first packet protected by @header may have been replaced
+ * in the window already */
+static gboolean
+gst_rtp_fec_decoder_is_stale (GstRtpFecDecoder * dec,
+    const GstRtpFecHeader * header)
+{
+  return dec->have_media
+      && (gint16) (dec->max_seq - header->sn_base) >= GST_RTP_FEC_WINDOW;
+}
+
+/* XOR @packet with all protected packets but @seq */
+static GstBuffer *
+gst_rtp_fec_decoder_recover (GstRtpFecDecoder * dec, GstRtpFecPacket * packet,
+    guint16 seq)
+{
+  const GstRtpFecHeader *header = &packet->header;
+  guint16 length = header->length_recovery;
+  guint8 pxcc = header->pxcc_recovery;
+  guint8 marker = header->marker_recovery;
+  guint8 pt = header->pt_recovery;
+  guint32 ts = header->ts_recovery;
+  GstMapInfo fec_map, out_map;
+  GstBuffer *out;
+  gsize fec_len;
+  guint i;
+
+  gst_buffer_map (packet->buffer, &fec_map, GST_MAP_READ);
+  fec_len = fec_map.size - RTP_HEADER_LEN - GST_RTP_FEC_HEADER_LEN;
+  out = gst_buffer_new_allocate (NULL, RTP_HEADER_LEN + fec_len, NULL);
+  gst_buffer_map (out, &out_map, GST_MAP_WRITE);
+  memcpy (out_map.data + RTP_HEADER_LEN,
+      fec_map.data + RTP_HEADER_LEN + GST_RTP_FEC_HEADER_LEN, fec_len);
+  gst_buffer_unmap (packet->buffer, &fec_map);
+
+  for (i = 0; i < header->na; i++) {
+    guint16 media_seq = header->sn_base + i * header->offset;
+    GstBuffer *media;
+    GstMapInfo map;
+    gsize media_len;
+
+    if (media_seq == seq)
+      continue;
+
+    media = gst_rtp_fec_decoder_lookup (dec, media_seq);
+    gst_buffer_map (media, &map, GST_MAP_READ);
+    media_len = map.size - RTP_HEADER_LEN;
+    if (media_len > fec_len) {
+      gst_buffer_unmap (media, &map);
+      goto invalid;
+    }
+
+    gst_rtp_xor (out_map.data + RTP_HEADER_LEN, map.data + RTP_HEADER_LEN,
+        media_len);
+    length ^= media_len;
+    pxcc ^= map.data[0] & 0x3f;
+    marker ^= map.data[1] >> 7;
+    pt ^= map.data[1] & 0x7f;
+    ts ^= GST_READ_UINT32_BE (map.data + 4);
+    gst_buffer_unmap (media, &map);
+  }
+
+  if (length > fec_len)
+    goto invalid;
+
+  out_map.data[0] = 0x80 | pxcc;
+  out_map.data[1] = (marker << 7) | pt;
+  GST_WRITE_UINT16_BE (out_map.data + 2, seq);
+  GST_WRITE_UINT32_BE (out_map.data + 4, ts);
+  /* FEC packets do not carry the SSRC of the media stream */
+  GST_WRITE_UINT32_BE (out_map.data + 8, dec->ssrc);
+  gst_buffer_unmap (out, &out_map);
+  gst_buffer_resize (out, 0, RTP_HEADER_LEN + length);
+
+  /* The packet is only available from the moment the FEC arrived */
+  GST_BUFFER_PTS (out) = GST_BUFFER_PTS (packet->buffer);
+  GST_BUFFER_DTS (out) = GST_BUFFER_DTS (packet->buffer);
+
+  return out;
+
+invalid:
+  {
+    gst_buffer_unmap (out, &out_map);
+    gst_buffer_unref (out);
+    return NULL;
+  }
+}
+
+static GstRtpFecResult
+gst_rtp_fec_decoder_try (GstRtpFecDecoder * dec, GstRtpFecPacket * packet,
+    GQueue * recovered)
+{
+  const GstRtpFecHeader *header = &packet->header;
+  guint16 missing_seq = 0;
+  guint i, missing = 0;
+  GstBuffer *out;
+
+  if (gst_rtp_fec_decoder_is_stale (dec, header))
+    return GST_RTP_FEC_FAILED;
+
+  for (i = 0; i < header->na && missing < 2; i++) {
+    guint16 seq = header->sn_base + i * header->offset;
+
+    if (gst_rtp_fec_decoder_lookup (dec, seq) == NULL) {
+      missing_seq = seq;
+      missing++;
+    }
+  }
+
+  if (missing == 0)
+    return GST_RTP_FEC_DONE;
+  if (missing > 1)
+    return GST_RTP_FEC_WAIT;
+
+  out = gst_rtp_fec_decoder_recover (dec, packet, missing_seq);
+  if (out == NULL)
+    return GST_RTP_FEC_FAILED;
+
+  gst_rtp_fec_decoder_store (dec, missing_seq, out);
+  g_queue_push_tail (recovered, out);
+  dec->recovered++;
+
+  return GST_RTP_FEC_RECOVERED;
+}
+
+/* Retry the waiting FEC packets until no more packets are recovered */
+static void
+gst_rtp_fec_decoder_process (GstRtpFecDecoder * dec, GQueue * recovered)
+{
+  gboolean progress = TRUE;
+
+  while (progress) {
+    GList *l, *next;
+
+    progress = FALSE;
+    for (l = dec->pending.head; l; l = next) {
+      GstRtpFecPacket *packet = l->data;
+
+      next = l->next;
+      switch (gst_rtp_fec_decoder_try (dec, packet, recovered)) {
+        case GST_RTP_FEC_WAIT:
+          continue;
+        case GST_RTP_FEC_RECOVERED:
+          progress = TRUE;
+          break;
+        case GST_RTP_FEC_FAILED:
+          dec->unrecoverable++;
+          break;
+        case GST_RTP_FEC_DONE:
+          break;
+      }
+      g_queue_delete_link (&dec->pending, l);
+      gst_rtp_fec_packet_free (packet);
+    }
+  }
+}
+
+/**
+ * gst_rtp_fec_decoder_add_media:
+ * @dec: the decoder
+ * @buffer: (transfer none): a media packet
+ * @recovered: queue to append the recovered packets to
+ *
+ * Keep @buffer for recovering other packets and use it for the FEC
+ * packets that wait for it. Recovered packets are appended to
+ * @recovered, the caller owns them.
+ *
+ * Returns: %FALSE if @buffer is a duplicate, for instance a late packet
+ * that was recovered already, and is to be dropped.
+ */
+gboolean
+gst_rtp_fec_decoder_add_media (GstRtpFecDecoder * dec, GstBuffer * buffer,
+    GQueue * recovered)
+{
+  guint8 header[RTP_HEADER_LEN];
+  guint32 ssrc;
+  guint16 seq;
+
+  if (gst_buffer_extract (buffer, 0, header, RTP_HEADER_LEN) <
+      RTP_HEADER_LEN || header[0] >> 6 != 2)
+    return TRUE;
+
+  seq = GST_READ_UINT16_BE (header + 2);
+  ssrc = GST_READ_UINT32_BE (header + 8);
+
+  /* A new sender restarts the sequence numbers */
+  if (dec->have_media && ssrc != dec->ssrc)
+    gst_rtp_fec_decoder_reset (dec);
+  dec->ssrc = ssrc;
+
+  if (gst_rtp_fec_decoder_lookup (dec, seq))
+    return FALSE;
+
+  gst_rtp_fec_decoder_store (dec, seq, buffer);
+  if (dec->pending.length > 0)
+    gst_rtp_fec_decoder_process (dec, recovered);
+
+  return TRUE;
+}
+
+/**
+ * gst_rtp_fec_decoder_add_fec:
+ * @dec: the decoder
+ * @buffer: (transfer none): a FEC packet
+ * @recovered: queue to append the recovered packets to
+ *
+ * Recover the packet @buffer protects if it is the only one missing,
+ * otherwise keep @buffer until more packets arrived. Recovered packets
+ * are appended to @recovered, the caller owns them.
+ *
+ * Returns: %FALSE if @buffer is not a valid FEC packet.
+ */
+gboolean
+gst_rtp_fec_decoder_add_fec (GstRtpFecDecoder * dec, GstBuffer * buffer,
+    GQueue * recovered)
+{
+  GstRtpFecPacket *packet;
+  GstRtpFecHeader header;
+  GstMapInfo map;
+  gboolean valid;
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  valid = gst_rtp_fec_header_parse (&header, map.data, map.size);
+  gst_buffer_unmap (buffer, &map);
+  if (!valid)
+    return FALSE;
+
+  /* Too late to be of use */
+  if (gst_rtp_fec_decoder_is_stale (dec, &header))
+    return TRUE;
+
+  packet = g_new (GstRtpFecPacket, 1);
+  packet->header = header;
+  packet->buffer = gst_buffer_ref (buffer);
+  g_queue_push_tail (&dec->pending, packet);
+
+  if (dec->pending.length > MAX_PENDING) {
+    gst_rtp_fec_packet_free (g_queue_pop_head (&dec->pending));
+    dec->unrecoverable++;
+  }
+
+  gst_rtp_fec_decoder_process (dec, recovered);
+
+  return TRUE;
+}
+
+/**
+ * gst_rtp_fec_decoder_get_recovered:
+ * @dec: the decoder
+ *
+ * Returns: the number of packets recovered.
+ */
+guint64
+gst_rtp_fec_decoder_get_recovered (GstRtpFecDecoder * dec)
+{
+  return dec->recovered;
+}
+
+/**
+ * gst_rtp_fec_decoder_get_unrecoverable:
+ * @dec: the decoder
+ *
+ * Returns: the number of FEC packets given up because more than one of
+ * the packets they protect was lost.
+ */
+guint64
+gst_rtp_fec_decoder_get_unrecoverable (GstRtpFecDecoder * dec)
+{
+  return dec->unrecoverable;
+}
+
+/**
+ * gst_rtp_fec_encoder_new:
+ * @columns: L, the number of columns of the matrix
+ * @rows: D, the number of rows of the matrix
+ *
+ * Returns: (transfer full): a new encoder for one stream.
+ */
+GstRtpFecEncoder *
+gst_rtp_fec_encoder_new (guint columns, guint rows)
+{
+  GstRtpFecEncoder *enc;
+
+  g_return_val_if_fail (columns > 0 && columns <= G_MAXUINT8, NULL);
+  g_return_val_if_fail (rows > 0 && rows <= G_MAXUINT8, NULL);
+
+  enc = g_new0 (GstRtpFecEncoder, 1);
+  enc->columns = columns;
+  enc->rows = rows;
+  enc->column = g_new0 (GstRtpFecParity, columns);
+  enc->column_seq = g_random_int ();
+  enc->row_seq = g_random_int ();
+
+  return enc;
+}
+
+/**
+ * gst_rtp_fec_encoder_free:
+ * @enc: the encoder
+ */
+void
+gst_rtp_fec_encoder_free (GstRtpFecEncoder * enc)
+{
+  guint i;
+
+  for (i = 0; i < enc->columns; i++)
+    g_free (enc->column[i].payload);
+  g_free (enc->column);
+  g_free (enc->row.payload);
+  g_free (enc);
+}
+
+/**
+ * gst_rtp_fec_encoder_reset:
+ * @enc: the encoder
+ *
+ * Drop the parities of the current matrix, the next packet starts a new
+ * one.
+ */
+void
+gst_rtp_fec_encoder_reset (GstRtpFecEncoder * enc)
+{
+  guint i;
+
+  for (i = 0; i < enc->columns; i++)
+    enc->column[i].n_packets = 0;
+  enc->row.n_packets = 0;
+  enc->index = 0;
+  enc->have_media = FALSE;
+}
+
+static void
+gst_rtp_fec_parity_add (GstRtpFecParity * parity, GstBuffer * buffer,
+    const guint8 * data, gsize size)
+{
+  const guint8 *payload = data + RTP_HEADER_LEN;
+  gsize len = size - RTP_HEADER_LEN;
+
+  if (len > parity->allocated) {
+    parity->payload = g_realloc (parity->payload, len);
+    parity->allocated = len;
+  }
+
+  if (parity->n_packets == 0) {
+    parity->sn_base = GST_READ_UINT16_BE (data + 2);
+    parity->length = len;
+    parity->pt = data[1] & 0x7f;
+    parity->ts = GST_READ_UINT32_BE (data + 4);
+    parity->pxcc = data[0] & 0x3f;
+    parity->marker = data[1] >> 7;
+    memcpy (parity->payload, payload, len);
+    parity->size = len;
+  } else {
+    parity->length ^= len;
+    parity->pt ^= data[1] & 0x7f;
+    parity->ts ^= GST_READ_UINT32_BE (data + 4);
+    parity->pxcc ^= data[0] & 0x3f;
+    parity->marker ^= data[1] >> 7;
+    /* Shorter payloads were padded with zeroes */
+    if (len > parity->size) {
+      memset (parity->payload + parity->size, 0, len - parity->size);
+      parity->size = len;
+    }
+    gst_rtp_xor (parity->payload, payload, len);
+  }
+
+  parity->n_packets++;
+  parity->last_ts = GST_READ_UINT32_BE (data + 4);
+  parity->pts = GST_BUFFER_PTS (buffer);
+  parity->dts = GST_BUFFER_DTS (buffer);
+}
+
+/* The FEC packet of @parity, which starts over */
+static GstBuffer *
+gst_rtp_fec_parity_finish (GstRtpFecParity * parity, gboolean row,
+    guint offset, guint16 seq)
+{
+  GstRtpFecHeader header;
+  GstBuffer *buffer;
+  GstMapInfo map;
+
+  header.sn_base = parity->sn_base;
+  header.length_recovery = parity->length;
+  header.pt_recovery = parity->pt;
+  header.ts_recovery = parity->ts;
+  header.pxcc_recovery = parity->pxcc;
+  header.marker_recovery = parity->marker;
+  header.row = row;
+  /* A single packet is its own row or column */
+  header.offset = parity->n_packets > 1 ? offset : 1;
+  header.na = parity->n_packets;
+
+  buffer = gst_buffer_new_allocate (NULL,
+      RTP_HEADER_LEN + GST_RTP_FEC_HEADER_LEN + parity->size, NULL);
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  map.data[1] = GST_RTP_FEC_PT;
+  GST_WRITE_UINT16_BE (map.data + 2, seq);
+  GST_WRITE_UINT32_BE (map.data + 4, parity->last_ts);
+  /* SMPTE 2022-1 sends the FEC streams with SSRC 0 */
+  GST_WRITE_UINT32_BE (map.data + 8, 0);
+  gst_rtp_fec_header_write (&header, map.data);
+  memcpy (map.data + RTP_HEADER_LEN + GST_RTP_FEC_HEADER_LEN,
+      parity->payload, parity->size);
+  gst_buffer_unmap (buffer, &map);
+
+  GST_BUFFER_PTS (buffer) = parity->pts;
+  GST_BUFFER_DTS (buffer) = parity->dts;
+  parity->n_packets = 0;
+
+  return buffer;
+}
+
+/**
+ * gst_rtp_fec_encoder_flush:
+ * @enc: the encoder
+ * @column_fec: (nullable): queue to append the column FEC packets to
+ * @row_fec: (nullable): queue to append the row FEC packet to
+ *
+ * Finish the FEC packets of the current matrix for the packets added so
+ * far, the next packet starts a new matrix.
+ */
+void
+gst_rtp_fec_encoder_flush (GstRtpFecEncoder * enc, GQueue * column_fec,
+    GQueue * row_fec)
+{
+  guint i;
+
+  for (i = 0; i < enc->columns; i++) {
+    if (column_fec && enc->column[i].n_packets > 0)
+      g_queue_push_tail (column_fec,
+          gst_rtp_fec_parity_finish (&enc->column[i], FALSE, enc->columns,
+              enc->column_seq++));
+  }
+  if (row_fec && enc->row.n_packets > 0)
+    g_queue_push_tail (row_fec,
+        gst_rtp_fec_parity_finish (&enc->row, TRUE, 1, enc->row_seq++));
+
+  gst_rtp_fec_encoder_reset (enc);
+}
+
+/**
+ * gst_rtp_fec_encoder_add_media:
+ * @enc: the encoder
+ * @buffer: (transfer none): a media packet
+ * @column_fec: (nullable): queue to append the column FEC packets to
+ * @row_fec: (nullable): queue to append the row FEC packet to
+ *
+ * Add @buffer to the parity of its column and row. The FEC packets that
+ * @buffer completes are appended to @column_fec and @row_fec, the caller
+ * owns them. No parity is computed for a direction whose queue is %NULL.
+ */
+void
+gst_rtp_fec_encoder_add_media (GstRtpFecEncoder * enc, GstBuffer * buffer,
+    GQueue * column_fec, GQueue * row_fec)
+{
+  guint column, row;
+  GstMapInfo map;
+  guint16 seq;
+  guint32 ssrc;
+
+  if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
+    return;
+  if (map.size < RTP_HEADER_LEN || map.data[0] >> 6 != 2)
+    goto done;
+
+  seq = GST_READ_UINT16_BE (map.data + 2);
+  ssrc = GST_READ_UINT32_BE (map.data + 8);
+
+  /* The packets of a matrix must follow each other */
+  if (enc->have_media && (seq != enc->next_seq || ssrc != enc->ssrc))
+    gst_rtp_fec_encoder_flush (enc, column_fec, row_fec);
+
+  column = enc->index % enc->columns;
+  row = enc->index / enc->columns;
+
+  if (column_fec) {
+    gst_rtp_fec_parity_add (&enc->column[column], buffer, map.data,
+        map.size);
+    if (row == enc->rows - 1)
+      g_queue_push_tail (column_fec,
+          gst_rtp_fec_parity_finish (&enc->column[column], FALSE,
+              enc->columns, enc->column_seq++));
+  }
+
+  if (row_fec) {
+    gst_rtp_fec_parity_add (&enc->row, buffer, map.data, map.size);
+    if (column == enc->columns - 1)
+      g_queue_push_tail (row_fec,
+          gst_rtp_fec_parity_finish (&enc->row, TRUE, 1, enc->row_seq++));
+  }
+
+  enc->index = (enc->index + 1) % (enc->columns * enc->rows);
+  enc->have_media = TRUE;
+  enc->next_seq = seq + 1;
+  enc->ssrc = ssrc;
+
+done:
+  gst_buffer_unmap (buffer, &map);
+}
@@ -0,0 +1,65 @@
+#ifndef __GST_RTP_FEC_H__
+#define __GST_RTP_FEC_H__
+
+#include <gst/gst.h>
+
+/* Size of the FEC header that follows the RTP header of a FEC packet */
+#define GST_RTP_FEC_HEADER_LEN 16
+
+/* The SMPTE 2022-1 FEC header and the recovery bits that RFC 2733 carries
+ * in the RTP header of the FEC packet. The packets protected by a FEC
+ * packet are @sn_base + i * @offset for i < @na. */
+typedef struct
+{
+  guint16 sn_base;
+  guint16 length_recovery;
+  guint8 pt_recovery;
+  guint32 ts_recovery;
+  /* P, X and CC of the first RTP header byte, and the marker bit */
+  guint8 pxcc_recovery;
+  gboolean marker_recovery;
+  /* Row FEC (D bit set) protects consecutive packets, column FEC every
+   * L-th packet */
+  gboolean row;
+  guint8 offset;
+  guint8 na;
+} GstRtpFecHeader;
+
+typedef struct _GstRtpFecDecoder GstRtpFecDecoder;
+typedef struct _GstRtpFecEncoder GstRtpFecEncoder;
+
+gboolean gst_rtp_fec_header_parse (GstRtpFecHeader * header,
+    const guint8 * data, gsize size);
+
+void gst_rtp_fec_header_write (const GstRtpFecHeader * header,
+    guint8 * data);
+
+GstRtpFecDecoder * gst_rtp_fec_decoder_new (void);
+
+void gst_rtp_fec_decoder_free (GstRtpFecDecoder * dec);
+
+void gst_rtp_fec_decoder_reset (GstRtpFecDecoder * dec);
+
+gboolean gst_rtp_fec_decoder_add_media (GstRtpFecDecoder * dec,
+    GstBuffer * buffer, GQueue * recovered);
+
+gboolean gst_rtp_fec_decoder_add_fec (GstRtpFecDecoder * dec,
+    GstBuffer * buffer, GQueue * recovered);
+
+guint64 gst_rtp_fec_decoder_get_recovered (GstRtpFecDecoder * dec);
+
+guint64 gst_rtp_fec_decoder_get_unrecoverable (GstRtpFecDecoder * dec);
+
+GstRtpFecEncoder * gst_rtp_fec_encoder_new (guint columns, guint rows);
+
+void gst_rtp_fec_encoder_free (GstRtpFecEncoder * enc);
+
+void gst_rtp_fec_encoder_reset (GstRtpFecEncoder * enc);
+
+void gst_rtp_fec_encoder_add_media (GstRtpFecEncoder * enc,
+    GstBuffer * buffer, GQueue * column_fec, GQueue * row_fec);
+
+void gst_rtp_fec_encoder_flush (GstRtpFecEncoder * enc, GQueue * column_fec,
+    GQueue * row_fec);
+
+#endif
@@ -0,0 +1,204 @@
+/*
+ * Classic BPF socket filters for RTP and RTCP sockets.
+ *
+ * The filter runs in the kernel for every datagram before it is queued on
+ * the socket, so packets that the receiver would throw away anyway never
+ * cost a copy to userspace. For UDP sockets the program sees the packet
+ * starting at the UDP header, so the RTP header starts at offset 8.
+ *
+ * The program checks the RTP version and, when given, the payload type
+ * and the SSRC against short lists of accepted values:
+ *
+ *   A = version bits, drop unless 2
+ *   A = payload type, drop unless one of pts (RTP only)
+ *   accept if A is one of any_ssrc_pts (RTP only)
+ *   A = SSRC, drop unless one of ssrcs
+ *   accept
+ *
+ * The payload types of any_ssrc_pts skip the SSRC check, for the RFC 4588
+ * retransmissions that the sender sends with a random SSRC of its own.
+ */
+
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#ifdef __linux__
+#include <linux/filter.h>
+#endif
+
+#include "gstrtp-filter.h"
+
+#define UDP_HEADER_SIZE 8
+
+/**
+ * gst_rtp_filter_parse_list:
+ * @str: comma separated list of numbers, decimal or with a 0x prefix
+ * @max_value: the largest value allowed in the list
+ *
+ * Returns: (transfer full): an array of guint32 with the values of @str
+ * or %NULL if an entry is invalid or the list has more than
+ * GST_RTP_FILTER_MAX_ENTRIES values.
+ */
+GArray *
+gst_rtp_filter_parse_list (const gchar * str, guint32 max_value)
+{
+  GArray *values = g_array_new (FALSE, FALSE, sizeof (guint32));
+  gchar **entries;
+  guint i;
+
+  entries = g_strsplit (str, ",", -1);
+  for (i = 0; entries[i]; i++) {
+    guint64 value;
+    guint32 v;
+    gchar *end;
+
+    g_strstrip (entries[i]);
+    if (entries[i][0] == '\0')
+      continue;
+
+    value = g_ascii_strtoull (entries[i], &end, 0);
+    if (end == entries[i] || *end != '\0' || value > max_value
+        || values->len == GST_RTP_FILTER_MAX_ENTRIES) {
+      g_array_unref (values);
+      values = NULL;
+      break;
+    }
+
+    v = value;
+    g_array_append_val (values, v);
+  }
+  g_strfreev (entries);
+
+  return values;
+}
+
+#ifdef __linux__
+static void
+gst_rtp_filter_emit (GArray * code, guint16 op, guint8 jt, guint8 jf,
+    guint32 k)
+{
+  struct sock_filter insn = { op, jt, jf, k };
+
+  g_array_append_val (code, insn);
+}
+
+/* Drop the packet unless A is one of @values */
+static void
+gst_rtp_filter_emit_match (GArray * code, GArray * values)
+{
+  guint i;
+
+  for (i = 0; i < values->len; i++)
+    gst_rtp_filter_emit (code, BPF_JMP | BPF_JEQ | BPF_K,
+        values->len - i, 0, g_array_index (values, guint32, i));
+  gst_rtp_filter_emit (code, BPF_RET | BPF_K, 0, 0, 0);
+}
+
+/* Accept the packet if A is one of @values */
+static void
+gst_rtp_filter_emit_accept (GArray * code, GArray * values)
+{
+  guint i;
+
+  for (i = 0; i < values->len; i++)
+    gst_rtp_filter_emit (code, BPF_JMP | BPF_JEQ | BPF_K,
+        values->len - i, 0, g_array_index (values, guint32, i));
+  gst_rtp_filter_emit (code, BPF_JMP | BPF_JA, 0, 0, 1);
+  gst_rtp_filter_emit (code, BPF_RET | BPF_K, 0, 0, G_MAXUINT32);
+}
+#endif
+
+/**
+ * gst_rtp_filter_new:
+ * @rtcp: whether the filter is for the RTCP socket
+ * @ssrcs: (nullable): the accepted SSRCs, or %NULL to accept all
+ * @pts: (nullable): the accepted payload types, or %NULL to accept all
+ * @any_ssrc_pts: (nullable): payload types accepted from any SSRC, or %NULL
+ *
+ * Build a filter for the packets of an RTP session. For RTCP, the SSRC of
+ * the sender of the first packet of a compound packet is checked and @pts
+ * and @any_ssrc_pts are ignored. The payload types of @any_ssrc_pts still
+ * have to be in @pts when that is given.
+ *
+ * Returns: (transfer full): the filter program or %NULL if socket filters
+ * are not supported.
+ */
+GBytes *
+gst_rtp_filter_new (gboolean rtcp, GArray * ssrcs, GArray * pts,
+    GArray * any_ssrc_pts)
+{
+#ifdef __linux__
+  GArray *code = g_array_new (FALSE, FALSE, sizeof (struct sock_filter));
+  guint size;
+
+  /* Version 2, the packet is dropped if it is too short to load from */
+  gst_rtp_filter_emit (code, BPF_LD | BPF_B | BPF_ABS, 0, 0,
+      UDP_HEADER_SIZE);
+  gst_rtp_filter_emit (code, BPF_ALU | BPF_AND | BPF_K, 0, 0, 0xc0);
+  gst_rtp_filter_emit (code, BPF_JMP | BPF_JEQ | BPF_K, 1, 0, 0x80);
+  gst_rtp_filter_emit (code, BPF_RET | BPF_K, 0, 0, 0);
+
+  if (!rtcp && ((pts && pts->len > 0) || (any_ssrc_pts
+              && any_ssrc_pts->len > 0 && ssrcs && ssrcs->len > 0))) {
+    gst_rtp_filter_emit (code, BPF_LD | BPF_B | BPF_ABS, 0, 0,
+        UDP_HEADER_SIZE + 1);
+    gst_rtp_filter_emit (code, BPF_ALU | BPF_AND | BPF_K, 0, 0, 0x7f);
+    if (pts && pts->len > 0)
+      gst_rtp_filter_emit_match (code, pts);
+    /* Only worth it when the SSRC is checked */
+    if (any_ssrc_pts && ssrcs && ssrcs->len > 0)
+      gst_rtp_filter_emit_accept (code, any_ssrc_pts);
+  }
+
+  if (ssrcs && ssrcs->len > 0) {
+    gst_rtp_filter_emit (code, BPF_LD | BPF_W | BPF_ABS, 0, 0,
+        UDP_HEADER_SIZE + (rtcp ? 4 : 8));
+    gst_rtp_filter_emit_match (code, ssrcs);
+  }
+
+  gst_rtp_filter_emit (code, BPF_RET | BPF_K, 0, 0, G_MAXUINT32);
+
+  size = code->len * sizeof (struct sock_filter);
+  return g_bytes_new_take (g_array_free (code, FALSE), size);
+#else
+  return NULL;
+#endif
+}
+
+/**
+ * gst_rtp_filter_attach:
+ * @socket: the socket to filter
+ * @filter: a filter from gst_rtp_filter_new()
+ * @error: location for a #GError, or %NULL
+ *
+ * Replace the socket filter of @socket with @filter.
+ *
+ * Returns: %TRUE if the filter was attached.
+ */
+gboolean
+gst_rtp_filter_attach (GSocket * socket, GBytes * filter, GError ** error)
+{
+#if defined (__linux__) && defined (SO_ATTACH_FILTER)
+  struct sock_fprog prog;
+  gsize size;
+
+  prog.filter = (struct sock_filter *) g_bytes_get_data (filter, &size);
+  prog.len = size / sizeof (struct sock_filter);
+
+  if (setsockopt (g_socket_get_fd (socket), SOL_SOCKET, SO_ATTACH_FILTER,
+          &prog, sizeof (prog)) < 0) {
+    gint errsv = errno;
+
+    g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errsv),
+        "Could not attach socket filter: %s", g_strerror (errsv));
+    return FALSE;
+  }
+
+  return TRUE;
+#else
+  g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+      "Socket filters are not supported on this system");
+  return FALSE;
+#endif
+}
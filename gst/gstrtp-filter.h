@@ -0,0 +1,17 @@
+#ifndef __GST_RTP_FILTER_H__
+#define __GST_RTP_FILTER_H__
+
+#include <gio/gio.h>
+#include <gst/gst.h>
+
+/* Maximum number of SSRCs or payload types in a filter */
+#define GST_RTP_FILTER_MAX_ENTRIES 64
+
+GArray * gst_rtp_filter_parse_list (const gchar * str, guint32 max_value);
+
+GBytes * gst_rtp_filter_new (gboolean rtcp, GArray * ssrcs, GArray * pts,
+    GArray * any_ssrc_pts);
+
+gboolean gst_rtp_filter_attach (GSocket * socket, GBytes * filter, GError ** error);
+
+#endif
@@ -0,0 +1,160 @@
+/*
+ * Latency histogram with logarithmic buckets.
+ *
+ * Bucket 0 counts the values below 1 microsecond, bucket i the values
+ * from 2^(i-1) up to 2^i microseconds and the last bucket everything
+ * above. Adding a value is a couple of instructions under an uncontended
+ * lock, so it can be done for every packet on the streaming thread.
+ * Percentiles are reported as the upper limit of the bucket they fall in.
+ */
+
+#include <string.h>
+
+#include "gstrtp-histogram.h"
+
+#define N_BUCKETS 26
+
+struct _GstRtpHistogram
+{
+  GMutex lock;
+  guint64 buckets[N_BUCKETS];
+  guint64 count;
+  GstClockTime sum;
+  GstClockTime max;
+};
+
+GstRtpHistogram *
+gst_rtp_histogram_new (void)
+{
+  GstRtpHistogram *histogram = g_new0 (GstRtpHistogram, 1);
+
+  g_mutex_init (&histogram->lock);
+
+  return histogram;
+}
+
+void
+gst_rtp_histogram_free (GstRtpHistogram * histogram)
+{
+  g_mutex_clear (&histogram->lock);
+  g_free (histogram);
+}
+
+static guint
+gst_rtp_histogram_get_bucket (GstClockTime value)
+{
+  guint64 us = value / GST_USECOND;
+
+  if (us == 0)
+    return 0;
+
+  return MIN (g_bit_storage (us), N_BUCKETS - 1);
+}
+
+/**
+ * gst_rtp_histogram_add:
+ * @histogram: a #GstRtpHistogram
+ * @value: the latency to count
+ *
+ * Count @value in its bucket. Can be called from any thread.
+ */
+void
+gst_rtp_histogram_add (GstRtpHistogram * histogram, GstClockTime value)
+{
+  guint bucket = gst_rtp_histogram_get_bucket (value);
+
+  g_mutex_lock (&histogram->lock);
+  histogram->buckets[bucket]++;
+  histogram->count++;
+  histogram->sum += value;
+  histogram->max = MAX (histogram->max, value);
+  g_mutex_unlock (&histogram->lock);
+}
+
+void
+gst_rtp_histogram_reset (GstRtpHistogram * histogram)
+{
+  g_mutex_lock (&histogram->lock);
+  memset (histogram->buckets, 0, sizeof (histogram->buckets));
+  histogram->count = 0;
+  histogram->sum = 0;
+  histogram->max = 0;
+  g_mutex_unlock (&histogram->lock);
+}
+
+/* Upper limit of the bucket that holds the given fraction of the values */
+static GstClockTime
+gst_rtp_histogram_get_percentile (const guint64 * buckets, guint64 count,
+    GstClockTime max, gdouble fraction)
+{
+  guint64 rank, seen = 0;
+  guint i;
+
+  if (count == 0)
+    return 0;
+
+  rank = MAX ((guint64) (count * fraction + 0.5), 1);
+  for (i = 0; i < N_BUCKETS - 1; i++) {
+    seen += buckets[i];
+    if (seen >= rank)
+      return MIN ((G_GUINT64_CONSTANT (1) << i) * GST_USECOND, max);
+  }
+
+  return max;
+}
+
+/**
+ * gst_rtp_histogram_to_structure:
+ * @histogram: a #GstRtpHistogram
+ *
+ * Returns: a new #GstStructure with name
+ * application/x-rtp-latency-histogram and the following fields:
+ *
+ * - "count" G_TYPE_UINT64: number of values
+ * - "average" G_TYPE_UINT64: average value in nanoseconds
+ * - "max" G_TYPE_UINT64: largest value in nanoseconds
+ * - "p50", "p90", "p99" G_TYPE_UINT64: upper limit in nanoseconds of the
+ *   bucket that contains the percentile
+ * - "buckets" GST_TYPE_ARRAY of G_TYPE_UINT64: number of values per
+ *   bucket, see above for the limits
+ */
+GstStructure *
+gst_rtp_histogram_to_structure (GstRtpHistogram * histogram)
+{
+  guint64 buckets[N_BUCKETS];
+  guint64 count;
+  GstClockTime sum, max;
+  GValue array = G_VALUE_INIT;
+  GValue value = G_VALUE_INIT;
+  GstStructure *s;
+  guint i;
+
+  g_mutex_lock (&histogram->lock);
+  memcpy (buckets, histogram->buckets, sizeof (buckets));
+  count = histogram->count;
+  sum = histogram->sum;
+  max = histogram->max;
+  g_mutex_unlock (&histogram->lock);
+
+  s = gst_structure_new ("application/x-rtp-latency-histogram",
+      "count", G_TYPE_UINT64, count,
+      "average", G_TYPE_UINT64, count > 0 ? sum / count : 0,
+      "max", G_TYPE_UINT64, max,
+      "p50", G_TYPE_UINT64,
+      gst_rtp_histogram_get_percentile (buckets, count, max, 0.50),
+      "p90", G_TYPE_UINT64,
+      gst_rtp_histogram_get_percentile (buckets, count, max, 0.90),
+      "p99", G_TYPE_UINT64,
+      gst_rtp_histogram_get_percentile (buckets, count, max, 0.99), NULL);
+
+  g_value_init (&array, GST_TYPE_ARRAY);
+  g_value_init (&value, G_TYPE_UINT64);
+  for (i = 0; i < N_BUCKETS; i++) {
+    g_value_set_uint64 (&value, buckets[i]);
+    gst_value_array_append_value (&array, &value);
+  }
+  g_value_unset (&value);
+  gst_structure_take_value (s, "buckets", &array);
+
+  return s;
+}
@@ -0,0 +1,18 @@
+#ifndef __GST_RTP_HISTOGRAM_H__
+#define __GST_RTP_HISTOGRAM_H__
+
+#include <gst/gst.h>
+
+typedef struct _GstRtpHistogram GstRtpHistogram;
+
+GstRtpHistogram * gst_rtp_histogram_new (void);
+
+void gst_rtp_histogram_free (GstRtpHistogram * histogram);
+
+void gst_rtp_histogram_add (GstRtpHistogram * histogram, GstClockTime value);
+
+void gst_rtp_histogram_reset (GstRtpHistogram * histogram);
+
+GstStructure * gst_rtp_histogram_to_structure (GstRtpHistogram * histogram);
+
+#endif
@@ -0,0 +1,194 @@
+/*
+ * Process-wide hostname cache with asynchronous lookups.
+ *
+ * Hostnames are looked up with the default #GResolver on a small pool of
+ * threads, so the caller never blocks on DNS. The results are kept for
+ * all users in the process and reused as long as they are younger than
+ * the TTL the caller accepts; GResolver does not report the TTL of
+ * address records, so the callers pass the one they want. Lookups of a
+ * host that is already being looked up wait for the running one instead
+ * of starting another. Failed lookups are not cached.
+ */
+
+#include "gstrtp-resolver.h"
+
+/* Lookups running at the same time */
+#define RESOLVER_THREADS 4
+
+typedef struct
+{
+  GstRtpResolverFunc func;
+  gpointer user_data;
+  GDestroyNotify notify;
+} GstRtpResolverRequest;
+
+typedef struct
+{
+  /* NULL until the first lookup succeeded */
+  GInetAddress *address;
+  gint64 time;
+  /* GstRtpResolverRequest waiting for the running lookup */
+  GSList *pending;
+} GstRtpResolverEntry;
+
+static GMutex cache_lock;
+/* hostname -> GstRtpResolverEntry, protected by cache_lock */
+static GHashTable *cache;
+static GThreadPool *pool;
+
+static void
+gst_rtp_resolver_entry_free (GstRtpResolverEntry * entry)
+{
+  g_clear_object (&entry->address);
+  g_free (entry);
+}
+
+static void
+gst_rtp_resolver_request_done (GstRtpResolverRequest * request,
+    GInetAddress * address, const GError * error)
+{
+  request->func (address, error, request->user_data);
+  if (request->notify)
+    request->notify (request->user_data);
+  g_free (request);
+}
+
+static void
+gst_rtp_resolver_init_unlocked (void)
+{
+  if (cache)
+    return;
+
+  cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+      (GDestroyNotify) gst_rtp_resolver_entry_free);
+}
+
+static void
+gst_rtp_resolver_lookup_thread (gpointer data, gpointer user_data)
+{
+  gchar *host = data;
+  GstRtpResolverEntry *entry;
+  GInetAddress *address = NULL;
+  GResolver *resolver;
+  GError *error = NULL;
+  GSList *pending, *l;
+  GList *results;
+
+  resolver = g_resolver_get_default ();
+  results = g_resolver_lookup_by_name (resolver, host, NULL, &error);
+  g_object_unref (resolver);
+
+  if (results) {
+    address = G_INET_ADDRESS (g_object_ref (results->data));
+    g_resolver_free_addresses (results);
+  }
+
+  g_mutex_lock (&cache_lock);
+  entry = g_hash_table_lookup (cache, host);
+  if (address) {
+    g_clear_object (&entry->address);
+    entry->address = g_object_ref (address);
+    entry->time = g_get_monotonic_time ();
+  }
+  pending = g_slist_reverse (entry->pending);
+  entry->pending = NULL;
+  if (entry->address == NULL)
+    g_hash_table_remove (cache, host);
+  g_mutex_unlock (&cache_lock);
+
+  for (l = pending; l; l = l->next)
+    gst_rtp_resolver_request_done (l->data, address, error);
+  g_slist_free (pending);
+
+  g_clear_object (&address);
+  g_clear_error (&error);
+  g_free (host);
+}
+
+/**
+ * gst_rtp_resolver_lookup_cached:
+ * @host: numeric address or hostname
+ * @ttl: the age in seconds up to which a cached address is used, 0 to
+ *   not use the cache
+ *
+ * Returns: (transfer full): @host converted to an address when it is
+ * numeric, or the address it was resolved to in the last @ttl seconds,
+ * %NULL otherwise.
+ */
+GInetAddress *
+gst_rtp_resolver_lookup_cached (const gchar * host, guint ttl)
+{
+  GstRtpResolverEntry *entry;
+  GInetAddress *address;
+
+  g_return_val_if_fail (host != NULL, NULL);
+
+  address = g_inet_address_new_from_string (host);
+  if (address || ttl == 0)
+    return address;
+
+  g_mutex_lock (&cache_lock);
+  gst_rtp_resolver_init_unlocked ();
+  entry = g_hash_table_lookup (cache, host);
+  if (entry && entry->address
+      && g_get_monotonic_time () - entry->time < ttl * G_USEC_PER_SEC)
+    address = g_object_ref (entry->address);
+  g_mutex_unlock (&cache_lock);
+
+  return address;
+}
+
+/**
+ * gst_rtp_resolver_lookup_async:
+ * @host: numeric address or hostname
+ * @ttl: the age in seconds up to which a cached address is used
+ * @func: called with the result
+ * @user_data: data passed to @func
+ * @notify: (nullable): called with @user_data after @func
+ *
+ * Resolve @host without blocking. @func is called right away when @host
+ * is numeric or cached, otherwise from a resolver thread once the lookup
+ * finished.
+ */
+void
+gst_rtp_resolver_lookup_async (const gchar * host, guint ttl,
+    GstRtpResolverFunc func, gpointer user_data, GDestroyNotify notify)
+{
+  GstRtpResolverRequest *request;
+  GstRtpResolverEntry *entry;
+  GInetAddress *address;
+  gboolean start;
+
+  g_return_if_fail (host != NULL);
+  g_return_if_fail (func != NULL);
+
+  request = g_new0 (GstRtpResolverRequest, 1);
+  request->func = func;
+  request->user_data = user_data;
+  request->notify = notify;
+
+  address = gst_rtp_resolver_lookup_cached (host, ttl);
+  if (address) {
+    gst_rtp_resolver_request_done (request, address, NULL);
+    g_object_unref (address);
+    return;
+  }
+
+  g_mutex_lock (&cache_lock);
+  gst_rtp_resolver_init_unlocked ();
+  if (pool == NULL)
+    pool = g_thread_pool_new (gst_rtp_resolver_lookup_thread, NULL,
+        RESOLVER_THREADS, FALSE, NULL);
+
+  entry = g_hash_table_lookup (cache, host);
+  if (entry == NULL) {
+    entry = g_new0 (GstRtpResolverEntry, 1);
+    g_hash_table_insert (cache, g_strdup (host), entry);
+  }
+  /* Only the first request starts a lookup */
+  start = entry->pending == NULL;
+  entry->pending = g_slist_prepend (entry->pending, request);
+  if (start)
+    g_thread_pool_push (pool, g_strdup (host), NULL);
+  g_mutex_unlock (&cache_lock);
+}
@@ -0,0 +1,16 @@
+#ifndef __GST_RTP_RESOLVER_H__
+#define __GST_RTP_RESOLVER_H__
+
+#include <gio/gio.h>
+#include <gst/gst.h>
+
+/* Called from a resolver thread with the address or the error */
+typedef void (*GstRtpResolverFunc) (GInetAddress * address,
+    const GError * error, gpointer user_data);
+
+GInetAddress * gst_rtp_resolver_lookup_cached (const gchar * host, guint ttl);
+
+void gst_rtp_resolver_lookup_async (const gchar * host, guint ttl,
+    GstRtpResolverFunc func, gpointer user_data, GDestroyNotify notify);
+
+#endif
@@ -0,0 +1,242 @@
+/*
+ * Send-side packet cache for RFC 4588 retransmissions.
+ *
+ * The packets of one stream are kept in a ring in the order they were
+ * sent, so that the oldest one is always the next to go: when the cache
+ * holds more than its byte limit, or when the packet is older than the
+ * time limit compared to the newest packet. The ring doubles when it is
+ * full and never shrinks, it settles at the number of packets the limits
+ * allow.
+ *
+ * The sequence numbers in the ring are increasing, so a request is
+ * normally answered by indexing the ring with the distance to the oldest
+ * sequence number; when the sender skipped sequence numbers, a binary
+ * search over the same distances finds the packet. A sequence number
+ * going backwards starts the ring over, the stream was restarted.
+ *
+ * The cache is not thread-safe, the caller serializes adding and looking
+ * up packets.
+ */
+
+#include "gstrtp-rtxcache.h"
+
+#define INITIAL_CAPACITY 64
+
+typedef struct
+{
+  GstBuffer *buffer;
+  GstClockTime timestamp;
+  gsize size;
+  guint16 seq;
+} GstRtpRtxEntry;
+
+struct _GstRtpRtxCache
+{
+  GstClockTime max_time;
+  gsize max_bytes;
+
+  /* Ring of capacity entries, a power of two, the oldest at head */
+  GstRtpRtxEntry *entries;
+  guint capacity;
+  guint head;
+  guint length;
+
+  gsize bytes;
+  /* Newest timestamp added, the time limit is relative to it */
+  GstClockTime newest;
+};
+
+#define ENTRY(cache,i) \
+    (&(cache)->entries[((cache)->head + (i)) & ((cache)->capacity - 1)])
+
+/**
+ * gst_rtp_rtx_cache_new:
+ * @max_time: how long to keep packets, or 0 for no time limit
+ * @max_bytes: how many bytes of packets to keep, or 0 for no limit
+ *
+ * Returns: (transfer full): a new, empty cache
+ */
+GstRtpRtxCache *
+gst_rtp_rtx_cache_new (GstClockTime max_time, gsize max_bytes)
+{
+  GstRtpRtxCache *cache = g_new0 (GstRtpRtxCache, 1);
+
+  cache->max_time = max_time;
+  cache->max_bytes = max_bytes;
+  cache->capacity = INITIAL_CAPACITY;
+  cache->entries = g_new0 (GstRtpRtxEntry, cache->capacity);
+  cache->newest = GST_CLOCK_TIME_NONE;
+
+  return cache;
+}
+
+void
+gst_rtp_rtx_cache_free (GstRtpRtxCache * cache)
+{
+  gst_rtp_rtx_cache_clear (cache);
+  g_free (cache->entries);
+  g_free (cache);
+}
+
+static void
+gst_rtp_rtx_cache_pop (GstRtpRtxCache * cache)
+{
+  GstRtpRtxEntry *entry = ENTRY (cache, 0);
+
+  cache->bytes -= entry->size;
+  gst_buffer_unref (entry->buffer);
+  entry->buffer = NULL;
+  cache->head = (cache->head + 1) & (cache->capacity - 1);
+  cache->length--;
+}
+
+void
+gst_rtp_rtx_cache_clear (GstRtpRtxCache * cache)
+{
+  while (cache->length > 0)
+    gst_rtp_rtx_cache_pop (cache);
+  cache->head = 0;
+  cache->newest = GST_CLOCK_TIME_NONE;
+}
+
+static void
+gst_rtp_rtx_cache_grow (GstRtpRtxCache * cache)
+{
+  GstRtpRtxEntry *entries;
+  guint i;
+
+  entries = g_new0 (GstRtpRtxEntry, cache->capacity * 2);
+  for (i = 0; i < cache->length; i++)
+    entries[i] = *ENTRY (cache, i);
+
+  g_free (cache->entries);
+  cache->entries = entries;
+  cache->capacity *= 2;
+  cache->head = 0;
+}
+
+/* Drop the oldest packets until @size more bytes fit and the oldest
+ * packet is within the time limit */
+static void
+gst_rtp_rtx_cache_expire (GstRtpRtxCache * cache, gsize size)
+{
+  while (cache->length > 0 && cache->max_bytes > 0
+      && cache->bytes + size > cache->max_bytes)
+    gst_rtp_rtx_cache_pop (cache);
+
+  if (cache->max_time == 0 || !GST_CLOCK_TIME_IS_VALID (cache->newest))
+    return;
+
+  while (cache->length > 0) {
+    GstClockTime timestamp = ENTRY (cache, 0)->timestamp;
+
+    if (GST_CLOCK_TIME_IS_VALID (timestamp)
+        && timestamp + cache->max_time >= cache->newest)
+      break;
+    gst_rtp_rtx_cache_pop (cache);
+  }
+}
+
+/**
+ * gst_rtp_rtx_cache_add:
+ * @cache: the cache
+ * @seq: the sequence number of @buffer
+ * @timestamp: when @buffer was sent, or GST_CLOCK_TIME_NONE
+ * @buffer: (transfer none): the RTP packet
+ *
+ * Keep @buffer for retransmission, dropping the packets that fall out of
+ * the limits. A packet without a timestamp only leaves the cache for the
+ * byte limit or with the packets before it.
+ */
+void
+gst_rtp_rtx_cache_add (GstRtpRtxCache * cache, guint16 seq,
+    GstClockTime timestamp, GstBuffer * buffer)
+{
+  GstRtpRtxEntry *entry;
+  gsize size = gst_buffer_get_size (buffer);
+
+  if (cache->length > 0) {
+    guint16 last = ENTRY (cache, cache->length - 1)->seq;
+
+    /* A duplicate or a restarted stream */
+    if ((guint16) (seq - last) == 0 || (guint16) (seq - last) >= 0x8000)
+      gst_rtp_rtx_cache_clear (cache);
+  }
+
+  /* The ring covers at most half of the sequence numbers, so that their
+   * distances stay increasing */
+  while (cache->length > 0 && (guint16) (seq - ENTRY (cache, 0)->seq) >=
+      0x8000)
+    gst_rtp_rtx_cache_pop (cache);
+
+  if (GST_CLOCK_TIME_IS_VALID (timestamp)
+      && (!GST_CLOCK_TIME_IS_VALID (cache->newest)
+          || timestamp > cache->newest))
+    cache->newest = timestamp;
+
+  gst_rtp_rtx_cache_expire (cache, size);
+  if (cache->length == cache->capacity)
+    gst_rtp_rtx_cache_grow (cache);
+
+  entry = ENTRY (cache, cache->length);
+  entry->buffer = gst_buffer_ref (buffer);
+  entry->timestamp = timestamp;
+  entry->size = size;
+  entry->seq = seq;
+  cache->length++;
+  cache->bytes += size;
+}
+
+/**
+ * gst_rtp_rtx_cache_lookup:
+ * @cache: the cache
+ * @seq: the sequence number to look for
+ *
+ * Returns: (transfer full) (nullable): the packet with @seq, or %NULL if
+ * it is not in the cache (anymore).
+ */
+GstBuffer *
+gst_rtp_rtx_cache_lookup (GstRtpRtxCache * cache, guint16 seq)
+{
+  guint16 first, distance;
+  guint lo, hi;
+
+  if (cache->length == 0)
+    return NULL;
+
+  first = ENTRY (cache, 0)->seq;
+  distance = seq - first;
+
+  /* Without gaps, the packet is at its distance to the oldest one */
+  if (distance < cache->length && ENTRY (cache, distance)->seq == seq)
+    return gst_buffer_ref (ENTRY (cache, distance)->buffer);
+
+  /* Otherwise it is before, the distances only grow faster */
+  lo = 0;
+  hi = MIN ((guint) distance + 1, cache->length);
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+    guint16 d = ENTRY (cache, mid)->seq - first;
+
+    if (d == distance)
+      return gst_buffer_ref (ENTRY (cache, mid)->buffer);
+    if (d < distance)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return NULL;
+}
+
+guint
+gst_rtp_rtx_cache_get_packets (GstRtpRtxCache * cache)
+{
+  return cache->length;
+}
+
+gsize
+gst_rtp_rtx_cache_get_bytes (GstRtpRtxCache * cache)
+{
+  return cache->bytes;
+}
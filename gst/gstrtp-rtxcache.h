@@ -0,0 +1,23 @@
+#ifndef __GST_RTP_RTX_CACHE_H__
+#define __GST_RTP_RTX_CACHE_H__
+
+#include <gst/gst.h>
+
+typedef struct _GstRtpRtxCache GstRtpRtxCache;
+
+GstRtpRtxCache * gst_rtp_rtx_cache_new (GstClockTime max_time, gsize max_bytes);
+
+void gst_rtp_rtx_cache_free (GstRtpRtxCache * cache);
+
+void gst_rtp_rtx_cache_clear (GstRtpRtxCache * cache);
+
+void gst_rtp_rtx_cache_add (GstRtpRtxCache * cache, guint16 seq,
+    GstClockTime timestamp, GstBuffer * buffer);
+
+GstBuffer * gst_rtp_rtx_cache_lookup (GstRtpRtxCache * cache, guint16 seq);
+
+guint gst_rtp_rtx_cache_get_packets (GstRtpRtxCache * cache);
+
+gsize gst_rtp_rtx_cache_get_bytes (GstRtpRtxCache * cache);
+
+#endif
@@ -0,0 +1,225 @@
+/*
+ * Socket options of the RTP bins.
+ *
+ * The bins take the options as properties, also through the URI query,
+ * and apply them to the sockets of their internal elements when those are
+ * opened; nrtp_recvsrc and nrtp_sendsink get them as a structure. After
+ * setting, the effective values are read back from the kernel and
+ * logged, the kernel doubles the buffer sizes and clamps them to
+ * net.core.rmem_max and net.core.wmem_max unless the process has
+ * CAP_NET_ADMIN.
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include "gstrtp-sockopt.h"
+
+/**
+ * gst_rtp_socket_options_init:
+ * @opts: the options
+ *
+ * Leave all options at the system default.
+ */
+void
+gst_rtp_socket_options_init (GstRtpSocketOptions * opts)
+{
+  opts->buffer_size = -1;
+  opts->busy_poll = -1;
+  opts->priority = -1;
+  opts->dscp = -1;
+  opts->incoming_cpu = -1;
+}
+
+/**
+ * gst_rtp_socket_options_is_set:
+ * @opts: the options
+ *
+ * Returns: %TRUE if any option is changed from the system default.
+ */
+gboolean
+gst_rtp_socket_options_is_set (const GstRtpSocketOptions * opts)
+{
+  return opts->buffer_size >= 0 || opts->busy_poll >= 0
+      || opts->priority >= 0 || opts->dscp >= 0 || opts->incoming_cpu >= 0;
+}
+
+/**
+ * gst_rtp_socket_options_to_structure:
+ * @opts: the options
+ *
+ * Returns: (transfer full): @opts as a structure for the socket-options
+ * property of nrtp_recvsrc and nrtp_sendsink.
+ */
+GstStructure *
+gst_rtp_socket_options_to_structure (const GstRtpSocketOptions * opts)
+{
+  return gst_structure_new (GST_RTP_SOCKET_OPTIONS_STRUCTURE,
+      "buffer-size", G_TYPE_INT, opts->buffer_size,
+      "busy-poll", G_TYPE_INT, opts->busy_poll,
+      "priority", G_TYPE_INT, opts->priority,
+      "dscp", G_TYPE_INT, opts->dscp,
+      "incoming-cpu", G_TYPE_INT, opts->incoming_cpu, NULL);
+}
+
+/**
+ * gst_rtp_socket_options_from_structure:
+ * @opts: the options to fill in
+ * @s: (nullable): a structure from gst_rtp_socket_options_to_structure()
+ *
+ * Options missing from @s are left at the system default.
+ */
+void
+gst_rtp_socket_options_from_structure (GstRtpSocketOptions * opts,
+    const GstStructure * s)
+{
+  gst_rtp_socket_options_init (opts);
+  if (s == NULL)
+    return;
+
+  gst_structure_get_int (s, "buffer-size", &opts->buffer_size);
+  gst_structure_get_int (s, "busy-poll", &opts->busy_poll);
+  gst_structure_get_int (s, "priority", &opts->priority);
+  gst_structure_get_int (s, "dscp", &opts->dscp);
+  gst_structure_get_int (s, "incoming-cpu", &opts->incoming_cpu);
+}
+
+static void
+gst_rtp_socket_options_set (GstObject * obj, GSocket * socket, gint level,
+    gint optname, const gchar * name, gint value)
+{
+  GError *error = NULL;
+
+  if (!g_socket_set_option (socket, level, optname, value, &error)) {
+    GST_WARNING_OBJECT (obj, "Could not set %s to %d: %s", name, value,
+        error->message);
+    g_clear_error (&error);
+  }
+}
+
+/* The effective value as a string for the log, "-" if unknown */
+static void
+gst_rtp_socket_options_append (GString * str, GSocket * socket, gint level,
+    gint optname, const gchar * name)
+{
+  gint value;
+
+  if (g_socket_get_option (socket, level, optname, &value, NULL))
+    g_string_append_printf (str, " %s=%d", name, value);
+  else
+    g_string_append_printf (str, " %s=-", name);
+}
+
+/**
+ * gst_rtp_socket_options_apply:
+ * @obj: the element the socket belongs to, for logging
+ * @socket: the socket
+ * @opts: the options
+ * @send: %TRUE to size the send buffer, %FALSE for the receive buffer
+ *
+ * Set the options of @opts that are not left at the system default on
+ * @socket and log the values that are in effect afterwards. Options that
+ * the system does not support are skipped with a warning.
+ */
+void
+gst_rtp_socket_options_apply (GstObject * obj, GSocket * socket,
+    const GstRtpSocketOptions * opts, gboolean send)
+{
+  gint buf_opt = send ? SO_SNDBUF : SO_RCVBUF;
+  const gchar *buf_name = send ? "SO_SNDBUF" : "SO_RCVBUF";
+  GString *str;
+
+  g_return_if_fail (G_IS_SOCKET (socket));
+
+  if (!gst_rtp_socket_options_is_set (opts))
+    return;
+
+  if (opts->buffer_size >= 0) {
+    gst_rtp_socket_options_set (obj, socket, SOL_SOCKET, buf_opt, buf_name,
+        opts->buffer_size);
+#if defined (SO_RCVBUFFORCE) && defined (SO_SNDBUFFORCE)
+    {
+      gint value = 0;
+
+      /* The kernel reports twice the size it was given. When it was
+       * clamped to the system maximum, forcing works with CAP_NET_ADMIN. */
+      if (g_socket_get_option (socket, SOL_SOCKET, buf_opt, &value, NULL)
+          && value / 2 < opts->buffer_size
+          && !g_socket_set_option (socket, SOL_SOCKET,
+              send ? SO_SNDBUFFORCE : SO_RCVBUFFORCE, opts->buffer_size,
+              NULL))
+        GST_WARNING_OBJECT (obj, "%s is limited to %d bytes by the system, "
+            "raise net.core.%s", buf_name, value / 2,
+            send ? "wmem_max" : "rmem_max");
+    }
+#endif
+  }
+
+  if (opts->busy_poll >= 0) {
+#ifdef SO_BUSY_POLL
+    gst_rtp_socket_options_set (obj, socket, SOL_SOCKET, SO_BUSY_POLL,
+        "SO_BUSY_POLL", opts->busy_poll);
+#else
+    GST_WARNING_OBJECT (obj, "SO_BUSY_POLL is not supported");
+#endif
+  }
+
+  if (opts->priority >= 0) {
+#ifdef SO_PRIORITY
+    gst_rtp_socket_options_set (obj, socket, SOL_SOCKET, SO_PRIORITY,
+        "SO_PRIORITY", opts->priority);
+#else
+    GST_WARNING_OBJECT (obj, "SO_PRIORITY is not supported");
+#endif
+  }
+
+  /* The DSCP is in the upper six bits of the TOS or traffic class */
+  if (opts->dscp >= 0) {
+    if (g_socket_get_family (socket) == G_SOCKET_FAMILY_IPV6) {
+#ifdef IPV6_TCLASS
+      gst_rtp_socket_options_set (obj, socket, IPPROTO_IPV6, IPV6_TCLASS,
+          "IPV6_TCLASS", opts->dscp << 2);
+#else
+      GST_WARNING_OBJECT (obj, "IPV6_TCLASS is not supported");
+#endif
+    } else {
+      gst_rtp_socket_options_set (obj, socket, IPPROTO_IP, IP_TOS, "IP_TOS",
+          opts->dscp << 2);
+    }
+  }
+
+  if (opts->incoming_cpu >= 0) {
+#ifdef SO_INCOMING_CPU
+    gst_rtp_socket_options_set (obj, socket, SOL_SOCKET, SO_INCOMING_CPU,
+        "SO_INCOMING_CPU", opts->incoming_cpu);
+#else
+    GST_WARNING_OBJECT (obj, "SO_INCOMING_CPU is not supported");
+#endif
+  }
+
+  str = g_string_new ("Socket options in effect:");
+  gst_rtp_socket_options_append (str, socket, SOL_SOCKET, buf_opt, buf_name);
+#ifdef SO_BUSY_POLL
+  gst_rtp_socket_options_append (str, socket, SOL_SOCKET, SO_BUSY_POLL,
+      "SO_BUSY_POLL");
+#endif
+#ifdef SO_PRIORITY
+  gst_rtp_socket_options_append (str, socket, SOL_SOCKET, SO_PRIORITY,
+      "SO_PRIORITY");
+#endif
+  if (g_socket_get_family (socket) == G_SOCKET_FAMILY_IPV6) {
+#ifdef IPV6_TCLASS
+    gst_rtp_socket_options_append (str, socket, IPPROTO_IPV6, IPV6_TCLASS,
+        "IPV6_TCLASS");
+#endif
+  } else {
+    gst_rtp_socket_options_append (str, socket, IPPROTO_IP, IP_TOS, "IP_TOS");
+  }
+#ifdef SO_INCOMING_CPU
+  gst_rtp_socket_options_append (str, socket, SOL_SOCKET, SO_INCOMING_CPU,
+      "SO_INCOMING_CPU");
+#endif
+  GST_INFO_OBJECT (obj, "%s", str->str);
+  g_string_free (str, TRUE);
+}
@@ -0,0 +1,33 @@
+#ifndef __GST_RTP_SOCKOPT_H__
+#define __GST_RTP_SOCKOPT_H__
+
+#include <gio/gio.h>
+#include <gst/gst.h>
+
+/* Tuning of the sockets of the bins, -1 leaves an option at the system
+ * default. The buffer size is SO_RCVBUF for receiving sockets and
+ * SO_SNDBUF for sending ones. */
+typedef struct
+{
+  gint buffer_size;
+  gint busy_poll;
+  gint priority;
+  gint dscp;
+  gint incoming_cpu;
+} GstRtpSocketOptions;
+
+#define GST_RTP_SOCKET_OPTIONS_STRUCTURE "application/x-rtp-socket-options"
+
+void gst_rtp_socket_options_init (GstRtpSocketOptions * opts);
+
+gboolean gst_rtp_socket_options_is_set (const GstRtpSocketOptions * opts);
+
+GstStructure * gst_rtp_socket_options_to_structure (const GstRtpSocketOptions * opts);
+
+void gst_rtp_socket_options_from_structure (GstRtpSocketOptions * opts,
+    const GstStructure * s);
+
+void gst_rtp_socket_options_apply (GstObject * obj, GSocket * socket,
+    const GstRtpSocketOptions * opts, gboolean send);
+
+#endif
@@ -0,0 +1,564 @@
+/*
+ * Per-SSRC packet statistics.
+ *
+ * The streaming threads update the counters of every packet and a
+ * monitoring thread may read them at any time, so neither side takes a
+ * lock on the data path. Sources are looked up in an immutable snapshot
+ * behind an atomic pointer; only adding or removing an SSRC takes the
+ * lock to publish a copy of the snapshot. Readers announce themselves to
+ * a GstRtpEpoch, which frees the replaced snapshots and the removed
+ * sources once no reader can use them anymore.
+ *
+ * A source is only updated by the streaming thread of its session, so
+ * its 64-bit counters are a GstRtpCounters owned by that thread, which
+ * the monitoring thread reads without tearing them on 32-bit targets. The
+ * sequence number and jitter state is only touched by that thread too.
+ */
+
+#include <string.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#ifdef __linux__
+#include <linux/sock_diag.h>
+#endif
+
+#include <gst/rtp/gstrtppayloads.h>
+
+#include "gstrtp-stats.h"
+#include "gstrtp-counters.h"
+#include "gstrtp-epoch.h"
+
+/* Number of sequence numbers below the highest one that are tracked to
+ * tell duplicates from reordered packets */
+#define SEQ_WINDOW 64
+
+enum
+{
+  SOURCE_PACKETS,
+  SOURCE_BYTES,
+  SOURCE_LOST,
+  SOURCE_REORDERED,
+  SOURCE_DUPLICATES,
+  SOURCE_JITTER,
+  /* The jitter in microseconds, for comparing sources of any clock rate */
+  SOURCE_JITTER_US,
+  N_SOURCE_COUNTERS
+};
+
+typedef struct
+{
+  guint session;
+  guint32 ssrc;
+
+  /* Written by the streaming thread only */
+  GstRtpCounters *counters;
+
+  /* Only used by the streaming thread */
+  guint32 jitter;
+  guint clock_rate;
+  gboolean pt_checked;
+  gboolean have_seq;
+  guint32 base_seq;
+  guint32 max_seq;
+  guint64 window;
+  guint32 unique;
+  gboolean have_transit;
+  gint32 transit;
+  guint32 jitter_q4;
+} GstRtpStatsSource;
+
+typedef struct
+{
+  /* Sorted on session and ssrc */
+  GstRtpStatsSource **sources;
+  guint n_sources;
+} GstRtpStatsSnapshot;
+
+struct _GstRtpStats
+{
+  gboolean receiving;
+  GstRtpStatsSnapshot *current;
+  GstRtpEpoch *epoch;
+
+  /* Serializes adding and removing sources, protects sockets and the
+   * totals */
+  GMutex lock;
+  /* GSocket per session id, to read the socket drops from */
+  GHashTable *sockets;
+  /* What the removed sources counted */
+  guint64 packets;
+  guint64 bytes;
+  guint64 lost;
+};
+
+static void
+gst_rtp_stats_source_free (GstRtpStatsSource * source)
+{
+  gst_rtp_counters_free (source->counters);
+  g_free (source);
+}
+
+static void
+gst_rtp_stats_snapshot_free (GstRtpStatsSnapshot * snapshot)
+{
+  g_free (snapshot->sources);
+  g_free (snapshot);
+}
+
+/**
+ * gst_rtp_stats_new:
+ * @receiving: whether the packets are received
+ *
+ * Create statistics for sent or received packets. Only received packets
+ * are tracked for loss, reordering, duplicates and jitter.
+ *
+ * Returns: a new #GstRtpStats
+ */
+GstRtpStats *
+gst_rtp_stats_new (gboolean receiving)
+{
+  GstRtpStats *stats = g_new0 (GstRtpStats, 1);
+
+  stats->receiving = receiving;
+  stats->current = g_new0 (GstRtpStatsSnapshot, 1);
+  stats->epoch = gst_rtp_epoch_new ();
+  g_mutex_init (&stats->lock);
+  stats->sockets = g_hash_table_new_full (NULL, NULL, NULL, g_object_unref);
+
+  return stats;
+}
+
+void
+gst_rtp_stats_free (GstRtpStats * stats)
+{
+  guint i;
+
+  for (i = 0; i < stats->current->n_sources; i++)
+    gst_rtp_stats_source_free (stats->current->sources[i]);
+  gst_rtp_stats_snapshot_free (stats->current);
+  gst_rtp_epoch_free (stats->epoch);
+  g_hash_table_unref (stats->sockets);
+  g_mutex_clear (&stats->lock);
+  g_free (stats);
+}
+
+/**
+ * gst_rtp_stats_set_socket:
+ * @stats: a #GstRtpStats
+ * @session: the session id
+ * @socket: (nullable): the socket the session receives on
+ *
+ * Report the packets the kernel dropped on @socket because its receive
+ * buffer was full as the socket drops of @stats.
+ */
+void
+gst_rtp_stats_set_socket (GstRtpStats * stats, guint session,
+    GSocket * socket)
+{
+  g_mutex_lock (&stats->lock);
+  if (socket)
+    g_hash_table_insert (stats->sockets, GUINT_TO_POINTER (session),
+        g_object_ref (socket));
+  else
+    g_hash_table_remove (stats->sockets, GUINT_TO_POINTER (session));
+  g_mutex_unlock (&stats->lock);
+}
+
+static guint64
+gst_rtp_stats_source_key (guint session, guint32 ssrc)
+{
+  return ((guint64) session << 32) | ssrc;
+}
+
+/* Index of the source, or of the position to insert it at */
+static guint
+gst_rtp_stats_snapshot_find (const GstRtpStatsSnapshot * snapshot,
+    guint64 key, gboolean * found)
+{
+  guint lo = 0, hi = snapshot->n_sources;
+
+  while (lo < hi) {
+    guint mid = (lo + hi) / 2;
+    GstRtpStatsSource *source = snapshot->sources[mid];
+    guint64 mid_key = gst_rtp_stats_source_key (source->session,
+        source->ssrc);
+
+    if (mid_key == key) {
+      *found = TRUE;
+      return mid;
+    }
+    if (mid_key < key)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  *found = FALSE;
+  return lo;
+}
+
+static GstRtpStatsSource *
+gst_rtp_stats_add_source (GstRtpStats * stats, guint session, guint32 ssrc)
+{
+  GstRtpStatsSnapshot *snapshot, *copy;
+  GstRtpStatsSource *source;
+  gboolean found;
+  guint idx;
+
+  g_mutex_lock (&stats->lock);
+  snapshot = stats->current;
+  idx = gst_rtp_stats_snapshot_find (snapshot,
+      gst_rtp_stats_source_key (session, ssrc), &found);
+  if (found) {
+    /* Added by another thread in the meantime */
+    source = snapshot->sources[idx];
+    g_mutex_unlock (&stats->lock);
+    return source;
+  }
+
+  source = g_new0 (GstRtpStatsSource, 1);
+  source->session = session;
+  source->ssrc = ssrc;
+  source->counters = gst_rtp_counters_new (N_SOURCE_COUNTERS);
+
+  copy = g_new0 (GstRtpStatsSnapshot, 1);
+  copy->n_sources = snapshot->n_sources + 1;
+  copy->sources = g_new (GstRtpStatsSource *, copy->n_sources);
+  memcpy (copy->sources, snapshot->sources,
+      idx * sizeof (GstRtpStatsSource *));
+  copy->sources[idx] = source;
+  memcpy (copy->sources + idx + 1, snapshot->sources + idx,
+      (snapshot->n_sources - idx) * sizeof (GstRtpStatsSource *));
+
+  g_atomic_pointer_set (&stats->current, copy);
+  gst_rtp_epoch_retire (stats->epoch, snapshot,
+      (GDestroyNotify) gst_rtp_stats_snapshot_free);
+  g_mutex_unlock (&stats->lock);
+
+  return source;
+}
+
+/**
+ * gst_rtp_stats_remove_source:
+ * @stats: a #GstRtpStats
+ * @session: the session id
+ * @ssrc: the SSRC that left
+ *
+ * Forget @ssrc, after a BYE or a timeout. What it counted stays in the
+ * totals. When it sends again, it is counted as a new source.
+ */
+void
+gst_rtp_stats_remove_source (GstRtpStats * stats, guint session,
+    guint32 ssrc)
+{
+  GstRtpStatsSnapshot *snapshot, *copy;
+  GstRtpStatsSource *source;
+  guint64 counters[N_SOURCE_COUNTERS];
+  gboolean found;
+  guint idx;
+
+  g_mutex_lock (&stats->lock);
+  snapshot = stats->current;
+  idx = gst_rtp_stats_snapshot_find (snapshot,
+      gst_rtp_stats_source_key (session, ssrc), &found);
+  if (!found) {
+    g_mutex_unlock (&stats->lock);
+    return;
+  }
+  source = snapshot->sources[idx];
+
+  copy = g_new0 (GstRtpStatsSnapshot, 1);
+  copy->n_sources = snapshot->n_sources - 1;
+  copy->sources = g_new (GstRtpStatsSource *, MAX (copy->n_sources, 1));
+  memcpy (copy->sources, snapshot->sources,
+      idx * sizeof (GstRtpStatsSource *));
+  memcpy (copy->sources + idx, snapshot->sources + idx + 1,
+      (copy->n_sources - idx) * sizeof (GstRtpStatsSource *));
+  g_atomic_pointer_set (&stats->current, copy);
+
+  /* A packet that a streaming thread still counts for the source is
+   * lost from the totals, the source left already */
+  gst_rtp_counters_read (source->counters, counters);
+  stats->packets += counters[SOURCE_PACKETS];
+  stats->bytes += counters[SOURCE_BYTES];
+  stats->lost += counters[SOURCE_LOST];
+
+  gst_rtp_epoch_retire (stats->epoch, snapshot,
+      (GDestroyNotify) gst_rtp_stats_snapshot_free);
+  gst_rtp_epoch_retire (stats->epoch, source,
+      (GDestroyNotify) gst_rtp_stats_source_free);
+  g_mutex_unlock (&stats->lock);
+}
+
+static void
+gst_rtp_stats_source_update_seq (GstRtpStatsSource * source, guint16 seq,
+    gboolean * duplicate)
+{
+  gint16 delta;
+  guint32 expected;
+
+  *duplicate = FALSE;
+
+  if (!source->have_seq) {
+    /* Start one cycle up so that older packets do not wrap below 0 */
+    source->base_seq = source->max_seq = 0x10000 + seq;
+    source->window = 1;
+    source->unique = 1;
+    source->have_seq = TRUE;
+    return;
+  }
+
+  delta = (gint16) (seq - (guint16) source->max_seq);
+  if (delta > 0) {
+    source->max_seq += delta;
+    source->window = delta < SEQ_WINDOW ? source->window << delta : 0;
+    source->window |= 1;
+    source->unique++;
+  } else if (-delta < SEQ_WINDOW) {
+    guint64 bit = G_GUINT64_CONSTANT (1) << -delta;
+
+    if (source->window & bit) {
+      *duplicate = TRUE;
+      gst_rtp_counters_add (source->counters, SOURCE_DUPLICATES, 1);
+      return;
+    }
+    source->window |= bit;
+    source->unique++;
+    gst_rtp_counters_add (source->counters, SOURCE_REORDERED, 1);
+  } else {
+    /* Too old to know whether it is a duplicate */
+    source->unique++;
+    gst_rtp_counters_add (source->counters, SOURCE_REORDERED, 1);
+  }
+
+  expected = source->max_seq - source->base_seq + 1;
+  gst_rtp_counters_set (source->counters, SOURCE_LOST,
+      expected > source->unique ? expected - source->unique : 0);
+}
+
+/* Interarrival jitter as in RFC 3550, A.8, in clock rate units */
+static void
+gst_rtp_stats_source_update_jitter (GstRtpStatsSource * source,
+    GstClockTime arrival, guint32 rtptime)
+{
+  guint32 arrival_ts, jitter;
+  gint32 transit, d;
+
+  arrival_ts = gst_util_uint64_scale_int (arrival, source->clock_rate,
+      GST_SECOND);
+  transit = (gint32) (arrival_ts - rtptime);
+
+  if (source->have_transit) {
+    d = transit - source->transit;
+    if (d < 0)
+      d = -d;
+    source->jitter_q4 += d - ((source->jitter_q4 + 8) >> 4);
+    jitter = source->jitter_q4 >> 4;
+    if (jitter != source->jitter) {
+      source->jitter = jitter;
+      gst_rtp_counters_set (source->counters, SOURCE_JITTER, jitter);
+      gst_rtp_counters_set (source->counters, SOURCE_JITTER_US,
+          gst_util_uint64_scale_int (jitter, G_USEC_PER_SEC,
+              source->clock_rate));
+    }
+  }
+
+  source->transit = transit;
+  source->have_transit = TRUE;
+}
+
+/**
+ * gst_rtp_stats_add_buffer:
+ * @stats: a #GstRtpStats
+ * @session: the session id the packet belongs to
+ * @buffer: an RTP packet
+ * @clock_rate: the clock rate of the stream, or 0 if unknown
+ *
+ * Count @buffer for its SSRC. For received packets, the buffer timestamp
+ * is taken as the arrival time for the jitter. When @clock_rate is 0,
+ * the clock rate of a static payload type is used.
+ */
+void
+gst_rtp_stats_add_buffer (GstRtpStats * stats, guint session,
+    GstBuffer * buffer, guint clock_rate)
+{
+  GstRtpStatsSnapshot *snapshot;
+  GstRtpStatsSource *source;
+  GstClockTime arrival;
+  guint8 header[12];
+  gboolean found, duplicate;
+  guint64 key;
+  guint idx, token;
+  guint8 pt;
+
+  if (gst_buffer_extract (buffer, 0, header, sizeof (header)) <
+      sizeof (header) || (header[0] >> 6) != 2)
+    return;
+
+  pt = header[1] & 0x7f;
+  /* RTCP multiplexed on the RTP port (RFC 5761) */
+  if (pt >= 72 && pt <= 76)
+    return;
+
+  key = gst_rtp_stats_source_key (session, GST_READ_UINT32_BE (header + 8));
+  token = gst_rtp_epoch_read_begin (stats->epoch);
+  snapshot = g_atomic_pointer_get (&stats->current);
+  idx = gst_rtp_stats_snapshot_find (snapshot, key, &found);
+  if (G_LIKELY (found))
+    source = snapshot->sources[idx];
+  else
+    source = gst_rtp_stats_add_source (stats, session,
+        GST_READ_UINT32_BE (header + 8));
+
+  gst_rtp_counters_add (source->counters, SOURCE_PACKETS, 1);
+  gst_rtp_counters_add (source->counters, SOURCE_BYTES,
+      gst_buffer_get_size (buffer));
+
+  if (!stats->receiving)
+    goto done;
+
+  gst_rtp_stats_source_update_seq (source, GST_READ_UINT16_BE (header + 2),
+      &duplicate);
+  if (duplicate)
+    goto done;
+
+  if (clock_rate > 0) {
+    source->clock_rate = clock_rate;
+  } else if (source->clock_rate == 0 && !source->pt_checked) {
+    const GstRTPPayloadInfo *info = gst_rtp_payload_info_for_pt (pt);
+
+    if (info)
+      source->clock_rate = info->clock_rate;
+    source->pt_checked = TRUE;
+  }
+
+  arrival = GST_BUFFER_PTS (buffer);
+  if (source->clock_rate > 0 && GST_CLOCK_TIME_IS_VALID (arrival))
+    gst_rtp_stats_source_update_jitter (source, arrival,
+        GST_READ_UINT32_BE (header + 4));
+
+done:
+  gst_rtp_epoch_read_end (stats->epoch, token);
+}
+
+static guint64
+gst_rtp_stats_get_socket_drops (GSocket * socket)
+{
+#if defined (__linux__) && defined (SO_MEMINFO)
+  guint32 meminfo[SK_MEMINFO_VARS];
+  socklen_t len = sizeof (meminfo);
+
+  if (getsockopt (g_socket_get_fd (socket), SOL_SOCKET, SO_MEMINFO, meminfo,
+          &len) == 0 && len > SK_MEMINFO_DROPS * sizeof (guint32))
+    return meminfo[SK_MEMINFO_DROPS];
+#endif
+
+  return 0;
+}
+
+/**
+ * gst_rtp_stats_get_structure:
+ * @stats: a #GstRtpStats
+ * @name: the name of the structure
+ *
+ * Returns: a new #GstStructure with the totals "packets" and "bytes" as
+ * G_TYPE_UINT64, for received packets also "lost" and "socket-drops",
+ * and "sources", a GST_TYPE_ARRAY with an
+ * application/x-rtp-source-stats structure per SSRC that was not
+ * removed. The totals include the removed sources.
+ */
+GstStructure *
+gst_rtp_stats_get_structure (GstRtpStats * stats, const gchar * name)
+{
+  GstRtpStatsSnapshot *snapshot;
+  GValue sources = G_VALUE_INIT;
+  GValue value = G_VALUE_INIT;
+  guint64 counters[N_SOURCE_COUNTERS];
+  guint64 packets, bytes, lost, drops = 0;
+  GHashTableIter iter;
+  gpointer socket;
+  GstStructure *s;
+  guint i, token;
+
+  g_value_init (&sources, GST_TYPE_ARRAY);
+
+  /* The sources that were removed are either in the totals or in the
+   * snapshot, not in both */
+  g_mutex_lock (&stats->lock);
+  packets = stats->packets;
+  bytes = stats->bytes;
+  lost = stats->lost;
+  token = gst_rtp_epoch_read_begin (stats->epoch);
+  snapshot = g_atomic_pointer_get (&stats->current);
+  g_mutex_unlock (&stats->lock);
+
+  for (i = 0; i < snapshot->n_sources; i++) {
+    GstRtpStatsSource *source = snapshot->sources[i];
+    GstStructure *ss;
+
+    gst_rtp_counters_read (source->counters, counters);
+    ss = gst_structure_new ("application/x-rtp-source-stats",
+        "session", G_TYPE_UINT, source->session,
+        "ssrc", G_TYPE_UINT, source->ssrc,
+        "packets", G_TYPE_UINT64, counters[SOURCE_PACKETS],
+        "bytes", G_TYPE_UINT64, counters[SOURCE_BYTES], NULL);
+    packets += counters[SOURCE_PACKETS];
+    bytes += counters[SOURCE_BYTES];
+
+    if (stats->receiving) {
+      gst_structure_set (ss,
+          "lost", G_TYPE_UINT64, counters[SOURCE_LOST],
+          "reordered", G_TYPE_UINT64, counters[SOURCE_REORDERED],
+          "duplicates", G_TYPE_UINT64, counters[SOURCE_DUPLICATES],
+          "jitter", G_TYPE_UINT, (guint) counters[SOURCE_JITTER], NULL);
+      lost += counters[SOURCE_LOST];
+    }
+
+    g_value_init (&value, GST_TYPE_STRUCTURE);
+    g_value_take_boxed (&value, ss);
+    gst_value_array_append_and_take_value (&sources, &value);
+  }
+  gst_rtp_epoch_read_end (stats->epoch, token);
+
+  s = gst_structure_new (name,
+      "packets", G_TYPE_UINT64, packets, "bytes", G_TYPE_UINT64, bytes, NULL);
+
+  if (stats->receiving) {
+    g_mutex_lock (&stats->lock);
+    g_hash_table_iter_init (&iter, stats->sockets);
+    while (g_hash_table_iter_next (&iter, NULL, &socket))
+      drops += gst_rtp_stats_get_socket_drops (socket);
+    g_mutex_unlock (&stats->lock);
+
+    gst_structure_set (s, "lost", G_TYPE_UINT64, lost,
+        "socket-drops", G_TYPE_UINT64, drops, NULL);
+  }
+
+  gst_structure_take_value (s, "sources", &sources);
+
+  return s;
+}
+
+/**
+ * gst_rtp_stats_get_max_jitter:
+ * @stats: a #GstRtpStats of received packets
+ *
+ * Returns: the largest interarrival jitter of all sources.
+ */
+GstClockTime
+gst_rtp_stats_get_max_jitter (GstRtpStats * stats)
+{
+  GstRtpStatsSnapshot *snapshot;
+  guint64 jitter = 0;
+  guint i, token;
+
+  token = gst_rtp_epoch_read_begin (stats->epoch);
+  snapshot = g_atomic_pointer_get (&stats->current);
+  for (i = 0; i < snapshot->n_sources; i++)
+    jitter = MAX (jitter, gst_rtp_counters_get (snapshot->sources[i]->counters,
+            SOURCE_JITTER_US));
+  gst_rtp_epoch_read_end (stats->epoch, token);
+
+  return jitter * GST_USECOND;
+}
@@ -0,0 +1,23 @@
+#ifndef __GST_RTP_STATS_H__
+#define __GST_RTP_STATS_H__
+
+#include <gio/gio.h>
+#include <gst/gst.h>
+
+typedef struct _GstRtpStats GstRtpStats;
+
+GstRtpStats * gst_rtp_stats_new (gboolean receiving);
+
+void gst_rtp_stats_free (GstRtpStats * stats);
+
+void gst_rtp_stats_set_socket (GstRtpStats * stats, guint session, GSocket * socket);
+
+void gst_rtp_stats_remove_source (GstRtpStats * stats, guint session, guint32 ssrc);
+
+void gst_rtp_stats_add_buffer (GstRtpStats * stats, guint session, GstBuffer * buffer, guint clock_rate);
+
+GstStructure * gst_rtp_stats_get_structure (GstRtpStats * stats, const gchar * name);
+
+GstClockTime gst_rtp_stats_get_max_jitter (GstRtpStats * stats);
+
+#endif
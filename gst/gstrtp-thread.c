@@ -0,0 +1,136 @@
+/*
+ * Placement and scheduling of streaming threads.
+ *
+ * The bins pin the threads of their internal elements to a set of CPUs
+ * and optionally run them with the SCHED_FIFO policy, so that the
+ * receive and send paths keep their caches and are not preempted by
+ * other work on dedicated cores. Threads announce themselves with a
+ * stream-status message of type GST_STREAM_STATUS_TYPE_ENTER, which is
+ * handled synchronously in the thread that posted it, so the settings
+ * are applied to the calling thread.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "gstrtp-thread.h"
+
+#ifdef __linux__
+#define MAX_CPUS CPU_SETSIZE
+#else
+#define MAX_CPUS 1024
+#endif
+
+/**
+ * gst_rtp_thread_parse_cpus:
+ * @str: comma separated list of CPU numbers and ranges like "2-5"
+ *
+ * Returns: (transfer full): an array of guint with the CPUs of @str, or
+ * %NULL if an entry is invalid or the list is empty.
+ */
+GArray *
+gst_rtp_thread_parse_cpus (const gchar * str)
+{
+  GArray *cpus = g_array_new (FALSE, FALSE, sizeof (guint));
+  gchar **entries;
+  guint i;
+
+  entries = g_strsplit (str, ",", -1);
+  for (i = 0; entries[i]; i++) {
+    guint64 first, last;
+    gchar *end;
+    guint cpu;
+
+    g_strstrip (entries[i]);
+    if (entries[i][0] == '\0')
+      continue;
+
+    first = g_ascii_strtoull (entries[i], &end, 10);
+    if (end == entries[i])
+      goto invalid;
+    last = first;
+    if (*end == '-') {
+      gchar *start = end + 1;
+
+      last = g_ascii_strtoull (start, &end, 10);
+      if (end == start)
+        goto invalid;
+    }
+    if (*end != '\0' || first > last || last >= MAX_CPUS)
+      goto invalid;
+
+    for (cpu = first; cpu <= last; cpu++)
+      g_array_append_val (cpus, cpu);
+  }
+  g_strfreev (entries);
+
+  if (cpus->len == 0) {
+    g_array_unref (cpus);
+    return NULL;
+  }
+
+  return cpus;
+
+invalid:
+  g_strfreev (entries);
+  g_array_unref (cpus);
+  return NULL;
+}
+
+/**
+ * gst_rtp_thread_tune:
+ * @obj: the element the thread belongs to, for logging
+ * @cpus: (nullable): array of guint with the CPUs to run on, %NULL for all
+ * @priority: SCHED_FIFO priority, 0 to keep the scheduling policy
+ *
+ * Pin the calling thread to @cpus and give it the real-time @priority.
+ * Failures, typically a missing CAP_SYS_NICE for the priority, only
+ * produce a warning and leave the thread as it was.
+ */
+void
+gst_rtp_thread_tune (GstObject * obj, GArray * cpus, gint priority)
+{
+#ifdef __linux__
+  gint res;
+
+  if (cpus) {
+    cpu_set_t set;
+    guint i;
+
+    CPU_ZERO (&set);
+    for (i = 0; i < cpus->len; i++)
+      CPU_SET (g_array_index (cpus, guint, i), &set);
+
+    res = pthread_setaffinity_np (pthread_self (), sizeof (set), &set);
+    if (res != 0)
+      GST_WARNING_OBJECT (obj, "Could not set the CPU affinity: %s",
+          g_strerror (res));
+  }
+
+  if (priority > 0) {
+    struct sched_param param;
+
+    memset (&param, 0, sizeof (param));
+    param.sched_priority = MIN (priority, sched_get_priority_max (SCHED_FIFO));
+
+    res = pthread_setschedparam (pthread_self (), SCHED_FIFO, &param);
+    if (res != 0)
+      GST_WARNING_OBJECT (obj, "Could not set real-time priority %d: %s",
+          param.sched_priority, g_strerror (res));
+  }
+
+  GST_DEBUG_OBJECT (obj, "Tuned streaming thread %p", g_thread_self ());
+#else
+  if (cpus || priority > 0)
+    GST_WARNING_OBJECT (obj, "CPU affinity and real-time priority are not "
+        "supported");
+#endif
+}
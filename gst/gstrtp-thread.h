@@ -0,0 +1,13 @@
+#ifndef __GST_RTP_THREAD_H__
+#define __GST_RTP_THREAD_H__
+
+#include <gst/gst.h>
+
+/* Highest SCHED_FIFO priority that can be requested */
+#define GST_RTP_THREAD_MAX_PRIORITY 99
+
+GArray * gst_rtp_thread_parse_cpus (const gchar * str);
+
+void gst_rtp_thread_tune (GstObject * obj, GArray * cpus, gint priority);
+
+#endif
@@ -0,0 +1,563 @@
+/*
+ * io_uring receive engine.
+ *
+ * A single multishot recvmsg request stays armed on the socket and the
+ * kernel picks a buffer from a provided buffer ring for every datagram it
+ * completes. The streaming thread only reaps completions from shared
+ * memory and enters the kernel when the completion queue is empty, so a
+ * busy socket is read without any system call per packet.
+ *
+ * Each ring buffer starts with the struct io_uring_recvmsg_out header,
+ * followed by the sender address, the control messages and the payload.
+ * The payload is wrapped in a GstMemory without copying; when downstream
+ * frees it the buffer is handed back to the kernel. Buffers are returned
+ * from arbitrary threads, so the producer side of the buffer ring is
+ * protected by a mutex, and every outstanding buffer keeps the engine
+ * alive until it is released.
+ *
+ * When downstream holds on to all buffers, the kernel ends the multishot
+ * request with ENOBUFS and the datagrams stay in the socket buffer. The
+ * request is armed again once a buffer is released.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <errno.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+#include "gstrtp-uring.h"
+
+#ifdef HAVE_LIBURING
+
+#define QUEUE_DEPTH     8
+#define BUFFER_GROUP    0
+#define RECV_TAG        1
+#define CANCEL_TAG      2
+/* Room for the ancillary data of one packet */
+#define CONTROL_SIZE    64
+/* Largest buffer ring the kernel accepts */
+#define MAX_BUFFERS     32768
+/* Blocking waits wake up this often to check for cancellation */
+#define WAIT_TIMEOUT    (50 * GST_MSECOND)
+
+typedef struct
+{
+  GstRtpUring *uring;
+  guint16 bid;
+} GstRtpUringSlot;
+
+struct _GstRtpUring
+{
+  gint refcount;
+
+  struct io_uring ring;
+  struct io_uring_buf_ring *buf_ring;
+  gint fd;
+  /* Template of the multishot request, only the sizes of the name and the
+   * control area are used */
+  struct msghdr msg;
+  gboolean armed;
+
+  guint n_buffers;
+  guint buffer_size;
+  guint8 *memory;
+  GstRtpUringSlot *slots;
+
+  /* Protects the tail of the buffer ring and the counters below */
+  GMutex lock;
+  GCond cond;
+  guint available;
+  guint64 syscalls;
+  guint64 overruns;
+};
+
+static void
+gst_rtp_uring_unref (GstRtpUring * uring)
+{
+  if (!g_atomic_int_dec_and_test (&uring->refcount))
+    return;
+
+  if (uring->buf_ring)
+    io_uring_free_buf_ring (&uring->ring, uring->buf_ring, uring->n_buffers,
+        BUFFER_GROUP);
+  io_uring_queue_exit (&uring->ring);
+
+  g_mutex_clear (&uring->lock);
+  g_cond_clear (&uring->cond);
+  g_free (uring->memory);
+  g_free (uring->slots);
+  g_free (uring);
+}
+
+/* Hand a buffer back to the kernel, with the lock held */
+static void
+gst_rtp_uring_recycle (GstRtpUring * uring, guint16 bid)
+{
+  io_uring_buf_ring_add (uring->buf_ring,
+      uring->memory + (gsize) bid * uring->buffer_size, uring->buffer_size,
+      bid, io_uring_buf_ring_mask (uring->n_buffers), 0);
+  io_uring_buf_ring_advance (uring->buf_ring, 1);
+  uring->available++;
+}
+
+/* Called when downstream frees the memory of a packet */
+static void
+gst_rtp_uring_release (GstRtpUringSlot * slot)
+{
+  GstRtpUring *uring = slot->uring;
+
+  g_mutex_lock (&uring->lock);
+  gst_rtp_uring_recycle (uring, slot->bid);
+  g_cond_signal (&uring->cond);
+  g_mutex_unlock (&uring->lock);
+
+  gst_rtp_uring_unref (uring);
+}
+
+static gboolean
+gst_rtp_uring_arm (GstRtpUring * uring, GError ** error)
+{
+  struct io_uring_sqe *sqe;
+  gint ret;
+
+  sqe = io_uring_get_sqe (&uring->ring);
+  io_uring_prep_recvmsg_multishot (sqe, uring->fd, &uring->msg, 0);
+  sqe->flags |= IOSQE_BUFFER_SELECT;
+  sqe->buf_group = BUFFER_GROUP;
+  io_uring_sqe_set_data64 (sqe, RECV_TAG);
+
+  ret = io_uring_submit (&uring->ring);
+
+  g_mutex_lock (&uring->lock);
+  uring->syscalls++;
+  g_mutex_unlock (&uring->lock);
+
+  if (ret < 0) {
+    g_set_error (error, G_IO_ERROR, g_io_error_from_errno (-ret),
+        "Could not submit receive request: %s", g_strerror (-ret));
+    return FALSE;
+  }
+
+  uring->armed = TRUE;
+
+  return TRUE;
+}
+
+/* After the buffers ran out, wait for downstream to release one instead
+ * of spinning on ENOBUFS. */
+static gboolean
+gst_rtp_uring_rearm (GstRtpUring * uring, GCancellable * cancellable,
+    GError ** error)
+{
+  g_mutex_lock (&uring->lock);
+  while (uring->available == 0 && !g_cancellable_is_cancelled (cancellable))
+    g_cond_wait_until (&uring->cond, &uring->lock,
+        g_get_monotonic_time () + WAIT_TIMEOUT / GST_USECOND);
+  g_mutex_unlock (&uring->lock);
+
+  if (g_cancellable_set_error_if_cancelled (cancellable, error))
+    return FALSE;
+
+  return gst_rtp_uring_arm (uring, error);
+}
+
+static GstClockTime
+gst_rtp_uring_get_arrival_time (GstRtpUring * uring,
+    struct io_uring_recvmsg_out *out)
+{
+#ifdef SO_TIMESTAMPNS
+  struct cmsghdr *cmsg;
+
+  if (uring->msg.msg_controllen == 0 || (out->flags & MSG_CTRUNC))
+    return GST_CLOCK_TIME_NONE;
+
+  for (cmsg = io_uring_recvmsg_cmsg_firsthdr (out, &uring->msg); cmsg;
+      cmsg = io_uring_recvmsg_cmsg_nexthdr (out, &uring->msg, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+      struct timespec ts;
+
+      memcpy (&ts, CMSG_DATA (cmsg), sizeof (ts));
+      return GST_TIMESPEC_TO_TIME (ts);
+    }
+  }
+#endif
+
+  return GST_CLOCK_TIME_NONE;
+}
+
+/* Wrap the payload of a completed receive in a buffer. Truncated packets
+ * are dropped and their buffer goes straight back to the ring. */
+static gboolean
+gst_rtp_uring_take (GstRtpUring * uring, struct io_uring_cqe *cqe,
+    GstRtpUringPacket * packet)
+{
+  guint16 bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+  guint8 *data = uring->memory + (gsize) bid * uring->buffer_size;
+  struct io_uring_recvmsg_out *out;
+  guint8 *payload;
+  gsize len;
+
+  out = io_uring_recvmsg_validate (data, cqe->res, &uring->msg);
+  if (out == NULL || (out->flags & MSG_TRUNC)) {
+    g_mutex_lock (&uring->lock);
+    gst_rtp_uring_recycle (uring, bid);
+    g_mutex_unlock (&uring->lock);
+    return FALSE;
+  }
+
+  payload = io_uring_recvmsg_payload (out, &uring->msg);
+  len = io_uring_recvmsg_payload_length (out, cqe->res, &uring->msg);
+
+  g_atomic_int_inc (&uring->refcount);
+  packet->buffer = gst_buffer_new ();
+  gst_buffer_append_memory (packet->buffer,
+      gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY, data,
+          uring->buffer_size, payload - data, len, &uring->slots[bid],
+          (GDestroyNotify) gst_rtp_uring_release));
+
+  packet->addr = out->namelen > 0 ? io_uring_recvmsg_name (out) : NULL;
+  packet->addr_len = MIN (out->namelen, uring->msg.msg_namelen);
+  packet->arrival = gst_rtp_uring_get_arrival_time (uring, out);
+
+  return TRUE;
+}
+
+/**
+ * gst_rtp_uring_is_supported:
+ *
+ * Checks once whether the running kernel supports provided buffer rings
+ * and multishot recvmsg.
+ *
+ * Returns: %TRUE if gst_rtp_uring_new() can be expected to succeed.
+ */
+gboolean
+gst_rtp_uring_is_supported (void)
+{
+  static gsize supported = 0;
+
+  if (g_once_init_enter (&supported)) {
+    gsize result = 1;
+    GSocket *socket;
+
+    socket = g_socket_new (G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_DATAGRAM,
+        G_SOCKET_PROTOCOL_UDP, NULL);
+    if (socket) {
+      GstRtpUring *uring = gst_rtp_uring_new (socket, 1, 64, FALSE, NULL);
+
+      if (uring) {
+        gst_rtp_uring_free (uring);
+        result = 2;
+      }
+      g_object_unref (socket);
+    }
+
+    g_once_init_leave (&supported, result);
+  }
+
+  return supported == 2;
+}
+
+/**
+ * gst_rtp_uring_new:
+ * @socket: the bound socket to receive from
+ * @n_buffers: number of receive buffers, rounded up to a power of two
+ * @mtu: largest payload that is received, larger datagrams are dropped
+ * @timestamps: reserve room for the SO_TIMESTAMPNS control message
+ * @error: return location for a #GError
+ *
+ * Sets up a ring with @n_buffers buffers and arms a multishot receive on
+ * @socket. The socket must stay open until gst_rtp_uring_free().
+ *
+ * Returns: (transfer full): the engine, or %NULL if io_uring is not
+ * available.
+ */
+GstRtpUring *
+gst_rtp_uring_new (GSocket * socket, guint n_buffers, guint mtu,
+    gboolean timestamps, GError ** error)
+{
+  GstRtpUring *uring;
+  struct io_uring_cqe *cqe;
+  guint n, i;
+  gint ret;
+
+  for (n = 1; n < n_buffers && n < MAX_BUFFERS; n <<= 1);
+
+  uring = g_new0 (GstRtpUring, 1);
+  uring->refcount = 1;
+  uring->fd = g_socket_get_fd (socket);
+  uring->msg.msg_namelen = sizeof (struct sockaddr_storage);
+  uring->msg.msg_controllen = timestamps ? CONTROL_SIZE : 0;
+  uring->n_buffers = n;
+  uring->buffer_size = GST_ROUND_UP_64 (sizeof (struct io_uring_recvmsg_out)
+      + uring->msg.msg_namelen + uring->msg.msg_controllen + mtu);
+  g_mutex_init (&uring->lock);
+  g_cond_init (&uring->cond);
+
+  ret = io_uring_queue_init (QUEUE_DEPTH, &uring->ring, 0);
+  if (ret < 0) {
+    g_mutex_clear (&uring->lock);
+    g_cond_clear (&uring->cond);
+    g_free (uring);
+    g_set_error (error, G_IO_ERROR, g_io_error_from_errno (-ret),
+        "Could not create io_uring: %s", g_strerror (-ret));
+    return NULL;
+  }
+
+  uring->buf_ring = io_uring_setup_buf_ring (&uring->ring, n, BUFFER_GROUP,
+      0, &ret);
+  if (uring->buf_ring == NULL)
+    goto failed;
+
+  uring->memory = g_malloc ((gsize) n * uring->buffer_size);
+  uring->slots = g_new (GstRtpUringSlot, n);
+  for (i = 0; i < n; i++) {
+    uring->slots[i].uring = uring;
+    uring->slots[i].bid = i;
+    gst_rtp_uring_recycle (uring, i);
+  }
+
+  if (!gst_rtp_uring_arm (uring, error)) {
+    gst_rtp_uring_unref (uring);
+    return NULL;
+  }
+
+  /* Kernels without multishot recvmsg fail the request right away */
+  if (io_uring_peek_cqe (&uring->ring, &cqe) == 0 && cqe->res < 0) {
+    ret = cqe->res;
+    goto failed;
+  }
+
+  return uring;
+
+failed:
+  g_set_error (error, G_IO_ERROR, g_io_error_from_errno (-ret),
+      "Could not set up multishot receive: %s", g_strerror (-ret));
+  gst_rtp_uring_unref (uring);
+  return NULL;
+}
+
+/**
+ * gst_rtp_uring_free:
+ * @uring: a #GstRtpUring
+ *
+ * Cancels the receive request so that the socket can be closed. The
+ * buffers that are still in flight keep their memory until they are
+ * released.
+ */
+void
+gst_rtp_uring_free (GstRtpUring * uring)
+{
+  struct io_uring_sqe *sqe;
+  struct io_uring_cqe *cqe;
+
+  if (uring->armed) {
+    sqe = io_uring_get_sqe (&uring->ring);
+    io_uring_prep_cancel64 (sqe, RECV_TAG, 0);
+    io_uring_sqe_set_data64 (sqe, CANCEL_TAG);
+    io_uring_submit (&uring->ring);
+  }
+
+  /* Packets that completed in the meantime are dropped */
+  while (uring->armed && io_uring_wait_cqe (&uring->ring, &cqe) == 0) {
+    if (cqe->user_data == RECV_TAG) {
+      if (!(cqe->flags & IORING_CQE_F_MORE))
+        uring->armed = FALSE;
+      if (cqe->flags & IORING_CQE_F_BUFFER) {
+        g_mutex_lock (&uring->lock);
+        gst_rtp_uring_recycle (uring, cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+        g_mutex_unlock (&uring->lock);
+      }
+    }
+    io_uring_cqe_seen (&uring->ring, cqe);
+  }
+
+  gst_rtp_uring_unref (uring);
+}
+
+/**
+ * gst_rtp_uring_receive:
+ * @uring: a #GstRtpUring
+ * @packets: array to store the received packets in
+ * @max_packets: size of @packets
+ * @cancellable: a #GCancellable to interrupt the wait
+ * @error: return location for a #GError
+ *
+ * Waits until at least one packet was received and takes up to
+ * @max_packets of them.
+ *
+ * Returns: the number of packets stored in @packets, or -1 with @error
+ * set when cancelled or receiving failed.
+ */
+gint
+gst_rtp_uring_receive (GstRtpUring * uring, GstRtpUringPacket * packets,
+    guint max_packets, GCancellable * cancellable, GError ** error)
+{
+  struct __kernel_timespec timeout = { 0, WAIT_TIMEOUT };
+  struct io_uring_cqe *cqe;
+  guint n = 0, seen, consumed, syscalls, overruns;
+  gint failed;
+  unsigned head;
+  gint ret;
+
+  while (n == 0) {
+    if (g_cancellable_set_error_if_cancelled (cancellable, error))
+      return -1;
+
+    if (!uring->armed && !gst_rtp_uring_rearm (uring, cancellable, error))
+      return -1;
+
+    /* Only enter the kernel when there is nothing to reap */
+    syscalls = 0;
+    if (io_uring_peek_cqe (&uring->ring, &cqe) != 0) {
+      syscalls++;
+      ret = io_uring_wait_cqe_timeout (&uring->ring, &cqe, &timeout);
+      if (ret < 0 && ret != -ETIME && ret != -EINTR) {
+        g_set_error (error, G_IO_ERROR, g_io_error_from_errno (-ret),
+            "Waiting for packets failed: %s", g_strerror (-ret));
+        return -1;
+      }
+    }
+
+    seen = consumed = overruns = 0;
+    failed = 0;
+    io_uring_for_each_cqe (&uring->ring, head, cqe) {
+      if (n == max_packets)
+        break;
+      seen++;
+
+      if (!(cqe->flags & IORING_CQE_F_MORE))
+        uring->armed = FALSE;
+
+      if (cqe->res < 0) {
+        if (cqe->res == -ENOBUFS)
+          overruns++;
+        else if (cqe->res != -ECANCELED)
+          failed = -cqe->res;
+        continue;
+      }
+
+      if (cqe->flags & IORING_CQE_F_BUFFER) {
+        consumed++;
+        if (gst_rtp_uring_take (uring, cqe, &packets[n]))
+          n++;
+      }
+    }
+    io_uring_cq_advance (&uring->ring, seen);
+
+    g_mutex_lock (&uring->lock);
+    uring->available -= consumed;
+    uring->syscalls += syscalls;
+    uring->overruns += overruns;
+    g_mutex_unlock (&uring->lock);
+
+    if (n == 0 && failed != 0) {
+      g_set_error (error, G_IO_ERROR, g_io_error_from_errno (failed),
+          "Receive failed: %s", g_strerror (failed));
+      return -1;
+    }
+  }
+
+  return n;
+}
+
+/**
+ * gst_rtp_uring_get_n_buffers:
+ * @uring: a #GstRtpUring
+ *
+ * Returns: the number of buffers in the ring.
+ */
+guint
+gst_rtp_uring_get_n_buffers (GstRtpUring * uring)
+{
+  return uring->n_buffers;
+}
+
+/**
+ * gst_rtp_uring_get_buffer_size:
+ * @uring: a #GstRtpUring
+ *
+ * Returns: the size of every buffer in the ring, including the headers.
+ */
+guint
+gst_rtp_uring_get_buffer_size (GstRtpUring * uring)
+{
+  return uring->buffer_size;
+}
+
+/**
+ * gst_rtp_uring_get_stats:
+ * @uring: a #GstRtpUring
+ * @syscalls: (out): number of times the kernel was entered
+ * @overruns: (out): number of times the receive stopped because all
+ *   buffers were in use
+ *
+ * Can be called from any thread.
+ */
+void
+gst_rtp_uring_get_stats (GstRtpUring * uring, guint64 * syscalls,
+    guint64 * overruns)
+{
+  g_mutex_lock (&uring->lock);
+  *syscalls = uring->syscalls;
+  *overruns = uring->overruns;
+  g_mutex_unlock (&uring->lock);
+}
+
+#else /* HAVE_LIBURING */
+
+gboolean
+gst_rtp_uring_is_supported (void)
+{
+  return FALSE;
+}
+
+GstRtpUring *
+gst_rtp_uring_new (GSocket * socket, guint n_buffers, guint mtu,
+    gboolean timestamps, GError ** error)
+{
+  g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+      "Built without io_uring support");
+  return NULL;
+}
+
+void
+gst_rtp_uring_free (GstRtpUring * uring)
+{
+  g_return_if_reached ();
+}
+
+gint
+gst_rtp_uring_receive (GstRtpUring * uring, GstRtpUringPacket * packets,
+    guint max_packets, GCancellable * cancellable, GError ** error)
+{
+  g_return_val_if_reached (-1);
+}
+
+guint
+gst_rtp_uring_get_n_buffers (GstRtpUring * uring)
+{
+  g_return_val_if_reached (0);
+}
+
+guint
+gst_rtp_uring_get_buffer_size (GstRtpUring * uring)
+{
+  g_return_val_if_reached (0);
+}
+
+void
+gst_rtp_uring_get_stats (GstRtpUring * uring, guint64 * syscalls,
+    guint64 * overruns)
+{
+  g_return_if_reached ();
+}
+
+#endif /* HAVE_LIBURING */
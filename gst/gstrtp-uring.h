@@ -0,0 +1,36 @@
+#ifndef __GST_RTP_URING_H__
+#define __GST_RTP_URING_H__
+
+#include <gio/gio.h>
+#include <gst/gst.h>
+
+typedef struct _GstRtpUring GstRtpUring;
+
+/* A received datagram. @addr points into the memory of @buffer and stays
+ * valid as long as the buffer does. */
+typedef struct
+{
+  GstBuffer *buffer;
+  gconstpointer addr;
+  gsize addr_len;
+  GstClockTime arrival;
+} GstRtpUringPacket;
+
+gboolean gst_rtp_uring_is_supported (void);
+
+GstRtpUring * gst_rtp_uring_new (GSocket * socket, guint n_buffers, guint mtu,
+    gboolean timestamps, GError ** error);
+
+void gst_rtp_uring_free (GstRtpUring * uring);
+
+gint gst_rtp_uring_receive (GstRtpUring * uring, GstRtpUringPacket * packets,
+    guint max_packets, GCancellable * cancellable, GError ** error);
+
+guint gst_rtp_uring_get_n_buffers (GstRtpUring * uring);
+
+guint gst_rtp_uring_get_buffer_size (GstRtpUring * uring);
+
+void gst_rtp_uring_get_stats (GstRtpUring * uring, guint64 * syscalls,
+    guint64 * overruns);
+
+#endif
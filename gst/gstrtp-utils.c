@@ -2,6 +2,8 @@
  * See: https://bugzilla.gnome.org/show_bug.cgi?id=779765
  */
 
+#include <string.h>
+
 #include "gstrtp-utils.h"
 
 static void
@@ -37,3 +39,192 @@ gst_rtp_utils_set_properties_from_uri_query (GObject * obj, const GstUri * uri)
     g_hash_table_unref (hash_table);
   }
 }
+
+/**
+ * gst_rtp_utils_resolve_host:
+ * @host: numeric address or hostname
+ * @error: location for a #GError, or %NULL
+ *
+ * Convert @host to an address, numeric addresses are used as they are,
+ * hostnames are looked up with the default #GResolver.
+ *
+ * Returns: (transfer full): the first address for @host or %NULL.
+ */
+GInetAddress *
+gst_rtp_utils_resolve_host (const gchar * host, GError ** error)
+{
+  GInetAddress *iaddr;
+  GResolver *resolver;
+  GList *results;
+
+  g_return_val_if_fail (host != NULL, NULL);
+
+  iaddr = g_inet_address_new_from_string (host);
+  if (iaddr)
+    return iaddr;
+
+  resolver = g_resolver_get_default ();
+  results = g_resolver_lookup_by_name (resolver, host, NULL, error);
+  g_object_unref (resolver);
+
+  if (!results)
+    return NULL;
+
+  iaddr = G_INET_ADDRESS (g_object_ref (results->data));
+  g_resolver_free_addresses (results);
+
+  return iaddr;
+}
+
+/**
+ * gst_rtp_utils_socket_address_equal:
+ * @a: (nullable): a #GSocketAddress
+ * @b: (nullable): a #GSocketAddress
+ *
+ * Returns: %TRUE if @a and @b are the same internet address and port.
+ */
+gboolean
+gst_rtp_utils_socket_address_equal (GSocketAddress * a, GSocketAddress * b)
+{
+  GInetSocketAddress *ia, *ib;
+
+  if (a == b)
+    return TRUE;
+  if (a == NULL || b == NULL)
+    return FALSE;
+  if (!G_IS_INET_SOCKET_ADDRESS (a) || !G_IS_INET_SOCKET_ADDRESS (b))
+    return FALSE;
+
+  ia = G_INET_SOCKET_ADDRESS (a);
+  ib = G_INET_SOCKET_ADDRESS (b);
+
+  return g_inet_socket_address_get_port (ia) ==
+      g_inet_socket_address_get_port (ib)
+      && g_inet_address_equal (g_inet_socket_address_get_address (ia),
+      g_inet_socket_address_get_address (ib));
+}
+
+/**
+ * gst_rtp_utils_parse_address:
+ * @str: "port", "host:port" or "[ipv6-address]:port"
+ * @host: (out) (transfer full): location for the host, set to %NULL when
+ *   @str only has a port
+ * @port: (out): location for the port
+ *
+ * Returns: %TRUE if @str could be parsed, %FALSE otherwise.
+ */
+gboolean
+gst_rtp_utils_parse_address (const gchar * str, gchar ** host, guint * port)
+{
+  const gchar *port_str;
+  gchar *end = NULL;
+  guint64 value;
+
+  g_return_val_if_fail (str != NULL, FALSE);
+  g_return_val_if_fail (host != NULL, FALSE);
+  g_return_val_if_fail (port != NULL, FALSE);
+
+  *host = NULL;
+
+  if (str[0] == '[') {
+    const gchar *close = strchr (str, ']');
+
+    if (close == NULL || close[1] != ':')
+      return FALSE;
+    *host = g_strndup (str + 1, close - str - 1);
+    port_str = close + 2;
+  } else {
+    const gchar *colon = strrchr (str, ':');
+
+    if (colon) {
+      *host = g_strndup (str, colon - str);
+      port_str = colon + 1;
+    } else {
+      port_str = str;
+    }
+  }
+
+  if (*host && **host == '\0')
+    g_clear_pointer (host, g_free);
+
+  value = g_ascii_strtoull (port_str, &end, 10);
+  if (end == port_str || *end != '\0' || value == 0 || value > 65535) {
+    g_clear_pointer (host, g_free);
+    return FALSE;
+  }
+
+  *port = value;
+
+  return TRUE;
+}
+
+/**
+ * gst_rtp_utils_parse_rtx_pt_map:
+ * @str: comma separated "pt:rtx-pt" pairs, like "96:97,98:99"
+ *
+ * Returns: (transfer full): an application/x-rtp-pt-map structure as
+ * rtprtxsend and rtprtxreceive take it, with the retransmission payload
+ * type of each media payload type, or %NULL if an entry is invalid.
+ */
+GstStructure *
+gst_rtp_utils_parse_rtx_pt_map (const gchar * str)
+{
+  GstStructure *pt_map;
+  gchar **entries;
+  guint i;
+
+  g_return_val_if_fail (str != NULL, NULL);
+
+  pt_map = gst_structure_new_empty ("application/x-rtp-pt-map");
+  entries = g_strsplit (str, ",", -1);
+  for (i = 0; entries[i]; i++) {
+    guint64 pt, rtx_pt;
+    gchar *colon, *end;
+
+    g_strstrip (entries[i]);
+    if (entries[i][0] == '\0')
+      continue;
+
+    pt = g_ascii_strtoull (entries[i], &colon, 10);
+    if (colon == entries[i] || *colon != ':' || pt > 127)
+      goto invalid;
+    rtx_pt = g_ascii_strtoull (colon + 1, &end, 10);
+    if (end == colon + 1 || *end != '\0' || rtx_pt > 127 || rtx_pt == pt)
+      goto invalid;
+
+    *colon = '\0';
+    gst_structure_set (pt_map, entries[i], G_TYPE_UINT, (guint) rtx_pt,
+        NULL);
+  }
+  g_strfreev (entries);
+
+  return pt_map;
+
+invalid:
+  g_strfreev (entries);
+  gst_structure_free (pt_map);
+  return NULL;
+}
+
+/**
+ * gst_rtp_utils_get_rtx_pts:
+ * @pt_map: a structure from gst_rtp_utils_parse_rtx_pt_map()
+ *
+ * Returns: (transfer full): the retransmission payload types of @pt_map
+ * as a comma separated list.
+ */
+gchar *
+gst_rtp_utils_get_rtx_pts (const GstStructure * pt_map)
+{
+  GString *pts = g_string_new (NULL);
+  guint i, rtx_pt;
+
+  for (i = 0; i < gst_structure_n_fields (pt_map); i++) {
+    if (!gst_structure_get_uint (pt_map,
+            gst_structure_nth_field_name (pt_map, i), &rtx_pt))
+      continue;
+    g_string_append_printf (pts, "%s%u", pts->len ? "," : "", rtx_pt);
+  }
+
+  return g_string_free (pts, FALSE);
+}
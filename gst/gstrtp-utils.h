@@ -1,8 +1,19 @@
 #ifndef __GST_RTP_UTILS_H__
 #define __GST_RTP_UTILS_H__
 
+#include <gio/gio.h>
 #include <gst/gst.h>
 
 void gst_rtp_utils_set_properties_from_uri_query (GObject * obj, const GstUri * uri);
 
+GInetAddress * gst_rtp_utils_resolve_host (const gchar * host, GError ** error);
+
+gboolean gst_rtp_utils_socket_address_equal (GSocketAddress * a, GSocketAddress * b);
+
+gboolean gst_rtp_utils_parse_address (const gchar * str, gchar ** host, guint * port);
+
+GstStructure * gst_rtp_utils_parse_rtx_pt_map (const gchar * str);
+
+gchar * gst_rtp_utils_get_rtx_pts (const GstStructure * pt_map);
+
 #endif
@@ -0,0 +1,214 @@
+/*
+ * XOR of packet payloads for FEC recovery.
+ *
+ * Recovering a packet XORs the payload of the FEC packet with the
+ * payloads of all other packets it protects, which is the bulk of the
+ * work of the FEC decoder. There are kernels for SSE2, AVX2 and NEON next
+ * to the portable one; the best one the CPU supports is picked on first
+ * use. AVX2 is compiled for its own functions only and checked at run
+ * time, SSE2 and NEON are part of the x86-64 and AArch64 baselines and
+ * are used when the compiler targets them.
+ */
+
+#include <string.h>
+
+#if defined (__SSE2__)
+#include <emmintrin.h>
+#define HAVE_XOR_SSE2 1
+#endif
+
+#if (defined (__x86_64__) || defined (__i386__)) && defined (__GNUC__)
+#include <immintrin.h>
+#define HAVE_XOR_AVX2 1
+#endif
+
+#if defined (__ARM_NEON) || defined (__ARM_NEON__)
+#include <arm_neon.h>
+#define HAVE_XOR_NEON 1
+#endif
+
+#include "gstrtp-xor.h"
+
+typedef void (*GstRtpXorFunc) (guint8 * dst, const guint8 * src, gsize len);
+
+static void
+gst_rtp_xor_scalar (guint8 * dst, const guint8 * src, gsize len)
+{
+  gsize i = 0;
+
+  /* memcpy() keeps unaligned words legal, compilers turn it into plain
+   * loads and stores */
+  for (; i + 8 <= len; i += 8) {
+    guint64 a, b;
+
+    memcpy (&a, dst + i, 8);
+    memcpy (&b, src + i, 8);
+    a ^= b;
+    memcpy (dst + i, &a, 8);
+  }
+  for (; i < len; i++)
+    dst[i] ^= src[i];
+}
+
+#ifdef HAVE_XOR_SSE2
+static void
+gst_rtp_xor_sse2 (guint8 * dst, const guint8 * src, gsize len)
+{
+  gsize i = 0;
+
+  for (; i + 16 <= len; i += 16) {
+    __m128i a = _mm_loadu_si128 ((const __m128i *) (dst + i));
+    __m128i b = _mm_loadu_si128 ((const __m128i *) (src + i));
+
+    _mm_storeu_si128 ((__m128i *) (dst + i), _mm_xor_si128 (a, b));
+  }
+  gst_rtp_xor_scalar (dst + i, src + i, len - i);
+}
+#endif
+
+#ifdef HAVE_XOR_AVX2
+__attribute__ ((target ("avx2")))
+static void
+gst_rtp_xor_avx2 (guint8 * dst, const guint8 * src, gsize len)
+{
+  gsize i = 0;
+
+  for (; i + 32 <= len; i += 32) {
+    __m256i a = _mm256_loadu_si256 ((const __m256i *) (dst + i));
+    __m256i b = _mm256_loadu_si256 ((const __m256i *) (src + i));
+
+    _mm256_storeu_si256 ((__m256i *) (dst + i), _mm256_xor_si256 (a, b));
+  }
+  gst_rtp_xor_scalar (dst + i, src + i, len - i);
+}
+#endif
+
+#ifdef HAVE_XOR_NEON
+static void
+gst_rtp_xor_neon (guint8 * dst, const guint8 * src, gsize len)
+{
+  gsize i = 0;
+
+  for (; i + 16 <= len; i += 16)
+    vst1q_u8 (dst + i, veorq_u8 (vld1q_u8 (dst + i), vld1q_u8 (src + i)));
+  gst_rtp_xor_scalar (dst + i, src + i, len - i);
+}
+#endif
+
+static GstRtpXorFunc
+gst_rtp_xor_get_func (GstRtpXorImpl impl)
+{
+  switch (impl) {
+    case GST_RTP_XOR_IMPL_SCALAR:
+      return gst_rtp_xor_scalar;
+#ifdef HAVE_XOR_SSE2
+    case GST_RTP_XOR_IMPL_SSE2:
+      return gst_rtp_xor_sse2;
+#endif
+#ifdef HAVE_XOR_AVX2
+    case GST_RTP_XOR_IMPL_AVX2:
+      return __builtin_cpu_supports ("avx2") ? gst_rtp_xor_avx2 : NULL;
+#endif
+#ifdef HAVE_XOR_NEON
+    case GST_RTP_XOR_IMPL_NEON:
+      return gst_rtp_xor_neon;
+#endif
+    default:
+      return NULL;
+  }
+}
+
+/* Index of the best kernel plus one, 0 until the first call */
+static gsize best_impl;
+
+/**
+ * gst_rtp_xor_get_impl:
+ *
+ * Returns: the kernel that gst_rtp_xor() uses.
+ */
+GstRtpXorImpl
+gst_rtp_xor_get_impl (void)
+{
+  if (g_once_init_enter (&best_impl)) {
+    GstRtpXorImpl impl = GST_RTP_XOR_IMPL_COUNT;
+
+    /* The later kernels are the faster ones */
+    while (impl > GST_RTP_XOR_IMPL_SCALAR
+        && !gst_rtp_xor_impl_is_supported (impl - 1))
+      impl--;
+    g_once_init_leave (&best_impl, impl);
+  }
+
+  return best_impl - 1;
+}
+
+/**
+ * gst_rtp_xor_impl_is_supported:
+ * @impl: a kernel
+ *
+ * Returns: %TRUE if @impl was compiled in and the CPU can run it.
+ */
+gboolean
+gst_rtp_xor_impl_is_supported (GstRtpXorImpl impl)
+{
+  return gst_rtp_xor_get_func (impl) != NULL;
+}
+
+/**
+ * gst_rtp_xor_impl_get_name:
+ * @impl: a kernel
+ *
+ * Returns: the name of @impl for logging.
+ */
+const gchar *
+gst_rtp_xor_impl_get_name (GstRtpXorImpl impl)
+{
+  static const gchar *names[] = { "scalar", "sse2", "avx2", "neon" };
+
+  g_return_val_if_fail (impl < GST_RTP_XOR_IMPL_COUNT, NULL);
+
+  return names[impl];
+}
+
+/**
+ * gst_rtp_xor_with_impl:
+ * @impl: a supported kernel
+ * @dst: the bytes to XOR into
+ * @src: the bytes to XOR with
+ * @len: the number of bytes
+ *
+ * Like gst_rtp_xor() with the kernel @impl, to compare them.
+ */
+void
+gst_rtp_xor_with_impl (GstRtpXorImpl impl, guint8 * dst, const guint8 * src,
+    gsize len)
+{
+  GstRtpXorFunc func = gst_rtp_xor_get_func (impl);
+
+  g_return_if_fail (func != NULL);
+
+  func (dst, src, len);
+}
+
+/**
+ * gst_rtp_xor:
+ * @dst: the bytes to XOR into
+ * @src: the bytes to XOR with
+ * @len: the number of bytes
+ *
+ * XOR @len bytes of @src into @dst with the fastest kernel the CPU
+ * supports. Neither needs to be aligned.
+ */
+void
+gst_rtp_xor (guint8 * dst, const guint8 * src, gsize len)
+{
+  static gpointer best_func;
+  GstRtpXorFunc func = g_atomic_pointer_get (&best_func);
+
+  if (G_UNLIKELY (func == NULL)) {
+    func = gst_rtp_xor_get_func (gst_rtp_xor_get_impl ());
+    g_atomic_pointer_set (&best_func, func);
+  }
+
+  func (dst, src, len);
+}
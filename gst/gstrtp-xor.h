@@ -0,0 +1,29 @@
+#ifndef __GST_RTP_XOR_H__
+#define __GST_RTP_XOR_H__
+
+#include <gst/gst.h>
+
+/* The kernels that gst_rtp_xor() chooses from, the best one the CPU
+ * supports is used */
+typedef enum
+{
+  GST_RTP_XOR_IMPL_SCALAR,
+  GST_RTP_XOR_IMPL_SSE2,
+  GST_RTP_XOR_IMPL_AVX2,
+  GST_RTP_XOR_IMPL_NEON,
+
+  GST_RTP_XOR_IMPL_COUNT
+} GstRtpXorImpl;
+
+void gst_rtp_xor (guint8 * dst, const guint8 * src, gsize len);
+
+GstRtpXorImpl gst_rtp_xor_get_impl (void);
+
+gboolean gst_rtp_xor_impl_is_supported (GstRtpXorImpl impl);
+
+const gchar * gst_rtp_xor_impl_get_name (GstRtpXorImpl impl);
+
+void gst_rtp_xor_with_impl (GstRtpXorImpl impl, guint8 * dst,
+    const guint8 * src, gsize len);
+
+#endif
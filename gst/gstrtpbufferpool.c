@@ -0,0 +1,159 @@
+/* GStreamer
+ * Copyright (C) <2018> Marc Leeman <marc.leeman@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION: gstrtpbufferpool
+ * @title: GstRtpBufferPool
+ * @short description: Pool of MTU-sized buffers for received packets
+ *
+ * A #GstBufferPool that hands out buffers of the configured size to read
+ * datagrams into. Received packets are usually shorter than the MTU, so
+ * the buffers are shrunk to the packet size; the pool restores the
+ * full size when a buffer is returned, so it can be reused instead of
+ * being discarded and allocated again.
+ *
+ * The pool counts the number of buffers it allocates, which allows to
+ * verify that no allocations happen once the pool is warmed up.
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "gstrtpbufferpool.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_rtp_buffer_pool_debug);
+#define GST_CAT_DEFAULT gst_rtp_buffer_pool_debug
+
+struct _GstRtpBufferPool
+{
+  GstBufferPool parent_instance;
+
+  guint size;
+  guint64 allocated;
+};
+
+#define gst_rtp_buffer_pool_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstRtpBufferPool, gst_rtp_buffer_pool,
+    GST_TYPE_BUFFER_POOL,
+    GST_DEBUG_CATEGORY_INIT (gst_rtp_buffer_pool_debug, "nrtp_bufferpool", 0,
+        "RTP Buffer Pool"));
+
+static gboolean
+gst_rtp_buffer_pool_set_config (GstBufferPool * pool, GstStructure * config)
+{
+  GstRtpBufferPool *self = GST_RTP_BUFFER_POOL (pool);
+  guint size;
+
+  if (!gst_buffer_pool_config_get_params (config, NULL, &size, NULL, NULL))
+    return FALSE;
+
+  self->size = size;
+
+  return GST_BUFFER_POOL_CLASS (parent_class)->set_config (pool, config);
+}
+
+static GstFlowReturn
+gst_rtp_buffer_pool_alloc_buffer (GstBufferPool * pool, GstBuffer ** buffer,
+    GstBufferPoolAcquireParams * params)
+{
+  GstRtpBufferPool *self = GST_RTP_BUFFER_POOL (pool);
+  GstFlowReturn ret;
+
+  ret = GST_BUFFER_POOL_CLASS (parent_class)->alloc_buffer (pool, buffer,
+      params);
+  if (ret == GST_FLOW_OK) {
+    GST_OBJECT_LOCK (self);
+    self->allocated++;
+    GST_OBJECT_UNLOCK (self);
+  }
+
+  return ret;
+}
+
+static void
+gst_rtp_buffer_pool_reset_buffer (GstBufferPool * pool, GstBuffer * buffer)
+{
+  GstRtpBufferPool *self = GST_RTP_BUFFER_POOL (pool);
+
+  GST_BUFFER_POOL_CLASS (parent_class)->reset_buffer (pool, buffer);
+
+  /* The buffer was resized to the received packet, grow it back so it is
+   * not discarded as a buffer with a different size. */
+  if (gst_buffer_get_size (buffer) != self->size)
+    gst_buffer_set_size (buffer, self->size);
+}
+
+static void
+gst_rtp_buffer_pool_class_init (GstRtpBufferPoolClass * klass)
+{
+  GstBufferPoolClass *gstbufferpool_class = GST_BUFFER_POOL_CLASS (klass);
+
+  gstbufferpool_class->set_config =
+      GST_DEBUG_FUNCPTR (gst_rtp_buffer_pool_set_config);
+  gstbufferpool_class->alloc_buffer =
+      GST_DEBUG_FUNCPTR (gst_rtp_buffer_pool_alloc_buffer);
+  gstbufferpool_class->reset_buffer =
+      GST_DEBUG_FUNCPTR (gst_rtp_buffer_pool_reset_buffer);
+}
+
+static void
+gst_rtp_buffer_pool_init (GstRtpBufferPool * self)
+{
+  self->size = 0;
+  self->allocated = 0;
+}
+
+/**
+ * gst_rtp_buffer_pool_new:
+ *
+ * Create a new, unconfigured #GstRtpBufferPool.
+ *
+ * Returns: (transfer full): a new #GstBufferPool
+ */
+GstBufferPool *
+gst_rtp_buffer_pool_new (void)
+{
+  GstRtpBufferPool *pool;
+
+  pool = g_object_new (GST_TYPE_RTP_BUFFER_POOL, NULL);
+  gst_object_ref_sink (pool);
+
+  return GST_BUFFER_POOL_CAST (pool);
+}
+
+/**
+ * gst_rtp_buffer_pool_get_allocated:
+ * @pool: a #GstRtpBufferPool
+ *
+ * Returns: the number of buffers that were allocated by @pool since it
+ *   was created, including the ones allocated when it was activated.
+ */
+guint64
+gst_rtp_buffer_pool_get_allocated (GstRtpBufferPool * pool)
+{
+  guint64 allocated;
+
+  GST_OBJECT_LOCK (pool);
+  allocated = pool->allocated;
+  GST_OBJECT_UNLOCK (pool);
+
+  return allocated;
+}
+
+/* ex: set tabstop=2 shiftwidth=2 expandtab: */
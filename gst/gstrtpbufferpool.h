@@ -0,0 +1,17 @@
+#ifndef _GST_RTP_BUFFER_POOL_H_
+#define _GST_RTP_BUFFER_POOL_H_
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+#define GST_TYPE_RTP_BUFFER_POOL (gst_rtp_buffer_pool_get_type ())
+G_DECLARE_FINAL_TYPE (GstRtpBufferPool, gst_rtp_buffer_pool, GST,
+    RTP_BUFFER_POOL, GstBufferPool);
+
+GstBufferPool *gst_rtp_buffer_pool_new (void);
+
+guint64 gst_rtp_buffer_pool_get_allocated (GstRtpBufferPool * pool);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,550 @@
+/* GStreamer
+ * Copyright (C) <2018> Marc Leeman <marc.leeman@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION: gstrtpfecdec
+ * @title: GstRtpFecDec
+ * @short description: recovers lost RTP packets with SMPTE 2022-1 FEC.
+ *
+ * This element is used by #GstRtpSrc to recover lost packets before they
+ * reach the jitterbuffer. The media packets enter on the sink pad and
+ * leave on the source pad unchanged; the column and row FEC streams enter
+ * on request pads named fec_%u. When a FEC packet arrives and exactly one
+ * of the packets it protects is missing, that packet is rebuilt and pushed
+ * right away, and it may in turn complete a FEC packet of the other
+ * direction that waited for it. A late original of a recovered packet is
+ * dropped.
+ *
+ * The recovered and unrecoverable packets are counted in
+ * #GstRtpFecDec:stats.
+ *
+ * Packets of the payload types in #GstRtpFecDec:ignore-pts, such as
+ * retransmissions, pass without being kept for recovery.
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "gstrtpfecdec.h"
+#include "gstrtp-fec.h"
+#include "gstrtp-xor.h"
+#include "gstrtp-filter.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_rtp_fec_dec_debug);
+#define GST_CAT_DEFAULT gst_rtp_fec_dec_debug
+
+#define DEFAULT_PROP_IGNORE_PTS       NULL
+
+struct _GstRtpFecDec
+{
+  GstElement parent_instance;
+
+  GstPad *sinkpad;
+  GstPad *srcpad;
+  guint n_fec_pads;
+
+  /* Protected by the object lock */
+  gchar *ignore_pts;
+  /* Set when going to PAUSED, read by the streaming thread */
+  gboolean ignored[128];
+
+  /* Protected by the stream lock of the source pad, which also keeps
+   * the media and FEC threads from pushing at the same time */
+  GstRtpFecDecoder *dec;
+  gboolean have_segment;
+
+  /* Statistics, protected by the object lock */
+  guint64 fec_packets;
+  guint64 recovered;
+  guint64 unrecoverable;
+  guint64 duplicates;
+};
+
+enum
+{
+  PROP_0,
+
+  PROP_IGNORE_PTS,
+  PROP_STATS,
+
+  PROP_LAST
+};
+
+#define gst_rtp_fec_dec_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstRtpFecDec, gst_rtp_fec_dec, GST_TYPE_ELEMENT,
+    GST_DEBUG_CATEGORY_INIT (gst_rtp_fec_dec_debug, "nrtp_fecdec", 0,
+        "RTP FEC Decoder"));
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("application/x-rtp"));
+
+static GstStaticPadTemplate fec_template = GST_STATIC_PAD_TEMPLATE ("fec_%u",
+    GST_PAD_SINK,
+    GST_PAD_REQUEST,
+    GST_STATIC_CAPS_ANY);
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("application/x-rtp"));
+
+static GstStructure *
+gst_rtp_fec_dec_create_stats (GstRtpFecDec * self)
+{
+  GstStructure *s;
+
+  GST_OBJECT_LOCK (self);
+  s = gst_structure_new ("application/x-rtp-fec-dec-stats",
+      "fec-packets", G_TYPE_UINT64, self->fec_packets,
+      "recovered", G_TYPE_UINT64, self->recovered,
+      "unrecoverable", G_TYPE_UINT64, self->unrecoverable,
+      "duplicates", G_TYPE_UINT64, self->duplicates, NULL);
+  GST_OBJECT_UNLOCK (self);
+
+  return s;
+}
+
+static void
+gst_rtp_fec_dec_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstRtpFecDec *self = GST_RTP_FEC_DEC (object);
+
+  switch (prop_id) {
+    case PROP_IGNORE_PTS:
+      GST_OBJECT_LOCK (self);
+      g_free (self->ignore_pts);
+      self->ignore_pts = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_rtp_fec_dec_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstRtpFecDec *self = GST_RTP_FEC_DEC (object);
+
+  switch (prop_id) {
+    case PROP_IGNORE_PTS:
+      GST_OBJECT_LOCK (self);
+      g_value_set_string (value, self->ignore_pts);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_rtp_fec_dec_create_stats (self));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_rtp_fec_dec_finalize (GObject * gobject)
+{
+  GstRtpFecDec *self = GST_RTP_FEC_DEC (gobject);
+
+  gst_rtp_fec_decoder_free (self->dec);
+  g_free (self->ignore_pts);
+
+  G_OBJECT_CLASS (parent_class)->finalize (gobject);
+}
+
+/* Copy the counters of the decoder, with the stream lock held */
+static void
+gst_rtp_fec_dec_update_stats (GstRtpFecDec * self, guint fec_packets,
+    guint duplicates)
+{
+  GST_OBJECT_LOCK (self);
+  self->fec_packets += fec_packets;
+  self->duplicates += duplicates;
+  self->recovered = gst_rtp_fec_decoder_get_recovered (self->dec);
+  self->unrecoverable = gst_rtp_fec_decoder_get_unrecoverable (self->dec);
+  GST_OBJECT_UNLOCK (self);
+}
+
+/* Add the packets of @recovered to @list, a new one if it is %NULL */
+static GstBufferList *
+gst_rtp_fec_dec_take_recovered (GQueue * recovered, GstBufferList * list)
+{
+  GstBuffer *buffer;
+
+  if (list == NULL && recovered->length > 0)
+    list = gst_buffer_list_new_sized (recovered->length);
+  while ((buffer = g_queue_pop_head (recovered)))
+    gst_buffer_list_add (list, buffer);
+
+  return list;
+}
+
+static gboolean
+gst_rtp_fec_dec_is_ignored (GstRtpFecDec * self, GstBuffer * buffer)
+{
+  guint8 header[2];
+
+  if (gst_buffer_extract (buffer, 0, header, 2) < 2)
+    return FALSE;
+
+  return self->ignored[header[1] & 0x7f];
+}
+
+static GstFlowReturn
+gst_rtp_fec_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstRtpFecDec *self = GST_RTP_FEC_DEC (parent);
+  GQueue recovered = G_QUEUE_INIT;
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstBufferList *list;
+  guint duplicates = 0;
+
+  GST_PAD_STREAM_LOCK (self->srcpad);
+  if (gst_rtp_fec_dec_is_ignored (self, buffer)) {
+    ret = gst_pad_push (self->srcpad, buffer);
+  } else if (gst_rtp_fec_decoder_add_media (self->dec, buffer, &recovered)) {
+    ret = gst_pad_push (self->srcpad, buffer);
+  } else {
+    GST_LOG_OBJECT (self, "Dropping duplicate packet");
+    gst_buffer_unref (buffer);
+    duplicates++;
+  }
+
+  list = gst_rtp_fec_dec_take_recovered (&recovered, NULL);
+  if (list) {
+    GST_LOG_OBJECT (self, "Recovered %u packets",
+        gst_buffer_list_length (list));
+    if (ret == GST_FLOW_OK)
+      ret = gst_pad_push_list (self->srcpad, list);
+    else
+      gst_buffer_list_unref (list);
+  }
+  gst_rtp_fec_dec_update_stats (self, 0, duplicates);
+  GST_PAD_STREAM_UNLOCK (self->srcpad);
+
+  return ret;
+}
+
+/* The recovered packets are pushed with the batch they belong after */
+static GstFlowReturn
+gst_rtp_fec_dec_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstRtpFecDec *self = GST_RTP_FEC_DEC (parent);
+  GQueue recovered = G_QUEUE_INIT;
+  GstFlowReturn ret;
+  GstBufferList *out;
+  guint i, len, duplicates = 0;
+
+  len = gst_buffer_list_length (list);
+  out = gst_buffer_list_new_sized (len);
+
+  GST_PAD_STREAM_LOCK (self->srcpad);
+  for (i = 0; i < len; i++) {
+    GstBuffer *buffer = gst_buffer_list_get (list, i);
+
+    if (gst_rtp_fec_dec_is_ignored (self, buffer)
+        || gst_rtp_fec_decoder_add_media (self->dec, buffer, &recovered))
+      gst_buffer_list_add (out, gst_buffer_ref (buffer));
+    else
+      duplicates++;
+  }
+  gst_buffer_list_unref (list);
+
+  out = gst_rtp_fec_dec_take_recovered (&recovered, out);
+  if (gst_buffer_list_length (out) > 0) {
+    ret = gst_pad_push_list (self->srcpad, out);
+  } else {
+    gst_buffer_list_unref (out);
+    ret = GST_FLOW_OK;
+  }
+  gst_rtp_fec_dec_update_stats (self, 0, duplicates);
+  GST_PAD_STREAM_UNLOCK (self->srcpad);
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_rtp_fec_dec_fec_chain (GstPad * pad, GstObject * parent,
+    GstBuffer * buffer)
+{
+  GstRtpFecDec *self = GST_RTP_FEC_DEC (parent);
+  GQueue recovered = G_QUEUE_INIT;
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstBufferList *list;
+
+  GST_PAD_STREAM_LOCK (self->srcpad);
+  if (!gst_rtp_fec_decoder_add_fec (self->dec, buffer, &recovered))
+    GST_LOG_OBJECT (pad, "Ignoring invalid FEC packet");
+  gst_buffer_unref (buffer);
+
+  list = gst_rtp_fec_dec_take_recovered (&recovered, NULL);
+  if (list) {
+    GST_LOG_OBJECT (self, "Recovered %u packets",
+        gst_buffer_list_length (list));
+    /* Nothing may be pushed before the media stream started */
+    if (self->have_segment)
+      ret = gst_pad_push_list (self->srcpad, list);
+    else
+      gst_buffer_list_unref (list);
+  }
+  gst_rtp_fec_dec_update_stats (self, 1, 0);
+  GST_PAD_STREAM_UNLOCK (self->srcpad);
+
+  /* Only flushing stops the FEC stream, the media stream reports the
+   * other flow returns of downstream */
+  return ret == GST_FLOW_FLUSHING ? ret : GST_FLOW_OK;
+}
+
+static gboolean
+gst_rtp_fec_dec_sink_event (GstPad * pad, GstObject * parent,
+    GstEvent * event)
+{
+  GstRtpFecDec *self = GST_RTP_FEC_DEC (parent);
+  gboolean res;
+
+  if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP) {
+    res = gst_pad_push_event (self->srcpad, event);
+
+    GST_PAD_STREAM_LOCK (self->srcpad);
+    gst_rtp_fec_decoder_reset (self->dec);
+    GST_PAD_STREAM_UNLOCK (self->srcpad);
+    return res;
+  }
+
+  if (!GST_EVENT_IS_SERIALIZED (event))
+    return gst_pad_event_default (pad, parent, event);
+
+  /* Serialized events keep their place between the packets that the FEC
+   * threads push */
+  GST_PAD_STREAM_LOCK (self->srcpad);
+  if (GST_EVENT_TYPE (event) == GST_EVENT_SEGMENT)
+    self->have_segment = TRUE;
+  res = gst_pad_event_default (pad, parent, event);
+  GST_PAD_STREAM_UNLOCK (self->srcpad);
+
+  return res;
+}
+
+/* The FEC streams only feed the decoder */
+static gboolean
+gst_rtp_fec_dec_fec_event (GstPad * pad, GstObject * parent,
+    GstEvent * event)
+{
+  gst_event_unref (event);
+
+  return TRUE;
+}
+
+static GstPad *
+gst_rtp_fec_dec_request_new_pad (GstElement * element,
+    GstPadTemplate * templ, const gchar * name, const GstCaps * caps)
+{
+  GstRtpFecDec *self = GST_RTP_FEC_DEC (element);
+  gchar *pad_name = NULL;
+  GstPad *pad;
+  guint id;
+
+  GST_OBJECT_LOCK (self);
+  if (name == NULL) {
+    pad_name = g_strdup_printf ("fec_%u", self->n_fec_pads++);
+    name = pad_name;
+  } else if (sscanf (name, "fec_%u", &id) == 1 && id >= self->n_fec_pads) {
+    /* Later pads without a name are numbered after this one */
+    self->n_fec_pads = id + 1;
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  pad = gst_pad_new_from_template (templ, name);
+  g_free (pad_name);
+
+  gst_pad_set_chain_function (pad,
+      GST_DEBUG_FUNCPTR (gst_rtp_fec_dec_fec_chain));
+  gst_pad_set_event_function (pad,
+      GST_DEBUG_FUNCPTR (gst_rtp_fec_dec_fec_event));
+
+  if (!gst_element_add_pad (element, pad)) {
+    gst_object_unref (pad);
+    return NULL;
+  }
+
+  return pad;
+}
+
+static void
+gst_rtp_fec_dec_release_pad (GstElement * element, GstPad * pad)
+{
+  gst_element_remove_pad (element, pad);
+}
+
+static gboolean
+gst_rtp_fec_dec_start (GstRtpFecDec * self)
+{
+  GArray *pts = NULL;
+  gchar *ignore_pts;
+  guint i;
+
+  GST_OBJECT_LOCK (self);
+  ignore_pts = g_strdup (self->ignore_pts);
+  GST_OBJECT_UNLOCK (self);
+
+  if (ignore_pts) {
+    pts = gst_rtp_filter_parse_list (ignore_pts, 127);
+    if (pts == NULL)
+      goto invalid_pts;
+  }
+
+  memset (self->ignored, 0, sizeof (self->ignored));
+  for (i = 0; pts && i < pts->len; i++)
+    self->ignored[g_array_index (pts, guint32, i)] = TRUE;
+  if (pts)
+    g_array_unref (pts);
+  g_free (ignore_pts);
+
+  return TRUE;
+
+invalid_pts:
+  {
+    GST_ELEMENT_ERROR (self, RESOURCE, SETTINGS, (NULL),
+        ("Invalid ignore-pts '%s'", ignore_pts));
+    g_free (ignore_pts);
+    return FALSE;
+  }
+}
+
+static GstStateChangeReturn
+gst_rtp_fec_dec_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstRtpFecDec *self = GST_RTP_FEC_DEC (element);
+  GstStateChangeReturn ret;
+
+  if (transition == GST_STATE_CHANGE_NULL_TO_READY)
+    GST_INFO_OBJECT (self, "Recovering with the %s XOR kernel",
+        gst_rtp_xor_impl_get_name (gst_rtp_xor_get_impl ()));
+
+  if (transition == GST_STATE_CHANGE_READY_TO_PAUSED
+      && !gst_rtp_fec_dec_start (self))
+    return GST_STATE_CHANGE_FAILURE;
+
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+  /* The FEC streams may still be stopping */
+  if (transition == GST_STATE_CHANGE_PAUSED_TO_READY) {
+    GST_PAD_STREAM_LOCK (self->srcpad);
+    gst_rtp_fec_decoder_reset (self->dec);
+    self->have_segment = FALSE;
+    GST_PAD_STREAM_UNLOCK (self->srcpad);
+  }
+
+  return ret;
+}
+
+static void
+gst_rtp_fec_dec_class_init (GstRtpFecDecClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *gstelement_class = GST_ELEMENT_CLASS (klass);
+
+  gobject_class->set_property = gst_rtp_fec_dec_set_property;
+  gobject_class->get_property = gst_rtp_fec_dec_get_property;
+  gobject_class->finalize = gst_rtp_fec_dec_finalize;
+
+  gstelement_class->request_new_pad =
+      GST_DEBUG_FUNCPTR (gst_rtp_fec_dec_request_new_pad);
+  gstelement_class->release_pad =
+      GST_DEBUG_FUNCPTR (gst_rtp_fec_dec_release_pad);
+  gstelement_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_rtp_fec_dec_change_state);
+
+  /**
+   * GstRtpFecDec:ignore-pts:
+   *
+   * Comma separated list of payload types that pass without being used
+   * for recovery, like the retransmissions of #GstRtpSrc:rtx, which have
+   * an SSRC and sequence numbers of their own.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_IGNORE_PTS,
+      g_param_spec_string ("ignore-pts", "Ignore payload types",
+          "Comma separated payload types to pass without FEC",
+          DEFAULT_PROP_IGNORE_PTS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpFecDec:stats:
+   *
+   * Statistics in a "application/x-rtp-fec-dec-stats" structure: the
+   * number of "fec-packets" received, the number of packets "recovered",
+   * the number of FEC packets that were "unrecoverable" because more
+   * than one of the packets they protect was lost, and the number of
+   * "duplicates" dropped, all as G_TYPE_UINT64.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics", "FEC recovery statistics",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_add_pad_template (gstelement_class,
+      gst_static_pad_template_get (&sink_template));
+  gst_element_class_add_pad_template (gstelement_class,
+      gst_static_pad_template_get (&fec_template));
+  gst_element_class_add_pad_template (gstelement_class,
+      gst_static_pad_template_get (&src_template));
+
+  gst_element_class_set_static_metadata (gstelement_class,
+      "RTP FEC decoder",
+      "Codec/Depayloader/Network/RTP",
+      "Recover lost RTP packets with SMPTE 2022-1 FEC",
+      "Marc Leeman <marc.leeman@gmail.com>");
+}
+
+static void
+gst_rtp_fec_dec_init (GstRtpFecDec * self)
+{
+  self->sinkpad = gst_pad_new_from_static_template (&sink_template, "sink");
+  gst_pad_set_chain_function (self->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_rtp_fec_dec_chain));
+  gst_pad_set_chain_list_function (self->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_rtp_fec_dec_chain_list));
+  gst_pad_set_event_function (self->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_rtp_fec_dec_sink_event));
+  GST_PAD_SET_PROXY_CAPS (self->sinkpad);
+  GST_PAD_SET_PROXY_ALLOCATION (self->sinkpad);
+  gst_element_add_pad (GST_ELEMENT (self), self->sinkpad);
+
+  self->srcpad = gst_pad_new_from_static_template (&src_template, "src");
+  GST_PAD_SET_PROXY_CAPS (self->srcpad);
+  gst_element_add_pad (GST_ELEMENT (self), self->srcpad);
+
+  self->dec = gst_rtp_fec_decoder_new ();
+  self->ignore_pts = DEFAULT_PROP_IGNORE_PTS;
+}
+
+/* ex: set tabstop=2 shiftwidth=2 expandtab: */
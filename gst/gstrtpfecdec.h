@@ -0,0 +1,12 @@
+#ifndef _GST_RTP_FEC_DEC_H_
+#define _GST_RTP_FEC_DEC_H_
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+#define GST_TYPE_RTP_FEC_DEC (gst_rtp_fec_dec_get_type ())
+G_DECLARE_FINAL_TYPE (GstRtpFecDec, gst_rtp_fec_dec, GST, RTP_FEC_DEC,
+    GstElement);
+G_END_DECLS
+
+#endif
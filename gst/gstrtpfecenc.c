@@ -0,0 +1,642 @@
+/* GStreamer
+ * Copyright (C) <2018> Marc Leeman <marc.leeman@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION: gstrtpfecenc
+ * @title: GstRtpFecEnc
+ * @short description: generates SMPTE 2022-1 FEC for an RTP stream.
+ *
+ * This element is used by #GstRtpSink to protect the sent packets. The
+ * media packets enter on the sink pad and leave on the source pad
+ * unchanged. They are arranged in a matrix of #GstRtpFecEnc:columns by
+ * #GstRtpFecEnc:rows packets, and the column FEC is pushed on the fec_0
+ * request pad and the row FEC on the fec_1 request pad as soon as the
+ * last packet of a column or row passed. Only the FEC of the requested
+ * pads is computed. nrtp_fecdec recovers the packets on the receiving
+ * side.
+ *
+ * The FEC pads are to be requested before the stream starts, they get
+ * their stream-start, segment and EOS events from the media stream.
+ *
+ * Packets of the payload types in #GstRtpFecEnc:ignore-pts, such as
+ * retransmissions, pass without being protected and without ending the
+ * matrix.
+ *
+ * As in SMPTE 2022-1, the FEC streams protect a single SSRC: the FEC
+ * packets only name the sequence numbers they cover and the receiver
+ * finds the media by port. A packet of another SSRC ends the matrix, so
+ * interleaved streams are barely protected and need an encoder each.
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include "gstrtpfecenc.h"
+#include "gstrtp-fec.h"
+#include "gstrtp-xor.h"
+#include "gstrtp-filter.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_rtp_fec_enc_debug);
+#define GST_CAT_DEFAULT gst_rtp_fec_enc_debug
+
+#define DEFAULT_PROP_COLUMNS          10
+#define DEFAULT_PROP_ROWS             10
+#define DEFAULT_PROP_IGNORE_PTS       NULL
+
+/* SMPTE 2022-1 limits the matrix to 20 columns or rows and 100 packets */
+#define MAX_MATRIX_SIDE               20
+#define MAX_MATRIX_SIZE               100
+
+/* The column and row FEC pads */
+#define N_FEC_PADS                    2
+
+struct _GstRtpFecEnc
+{
+  GstElement parent_instance;
+
+  GstPad *sinkpad;
+  GstPad *srcpad;
+  /* Protected by the object lock */
+  GstPad *fecpad[N_FEC_PADS];
+
+  /* Properties, protected by the object lock */
+  guint columns;
+  guint rows;
+  gchar *ignore_pts;
+
+  /* Created when going to PAUSED, used by the streaming thread */
+  GstRtpFecEncoder *enc;
+  gboolean ignored[128];
+
+  /* Statistics, protected by the object lock */
+  guint64 media_packets;
+  guint64 fec_packets;
+};
+
+enum
+{
+  PROP_0,
+
+  PROP_COLUMNS,
+  PROP_ROWS,
+  PROP_IGNORE_PTS,
+  PROP_STATS,
+
+  PROP_LAST
+};
+
+#define gst_rtp_fec_enc_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstRtpFecEnc, gst_rtp_fec_enc, GST_TYPE_ELEMENT,
+    GST_DEBUG_CATEGORY_INIT (gst_rtp_fec_enc_debug, "nrtp_fecenc", 0,
+        "RTP FEC Encoder"));
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("application/x-rtp"));
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("application/x-rtp"));
+
+static GstStaticPadTemplate fec_template = GST_STATIC_PAD_TEMPLATE ("fec_%u",
+    GST_PAD_SRC,
+    GST_PAD_REQUEST,
+    GST_STATIC_CAPS_ANY);
+
+static GstStructure *
+gst_rtp_fec_enc_create_stats (GstRtpFecEnc * self)
+{
+  GstStructure *s;
+
+  GST_OBJECT_LOCK (self);
+  s = gst_structure_new ("application/x-rtp-fec-enc-stats",
+      "media-packets", G_TYPE_UINT64, self->media_packets,
+      "fec-packets", G_TYPE_UINT64, self->fec_packets, NULL);
+  GST_OBJECT_UNLOCK (self);
+
+  return s;
+}
+
+static void
+gst_rtp_fec_enc_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstRtpFecEnc *self = GST_RTP_FEC_ENC (object);
+
+  switch (prop_id) {
+    case PROP_COLUMNS:
+      GST_OBJECT_LOCK (self);
+      self->columns = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_ROWS:
+      GST_OBJECT_LOCK (self);
+      self->rows = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_IGNORE_PTS:
+      GST_OBJECT_LOCK (self);
+      g_free (self->ignore_pts);
+      self->ignore_pts = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_rtp_fec_enc_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstRtpFecEnc *self = GST_RTP_FEC_ENC (object);
+
+  switch (prop_id) {
+    case PROP_COLUMNS:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, self->columns);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_ROWS:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, self->rows);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_IGNORE_PTS:
+      GST_OBJECT_LOCK (self);
+      g_value_set_string (value, self->ignore_pts);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_rtp_fec_enc_create_stats (self));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_rtp_fec_enc_finalize (GObject * gobject)
+{
+  GstRtpFecEnc *self = GST_RTP_FEC_ENC (gobject);
+
+  g_clear_pointer (&self->enc, gst_rtp_fec_encoder_free);
+  g_free (self->ignore_pts);
+
+  G_OBJECT_CLASS (parent_class)->finalize (gobject);
+}
+
+/* Take a reference to each requested FEC pad */
+static void
+gst_rtp_fec_enc_get_fec_pads (GstRtpFecEnc * self, GstPad ** pads)
+{
+  guint i;
+
+  GST_OBJECT_LOCK (self);
+  for (i = 0; i < N_FEC_PADS; i++)
+    pads[i] = self->fecpad[i] ? gst_object_ref (self->fecpad[i]) : NULL;
+  GST_OBJECT_UNLOCK (self);
+}
+
+/* Push the FEC packets of @fec on the matching pads of @pads and drop the
+ * pad references. The flow return of the FEC streams is not passed
+ * upstream, losing them only costs the protection. */
+static void
+gst_rtp_fec_enc_push_fec (GstRtpFecEnc * self, GstPad ** pads, GQueue * fec,
+    guint media_packets)
+{
+  guint64 fec_packets = 0;
+  GstBuffer *buffer;
+  guint i;
+
+  for (i = 0; i < N_FEC_PADS; i++) {
+    GstBufferList *list;
+    GstFlowReturn ret;
+
+    if (pads[i] == NULL)
+      continue;
+
+    if (fec[i].length > 0) {
+      fec_packets += fec[i].length;
+      list = gst_buffer_list_new_sized (fec[i].length);
+      while ((buffer = g_queue_pop_head (&fec[i])))
+        gst_buffer_list_add (list, buffer);
+
+      ret = gst_pad_push_list (pads[i], list);
+      if (ret != GST_FLOW_OK)
+        GST_LOG_OBJECT (pads[i], "Pushing FEC returned %s",
+            gst_flow_get_name (ret));
+    }
+    gst_object_unref (pads[i]);
+  }
+
+  GST_OBJECT_LOCK (self);
+  self->media_packets += media_packets;
+  self->fec_packets += fec_packets;
+  GST_OBJECT_UNLOCK (self);
+}
+
+static gboolean
+gst_rtp_fec_enc_is_ignored (GstRtpFecEnc * self, GstBuffer * buffer)
+{
+  guint8 header[2];
+
+  if (gst_buffer_extract (buffer, 0, header, 2) < 2)
+    return FALSE;
+
+  return self->ignored[header[1] & 0x7f];
+}
+
+static GstFlowReturn
+gst_rtp_fec_enc_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstRtpFecEnc *self = GST_RTP_FEC_ENC (parent);
+  GQueue fec[N_FEC_PADS] = { G_QUEUE_INIT, G_QUEUE_INIT };
+  GstPad *pads[N_FEC_PADS];
+  GstFlowReturn ret;
+
+  if (gst_rtp_fec_enc_is_ignored (self, buffer))
+    return gst_pad_push (self->srcpad, buffer);
+
+  gst_rtp_fec_enc_get_fec_pads (self, pads);
+  gst_rtp_fec_encoder_add_media (self->enc, buffer, pads[0] ? &fec[0] : NULL,
+      pads[1] ? &fec[1] : NULL);
+
+  ret = gst_pad_push (self->srcpad, buffer);
+  gst_rtp_fec_enc_push_fec (self, pads, fec, 1);
+
+  return ret;
+}
+
+/* The parity of the whole batch is computed before any of it is pushed */
+static GstFlowReturn
+gst_rtp_fec_enc_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstRtpFecEnc *self = GST_RTP_FEC_ENC (parent);
+  GQueue fec[N_FEC_PADS] = { G_QUEUE_INIT, G_QUEUE_INIT };
+  GstPad *pads[N_FEC_PADS];
+  GstFlowReturn ret;
+  guint i, len, media_packets = 0;
+
+  gst_rtp_fec_enc_get_fec_pads (self, pads);
+  len = gst_buffer_list_length (list);
+  for (i = 0; i < len; i++) {
+    GstBuffer *buffer = gst_buffer_list_get (list, i);
+
+    if (gst_rtp_fec_enc_is_ignored (self, buffer))
+      continue;
+    gst_rtp_fec_encoder_add_media (self->enc, buffer,
+        pads[0] ? &fec[0] : NULL, pads[1] ? &fec[1] : NULL);
+    media_packets++;
+  }
+
+  ret = gst_pad_push_list (self->srcpad, list);
+  gst_rtp_fec_enc_push_fec (self, pads, fec, media_packets);
+
+  return ret;
+}
+
+/* Every FEC stream is a stream of its own, like the streams of a
+ * demuxer */
+static void
+gst_rtp_fec_enc_start_fec_streams (GstRtpFecEnc * self, GstEvent * event)
+{
+  GstPad *pads[N_FEC_PADS];
+  const gchar *upstream_id;
+  guint group_id, i;
+  gboolean have_group;
+
+  gst_event_parse_stream_start (event, &upstream_id);
+  have_group = gst_event_parse_group_id (event, &group_id);
+
+  gst_rtp_fec_enc_get_fec_pads (self, pads);
+  for (i = 0; i < N_FEC_PADS; i++) {
+    GstEvent *start;
+    gchar *stream_id;
+
+    if (pads[i] == NULL)
+      continue;
+
+    stream_id = g_strdup_printf ("%s/%s", upstream_id,
+        GST_OBJECT_NAME (pads[i]));
+    start = gst_event_new_stream_start (stream_id);
+    if (have_group)
+      gst_event_set_group_id (start, group_id);
+    gst_pad_push_event (pads[i], start);
+    g_free (stream_id);
+    gst_object_unref (pads[i]);
+  }
+}
+
+static void
+gst_rtp_fec_enc_push_fec_event (GstRtpFecEnc * self, GstEvent * event)
+{
+  GstPad *pads[N_FEC_PADS];
+  guint i;
+
+  gst_rtp_fec_enc_get_fec_pads (self, pads);
+  for (i = 0; i < N_FEC_PADS; i++) {
+    if (pads[i] == NULL)
+      continue;
+
+    gst_pad_push_event (pads[i], gst_event_ref (event));
+    gst_object_unref (pads[i]);
+  }
+}
+
+static gboolean
+gst_rtp_fec_enc_sink_event (GstPad * pad, GstObject * parent,
+    GstEvent * event)
+{
+  GstRtpFecEnc *self = GST_RTP_FEC_ENC (parent);
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_STREAM_START:
+      gst_rtp_fec_enc_start_fec_streams (self, event);
+      break;
+    case GST_EVENT_EOS:{
+      GQueue fec[N_FEC_PADS] = { G_QUEUE_INIT, G_QUEUE_INIT };
+      GstPad *pads[N_FEC_PADS];
+
+      /* Protect the packets of the last, incomplete matrix as well */
+      gst_rtp_fec_enc_get_fec_pads (self, pads);
+      gst_rtp_fec_encoder_flush (self->enc, pads[0] ? &fec[0] : NULL,
+          pads[1] ? &fec[1] : NULL);
+      gst_rtp_fec_enc_push_fec (self, pads, fec, 0);
+      gst_rtp_fec_enc_push_fec_event (self, event);
+      break;
+    }
+    case GST_EVENT_FLUSH_STOP:
+      gst_rtp_fec_encoder_reset (self->enc);
+      gst_rtp_fec_enc_push_fec_event (self, event);
+      break;
+    case GST_EVENT_SEGMENT:
+    case GST_EVENT_FLUSH_START:
+      gst_rtp_fec_enc_push_fec_event (self, event);
+      break;
+    default:
+      break;
+  }
+
+  /* The caps and other events only describe the media stream */
+  return gst_pad_push_event (self->srcpad, event);
+}
+
+static GstPad *
+gst_rtp_fec_enc_request_new_pad (GstElement * element,
+    GstPadTemplate * templ, const gchar * name, const GstCaps * caps)
+{
+  GstRtpFecEnc *self = GST_RTP_FEC_ENC (element);
+  gchar pad_name[16];
+  GstPad *pad;
+  guint i;
+
+  GST_OBJECT_LOCK (self);
+  for (i = 0; i < N_FEC_PADS; i++) {
+    g_snprintf (pad_name, sizeof (pad_name), "fec_%u", i);
+    if (self->fecpad[i] == NULL && (name == NULL
+            || g_strcmp0 (name, pad_name) == 0))
+      break;
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  if (i == N_FEC_PADS) {
+    GST_WARNING_OBJECT (self, "Only fec_0 and fec_1 can be requested once");
+    return NULL;
+  }
+
+  pad = gst_pad_new_from_template (templ, pad_name);
+  if (!gst_element_add_pad (element, pad)) {
+    gst_object_unref (pad);
+    return NULL;
+  }
+
+  GST_OBJECT_LOCK (self);
+  self->fecpad[i] = pad;
+  GST_OBJECT_UNLOCK (self);
+
+  return pad;
+}
+
+static void
+gst_rtp_fec_enc_release_pad (GstElement * element, GstPad * pad)
+{
+  GstRtpFecEnc *self = GST_RTP_FEC_ENC (element);
+  guint i;
+
+  GST_OBJECT_LOCK (self);
+  for (i = 0; i < N_FEC_PADS; i++) {
+    if (self->fecpad[i] == pad)
+      self->fecpad[i] = NULL;
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  gst_element_remove_pad (element, pad);
+}
+
+static gboolean
+gst_rtp_fec_enc_start (GstRtpFecEnc * self)
+{
+  guint columns, rows, i;
+  gchar *ignore_pts;
+  GArray *pts = NULL;
+
+  GST_OBJECT_LOCK (self);
+  columns = self->columns;
+  rows = self->rows;
+  ignore_pts = g_strdup (self->ignore_pts);
+  GST_OBJECT_UNLOCK (self);
+
+  if (columns * rows > MAX_MATRIX_SIZE)
+    goto invalid_matrix;
+
+  if (ignore_pts) {
+    pts = gst_rtp_filter_parse_list (ignore_pts, 127);
+    if (pts == NULL)
+      goto invalid_pts;
+  }
+  memset (self->ignored, 0, sizeof (self->ignored));
+  for (i = 0; pts && i < pts->len; i++)
+    self->ignored[g_array_index (pts, guint32, i)] = TRUE;
+  if (pts)
+    g_array_unref (pts);
+  g_free (ignore_pts);
+
+  GST_INFO_OBJECT (self, "Protecting %ux%u matrices with the %s XOR kernel",
+      columns, rows, gst_rtp_xor_impl_get_name (gst_rtp_xor_get_impl ()));
+  self->enc = gst_rtp_fec_encoder_new (columns, rows);
+
+  return TRUE;
+
+invalid_matrix:
+  {
+    GST_ELEMENT_ERROR (self, RESOURCE, SETTINGS, (NULL),
+        ("A matrix of %u columns and %u rows has more than %u packets",
+            columns, rows, MAX_MATRIX_SIZE));
+    g_free (ignore_pts);
+    return FALSE;
+  }
+invalid_pts:
+  {
+    GST_ELEMENT_ERROR (self, RESOURCE, SETTINGS, (NULL),
+        ("Invalid ignore-pts '%s'", ignore_pts));
+    g_free (ignore_pts);
+    return FALSE;
+  }
+}
+
+static GstStateChangeReturn
+gst_rtp_fec_enc_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstRtpFecEnc *self = GST_RTP_FEC_ENC (element);
+  GstStateChangeReturn ret;
+
+  if (transition == GST_STATE_CHANGE_READY_TO_PAUSED
+      && !gst_rtp_fec_enc_start (self))
+    return GST_STATE_CHANGE_FAILURE;
+
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+  /* The streaming thread stopped with the pads */
+  if (transition == GST_STATE_CHANGE_PAUSED_TO_READY)
+    g_clear_pointer (&self->enc, gst_rtp_fec_encoder_free);
+
+  return ret;
+}
+
+static void
+gst_rtp_fec_enc_class_init (GstRtpFecEncClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *gstelement_class = GST_ELEMENT_CLASS (klass);
+
+  gobject_class->set_property = gst_rtp_fec_enc_set_property;
+  gobject_class->get_property = gst_rtp_fec_enc_get_property;
+  gobject_class->finalize = gst_rtp_fec_enc_finalize;
+
+  gstelement_class->request_new_pad =
+      GST_DEBUG_FUNCPTR (gst_rtp_fec_enc_request_new_pad);
+  gstelement_class->release_pad =
+      GST_DEBUG_FUNCPTR (gst_rtp_fec_enc_release_pad);
+  gstelement_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_rtp_fec_enc_change_state);
+
+  /**
+   * GstRtpFecEnc:columns:
+   *
+   * L, the number of columns of the matrix and the number of consecutive
+   * packets a row FEC packet protects. The column FEC costs 1 / rows and
+   * the row FEC 1 / columns of the bandwidth. Columns and rows together
+   * cover at most 100 packets. The matrix is set up when going to PAUSED.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_COLUMNS,
+      g_param_spec_uint ("columns", "Columns",
+          "Number of columns (L) of the FEC matrix", 1, MAX_MATRIX_SIDE,
+          DEFAULT_PROP_COLUMNS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpFecEnc:rows:
+   *
+   * D, the number of rows of the matrix and the number of packets a column
+   * FEC packet protects, every columns-th packet. A burst of up to
+   * columns packets is recovered from the column FEC.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_ROWS,
+      g_param_spec_uint ("rows", "Rows",
+          "Number of rows (D) of the FEC matrix", 1, MAX_MATRIX_SIDE,
+          DEFAULT_PROP_ROWS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpFecEnc:ignore-pts:
+   *
+   * Comma separated list of payload types that pass without FEC, like
+   * the retransmissions of #GstRtpSink:rtx, which have an SSRC and
+   * sequence numbers of their own.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_IGNORE_PTS,
+      g_param_spec_string ("ignore-pts", "Ignore payload types",
+          "Comma separated payload types to pass without FEC",
+          DEFAULT_PROP_IGNORE_PTS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpFecEnc:stats:
+   *
+   * Statistics in a "application/x-rtp-fec-enc-stats" structure: the
+   * number of "media-packets" protected and the number of "fec-packets"
+   * sent, both as G_TYPE_UINT64.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics", "FEC encoding statistics",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_add_pad_template (gstelement_class,
+      gst_static_pad_template_get (&sink_template));
+  gst_element_class_add_pad_template (gstelement_class,
+      gst_static_pad_template_get (&src_template));
+  gst_element_class_add_pad_template (gstelement_class,
+      gst_static_pad_template_get (&fec_template));
+
+  gst_element_class_set_static_metadata (gstelement_class,
+      "RTP FEC encoder",
+      "Codec/Payloader/Network/RTP",
+      "Generate SMPTE 2022-1 FEC for an RTP stream",
+      "Marc Leeman <marc.leeman@gmail.com>");
+}
+
+static void
+gst_rtp_fec_enc_init (GstRtpFecEnc * self)
+{
+  self->sinkpad = gst_pad_new_from_static_template (&sink_template, "sink");
+  gst_pad_set_chain_function (self->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_rtp_fec_enc_chain));
+  gst_pad_set_chain_list_function (self->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_rtp_fec_enc_chain_list));
+  gst_pad_set_event_function (self->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_rtp_fec_enc_sink_event));
+  GST_PAD_SET_PROXY_CAPS (self->sinkpad);
+  GST_PAD_SET_PROXY_ALLOCATION (self->sinkpad);
+  gst_element_add_pad (GST_ELEMENT (self), self->sinkpad);
+
+  self->srcpad = gst_pad_new_from_static_template (&src_template, "src");
+  GST_PAD_SET_PROXY_CAPS (self->srcpad);
+  gst_element_add_pad (GST_ELEMENT (self), self->srcpad);
+
+  self->columns = DEFAULT_PROP_COLUMNS;
+  self->rows = DEFAULT_PROP_ROWS;
+  self->ignore_pts = DEFAULT_PROP_IGNORE_PTS;
+}
+
+/* ex: set tabstop=2 shiftwidth=2 expandtab: */
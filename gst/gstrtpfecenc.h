@@ -0,0 +1,12 @@
+#ifndef _GST_RTP_FEC_ENC_H_
+#define _GST_RTP_FEC_ENC_H_
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+#define GST_TYPE_RTP_FEC_ENC (gst_rtp_fec_enc_get_type ())
+G_DECLARE_FINAL_TYPE (GstRtpFecEnc, gst_rtp_fec_enc, GST, RTP_FEC_ENC,
+    GstElement);
+G_END_DECLS
+
+#endif
@@ -0,0 +1,768 @@
+/* GStreamer
+ * Copyright (C) <2018> Marc Leeman <marc.leeman@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION: gstrtppacer
+ * @title: GstRtpPacer
+ * @short description: spreads outgoing RTP packets evenly over time.
+ *
+ * This element is used by #GstRtpSink to pace the RTP packets that are
+ * sent, so that a large frame does not leave as a burst at line rate.
+ * Packets are queued and pushed from a separate thread by a token bucket
+ * that fills up at #GstRtpPacer:bitrate and holds at most
+ * #GstRtpPacer:burst bytes. When no bitrate is set, the rate is derived
+ * from the buffer timestamps: the bytes of a frame are spread over the
+ * time until the next frame, with some headroom.
+ *
+ * Packets that may be sent at the same moment are pushed as one buffer
+ * list, so batched sending still works. The time a packet waits for its
+ * turn is reported in #GstRtpPacer:stats. The time it takes to send a
+ * full #GstRtpPacer:burst at the pacing rate is added to the latency.
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <errno.h>
+#include <time.h>
+
+#include "gstrtppacer.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_rtp_pacer_debug);
+#define GST_CAT_DEFAULT gst_rtp_pacer_debug
+
+#define DEFAULT_PROP_BITRATE          0
+#define DEFAULT_PROP_BURST            3000
+#define DEFAULT_PROP_MAX_SIZE_BUFFERS 1024
+
+/* Pace a derived rate this much faster than the stream, so the queue
+ * drains between frames */
+#define RATE_HEADROOM                 1.25
+/* Longest buffer list pushed at once */
+#define MAX_LIST_LENGTH               64
+/* Waits longer than this are done on the condition variable, so that
+ * flushing interrupts them, the remainder is slept precisely */
+#define COARSE_WAIT_MARGIN            (500 * GST_USECOND)
+
+typedef struct
+{
+  GstMiniObject *object;
+  /* GstBuffer size, 0 for events */
+  gsize size;
+  GstClockTime enqueued;
+} GstRtpPacerItem;
+
+struct _GstRtpPacer
+{
+  GstElement parent_instance;
+
+  GstPad *sinkpad;
+  GstPad *srcpad;
+
+  /* Properties */
+  guint64 bitrate;
+  guint burst;
+  guint max_size_buffers;
+
+  /* Queue, protected by the lock */
+  GMutex lock;
+  GCond cond;
+  GQueue queue;
+  guint n_buffers;
+  gboolean flushing;
+  GstFlowReturn srcresult;
+
+  /* Rate derived from the timestamps in bytes per second, protected by
+   * the lock */
+  GstClockTime frame_pts;
+  guint64 frame_bytes;
+  gdouble derived_rate;
+
+  /* Token bucket, only used by the streaming thread */
+  gdouble tokens;
+  GstClockTime last_refill;
+
+  /* Statistics, protected by the lock */
+  guint max_queued;
+  guint64 packets_paced;
+  GstClockTime total_delay;
+  GstClockTime max_delay;
+};
+
+enum
+{
+  PROP_0,
+
+  PROP_BITRATE,
+  PROP_BURST,
+  PROP_MAX_SIZE_BUFFERS,
+  PROP_STATS,
+
+  PROP_LAST
+};
+
+#define gst_rtp_pacer_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstRtpPacer, gst_rtp_pacer, GST_TYPE_ELEMENT,
+    GST_DEBUG_CATEGORY_INIT (gst_rtp_pacer_debug, "nrtp_pacer", 0,
+        "RTP Pacer"));
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+static GstClockTime
+gst_rtp_pacer_now (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+
+  return GST_TIMESPEC_TO_TIME (ts);
+}
+
+static GstStructure *
+gst_rtp_pacer_create_stats (GstRtpPacer * self)
+{
+  GstStructure *s;
+  guint64 rate;
+
+  g_mutex_lock (&self->lock);
+  rate = self->bitrate ? self->bitrate :
+      (guint64) (self->derived_rate * RATE_HEADROOM * 8);
+  s = gst_structure_new ("application/x-rtp-pacer-stats",
+      "queue-depth", G_TYPE_UINT, self->n_buffers,
+      "max-queue-depth", G_TYPE_UINT, self->max_queued,
+      "packets-paced", G_TYPE_UINT64, self->packets_paced,
+      "average-delay", G_TYPE_UINT64, self->packets_paced ?
+      self->total_delay / self->packets_paced : (guint64) 0,
+      "max-delay", G_TYPE_UINT64, self->max_delay,
+      "bitrate", G_TYPE_UINT64, rate, NULL);
+  g_mutex_unlock (&self->lock);
+
+  return s;
+}
+
+static void
+gst_rtp_pacer_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstRtpPacer *self = GST_RTP_PACER (object);
+
+  switch (prop_id) {
+    case PROP_BITRATE:
+      g_mutex_lock (&self->lock);
+      self->bitrate = g_value_get_uint64 (value);
+      g_cond_broadcast (&self->cond);
+      g_mutex_unlock (&self->lock);
+      gst_element_post_message (GST_ELEMENT (self),
+          gst_message_new_latency (GST_OBJECT (self)));
+      break;
+    case PROP_BURST:
+      g_mutex_lock (&self->lock);
+      self->burst = g_value_get_uint (value);
+      g_mutex_unlock (&self->lock);
+      gst_element_post_message (GST_ELEMENT (self),
+          gst_message_new_latency (GST_OBJECT (self)));
+      break;
+    case PROP_MAX_SIZE_BUFFERS:
+      g_mutex_lock (&self->lock);
+      self->max_size_buffers = g_value_get_uint (value);
+      g_cond_broadcast (&self->cond);
+      g_mutex_unlock (&self->lock);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_rtp_pacer_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstRtpPacer *self = GST_RTP_PACER (object);
+
+  switch (prop_id) {
+    case PROP_BITRATE:
+      g_value_set_uint64 (value, self->bitrate);
+      break;
+    case PROP_BURST:
+      g_value_set_uint (value, self->burst);
+      break;
+    case PROP_MAX_SIZE_BUFFERS:
+      g_value_set_uint (value, self->max_size_buffers);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_rtp_pacer_create_stats (self));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_rtp_pacer_item_free (GstRtpPacerItem * item)
+{
+  gst_mini_object_unref (item->object);
+  g_slice_free (GstRtpPacerItem, item);
+}
+
+static void
+gst_rtp_pacer_clear_unlocked (GstRtpPacer * self)
+{
+  GstRtpPacerItem *item;
+
+  while ((item = g_queue_pop_head (&self->queue)))
+    gst_rtp_pacer_item_free (item);
+  self->n_buffers = 0;
+  self->frame_pts = GST_CLOCK_TIME_NONE;
+  self->frame_bytes = 0;
+  g_cond_broadcast (&self->cond);
+}
+
+static void
+gst_rtp_pacer_finalize (GObject * gobject)
+{
+  GstRtpPacer *self = GST_RTP_PACER (gobject);
+
+  gst_rtp_pacer_clear_unlocked (self);
+  g_mutex_clear (&self->lock);
+  g_cond_clear (&self->cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (gobject);
+}
+
+/* Update the rate derived from the timestamps: all packets of a frame
+ * have the same timestamp, their bytes are to be sent before the next
+ * frame. */
+static void
+gst_rtp_pacer_update_rate_unlocked (GstRtpPacer * self, GstBuffer * buffer)
+{
+  GstClockTime pts = GST_BUFFER_PTS (buffer);
+
+  if (!GST_CLOCK_TIME_IS_VALID (pts))
+    pts = GST_BUFFER_DTS (buffer);
+  if (!GST_CLOCK_TIME_IS_VALID (pts))
+    return;
+
+  if (pts != self->frame_pts) {
+    if (GST_CLOCK_TIME_IS_VALID (self->frame_pts) && pts > self->frame_pts) {
+      gdouble rate = (gdouble) self->frame_bytes * GST_SECOND /
+          (pts - self->frame_pts);
+
+      if (self->derived_rate == 0)
+        self->derived_rate = rate;
+      else
+        self->derived_rate = (7 * self->derived_rate + rate) / 8;
+    }
+    self->frame_pts = pts;
+    self->frame_bytes = 0;
+  }
+  self->frame_bytes += gst_buffer_get_size (buffer);
+}
+
+static GstFlowReturn
+gst_rtp_pacer_enqueue_buffer (GstRtpPacer * self, GstBuffer * buffer)
+{
+  GstRtpPacerItem *item;
+  GstFlowReturn ret;
+
+  g_mutex_lock (&self->lock);
+  while (self->n_buffers >= self->max_size_buffers && !self->flushing
+      && self->srcresult == GST_FLOW_OK)
+    g_cond_wait (&self->cond, &self->lock);
+
+  ret = self->srcresult;
+  if (self->flushing || ret != GST_FLOW_OK) {
+    g_mutex_unlock (&self->lock);
+    gst_buffer_unref (buffer);
+    return ret;
+  }
+
+  if (self->bitrate == 0)
+    gst_rtp_pacer_update_rate_unlocked (self, buffer);
+
+  item = g_slice_new (GstRtpPacerItem);
+  item->object = GST_MINI_OBJECT_CAST (buffer);
+  item->size = gst_buffer_get_size (buffer);
+  item->enqueued = gst_rtp_pacer_now ();
+  g_queue_push_tail (&self->queue, item);
+
+  self->n_buffers++;
+  self->max_queued = MAX (self->max_queued, self->n_buffers);
+  g_cond_broadcast (&self->cond);
+  g_mutex_unlock (&self->lock);
+
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+gst_rtp_pacer_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  return gst_rtp_pacer_enqueue_buffer (GST_RTP_PACER (parent), buffer);
+}
+
+static GstFlowReturn
+gst_rtp_pacer_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstRtpPacer *self = GST_RTP_PACER (parent);
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint i, len;
+
+  len = gst_buffer_list_length (list);
+  for (i = 0; i < len && ret == GST_FLOW_OK; i++)
+    ret = gst_rtp_pacer_enqueue_buffer (self,
+        gst_buffer_ref (gst_buffer_list_get (list, i)));
+  gst_buffer_list_unref (list);
+
+  return ret;
+}
+
+static void gst_rtp_pacer_loop (GstPad * pad);
+
+static gboolean
+gst_rtp_pacer_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  GstRtpPacer *self = GST_RTP_PACER (parent);
+  GstRtpPacerItem *item;
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_FLUSH_START:
+      g_mutex_lock (&self->lock);
+      self->flushing = TRUE;
+      self->srcresult = GST_FLOW_FLUSHING;
+      g_cond_broadcast (&self->cond);
+      g_mutex_unlock (&self->lock);
+
+      gst_pad_push_event (self->srcpad, event);
+      gst_pad_pause_task (self->srcpad);
+      return TRUE;
+    case GST_EVENT_FLUSH_STOP:
+      gst_pad_push_event (self->srcpad, event);
+
+      g_mutex_lock (&self->lock);
+      gst_rtp_pacer_clear_unlocked (self);
+      self->flushing = FALSE;
+      self->srcresult = GST_FLOW_OK;
+      self->tokens = self->burst;
+      self->last_refill = GST_CLOCK_TIME_NONE;
+      g_mutex_unlock (&self->lock);
+
+      return gst_pad_start_task (self->srcpad,
+          (GstTaskFunction) gst_rtp_pacer_loop, self->srcpad, NULL);
+    default:
+      break;
+  }
+
+  if (!GST_EVENT_IS_SERIALIZED (event))
+    return gst_pad_push_event (self->srcpad, event);
+
+  /* Serialized events keep their place between the packets */
+  g_mutex_lock (&self->lock);
+  if (self->flushing) {
+    g_mutex_unlock (&self->lock);
+    gst_event_unref (event);
+    return FALSE;
+  }
+
+  item = g_slice_new (GstRtpPacerItem);
+  item->object = GST_MINI_OBJECT_CAST (event);
+  item->size = 0;
+  item->enqueued = GST_CLOCK_TIME_NONE;
+  g_queue_push_tail (&self->queue, item);
+  g_cond_broadcast (&self->cond);
+  g_mutex_unlock (&self->lock);
+
+  return TRUE;
+}
+
+/* Wait until @deadline on the monotonic clock, with the lock held.
+ * Returns FALSE when flushing. */
+static gboolean
+gst_rtp_pacer_wait_unlocked (GstRtpPacer * self, GstClockTime deadline)
+{
+  GstClockTime now = gst_rtp_pacer_now ();
+
+  if (deadline > now + COARSE_WAIT_MARGIN) {
+    gint64 end_time = g_get_monotonic_time () +
+        (deadline - now - COARSE_WAIT_MARGIN) / GST_USECOND;
+
+    while (!self->flushing
+        && g_cond_wait_until (&self->cond, &self->lock, end_time));
+  }
+
+  if (self->flushing)
+    return FALSE;
+
+  g_mutex_unlock (&self->lock);
+#ifdef HAVE_CLOCK_NANOSLEEP
+  {
+    struct timespec ts;
+
+    GST_TIME_TO_TIMESPEC (deadline, ts);
+    while (clock_nanosleep (CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) ==
+        EINTR);
+  }
+#else
+  now = gst_rtp_pacer_now ();
+  if (deadline > now)
+    g_usleep ((deadline - now) / GST_USECOND);
+#endif
+  g_mutex_lock (&self->lock);
+
+  return !self->flushing;
+}
+
+/* Rate in bytes per second, 0 when the packets are not to be paced */
+static gdouble
+gst_rtp_pacer_get_rate_unlocked (GstRtpPacer * self)
+{
+  if (self->bitrate > 0)
+    return self->bitrate / 8.0;
+
+  return self->derived_rate * RATE_HEADROOM;
+}
+
+/* A packet waits at most for a full burst to be sent ahead of it */
+static GstClockTime
+gst_rtp_pacer_get_delay (GstRtpPacer * self)
+{
+  GstClockTime delay = 0;
+  gdouble rate;
+
+  g_mutex_lock (&self->lock);
+  rate = gst_rtp_pacer_get_rate_unlocked (self);
+  if (rate > 0)
+    delay = self->burst * GST_SECOND / rate;
+  g_mutex_unlock (&self->lock);
+
+  return delay;
+}
+
+static gboolean
+gst_rtp_pacer_src_query (GstPad * pad, GstObject * parent, GstQuery * query)
+{
+  GstRtpPacer *self = GST_RTP_PACER (parent);
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_LATENCY:{
+      GstClockTime min, max, delay;
+      gboolean live;
+
+      if (!gst_pad_peer_query (self->sinkpad, query))
+        return FALSE;
+
+      gst_query_parse_latency (query, &live, &min, &max);
+      delay = gst_rtp_pacer_get_delay (self);
+      GST_DEBUG_OBJECT (self, "Adding %" GST_TIME_FORMAT " of pacing delay",
+          GST_TIME_ARGS (delay));
+
+      min += delay;
+      if (GST_CLOCK_TIME_IS_VALID (max))
+        max += delay;
+      gst_query_set_latency (query, live, min, max);
+
+      return TRUE;
+    }
+    default:
+      return gst_pad_query_default (pad, parent, query);
+  }
+}
+
+static void
+gst_rtp_pacer_refill_unlocked (GstRtpPacer * self, gdouble rate,
+    GstClockTime now)
+{
+  if (GST_CLOCK_TIME_IS_VALID (self->last_refill) && now > self->last_refill)
+    self->tokens += rate * (now - self->last_refill) / GST_SECOND;
+  self->tokens = MIN (self->tokens, self->burst);
+  self->last_refill = now;
+}
+
+static void
+gst_rtp_pacer_loop (GstPad * pad)
+{
+  GstRtpPacer *self = GST_RTP_PACER (GST_PAD_PARENT (pad));
+  GstBufferList *list = NULL;
+  GstRtpPacerItem *item;
+  GstFlowReturn ret;
+  GstClockTime now;
+  gdouble rate;
+
+  g_mutex_lock (&self->lock);
+again:
+  while (g_queue_is_empty (&self->queue) && !self->flushing)
+    g_cond_wait (&self->cond, &self->lock);
+  if (self->flushing)
+    goto flushing;
+
+  item = g_queue_peek_head (&self->queue);
+  if (GST_IS_EVENT (item->object)) {
+    GstEvent *event;
+    gboolean is_eos;
+
+    g_queue_pop_head (&self->queue);
+    g_mutex_unlock (&self->lock);
+
+    event = GST_EVENT_CAST (item->object);
+    is_eos = GST_EVENT_TYPE (event) == GST_EVENT_EOS;
+    gst_pad_push_event (self->srcpad, event);
+    g_slice_free (GstRtpPacerItem, item);
+
+    if (is_eos) {
+      g_mutex_lock (&self->lock);
+      self->srcresult = GST_FLOW_EOS;
+      g_cond_broadcast (&self->cond);
+      g_mutex_unlock (&self->lock);
+      gst_pad_pause_task (pad);
+    }
+    return;
+  }
+
+  now = gst_rtp_pacer_now ();
+  rate = gst_rtp_pacer_get_rate_unlocked (self);
+  if (rate > 0) {
+    gdouble needed = MIN (item->size, self->burst);
+
+    gst_rtp_pacer_refill_unlocked (self, rate, now);
+    if (self->tokens < needed) {
+      GstClockTime wait = (needed - self->tokens) * GST_SECOND / rate;
+
+      if (!gst_rtp_pacer_wait_unlocked (self, now + wait))
+        goto flushing;
+      goto again;
+    }
+  }
+
+  /* Send everything the bucket allows right now in one go */
+  list = gst_buffer_list_new ();
+  while ((item = g_queue_peek_head (&self->queue))
+      && GST_IS_BUFFER (item->object)
+      && gst_buffer_list_length (list) < MAX_LIST_LENGTH) {
+    GstClockTime delay;
+
+    if (rate > 0) {
+      if (self->tokens < MIN (item->size, self->burst))
+        break;
+      self->tokens -= item->size;
+    }
+
+    g_queue_pop_head (&self->queue);
+    self->n_buffers--;
+
+    delay = now > item->enqueued ? now - item->enqueued : 0;
+    self->packets_paced++;
+    self->total_delay += delay;
+    self->max_delay = MAX (self->max_delay, delay);
+
+    gst_buffer_list_add (list, GST_BUFFER_CAST (item->object));
+    g_slice_free (GstRtpPacerItem, item);
+  }
+  g_cond_broadcast (&self->cond);
+  g_mutex_unlock (&self->lock);
+
+  if (gst_buffer_list_length (list) == 1) {
+    GstBuffer *buffer = gst_buffer_ref (gst_buffer_list_get (list, 0));
+
+    gst_buffer_list_unref (list);
+    ret = gst_pad_push (self->srcpad, buffer);
+  } else {
+    ret = gst_pad_push_list (self->srcpad, list);
+  }
+
+  if (ret != GST_FLOW_OK) {
+    g_mutex_lock (&self->lock);
+    self->srcresult = ret;
+    g_cond_broadcast (&self->cond);
+    g_mutex_unlock (&self->lock);
+
+    if (ret == GST_FLOW_NOT_LINKED || ret < GST_FLOW_EOS)
+      GST_ELEMENT_FLOW_ERROR (self, ret);
+    GST_DEBUG_OBJECT (self, "Pausing task, reason %s", gst_flow_get_name (ret));
+    gst_pad_pause_task (pad);
+  }
+
+  return;
+
+flushing:
+  {
+    g_mutex_unlock (&self->lock);
+    GST_DEBUG_OBJECT (self, "Flushing, pausing task");
+    gst_pad_pause_task (pad);
+  }
+}
+
+static gboolean
+gst_rtp_pacer_src_activate_mode (GstPad * pad, GstObject * parent,
+    GstPadMode mode, gboolean active)
+{
+  GstRtpPacer *self = GST_RTP_PACER (parent);
+  gboolean ret;
+
+  if (mode != GST_PAD_MODE_PUSH)
+    return FALSE;
+
+  if (active) {
+    g_mutex_lock (&self->lock);
+    self->flushing = FALSE;
+    self->srcresult = GST_FLOW_OK;
+    self->tokens = self->burst;
+    self->last_refill = GST_CLOCK_TIME_NONE;
+    g_mutex_unlock (&self->lock);
+
+    return gst_pad_start_task (pad, (GstTaskFunction) gst_rtp_pacer_loop,
+        pad, NULL);
+  }
+
+  g_mutex_lock (&self->lock);
+  self->flushing = TRUE;
+  self->srcresult = GST_FLOW_FLUSHING;
+  g_cond_broadcast (&self->cond);
+  g_mutex_unlock (&self->lock);
+
+  ret = gst_pad_stop_task (pad);
+
+  g_mutex_lock (&self->lock);
+  gst_rtp_pacer_clear_unlocked (self);
+  g_mutex_unlock (&self->lock);
+
+  return ret;
+}
+
+static void
+gst_rtp_pacer_class_init (GstRtpPacerClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *gstelement_class = GST_ELEMENT_CLASS (klass);
+
+  gobject_class->set_property = gst_rtp_pacer_set_property;
+  gobject_class->get_property = gst_rtp_pacer_get_property;
+  gobject_class->finalize = gst_rtp_pacer_finalize;
+
+  /**
+   * GstRtpPacer:bitrate:
+   *
+   * The rate in bits per second the token bucket fills up at. 0 derives
+   * the rate from the buffer timestamps.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_BITRATE,
+      g_param_spec_uint64 ("bitrate", "Bitrate",
+          "Pacing rate in bits per second (0 = derive from timestamps)",
+          0, G_MAXUINT64, DEFAULT_PROP_BITRATE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpPacer:burst:
+   *
+   * The size of the token bucket in bytes, the number of bytes that can
+   * leave back to back after an idle period.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_BURST,
+      g_param_spec_uint ("burst", "Burst",
+          "Maximum number of bytes sent back to back", 1, G_MAXUINT,
+          DEFAULT_PROP_BURST, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpPacer:max-size-buffers:
+   *
+   * The maximum number of queued packets, upstream is blocked when the
+   * queue is full.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_SIZE_BUFFERS,
+      g_param_spec_uint ("max-size-buffers", "Max size buffers",
+          "Maximum number of packets in the queue", 1, G_MAXUINT,
+          DEFAULT_PROP_MAX_SIZE_BUFFERS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpPacer:stats:
+   *
+   * Statistics in a "application/x-rtp-pacer-stats" structure: the
+   * current and maximum "queue-depth" in packets, the number of
+   * "packets-paced", the "average-delay" and "max-delay" of a packet in
+   * the queue in nanoseconds and the pacing "bitrate" in use.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics", "Pacing statistics",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_add_pad_template (gstelement_class,
+      gst_static_pad_template_get (&sink_template));
+  gst_element_class_add_pad_template (gstelement_class,
+      gst_static_pad_template_get (&src_template));
+
+  gst_element_class_set_static_metadata (gstelement_class,
+      "RTP pacer",
+      "Filter/Network",
+      "Spread RTP packets evenly over time",
+      "Marc Leeman <marc.leeman@gmail.com>");
+}
+
+static void
+gst_rtp_pacer_init (GstRtpPacer * self)
+{
+  self->sinkpad = gst_pad_new_from_static_template (&sink_template, "sink");
+  gst_pad_set_chain_function (self->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_rtp_pacer_chain));
+  gst_pad_set_chain_list_function (self->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_rtp_pacer_chain_list));
+  gst_pad_set_event_function (self->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_rtp_pacer_sink_event));
+  GST_PAD_SET_PROXY_CAPS (self->sinkpad);
+  GST_PAD_SET_PROXY_ALLOCATION (self->sinkpad);
+  gst_element_add_pad (GST_ELEMENT (self), self->sinkpad);
+
+  self->srcpad = gst_pad_new_from_static_template (&src_template, "src");
+  gst_pad_set_activatemode_function (self->srcpad,
+      GST_DEBUG_FUNCPTR (gst_rtp_pacer_src_activate_mode));
+  gst_pad_set_query_function (self->srcpad,
+      GST_DEBUG_FUNCPTR (gst_rtp_pacer_src_query));
+  GST_PAD_SET_PROXY_CAPS (self->srcpad);
+  gst_element_add_pad (GST_ELEMENT (self), self->srcpad);
+
+  self->bitrate = DEFAULT_PROP_BITRATE;
+  self->burst = DEFAULT_PROP_BURST;
+  self->max_size_buffers = DEFAULT_PROP_MAX_SIZE_BUFFERS;
+
+  g_mutex_init (&self->lock);
+  g_cond_init (&self->cond);
+  g_queue_init (&self->queue);
+  self->flushing = TRUE;
+  self->srcresult = GST_FLOW_FLUSHING;
+  self->frame_pts = GST_CLOCK_TIME_NONE;
+  self->last_refill = GST_CLOCK_TIME_NONE;
+}
+
+/* ex: set tabstop=2 shiftwidth=2 expandtab: */
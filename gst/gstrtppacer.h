@@ -0,0 +1,11 @@
+#ifndef _GST_RTP_PACER_H_
+#define _GST_RTP_PACER_H_
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+#define GST_TYPE_RTP_PACER (gst_rtp_pacer_get_type ())
+G_DECLARE_FINAL_TYPE (GstRtpPacer, gst_rtp_pacer, GST, RTP_PACER, GstElement);
+G_END_DECLS
+
+#endif
@@ -0,0 +1,2057 @@
+/* GStreamer
+ * Copyright (C) <2018> Marc Leeman <marc.leeman@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION: gstrtprecvsrc
+ * @title: GstRtpRecvSrc
+ * @short description: UDP source that reads RTP packets from the network
+ * in batches.
+ *
+ * This element is used by #GstRtpSrc to read RTP packets from the
+ * network when more than one packet per system call is requested.
+ * Instead of one system call for each datagram, up to
+ * #GstRtpRecvSrc:batch-size datagrams are read with a single recvmmsg()
+ * call and pushed downstream as one #GstBufferList.
+ *
+ * On systems without recvmmsg(), the batch is filled with one recvmsg()
+ * call per datagram, which still saves on the number of buffer pushes.
+ *
+ * When #GstRtpRecvSrc:pool-size is set, packets are read straight into
+ * buffers from a preallocated pool of MTU-sized buffers that are recycled
+ * once downstream releases them. If the pool runs dry, for instance
+ * because the jitterbuffer holds on to more packets than the pool
+ * contains, a buffer is allocated instead and counted as a pool miss in
+ * #GstRtpRecvSrc:stats.
+ *
+ * A single receive thread limits a high bitrate stream to one core. With
+ * #GstRtpRecvSrc:n-threads larger than one, that many SO_REUSEPORT
+ * sockets are bound to the same port, each with its own receive thread.
+ * On Linux, a classic BPF program spreads the packets over the sockets
+ * based on the RTP sequence number, so even a single sender is
+ * distributed evenly; elsewhere the kernel picks the socket by hashing the
+ * sender address. The packets of all threads are merged and the packets
+ * of every sender are pushed downstream in sequence number order.
+ *
+ * With #GstRtpRecvSrc:timestamping, the kernel records the time every
+ * packet arrived on the socket (SO_TIMESTAMPNS) and it is attached to the
+ * buffer as a #GstReferenceTimestampMeta with caps timestamp/x-unix, in
+ * nanoseconds since the Unix epoch. The time packets waited in the socket
+ * buffer is then reported in #GstRtpRecvSrc:stats.
+ *
+ * Packets that do not fit in the receive buffer of a socket are dropped
+ * by the kernel without notice. With #GstRtpRecvSrc:detect-overflows,
+ * the kernel reports its drop counter with every packet, the drops are
+ * counted and posted and the buffer is raised up to
+ * #GstRtpRecvSrc:max-buffer-size.
+ *
+ * With #GstRtpRecvSrc:io-uring, a single multishot receive request on an
+ * io_uring replaces the poll() and recvmmsg() calls. The kernel writes
+ * the packets into a ring of #GstRtpRecvSrc:pool-size buffers that are
+ * pushed downstream without copying and handed back to the kernel when
+ * they are released. While packets keep arriving, they are picked up
+ * without entering the kernel at all. When the kernel or the build lacks
+ * support, or more than one receive thread is used, the element falls
+ * back to recvmmsg().
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <errno.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#ifdef __linux__
+#include <linux/filter.h>
+#endif
+
+#include <gio/gio.h>
+#include <gst/net/net.h>
+
+#include "gstrtprecvsrc.h"
+#include "gstrtpbufferpool.h"
+#include "gstrtp-utils.h"
+#include "gstrtp-histogram.h"
+#include "gstrtp-counters.h"
+#include "gstrtp-filter.h"
+#include "gstrtp-uring.h"
+#include "gstrtp-sockopt.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_rtp_recv_src_debug);
+#define GST_CAT_DEFAULT gst_rtp_recv_src_debug
+
+#define DEFAULT_PROP_ADDRESS          "0.0.0.0"
+#define DEFAULT_PROP_PORT             5004
+#define DEFAULT_PROP_BATCH_SIZE       32
+#define DEFAULT_PROP_MTU              1500
+#define DEFAULT_PROP_RETRIEVE_SENDER_ADDRESS TRUE
+#define DEFAULT_PROP_POOL_SIZE        0
+#define DEFAULT_PROP_N_THREADS        1
+#define DEFAULT_PROP_TIMESTAMPING     FALSE
+#define DEFAULT_PROP_IO_URING         FALSE
+#define DEFAULT_PROP_SPIN_TIME        0
+#define DEFAULT_PROP_DETECT_OVERFLOWS FALSE
+#define DEFAULT_PROP_MAX_BUFFER_SIZE  0
+
+#define MAX_BATCH_SIZE                1024
+#define MAX_THREADS                   64
+
+/* Number of batches per receive thread that can be queued before the
+ * threads stop reading and leave the packets in the socket buffers. */
+#define QUEUED_BATCHES                4
+
+/* Room for the ancillary data of one packet, the arrival time and the
+ * drop counter */
+#define CONTROL_SIZE                  64
+
+/* Overflows of the receive buffer are acted upon at most this often */
+#define OVERFLOW_INTERVAL             G_USEC_PER_SEC
+
+/* Size of the io_uring buffer ring when pool-size is not set */
+#define DEFAULT_URING_BUFFERS         1024
+
+/* The packets of a sender in a merged batch are only sorted when they are
+ * at most this many sequence numbers apart, a larger span is a jump in
+ * the sequence numbers that sorting would only make worse. */
+#define MERGE_WINDOW                  8192
+
+#ifndef HAVE_RECVMMSG
+struct mmsghdr
+{
+  struct msghdr msg_hdr;
+  unsigned int msg_len;
+};
+#endif
+
+/* Statistics of a reader, only updated by the thread that reads */
+enum
+{
+  READER_PACKETS,
+  READER_ALLOCATIONS,
+  READER_POOL_MISSES,
+  READER_SYSCALLS,
+  N_READER_COUNTERS
+};
+
+/* One socket with its receive batch, and its thread when more than one
+ * socket is used. */
+typedef struct
+{
+  GstRtpRecvSrc *src;
+  GSocket *socket;
+  GThread *thread;
+
+  guint n_msgs;
+  struct mmsghdr *msgs;
+  struct iovec *iovs;
+  struct sockaddr_storage *addrs;
+  GstBuffer **buffers;
+  GstMapInfo *maps;
+  /* CONTROL_SIZE bytes per message, only with timestamping or overflow
+   * detection */
+  guint8 *controls;
+  /* Packets the kernel dropped on the socket, as last reported and as
+   * accounted for */
+  guint32 drops;
+  guint32 drops_handled;
+  GstRtpCounters *counters;
+} GstRtpRecvSrcReader;
+
+/* A queued packet with its sort key: the sender, the distance to the
+ * first sequence number of the sender in the batch and the arrival */
+typedef struct
+{
+  guint sender;
+  gint32 offset;
+  guint index;
+  GstBuffer *buffer;
+} GstRtpRecvSrcPacket;
+
+/* A sender in a merged batch */
+typedef struct
+{
+  guint16 first;
+  gint32 min_offset;
+  gint32 max_offset;
+} GstRtpRecvSrcSender;
+
+struct _GstRtpRecvSrc
+{
+  GstPushSrc parent_instance;
+
+  /* Properties */
+  gchar *address;
+  gint port;
+  GstCaps *caps;
+  guint batch_size;
+  guint mtu;
+  gboolean retrieve_sender_address;
+  guint pool_size;
+  guint n_threads;
+  gboolean timestamping;
+  GBytes *socket_filter;
+  gboolean io_uring;
+  guint spin_time;
+  gboolean detect_overflows;
+  gint max_buffer_size;
+  /* Protected by the object lock */
+  GstRtpSocketOptions socket_options;
+
+  GSocket *socket;
+  GCancellable *cancellable;
+  GstBufferPool *pool;
+
+  /* Receive engine of the single reader when io_uring is used, protected
+   * by the object lock for the statistics */
+  GstRtpUring *uring;
+  GstRtpUringPacket *uring_packets;
+
+  /* The array is replaced under the object lock, for the statistics */
+  GstRtpRecvSrcReader *readers;
+  guint n_readers;
+
+  /* Packets received by the reader threads, protected by queue_lock */
+  GMutex queue_lock;
+  GCond queue_cond;
+  GQueue queue;
+  guint max_queued;
+  gboolean flushing;
+  gboolean stopping;
+  gint reader_errno;
+  GCancellable *readers_cancellable;
+  /* Senders of the batch being merged, only used by the streaming thread */
+  GHashTable *merge_ssrcs;
+  GArray *merge_senders;
+
+  /* Statistics, protected by the object lock. The readers count in their
+   * own counters, which are added here when they are freed. */
+  guint64 packets;
+  guint64 allocations;
+  guint64 pool_misses;
+  guint64 syscalls;
+  guint64 kernel_drops;
+  /* Drops not reported yet and the time they were last acted upon */
+  guint64 overflow_pending;
+  gint64 overflow_time;
+
+  /* Caps of the kernel arrival timestamp meta */
+  GstCaps *timestamp_caps;
+  /* Time between the kernel and us receiving a packet */
+  GstRtpHistogram *socket_delay;
+};
+
+enum
+{
+  PROP_0,
+
+  PROP_ADDRESS,
+  PROP_PORT,
+  PROP_CAPS,
+  PROP_BATCH_SIZE,
+  PROP_MTU,
+  PROP_RETRIEVE_SENDER_ADDRESS,
+  PROP_USED_SOCKET,
+  PROP_POOL_SIZE,
+  PROP_STATS,
+  PROP_N_THREADS,
+  PROP_TIMESTAMPING,
+  PROP_SOCKET_FILTER,
+  PROP_IO_URING,
+  PROP_SOCKET_OPTIONS,
+  PROP_SPIN_TIME,
+  PROP_DETECT_OVERFLOWS,
+  PROP_MAX_BUFFER_SIZE,
+
+  PROP_LAST
+};
+
+#define gst_rtp_recv_src_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstRtpRecvSrc, gst_rtp_recv_src, GST_TYPE_PUSH_SRC,
+    GST_DEBUG_CATEGORY_INIT (gst_rtp_recv_src_debug, "nrtp_recvsrc", 0,
+        "RTP Batched Receive Source"));
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+static void
+gst_rtp_recv_src_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstRtpRecvSrc *self = GST_RTP_RECV_SRC (object);
+
+  switch (prop_id) {
+    case PROP_ADDRESS:
+      GST_OBJECT_LOCK (self);
+      g_free (self->address);
+      self->address = g_value_dup_string (value);
+      if (self->address == NULL)
+        self->address = g_strdup (DEFAULT_PROP_ADDRESS);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_PORT:
+      self->port = g_value_get_int (value);
+      break;
+    case PROP_CAPS:{
+      const GstCaps *new_caps = gst_value_get_caps (value);
+      GstCaps *old_caps;
+
+      GST_OBJECT_LOCK (self);
+      old_caps = self->caps;
+      self->caps = new_caps ? gst_caps_copy (new_caps) : NULL;
+      GST_OBJECT_UNLOCK (self);
+
+      if (old_caps)
+        gst_caps_unref (old_caps);
+
+      gst_pad_mark_reconfigure (GST_BASE_SRC_PAD (self));
+      break;
+    }
+    case PROP_BATCH_SIZE:
+      self->batch_size = g_value_get_uint (value);
+      break;
+    case PROP_MTU:
+      self->mtu = g_value_get_uint (value);
+      break;
+    case PROP_RETRIEVE_SENDER_ADDRESS:
+      self->retrieve_sender_address = g_value_get_boolean (value);
+      break;
+    case PROP_POOL_SIZE:
+      self->pool_size = g_value_get_uint (value);
+      break;
+    case PROP_N_THREADS:
+      self->n_threads = g_value_get_uint (value);
+      break;
+    case PROP_TIMESTAMPING:
+      self->timestamping = g_value_get_boolean (value);
+      break;
+    case PROP_SOCKET_FILTER:
+      GST_OBJECT_LOCK (self);
+      g_clear_pointer (&self->socket_filter, g_bytes_unref);
+      self->socket_filter = g_value_dup_boxed (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_IO_URING:
+      self->io_uring = g_value_get_boolean (value);
+      break;
+    case PROP_SOCKET_OPTIONS:
+      GST_OBJECT_LOCK (self);
+      gst_rtp_socket_options_from_structure (&self->socket_options,
+          gst_value_get_structure (value));
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_SPIN_TIME:
+      self->spin_time = g_value_get_uint (value);
+      break;
+    case PROP_DETECT_OVERFLOWS:
+      self->detect_overflows = g_value_get_boolean (value);
+      break;
+    case PROP_MAX_BUFFER_SIZE:
+      GST_OBJECT_LOCK (self);
+      self->max_buffer_size = g_value_get_int (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static GstStructure *
+gst_rtp_recv_src_create_stats (GstRtpRecvSrc * self)
+{
+  GstStructure *s, *socket_delay;
+  guint64 packets, allocations, pool_misses, syscalls, pool_bytes = 0;
+  guint64 counters[N_READER_COUNTERS];
+  guint pool_size = 0, i;
+
+  GST_OBJECT_LOCK (self);
+  packets = self->packets;
+  allocations = self->allocations;
+  pool_misses = self->pool_misses;
+  syscalls = self->syscalls;
+  for (i = 0; i < self->n_readers; i++) {
+    gst_rtp_counters_read (self->readers[i].counters, counters);
+    packets += counters[READER_PACKETS];
+    allocations += counters[READER_ALLOCATIONS];
+    pool_misses += counters[READER_POOL_MISSES];
+    syscalls += counters[READER_SYSCALLS];
+  }
+  if (self->pool) {
+    allocations += gst_rtp_buffer_pool_get_allocated (GST_RTP_BUFFER_POOL
+        (self->pool));
+    pool_size = self->pool_size;
+    pool_bytes = (guint64) self->pool_size * self->mtu;
+  } else if (self->uring) {
+    guint64 uring_syscalls, overruns;
+
+    gst_rtp_uring_get_stats (self->uring, &uring_syscalls, &overruns);
+    pool_size = gst_rtp_uring_get_n_buffers (self->uring);
+    pool_bytes = (guint64) pool_size *
+        gst_rtp_uring_get_buffer_size (self->uring);
+    allocations += pool_size;
+    pool_misses += overruns;
+    syscalls += uring_syscalls;
+  }
+  s = gst_structure_new ("application/x-rtp-recv-src-stats",
+      "packets-received", G_TYPE_UINT64, packets,
+      "allocations", G_TYPE_UINT64, allocations,
+      "pool-misses", G_TYPE_UINT64, pool_misses,
+      "pool-size", G_TYPE_UINT, pool_size,
+      "pool-bytes", G_TYPE_UINT64, pool_bytes,
+      "sockets", G_TYPE_UINT, self->n_readers,
+      "io-uring", G_TYPE_BOOLEAN, self->uring != NULL,
+      "system-calls", G_TYPE_UINT64, syscalls,
+      "kernel-drops", G_TYPE_UINT64, self->kernel_drops, NULL);
+  GST_OBJECT_UNLOCK (self);
+
+  if (self->timestamping) {
+    socket_delay = gst_rtp_histogram_to_structure (self->socket_delay);
+    gst_structure_set (s, "socket-delay", GST_TYPE_STRUCTURE, socket_delay,
+        NULL);
+    gst_structure_free (socket_delay);
+  }
+
+  return s;
+}
+
+static void
+gst_rtp_recv_src_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstRtpRecvSrc *self = GST_RTP_RECV_SRC (object);
+
+  switch (prop_id) {
+    case PROP_ADDRESS:
+      GST_OBJECT_LOCK (self);
+      g_value_set_string (value, self->address);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_PORT:
+      g_value_set_int (value, self->port);
+      break;
+    case PROP_CAPS:
+      GST_OBJECT_LOCK (self);
+      gst_value_set_caps (value, self->caps);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_BATCH_SIZE:
+      g_value_set_uint (value, self->batch_size);
+      break;
+    case PROP_MTU:
+      g_value_set_uint (value, self->mtu);
+      break;
+    case PROP_RETRIEVE_SENDER_ADDRESS:
+      g_value_set_boolean (value, self->retrieve_sender_address);
+      break;
+    case PROP_USED_SOCKET:
+      GST_OBJECT_LOCK (self);
+      g_value_set_object (value, self->socket);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_POOL_SIZE:
+      g_value_set_uint (value, self->pool_size);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_rtp_recv_src_create_stats (self));
+      break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, self->n_threads);
+      break;
+    case PROP_TIMESTAMPING:
+      g_value_set_boolean (value, self->timestamping);
+      break;
+    case PROP_SOCKET_FILTER:
+      GST_OBJECT_LOCK (self);
+      g_value_set_boxed (value, self->socket_filter);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_IO_URING:
+      g_value_set_boolean (value, self->io_uring);
+      break;
+    case PROP_SOCKET_OPTIONS:
+      GST_OBJECT_LOCK (self);
+      g_value_take_boxed (value,
+          gst_rtp_socket_options_to_structure (&self->socket_options));
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_SPIN_TIME:
+      g_value_set_uint (value, self->spin_time);
+      break;
+    case PROP_DETECT_OVERFLOWS:
+      g_value_set_boolean (value, self->detect_overflows);
+      break;
+    case PROP_MAX_BUFFER_SIZE:
+      GST_OBJECT_LOCK (self);
+      g_value_set_int (value, self->max_buffer_size);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_rtp_recv_src_finalize (GObject * gobject)
+{
+  GstRtpRecvSrc *self = GST_RTP_RECV_SRC (gobject);
+
+  g_free (self->address);
+  if (self->caps)
+    gst_caps_unref (self->caps);
+  g_object_unref (self->cancellable);
+  g_object_unref (self->readers_cancellable);
+  g_mutex_clear (&self->queue_lock);
+  g_cond_clear (&self->queue_cond);
+  g_hash_table_unref (self->merge_ssrcs);
+  g_array_unref (self->merge_senders);
+  gst_caps_unref (self->timestamp_caps);
+  gst_rtp_histogram_free (self->socket_delay);
+  g_clear_pointer (&self->socket_filter, g_bytes_unref);
+
+  G_OBJECT_CLASS (parent_class)->finalize (gobject);
+}
+
+static GstCaps *
+gst_rtp_recv_src_get_caps (GstBaseSrc * bsrc, GstCaps * filter)
+{
+  GstRtpRecvSrc *self = GST_RTP_RECV_SRC (bsrc);
+  GstCaps *caps, *result;
+
+  GST_OBJECT_LOCK (self);
+  if (self->caps)
+    caps = gst_caps_ref (self->caps);
+  else
+    caps = gst_caps_new_any ();
+  GST_OBJECT_UNLOCK (self);
+
+  if (filter) {
+    result = gst_caps_intersect_full (filter, caps, GST_CAPS_INTERSECT_FIRST);
+    gst_caps_unref (caps);
+  } else {
+    result = caps;
+  }
+
+  return result;
+}
+
+static gboolean gst_rtp_recv_src_stop (GstBaseSrc * bsrc);
+static gpointer gst_rtp_recv_src_reader_thread (GstRtpRecvSrcReader * reader);
+
+/* All buffers of the pool are allocated up front, the pool never grows
+ * so the memory use is bounded by pool-size * mtu. */
+static gboolean
+gst_rtp_recv_src_start_pool (GstRtpRecvSrc * self)
+{
+  GstBufferPool *pool;
+  GstStructure *config;
+
+  pool = gst_rtp_buffer_pool_new ();
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, NULL, self->mtu,
+      self->pool_size, self->pool_size);
+
+  if (!gst_buffer_pool_set_config (pool, config)
+      || !gst_buffer_pool_set_active (pool, TRUE)) {
+    gst_object_unref (pool);
+    return FALSE;
+  }
+
+  GST_OBJECT_LOCK (self);
+  self->pool = pool;
+  GST_OBJECT_UNLOCK (self);
+
+  GST_DEBUG_OBJECT (self, "Using a pool of %u buffers of %u bytes.",
+      self->pool_size, self->mtu);
+
+  return TRUE;
+}
+
+/* io_uring replaces both the batch buffers and the pool, packets are
+ * received straight into the buffer ring. Falls back to recvmmsg() when
+ * the kernel or the build lacks support. */
+static void
+gst_rtp_recv_src_start_uring (GstRtpRecvSrc * self)
+{
+  GstRtpRecvSrcReader *reader = &self->readers[0];
+  GstRtpUring *uring;
+  GError *error = NULL;
+
+  if (self->n_readers > 1) {
+    GST_WARNING_OBJECT (self, "io_uring is only used with a single receive "
+        "thread, using recvmmsg()");
+    return;
+  }
+
+  uring = gst_rtp_uring_new (reader->socket,
+      self->pool_size > 0 ? self->pool_size : DEFAULT_URING_BUFFERS,
+      self->mtu, self->timestamping, &error);
+  if (uring == NULL) {
+    GST_WARNING_OBJECT (self, "Could not set up io_uring, using recvmmsg(): "
+        "%s", error->message);
+    g_clear_error (&error);
+    return;
+  }
+
+  if (self->detect_overflows)
+    GST_WARNING_OBJECT (self, "Overflows of the receive buffer are not "
+        "detected with io_uring");
+
+  self->uring_packets = g_new0 (GstRtpUringPacket, reader->n_msgs);
+  GST_OBJECT_LOCK (self);
+  self->uring = uring;
+  GST_OBJECT_UNLOCK (self);
+
+  GST_DEBUG_OBJECT (self, "Receiving with io_uring into %u buffers of %u "
+      "bytes.", gst_rtp_uring_get_n_buffers (uring),
+      gst_rtp_uring_get_buffer_size (uring));
+}
+
+/* Like udpsrc, bind to the multicast group itself so that only traffic
+ * for that group is received on the socket. */
+static GSocket *
+gst_rtp_recv_src_open_socket (GstRtpRecvSrc * self, GInetAddress * iaddr,
+    guint16 port, gboolean reuse_port, GError ** error)
+{
+  GSocketAddress *bind_addr;
+  GSocket *socket;
+  GBytes *filter = NULL;
+  GstRtpSocketOptions opts;
+  gboolean bound;
+
+  socket = g_socket_new (g_inet_address_get_family (iaddr),
+      G_SOCKET_TYPE_DATAGRAM, G_SOCKET_PROTOCOL_UDP, error);
+  if (socket == NULL)
+    return NULL;
+
+#ifdef SO_REUSEPORT
+  if (reuse_port && !g_socket_set_option (socket, SOL_SOCKET, SO_REUSEPORT,
+          1, error))
+    goto failed;
+#endif
+
+  /* Before binding, so that no unfiltered packet is queued */
+  GST_OBJECT_LOCK (self);
+  if (self->socket_filter)
+    filter = g_bytes_ref (self->socket_filter);
+  opts = self->socket_options;
+  GST_OBJECT_UNLOCK (self);
+
+  /* Also before binding, packets that arrive right away are queued in a
+   * buffer of the requested size */
+  gst_rtp_socket_options_apply (GST_OBJECT (self), socket, &opts, FALSE);
+  if (filter) {
+    GError *filter_error = NULL;
+
+    if (!gst_rtp_filter_attach (socket, filter, &filter_error)) {
+      GST_WARNING_OBJECT (self, "%s", filter_error->message);
+      g_clear_error (&filter_error);
+    }
+    g_bytes_unref (filter);
+  }
+
+  bind_addr = g_inet_socket_address_new (iaddr, port);
+  bound = g_socket_bind (socket, bind_addr, TRUE, error);
+  g_object_unref (bind_addr);
+  if (!bound) {
+    g_prefix_error (error, "Could not bind to port %u: ", port);
+    goto failed;
+  }
+
+#ifdef SO_TIMESTAMPNS
+  if (self->timestamping && !g_socket_set_option (socket, SOL_SOCKET,
+          SO_TIMESTAMPNS, 1, NULL))
+    GST_WARNING_OBJECT (self, "Could not enable kernel receive timestamps");
+#else
+  if (self->timestamping)
+    GST_WARNING_OBJECT (self, "Kernel receive timestamps are not supported");
+#endif
+
+#ifdef SO_RXQ_OVFL
+  if (self->detect_overflows && !g_socket_set_option (socket, SOL_SOCKET,
+          SO_RXQ_OVFL, 1, NULL))
+    GST_WARNING_OBJECT (self, "Could not enable the drop counter");
+#else
+  if (self->detect_overflows)
+    GST_WARNING_OBJECT (self, "Overflow detection is not supported");
+#endif
+
+  if (g_inet_address_get_is_multicast (iaddr)) {
+    if (!g_socket_join_multicast_group (socket, iaddr, FALSE, NULL, error)) {
+      g_prefix_error (error, "Could not join multicast group: ");
+      goto failed;
+    }
+  }
+
+  return socket;
+
+failed:
+  g_object_unref (socket);
+  return NULL;
+}
+
+/* Spread the packets over the SO_REUSEPORT group by RTP sequence number.
+ * Without it, the kernel hashes the addresses and ports, which sends all
+ * packets of a single sender to the same socket. */
+static void
+gst_rtp_recv_src_attach_reuseport_filter (GstRtpRecvSrc * self)
+{
+#if defined (__linux__) && defined (SO_ATTACH_REUSEPORT_CBPF)
+  struct sock_filter code[] = {
+    /* A = sequence number, the offset is relative to the UDP payload */
+    {BPF_LD | BPF_H | BPF_ABS, 0, 0, 2},
+    /* A = A % n_readers */
+    {BPF_ALU | BPF_MOD | BPF_K, 0, 0, self->n_readers},
+    /* Return the index of the socket in the group */
+    {BPF_RET | BPF_A, 0, 0, 0},
+  };
+  struct sock_fprog prog;
+
+  prog.len = G_N_ELEMENTS (code);
+  prog.filter = code;
+
+  if (setsockopt (g_socket_get_fd (self->readers[0].socket), SOL_SOCKET,
+          SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof (prog)) < 0) {
+    GST_WARNING_OBJECT (self, "Could not attach the SO_REUSEPORT filter, "
+        "packets are distributed by sender address: %s", g_strerror (errno));
+    return;
+  }
+
+  GST_DEBUG_OBJECT (self, "Distributing packets over %u sockets by sequence "
+      "number.", self->n_readers);
+#else
+  GST_DEBUG_OBJECT (self, "Distributing packets over %u sockets by sender "
+      "address.", self->n_readers);
+#endif
+}
+
+static void
+gst_rtp_recv_src_reader_init (GstRtpRecvSrc * self,
+    GstRtpRecvSrcReader * reader, GSocket * socket)
+{
+  reader->src = self;
+  reader->socket = socket;
+  reader->thread = NULL;
+  reader->n_msgs = CLAMP (self->batch_size, 1, MAX_BATCH_SIZE);
+  reader->msgs = g_new0 (struct mmsghdr, reader->n_msgs);
+  reader->iovs = g_new0 (struct iovec, reader->n_msgs);
+  reader->addrs = g_new0 (struct sockaddr_storage, reader->n_msgs);
+  reader->buffers = g_new0 (GstBuffer *, reader->n_msgs);
+  reader->maps = g_new0 (GstMapInfo, reader->n_msgs);
+  reader->drops = 0;
+  reader->drops_handled = 0;
+  if (self->timestamping || self->detect_overflows)
+    reader->controls = g_malloc0 (reader->n_msgs * CONTROL_SIZE);
+}
+
+static void
+gst_rtp_recv_src_reader_clear (GstRtpRecvSrcReader * reader)
+{
+  guint i;
+
+  for (i = 0; i < reader->n_msgs; i++) {
+    if (reader->buffers[i])
+      gst_buffer_unref (reader->buffers[i]);
+  }
+  reader->n_msgs = 0;
+
+  g_clear_pointer (&reader->msgs, g_free);
+  g_clear_pointer (&reader->iovs, g_free);
+  g_clear_pointer (&reader->addrs, g_free);
+  g_clear_pointer (&reader->buffers, g_free);
+  g_clear_pointer (&reader->maps, g_free);
+  g_clear_pointer (&reader->controls, g_free);
+  g_clear_pointer (&reader->counters, gst_rtp_counters_free);
+
+  if (reader->socket) {
+    g_socket_close (reader->socket, NULL);
+    g_clear_object (&reader->socket);
+  }
+}
+
+static gboolean
+gst_rtp_recv_src_start (GstBaseSrc * bsrc)
+{
+  GstRtpRecvSrc *self = GST_RTP_RECV_SRC (bsrc);
+  GInetAddress *iaddr;
+  GSocketAddress *local_addr;
+  GstRtpRecvSrcReader *readers;
+  GSocket *socket;
+  GError *error = NULL;
+  gchar *address;
+  guint16 port;
+  guint i, n_readers;
+
+  GST_OBJECT_LOCK (self);
+  address = g_strdup (self->address);
+  GST_OBJECT_UNLOCK (self);
+
+  iaddr = gst_rtp_utils_resolve_host (address, &error);
+  if (iaddr == NULL)
+    goto resolve_failed;
+  g_free (address);
+
+  n_readers = CLAMP (self->n_threads, 1, MAX_THREADS);
+  readers = g_new0 (GstRtpRecvSrcReader, n_readers);
+  for (i = 0; i < n_readers; i++)
+    readers[i].counters = gst_rtp_counters_new (N_READER_COUNTERS);
+  GST_OBJECT_LOCK (self);
+  self->readers = readers;
+  self->n_readers = n_readers;
+  GST_OBJECT_UNLOCK (self);
+
+  /* The first socket allocates the port if none was given, the other
+   * sockets join its SO_REUSEPORT group. */
+  port = self->port;
+  for (i = 0; i < self->n_readers; i++) {
+    socket = gst_rtp_recv_src_open_socket (self, iaddr, port,
+        self->n_readers > 1, &error);
+    if (socket == NULL)
+      goto open_failed;
+
+    gst_rtp_recv_src_reader_init (self, &self->readers[i], socket);
+
+    if (port == 0) {
+      local_addr = g_socket_get_local_address (socket, NULL);
+      if (local_addr) {
+        port = g_inet_socket_address_get_port (G_INET_SOCKET_ADDRESS
+            (local_addr));
+        g_object_unref (local_addr);
+      }
+    }
+  }
+  g_object_unref (iaddr);
+
+  GST_OBJECT_LOCK (self);
+  self->socket = g_object_ref (self->readers[0].socket);
+  self->packets = 0;
+  self->allocations = 0;
+  self->pool_misses = 0;
+  self->syscalls = 0;
+  self->kernel_drops = 0;
+  self->overflow_pending = 0;
+  self->overflow_time = 0;
+  GST_OBJECT_UNLOCK (self);
+  gst_rtp_histogram_reset (self->socket_delay);
+
+  if (self->io_uring)
+    gst_rtp_recv_src_start_uring (self);
+
+  if (self->uring == NULL && self->pool_size > 0
+      && !gst_rtp_recv_src_start_pool (self))
+    goto pool_failed;
+
+  if (self->n_readers > 1) {
+    gst_rtp_recv_src_attach_reuseport_filter (self);
+
+    self->max_queued = self->n_readers * self->readers[0].n_msgs *
+        QUEUED_BATCHES;
+    self->flushing = FALSE;
+    self->stopping = FALSE;
+    self->reader_errno = 0;
+
+    for (i = 0; i < self->n_readers; i++) {
+      self->readers[i].thread = g_thread_try_new ("nrtp_recvsrc",
+          (GThreadFunc) gst_rtp_recv_src_reader_thread, &self->readers[i],
+          &error);
+      if (self->readers[i].thread == NULL)
+        goto thread_failed;
+    }
+  }
+
+  GST_DEBUG_OBJECT (self, "Receiving on port %u with %u sockets and batches "
+      "of %u packets.", port, self->n_readers, self->readers[0].n_msgs);
+
+  return TRUE;
+
+resolve_failed:
+  GST_ELEMENT_ERROR (self, RESOURCE, NOT_FOUND,
+      ("Could not resolve hostname '%s'", address),
+      ("DNS resolver reported: %s", error->message));
+  g_free (address);
+  g_error_free (error);
+  return FALSE;
+
+open_failed:
+  GST_ELEMENT_ERROR (self, RESOURCE, OPEN_READ, (NULL),
+      ("Could not open socket: %s", error->message));
+  g_error_free (error);
+  g_object_unref (iaddr);
+  gst_rtp_recv_src_stop (bsrc);
+  return FALSE;
+
+pool_failed:
+  GST_ELEMENT_ERROR (self, RESOURCE, NO_SPACE_LEFT, (NULL),
+      ("Could not allocate a pool of %u buffers of %u bytes.",
+          self->pool_size, self->mtu));
+  gst_rtp_recv_src_stop (bsrc);
+  return FALSE;
+
+thread_failed:
+  GST_ELEMENT_ERROR (self, RESOURCE, FAILED, (NULL),
+      ("Could not start receive thread: %s", error->message));
+  g_error_free (error);
+  gst_rtp_recv_src_stop (bsrc);
+  return FALSE;
+}
+
+static gboolean
+gst_rtp_recv_src_stop (GstBaseSrc * bsrc)
+{
+  GstRtpRecvSrc *self = GST_RTP_RECV_SRC (bsrc);
+  GstRtpRecvSrcReader *readers;
+  GstBufferPool *pool;
+  GSocket *socket;
+  GstStructure *stats;
+  GstRtpUring *uring;
+  guint64 counters[N_READER_COUNTERS];
+  guint i, n_readers;
+
+  /* Stop the reader threads before their batches are freed */
+  g_mutex_lock (&self->queue_lock);
+  self->stopping = TRUE;
+  g_cond_broadcast (&self->queue_cond);
+  g_mutex_unlock (&self->queue_lock);
+  g_cancellable_cancel (self->readers_cancellable);
+
+  for (i = 0; i < self->n_readers; i++) {
+    if (self->readers[i].thread)
+      g_thread_join (self->readers[i].thread);
+    self->readers[i].thread = NULL;
+  }
+
+  g_queue_foreach (&self->queue, (GFunc) gst_buffer_unref, NULL);
+  g_queue_clear (&self->queue);
+
+  g_object_unref (self->readers_cancellable);
+  self->readers_cancellable = g_cancellable_new ();
+
+  stats = gst_rtp_recv_src_create_stats (self);
+  GST_INFO_OBJECT (self, "Receive statistics: %" GST_PTR_FORMAT, stats);
+  gst_structure_free (stats);
+
+  /* Keep the totals of the ring and stop receiving before the socket is
+   * closed, buffers in flight are returned to the ring when released */
+  GST_OBJECT_LOCK (self);
+  uring = self->uring;
+  self->uring = NULL;
+  if (uring) {
+    guint64 syscalls, overruns;
+
+    gst_rtp_uring_get_stats (uring, &syscalls, &overruns);
+    self->allocations += gst_rtp_uring_get_n_buffers (uring);
+    self->pool_misses += overruns;
+    self->syscalls += syscalls;
+  }
+  GST_OBJECT_UNLOCK (self);
+  if (uring)
+    gst_rtp_uring_free (uring);
+  g_clear_pointer (&self->uring_packets, g_free);
+
+  /* Keep the totals of the readers, the threads are gone */
+  GST_OBJECT_LOCK (self);
+  readers = self->readers;
+  n_readers = self->n_readers;
+  for (i = 0; i < n_readers; i++) {
+    gst_rtp_counters_read (readers[i].counters, counters);
+    self->packets += counters[READER_PACKETS];
+    self->allocations += counters[READER_ALLOCATIONS];
+    self->pool_misses += counters[READER_POOL_MISSES];
+    self->syscalls += counters[READER_SYSCALLS];
+  }
+  self->readers = NULL;
+  self->n_readers = 0;
+  GST_OBJECT_UNLOCK (self);
+
+  for (i = 0; i < n_readers; i++)
+    gst_rtp_recv_src_reader_clear (&readers[i]);
+  g_free (readers);
+
+  GST_OBJECT_LOCK (self);
+  pool = self->pool;
+  self->pool = NULL;
+  socket = self->socket;
+  self->socket = NULL;
+  GST_OBJECT_UNLOCK (self);
+
+  /* Buffers that are still in flight are freed when they are released
+   * to the inactive pool. */
+  if (pool) {
+    gst_buffer_pool_set_active (pool, FALSE);
+    gst_object_unref (pool);
+  }
+
+  if (socket)
+    g_object_unref (socket);
+
+  return TRUE;
+}
+
+static gboolean
+gst_rtp_recv_src_unlock (GstBaseSrc * bsrc)
+{
+  GstRtpRecvSrc *self = GST_RTP_RECV_SRC (bsrc);
+
+  GST_LOG_OBJECT (self, "Flushing");
+  g_cancellable_cancel (self->cancellable);
+
+  g_mutex_lock (&self->queue_lock);
+  self->flushing = TRUE;
+  g_cond_broadcast (&self->queue_cond);
+  g_mutex_unlock (&self->queue_lock);
+
+  return TRUE;
+}
+
+static gboolean
+gst_rtp_recv_src_unlock_stop (GstBaseSrc * bsrc)
+{
+  GstRtpRecvSrc *self = GST_RTP_RECV_SRC (bsrc);
+
+  GST_LOG_OBJECT (self, "No longer flushing");
+  g_object_unref (self->cancellable);
+  self->cancellable = g_cancellable_new ();
+
+  g_mutex_lock (&self->queue_lock);
+  self->flushing = FALSE;
+  g_mutex_unlock (&self->queue_lock);
+
+  return TRUE;
+}
+
+/* Make sure every slot in the batch has a writable buffer of MTU size and
+ * point the message headers to it. Buffers that were not filled by the
+ * previous call are reused. */
+static gboolean
+gst_rtp_recv_src_prepare_batch (GstRtpRecvSrc * self,
+    GstRtpRecvSrcReader * reader)
+{
+  GstBufferPoolAcquireParams params = { 0, };
+  guint i, allocations = 0, pool_misses = 0;
+
+  params.flags = GST_BUFFER_POOL_ACQUIRE_FLAG_DONTWAIT;
+
+  for (i = 0; i < reader->n_msgs; i++) {
+    struct msghdr *hdr = &reader->msgs[i].msg_hdr;
+
+    if (reader->buffers[i] == NULL && self->pool) {
+      if (gst_buffer_pool_acquire_buffer (self->pool, &reader->buffers[i],
+              &params) != GST_FLOW_OK) {
+        reader->buffers[i] = NULL;
+        pool_misses++;
+      }
+    }
+
+    if (reader->buffers[i] == NULL) {
+      reader->buffers[i] = gst_buffer_new_allocate (NULL, self->mtu, NULL);
+      allocations++;
+    }
+
+    if (!gst_buffer_map (reader->buffers[i], &reader->maps[i],
+            GST_MAP_WRITE)) {
+      while (i-- > 0)
+        gst_buffer_unmap (reader->buffers[i], &reader->maps[i]);
+      return FALSE;
+    }
+
+    reader->iovs[i].iov_base = reader->maps[i].data;
+    reader->iovs[i].iov_len = reader->maps[i].size;
+
+    hdr->msg_name = &reader->addrs[i];
+    hdr->msg_namelen = sizeof (reader->addrs[i]);
+    hdr->msg_iov = &reader->iovs[i];
+    hdr->msg_iovlen = 1;
+    if (reader->controls) {
+      hdr->msg_control = reader->controls + i * CONTROL_SIZE;
+      hdr->msg_controllen = CONTROL_SIZE;
+    } else {
+      hdr->msg_control = NULL;
+      hdr->msg_controllen = 0;
+    }
+    hdr->msg_flags = 0;
+    reader->msgs[i].msg_len = 0;
+  }
+
+  if (allocations > 0) {
+    if (pool_misses > 0)
+      GST_LOG_OBJECT (self, "Pool exhausted, allocated %u buffers.",
+          pool_misses);
+
+    gst_rtp_counters_add (reader->counters, READER_ALLOCATIONS, allocations);
+    if (pool_misses > 0)
+      gst_rtp_counters_add (reader->counters, READER_POOL_MISSES,
+          pool_misses);
+  }
+
+  return TRUE;
+}
+
+static void
+gst_rtp_recv_src_unmap_batch (GstRtpRecvSrcReader * reader)
+{
+  guint i;
+
+  for (i = 0; i < reader->n_msgs; i++)
+    gst_buffer_unmap (reader->buffers[i], &reader->maps[i]);
+}
+
+/* @calls is set to the number of system calls that were made */
+static gint
+gst_rtp_recv_src_recvmmsg (gint fd, struct mmsghdr *msgs, guint n_msgs,
+    guint * calls)
+{
+#ifdef HAVE_RECVMMSG
+  *calls = 1;
+  return recvmmsg (fd, msgs, n_msgs, MSG_DONTWAIT, NULL);
+#else
+  guint i;
+
+  for (i = 0; i < n_msgs; i++) {
+    gssize len = recvmsg (fd, &msgs[i].msg_hdr, MSG_DONTWAIT);
+
+    *calls = i + 1;
+    if (len < 0)
+      return i > 0 ? (gint) i : -1;
+    msgs[i].msg_len = len;
+  }
+
+  return n_msgs;
+#endif
+}
+
+static GstClockTime
+gst_rtp_recv_src_get_running_time (GstRtpRecvSrc * self)
+{
+  GstClock *clock;
+  GstClockTime now, base_time;
+
+  clock = gst_element_get_clock (GST_ELEMENT_CAST (self));
+  if (clock == NULL)
+    return GST_CLOCK_TIME_NONE;
+
+  now = gst_clock_get_time (clock);
+  base_time = gst_element_get_base_time (GST_ELEMENT_CAST (self));
+  gst_object_unref (clock);
+
+  return now > base_time ? now - base_time : 0;
+}
+
+/* The kernel arrival time of a packet in nanoseconds since the epoch, or
+ * GST_CLOCK_TIME_NONE if the control messages do not contain it. @drops
+ * is set to the number of packets the kernel dropped on the socket so far
+ * when the control messages contain it. */
+static GstClockTime
+gst_rtp_recv_src_parse_control (struct msghdr *hdr, guint32 * drops)
+{
+  GstClockTime arrival = GST_CLOCK_TIME_NONE;
+  struct cmsghdr *cmsg;
+
+  if (hdr->msg_control == NULL || (hdr->msg_flags & MSG_CTRUNC))
+    return GST_CLOCK_TIME_NONE;
+
+  for (cmsg = CMSG_FIRSTHDR (hdr); cmsg; cmsg = CMSG_NXTHDR (hdr, cmsg)) {
+    if (cmsg->cmsg_level != SOL_SOCKET)
+      continue;
+#ifdef SO_TIMESTAMPNS
+    if (cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+      struct timespec ts;
+
+      memcpy (&ts, CMSG_DATA (cmsg), sizeof (ts));
+      arrival = GST_TIMESPEC_TO_TIME (ts);
+    }
+#endif
+#ifdef SO_RXQ_OVFL
+    if (cmsg->cmsg_type == SO_RXQ_OVFL)
+      memcpy (drops, CMSG_DATA (cmsg), sizeof (guint32));
+#endif
+  }
+
+  return arrival;
+}
+
+/* Attach the sender address and the kernel arrival time to a received
+ * packet. @now is the wall clock time it was read, for the socket delay. */
+static void
+gst_rtp_recv_src_add_meta (GstRtpRecvSrc * self, GstBuffer * buffer,
+    gconstpointer addr, gsize addr_len, GstClockTime arrival,
+    GstClockTime now)
+{
+  if (self->retrieve_sender_address && addr_len > 0) {
+    GSocketAddress *saddr;
+
+    saddr = g_socket_address_new_from_native ((gpointer) addr, addr_len);
+    if (saddr) {
+      gst_buffer_add_net_address_meta (buffer, saddr);
+      g_object_unref (saddr);
+    }
+  }
+
+  if (GST_CLOCK_TIME_IS_VALID (arrival)) {
+    gst_buffer_add_reference_timestamp_meta (buffer, self->timestamp_caps,
+        arrival, GST_CLOCK_TIME_NONE);
+    gst_rtp_histogram_add (self->socket_delay,
+        now > arrival ? now - arrival : 0);
+  }
+}
+
+/* Take the buffer from a filled slot of the batch, the slot will get a new
+ * buffer on the next call to gst_rtp_recv_src_prepare_batch (). @now is the
+ * wall clock time the batch was read, for the socket delay. */
+static GstBuffer *
+gst_rtp_recv_src_take_buffer (GstRtpRecvSrc * self,
+    GstRtpRecvSrcReader * reader, guint i, GstClockTime pts,
+    GstClockTime now)
+{
+  struct msghdr *hdr = &reader->msgs[i].msg_hdr;
+  GstBuffer *buffer = reader->buffers[i];
+  GstClockTime arrival = GST_CLOCK_TIME_NONE;
+
+  if (G_UNLIKELY (hdr->msg_flags & MSG_TRUNC)) {
+    GST_WARNING_OBJECT (self, "Dropping packet larger than the MTU (%u bytes),"
+        " consider increasing the mtu property.", self->mtu);
+    return NULL;
+  }
+
+  reader->buffers[i] = NULL;
+  gst_buffer_resize (buffer, 0, reader->msgs[i].msg_len);
+  GST_BUFFER_PTS (buffer) = pts;
+
+  if (reader->controls)
+    arrival = gst_rtp_recv_src_parse_control (hdr, &reader->drops);
+  gst_rtp_recv_src_add_meta (self, buffer, hdr->msg_name, hdr->msg_namelen,
+      arrival, now);
+
+  return buffer;
+}
+
+/* Account for @drops packets the kernel dropped on the socket of @reader
+ * because its receive buffer was full. At most once per
+ * OVERFLOW_INTERVAL, the buffer is doubled up to max-buffer-size, or a
+ * warning is posted when it can not grow any further, and the drops since
+ * the last time are posted in an overflow message. */
+static void
+gst_rtp_recv_src_handle_overflow (GstRtpRecvSrc * self,
+    GstRtpRecvSrcReader * reader, guint32 drops)
+{
+  gint64 now = g_get_monotonic_time ();
+  guint64 pending, total;
+  gint size = 0, max_size;
+
+  GST_OBJECT_LOCK (self);
+  self->kernel_drops += drops;
+  self->overflow_pending += drops;
+  if (self->overflow_time != 0 && now - self->overflow_time <
+      OVERFLOW_INTERVAL) {
+    GST_OBJECT_UNLOCK (self);
+    return;
+  }
+  self->overflow_time = now;
+  pending = self->overflow_pending;
+  self->overflow_pending = 0;
+  total = self->kernel_drops;
+  max_size = self->max_buffer_size;
+  GST_OBJECT_UNLOCK (self);
+
+  /* The kernel reports twice the size it was given */
+  if (g_socket_get_option (reader->socket, SOL_SOCKET, SO_RCVBUF, &size,
+          NULL))
+    size /= 2;
+
+  if (size > 0 && size < max_size) {
+    GstRtpSocketOptions opts;
+
+    gst_rtp_socket_options_init (&opts);
+    opts.buffer_size = MIN ((gint64) size * 2, max_size);
+    GST_INFO_OBJECT (self, "%" G_GUINT64_FORMAT " packets dropped, raising "
+        "the receive buffer from %d to %d bytes", pending, size,
+        opts.buffer_size);
+    gst_rtp_socket_options_apply (GST_OBJECT (self), reader->socket, &opts,
+        FALSE);
+
+    if (g_socket_get_option (reader->socket, SOL_SOCKET, SO_RCVBUF, &size,
+            NULL))
+      size /= 2;
+  } else {
+    GST_ELEMENT_WARNING (self, RESOURCE, READ,
+        ("Packets were lost because the receive buffer is full."),
+        ("The kernel dropped %" G_GUINT64_FORMAT " packets, the receive "
+            "buffer is %d bytes", pending, size));
+  }
+
+  gst_element_post_message (GST_ELEMENT_CAST (self),
+      gst_message_new_element (GST_OBJECT_CAST (self),
+          gst_structure_new ("application/x-rtp-recv-src-overflow",
+              "drops", G_TYPE_UINT64, pending,
+              "total-drops", G_TYPE_UINT64, total,
+              "buffer-size", G_TYPE_INT, size, NULL)));
+}
+
+/* Read one batch from the socket of @reader without blocking and add the
+ * packets to @list. Returns the number of packets added, or -1 with errno
+ * set when reading failed. When the caller waited for the socket before
+ * the read, @waited counts that call too. */
+static gint
+gst_rtp_recv_src_reader_read (GstRtpRecvSrc * self,
+    GstRtpRecvSrcReader * reader, GstBufferList * list, gboolean waited)
+{
+  GstClockTime pts, now = GST_CLOCK_TIME_NONE;
+  guint added, calls;
+  gint n, i;
+
+  if (!gst_rtp_recv_src_prepare_batch (self, reader)) {
+    errno = ENOMEM;
+    return -1;
+  }
+
+  n = gst_rtp_recv_src_recvmmsg (g_socket_get_fd (reader->socket),
+      reader->msgs, reader->n_msgs, &calls);
+  gst_rtp_recv_src_unmap_batch (reader);
+
+  gst_rtp_counters_add (reader->counters, READER_SYSCALLS,
+      calls + (waited ? 1 : 0));
+
+  if (n < 0) {
+    /* ECONNREFUSED is reported after an ICMP port unreachable on a
+     * unicast RTCP reply, it is not fatal for the RTP socket. */
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR
+        || errno == ECONNREFUSED)
+      return 0;
+    return -1;
+  }
+
+  pts = gst_rtp_recv_src_get_running_time (self);
+  if (self->timestamping)
+    now = g_get_real_time () * GST_USECOND;
+
+  added = 0;
+  for (i = 0; i < n; i++) {
+    GstBuffer *buffer =
+        gst_rtp_recv_src_take_buffer (self, reader, i, pts, now);
+
+    if (buffer) {
+      gst_buffer_list_add (list, buffer);
+      added++;
+    }
+  }
+
+  GST_LOG_OBJECT (self, "Received %d packets in one call.", n);
+
+  gst_rtp_counters_add (reader->counters, READER_PACKETS, added);
+
+  /* The counter wraps around */
+  if (G_UNLIKELY (reader->drops != reader->drops_handled)) {
+    guint32 drops = reader->drops - reader->drops_handled;
+
+    reader->drops_handled = reader->drops;
+    gst_rtp_recv_src_handle_overflow (self, reader, drops);
+  }
+
+  return added;
+}
+
+/* Keep reading from the socket of @reader without blocking for up to
+ * spin-time microseconds, which saves the wakeup of the blocking wait
+ * when packets arrive in quick succession. Returns like
+ * gst_rtp_recv_src_reader_read(), 0 when nothing arrived in time. */
+static gint
+gst_rtp_recv_src_reader_spin (GstRtpRecvSrc * self,
+    GstRtpRecvSrcReader * reader, GstBufferList * list,
+    GCancellable * cancellable)
+{
+  gint64 deadline;
+  gint n;
+
+  if (self->spin_time == 0)
+    return 0;
+
+  deadline = g_get_monotonic_time () + self->spin_time;
+  do {
+    n = gst_rtp_recv_src_reader_read (self, reader, list, FALSE);
+    if (n != 0)
+      return n;
+  } while (!g_cancellable_is_cancelled (cancellable)
+      && g_get_monotonic_time () < deadline);
+
+  return 0;
+}
+
+/* Receive thread for one socket of the SO_REUSEPORT group, the packets
+ * are queued for the streaming thread to merge. Like the streaming
+ * thread, it announces itself with a stream-status message so that the
+ * application or the parent bin can tune it. */
+static gpointer
+gst_rtp_recv_src_reader_thread (GstRtpRecvSrcReader * reader)
+{
+  GstRtpRecvSrc *self = reader->src;
+  GstBufferList *list;
+  GError *error = NULL;
+  gint n, i;
+
+  gst_element_post_message (GST_ELEMENT_CAST (self),
+      gst_message_new_stream_status (GST_OBJECT_CAST (self),
+          GST_STREAM_STATUS_TYPE_ENTER, GST_ELEMENT_CAST (self)));
+
+  list = gst_buffer_list_new_sized (reader->n_msgs);
+
+  while (TRUE) {
+    n = gst_rtp_recv_src_reader_spin (self, reader, list,
+        self->readers_cancellable);
+    if (n == 0) {
+      if (!g_socket_condition_wait (reader->socket, G_IO_IN | G_IO_PRI,
+              self->readers_cancellable, &error)) {
+        if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+          goto wait_failed;
+        g_clear_error (&error);
+        break;
+      }
+
+      n = gst_rtp_recv_src_reader_read (self, reader, list, TRUE);
+    }
+    if (n < 0)
+      goto read_failed;
+    if (n == 0)
+      continue;
+
+    g_mutex_lock (&self->queue_lock);
+    while (self->queue.length >= self->max_queued && !self->stopping)
+      g_cond_wait (&self->queue_cond, &self->queue_lock);
+    if (self->stopping) {
+      g_mutex_unlock (&self->queue_lock);
+      break;
+    }
+    for (i = 0; i < n; i++)
+      g_queue_push_tail (&self->queue,
+          gst_buffer_ref (gst_buffer_list_get (list, i)));
+    g_cond_broadcast (&self->queue_cond);
+    g_mutex_unlock (&self->queue_lock);
+
+    gst_buffer_list_remove (list, 0, n);
+  }
+
+  gst_buffer_list_unref (list);
+
+  return NULL;
+
+wait_failed:
+  GST_WARNING_OBJECT (self, "Socket wait failed: %s", error->message);
+  g_clear_error (&error);
+  errno = EIO;
+
+read_failed:
+  g_mutex_lock (&self->queue_lock);
+  self->reader_errno = errno;
+  g_cond_broadcast (&self->queue_cond);
+  g_mutex_unlock (&self->queue_lock);
+
+  gst_buffer_list_unref (list);
+
+  return NULL;
+}
+
+static gint
+gst_rtp_recv_src_compare_packets (gconstpointer a, gconstpointer b,
+    gpointer user_data)
+{
+  const GstRtpRecvSrcPacket *pa = a, *pb = b;
+
+  if (pa->sender != pb->sender)
+    return pa->sender < pb->sender ? -1 : 1;
+  if (pa->offset != pb->offset)
+    return pa->offset < pb->offset ? -1 : 1;
+  if (pa->index != pb->index)
+    return pa->index < pb->index ? -1 : 1;
+  return 0;
+}
+
+/* Give every packet its sort key. Sequence numbers only compare within a
+ * sender, so the packets are grouped by SSRC in the order the senders
+ * first appear, and ordered by their distance to the first sequence
+ * number of their sender, which handles the wraparound. RTCP and other
+ * packets are a group of their own and keep their place. */
+static void
+gst_rtp_recv_src_prepare_merge (GstRtpRecvSrc * self,
+    GstRtpRecvSrcPacket * packets, guint n)
+{
+  GArray *senders = self->merge_senders;
+  GstRtpRecvSrcSender *sender;
+  gpointer value;
+  guint i;
+
+  g_hash_table_remove_all (self->merge_ssrcs);
+  g_array_set_size (senders, 0);
+
+  for (i = 0; i < n; i++) {
+    GstRtpRecvSrcPacket *packet = &packets[i];
+    guint8 data[12];
+    guint32 ssrc;
+    guint16 seqnum;
+
+    packet->index = i;
+    packet->offset = 0;
+
+    /* Payload types 64-95 with the marker bit are RTCP (RFC 5761) */
+    if (gst_buffer_extract (packet->buffer, 0, data, 12) < 12
+        || (data[0] & 0xc0) != 0x80 || (data[1] >= 192 && data[1] <= 223)) {
+      packet->sender = senders->len;
+      g_array_set_size (senders, senders->len + 1);
+      continue;
+    }
+
+    seqnum = GST_READ_UINT16_BE (data + 2);
+    ssrc = GST_READ_UINT32_BE (data + 8);
+
+    if (!g_hash_table_lookup_extended (self->merge_ssrcs,
+            GUINT_TO_POINTER (ssrc), NULL, &value)) {
+      value = GUINT_TO_POINTER (senders->len);
+      g_array_set_size (senders, senders->len + 1);
+      sender = &g_array_index (senders, GstRtpRecvSrcSender, senders->len - 1);
+      sender->first = seqnum;
+      g_hash_table_insert (self->merge_ssrcs, GUINT_TO_POINTER (ssrc), value);
+    }
+
+    packet->sender = GPOINTER_TO_UINT (value);
+    sender = &g_array_index (senders, GstRtpRecvSrcSender, packet->sender);
+    packet->offset = (gint16) (seqnum - sender->first);
+    sender->min_offset = MIN (sender->min_offset, packet->offset);
+    sender->max_offset = MAX (sender->max_offset, packet->offset);
+  }
+
+  /* Beyond the window, the packets of a sender stay in arrival order */
+  for (i = 0; i < n; i++) {
+    sender = &g_array_index (senders, GstRtpRecvSrcSender,
+        packets[i].sender);
+    if (sender->max_offset - sender->min_offset > MERGE_WINDOW)
+      packets[i].offset = 0;
+  }
+}
+
+static GstFlowReturn
+gst_rtp_recv_src_create_uring (GstRtpRecvSrc * self, GstBufferList ** list)
+{
+  GstRtpRecvSrcReader *reader = &self->readers[0];
+  GstClockTime pts, now = GST_CLOCK_TIME_NONE;
+  GError *error = NULL;
+  gint n, i;
+
+  n = gst_rtp_uring_receive (self->uring, self->uring_packets,
+      reader->n_msgs, self->cancellable, &error);
+  if (n < 0)
+    goto receive_failed;
+
+  pts = gst_rtp_recv_src_get_running_time (self);
+  if (self->timestamping)
+    now = g_get_real_time () * GST_USECOND;
+
+  *list = gst_buffer_list_new_sized (n);
+  for (i = 0; i < n; i++) {
+    GstRtpUringPacket *packet = &self->uring_packets[i];
+
+    GST_BUFFER_PTS (packet->buffer) = pts;
+    gst_rtp_recv_src_add_meta (self, packet->buffer, packet->addr,
+        packet->addr_len, packet->arrival, now);
+    gst_buffer_list_add (*list, packet->buffer);
+    packet->buffer = NULL;
+  }
+
+  GST_LOG_OBJECT (self, "Received %d packets from the ring.", n);
+
+  gst_rtp_counters_add (reader->counters, READER_PACKETS, n);
+
+  return GST_FLOW_OK;
+
+receive_failed:
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+    GST_DEBUG_OBJECT (self, "Cancelled");
+    g_clear_error (&error);
+    return GST_FLOW_FLUSHING;
+  }
+  GST_ELEMENT_ERROR (self, RESOURCE, READ, (NULL), ("%s", error->message));
+  g_clear_error (&error);
+  return GST_FLOW_ERROR;
+}
+
+static GstFlowReturn
+gst_rtp_recv_src_create_single (GstRtpRecvSrc * self, GstBufferList ** list)
+{
+  GstRtpRecvSrcReader *reader = &self->readers[0];
+  GError *error = NULL;
+  gint n;
+
+  *list = gst_buffer_list_new_sized (reader->n_msgs);
+
+  do {
+    n = gst_rtp_recv_src_reader_spin (self, reader, *list, self->cancellable);
+    if (n == 0) {
+      if (!g_socket_condition_wait (reader->socket, G_IO_IN | G_IO_PRI,
+              self->cancellable, &error))
+        goto wait_failed;
+
+      n = gst_rtp_recv_src_reader_read (self, reader, *list, TRUE);
+    }
+    if (n < 0)
+      goto receive_failed;
+  } while (n == 0);
+
+  return GST_FLOW_OK;
+
+wait_failed:
+  gst_buffer_list_unref (*list);
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+    GST_DEBUG_OBJECT (self, "Cancelled");
+    g_clear_error (&error);
+    return GST_FLOW_FLUSHING;
+  }
+  GST_ELEMENT_ERROR (self, RESOURCE, READ, (NULL),
+      ("Socket wait failed: %s", error->message));
+  g_clear_error (&error);
+  return GST_FLOW_ERROR;
+
+receive_failed:
+  gst_buffer_list_unref (*list);
+  GST_ELEMENT_ERROR (self, RESOURCE, READ, (NULL),
+      ("Receive failed: %s", g_strerror (errno)));
+  return GST_FLOW_ERROR;
+}
+
+/* Take everything the reader threads queued and put the packets of every
+ * sender back in sequence number order. Each thread delivers its share
+ * in order, so this interleaves the per-thread streams again. */
+static GstFlowReturn
+gst_rtp_recv_src_create_merged (GstRtpRecvSrc * self, GstBufferList ** list)
+{
+  GstRtpRecvSrcPacket *packets;
+  guint n, i;
+  gint error;
+
+  g_mutex_lock (&self->queue_lock);
+  while (g_queue_is_empty (&self->queue) && !self->flushing
+      && self->reader_errno == 0)
+    g_cond_wait (&self->queue_cond, &self->queue_lock);
+
+  if (self->flushing)
+    goto flushing;
+  if (g_queue_is_empty (&self->queue))
+    goto receive_failed;
+
+  n = self->queue.length;
+  packets = g_new (GstRtpRecvSrcPacket, n);
+  for (i = 0; i < n; i++)
+    packets[i].buffer = g_queue_pop_head (&self->queue);
+  g_cond_broadcast (&self->queue_cond);
+  g_mutex_unlock (&self->queue_lock);
+
+  gst_rtp_recv_src_prepare_merge (self, packets, n);
+  g_qsort_with_data (packets, n, sizeof (GstRtpRecvSrcPacket),
+      gst_rtp_recv_src_compare_packets, NULL);
+
+  *list = gst_buffer_list_new_sized (n);
+  for (i = 0; i < n; i++)
+    gst_buffer_list_add (*list, packets[i].buffer);
+  g_free (packets);
+
+  return GST_FLOW_OK;
+
+flushing:
+  g_mutex_unlock (&self->queue_lock);
+  GST_DEBUG_OBJECT (self, "Flushing");
+  return GST_FLOW_FLUSHING;
+
+receive_failed:
+  error = self->reader_errno;
+  g_mutex_unlock (&self->queue_lock);
+  GST_ELEMENT_ERROR (self, RESOURCE, READ, (NULL),
+      ("Receive failed: %s", g_strerror (error)));
+  return GST_FLOW_ERROR;
+}
+
+static GstFlowReturn
+gst_rtp_recv_src_create (GstPushSrc * psrc, GstBuffer ** buf)
+{
+  GstRtpRecvSrc *self = GST_RTP_RECV_SRC (psrc);
+  GstBufferList *list;
+  GstFlowReturn ret;
+
+  if (self->n_readers > 1)
+    ret = gst_rtp_recv_src_create_merged (self, &list);
+  else if (self->uring)
+    ret = gst_rtp_recv_src_create_uring (self, &list);
+  else
+    ret = gst_rtp_recv_src_create_single (self, &list);
+
+  if (ret != GST_FLOW_OK)
+    return ret;
+
+  if (gst_buffer_list_length (list) == 1) {
+    *buf = gst_buffer_ref (gst_buffer_list_get (list, 0));
+    gst_buffer_list_unref (list);
+  } else {
+    gst_base_src_submit_buffer_list (GST_BASE_SRC_CAST (self), list);
+    *buf = NULL;
+  }
+
+  return GST_FLOW_OK;
+}
+
+static void
+gst_rtp_recv_src_class_init (GstRtpRecvSrcClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *gstelement_class = GST_ELEMENT_CLASS (klass);
+  GstBaseSrcClass *gstbasesrc_class = GST_BASE_SRC_CLASS (klass);
+  GstPushSrcClass *gstpushsrc_class = GST_PUSH_SRC_CLASS (klass);
+
+  gobject_class->set_property = gst_rtp_recv_src_set_property;
+  gobject_class->get_property = gst_rtp_recv_src_get_property;
+  gobject_class->finalize = gst_rtp_recv_src_finalize;
+
+  gstbasesrc_class->start = GST_DEBUG_FUNCPTR (gst_rtp_recv_src_start);
+  gstbasesrc_class->stop = GST_DEBUG_FUNCPTR (gst_rtp_recv_src_stop);
+  gstbasesrc_class->unlock = GST_DEBUG_FUNCPTR (gst_rtp_recv_src_unlock);
+  gstbasesrc_class->unlock_stop =
+      GST_DEBUG_FUNCPTR (gst_rtp_recv_src_unlock_stop);
+  gstbasesrc_class->get_caps = GST_DEBUG_FUNCPTR (gst_rtp_recv_src_get_caps);
+  gstpushsrc_class->create = GST_DEBUG_FUNCPTR (gst_rtp_recv_src_create);
+
+  /**
+   * GstRtpRecvSrc:address:
+   *
+   * Address to receive packets on (can be IPv4 or IPv6). For multicast
+   * addresses the group is joined.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_ADDRESS,
+      g_param_spec_string ("address", "Address",
+          "Address to receive packets on (can be IPv4 or IPv6).",
+          DEFAULT_PROP_ADDRESS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpRecvSrc:port:
+   *
+   * The port to receive packets on, 0 allocates a free port.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_PORT,
+      g_param_spec_int ("port", "Port",
+          "The port to receive packets on, 0 allocates a free port.",
+          0, G_MAXUINT16, DEFAULT_PROP_PORT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpRecvSrc:caps:
+   *
+   * The caps of the packets that are received.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_CAPS,
+      g_param_spec_boxed ("caps", "Caps",
+          "The caps of the source pad", GST_TYPE_CAPS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpRecvSrc:batch-size:
+   *
+   * The maximum number of packets that are read from the socket with one
+   * system call and pushed downstream in one #GstBufferList.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_BATCH_SIZE,
+      g_param_spec_uint ("batch-size", "Batch size",
+          "Maximum number of packets read with one system call",
+          1, MAX_BATCH_SIZE, DEFAULT_PROP_BATCH_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpRecvSrc:mtu:
+   *
+   * The size of the buffer each packet is read into, larger packets are
+   * dropped.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_MTU,
+      g_param_spec_uint ("mtu", "MTU",
+          "Maximum size of a received packet", 64, G_MAXUINT16,
+          DEFAULT_PROP_MTU, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpRecvSrc:retrieve-sender-address:
+   *
+   * Attach a #GstNetAddressMeta with the sender address to every packet.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class,
+      PROP_RETRIEVE_SENDER_ADDRESS,
+      g_param_spec_boolean ("retrieve-sender-address",
+          "Retrieve Sender Address",
+          "Whether to retrieve the sender address and add it to buffers as "
+          "meta", DEFAULT_PROP_RETRIEVE_SENDER_ADDRESS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpRecvSrc:used-socket:
+   *
+   * The socket that is used to receive packets, only valid between
+   * the READY and PAUSED states.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_USED_SOCKET,
+      g_param_spec_object ("used-socket", "Socket Handle",
+          "Socket currently in use for receiving packets", G_TYPE_SOCKET,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpRecvSrc:pool-size:
+   *
+   * The number of MTU-sized buffers that are preallocated to receive
+   * packets into. Buffers return to the pool when downstream releases
+   * them, so this should cover the packets held by the jitterbuffer.
+   * 0 allocates a new buffer for every packet.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_POOL_SIZE,
+      g_param_spec_uint ("pool-size", "Pool size",
+          "Number of preallocated receive buffers (0 = allocate per packet)",
+          0, G_MAXUINT16, DEFAULT_PROP_POOL_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpRecvSrc:stats:
+   *
+   * Various receive statistics. This property returns a #GstStructure
+   * with name application/x-rtp-recv-src-stats with the following fields:
+   *
+   * - "packets-received" G_TYPE_UINT64: number of packets pushed downstream
+   * - "allocations" G_TYPE_UINT64: number of buffers that were allocated,
+   *   including the ones preallocated by the pool
+   * - "pool-misses" G_TYPE_UINT64: number of buffers allocated because the
+   *   pool was empty
+   * - "pool-size" G_TYPE_UINT: number of buffers in the pool
+   * - "pool-bytes" G_TYPE_UINT64: memory preallocated by the pool
+   * - "sockets" G_TYPE_UINT: number of sockets packets are received on
+   * - "io-uring" G_TYPE_BOOLEAN: whether packets are received with io_uring,
+   *   the pool fields then describe its buffer ring and a pool miss is a
+   *   receive that stopped because all buffers were in use
+   * - "system-calls" G_TYPE_UINT64: number of system calls made to wait
+   *   for and read packets
+   * - "kernel-drops" G_TYPE_UINT64: number of packets the kernel dropped
+   *   because the receive buffer was full, only counted with
+   *   #GstRtpRecvSrc:detect-overflows
+   * - "socket-delay" GST_TYPE_STRUCTURE: only with
+   *   #GstRtpRecvSrc:timestamping, histogram of the time between the kernel
+   *   receiving a packet and the element reading it, see below
+   *
+   * The histogram is an application/x-rtp-latency-histogram structure with
+   * the fields "count", "average", "max", "p50", "p90" and "p99" as
+   * G_TYPE_UINT64 in nanoseconds, and "buckets", a GST_TYPE_ARRAY with the
+   * number of packets below 1us, from 1us to 2us, 2us to 4us and so on.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Various statistics", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpRecvSrc:n-threads:
+   *
+   * The number of sockets that are bound to the port with SO_REUSEPORT,
+   * each read by its own thread. The packets of all threads are merged
+   * before they are pushed downstream, with the packets of every sender
+   * in sequence number order.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Number of SO_REUSEPORT sockets and receive threads",
+          1, MAX_THREADS, DEFAULT_PROP_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpRecvSrc:timestamping:
+   *
+   * Let the kernel timestamp the arrival of every packet and attach it as
+   * a #GstReferenceTimestampMeta with caps timestamp/x-unix. Only
+   * supported on systems with SO_TIMESTAMPNS.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_TIMESTAMPING,
+      g_param_spec_boolean ("timestamping", "Timestamping",
+          "Attach the kernel arrival time to every packet",
+          DEFAULT_PROP_TIMESTAMPING,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpRecvSrc:socket-filter:
+   *
+   * A classic BPF program, as an array of struct sock_filter, that is
+   * attached to every socket with SO_ATTACH_FILTER before it is bound.
+   * Datagrams the program rejects are dropped by the kernel. Only
+   * supported on Linux.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_SOCKET_FILTER,
+      g_param_spec_boxed ("socket-filter", "Socket filter",
+          "Classic BPF program attached to the sockets", G_TYPE_BYTES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpRecvSrc:io-uring:
+   *
+   * Receive with a multishot request on an io_uring instead of recvmmsg().
+   * Packets are pushed in the buffers of the ring without copying, so
+   * #GstRtpRecvSrc:pool-size should cover the packets held downstream; it
+   * defaults to 1024 buffers here. Needs Linux 6.0 and a single receive
+   * thread, otherwise recvmmsg() is used.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_IO_URING,
+      g_param_spec_boolean ("io-uring", "io_uring",
+          "Receive with io_uring when the system supports it",
+          DEFAULT_PROP_IO_URING, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpRecvSrc:socket-options:
+   *
+   * Receive buffer size, busy polling, priority, DSCP and incoming CPU
+   * of the sockets, as an application/x-rtp-socket-options structure
+   * with the fields "buffer-size", "busy-poll", "priority", "dscp" and
+   * "incoming-cpu". A value of -1 leaves the system default. The options
+   * are set on every socket before it is bound, the values in effect are
+   * logged.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_SOCKET_OPTIONS,
+      g_param_spec_boxed ("socket-options", "Socket options",
+          "Options set on the sockets", GST_TYPE_STRUCTURE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpRecvSrc:detect-overflows:
+   *
+   * Have the kernel report the packets it dropped because the receive
+   * buffer of a socket was full (SO_RXQ_OVFL). They are counted in
+   * #GstRtpRecvSrc:stats, and at most once per second the buffer is raised
+   * up to #GstRtpRecvSrc:max-buffer-size. Once it can not grow any
+   * further, a warning message is posted instead. Every time, an element
+   * message application/x-rtp-recv-src-overflow is posted with the fields
+   * "drops" G_TYPE_UINT64, the packets dropped since the previous message,
+   * "total-drops" G_TYPE_UINT64 and "buffer-size" G_TYPE_INT, the receive
+   * buffer size afterwards. Not available with io_uring.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_DETECT_OVERFLOWS,
+      g_param_spec_boolean ("detect-overflows", "Detect overflows",
+          "Count the packets dropped because the receive buffer was full",
+          DEFAULT_PROP_DETECT_OVERFLOWS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpRecvSrc:max-buffer-size:
+   *
+   * Size in bytes up to which the receive buffer of a socket is doubled
+   * when #GstRtpRecvSrc:detect-overflows finds dropped packets, 0 never
+   * raises it.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_BUFFER_SIZE,
+      g_param_spec_int ("max-buffer-size", "Maximum buffer size",
+          "Size the receive buffer grows to on overflows (0 = do not grow)",
+          0, G_MAXINT, DEFAULT_PROP_MAX_BUFFER_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpRecvSrc:spin-time:
+   *
+   * Before blocking on an empty socket, keep polling it for this many
+   * microseconds. This trades a busy core for the wakeup latency of the
+   * receive threads and is meant for threads pinned to dedicated cores.
+   * Not used with io_uring.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_SPIN_TIME,
+      g_param_spec_uint ("spin-time", "Spin time",
+          "Time in us to poll an empty socket before blocking (0 = never)",
+          0, G_USEC_PER_SEC, DEFAULT_PROP_SPIN_TIME,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_add_pad_template (gstelement_class,
+      gst_static_pad_template_get (&src_template));
+
+  gst_element_class_set_static_metadata (gstelement_class,
+      "RTP batched receive source",
+      "Source/Network",
+      "Receive RTP packets from the network in batches",
+      "Marc Leeman <marc.leeman@gmail.com>");
+}
+
+static void
+gst_rtp_recv_src_init (GstRtpRecvSrc * self)
+{
+  self->address = g_strdup (DEFAULT_PROP_ADDRESS);
+  self->port = DEFAULT_PROP_PORT;
+  self->caps = NULL;
+  self->batch_size = DEFAULT_PROP_BATCH_SIZE;
+  self->mtu = DEFAULT_PROP_MTU;
+  self->retrieve_sender_address = DEFAULT_PROP_RETRIEVE_SENDER_ADDRESS;
+  self->pool_size = DEFAULT_PROP_POOL_SIZE;
+  self->n_threads = DEFAULT_PROP_N_THREADS;
+  self->timestamping = DEFAULT_PROP_TIMESTAMPING;
+  self->io_uring = DEFAULT_PROP_IO_URING;
+  gst_rtp_socket_options_init (&self->socket_options);
+  self->spin_time = DEFAULT_PROP_SPIN_TIME;
+  self->detect_overflows = DEFAULT_PROP_DETECT_OVERFLOWS;
+  self->max_buffer_size = DEFAULT_PROP_MAX_BUFFER_SIZE;
+
+  self->timestamp_caps = gst_caps_new_empty_simple ("timestamp/x-unix");
+  self->socket_delay = gst_rtp_histogram_new ();
+
+  self->cancellable = g_cancellable_new ();
+  self->readers_cancellable = g_cancellable_new ();
+  g_mutex_init (&self->queue_lock);
+  g_cond_init (&self->queue_cond);
+  g_queue_init (&self->queue);
+  self->merge_ssrcs = g_hash_table_new (NULL, NULL);
+  self->merge_senders = g_array_new (FALSE, TRUE,
+      sizeof (GstRtpRecvSrcSender));
+
+  gst_base_src_set_live (GST_BASE_SRC (self), TRUE);
+  gst_base_src_set_format (GST_BASE_SRC (self), GST_FORMAT_TIME);
+  gst_base_src_set_do_timestamp (GST_BASE_SRC (self), FALSE);
+}
+
+/* ex: set tabstop=2 shiftwidth=2 expandtab: */
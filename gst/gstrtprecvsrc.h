@@ -0,0 +1,13 @@
+#ifndef _GST_RTP_RECV_SRC_H_
+#define _GST_RTP_RECV_SRC_H_
+
+#include <gst/gst.h>
+#include <gst/base/gstpushsrc.h>
+
+G_BEGIN_DECLS
+#define GST_TYPE_RTP_RECV_SRC (gst_rtp_recv_src_get_type ())
+G_DECLARE_FINAL_TYPE (GstRtpRecvSrc, gst_rtp_recv_src, GST, RTP_RECV_SRC,
+    GstPushSrc);
+G_END_DECLS
+
+#endif
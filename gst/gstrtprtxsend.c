@@ -0,0 +1,664 @@
+/* GStreamer
+ * Copyright (C) <2018> Marc Leeman <marc.leeman@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION: gstrtprtxsend
+ * @title: GstRtpRtxSend
+ * @short description: retransmits RTP packets in the RFC 4588 format.
+ *
+ * This element is used by #GstRtpSink as the auxiliary sender of
+ * #GstRtpBin. The media packets enter on the sink pad and leave on the
+ * source pad unchanged, and the packets of the payload types in
+ * #GstRtpRtxSend:payload-type-map are kept in a cache per SSRC, limited
+ * by #GstRtpRtxSend:max-size-time and #GstRtpRtxSend:max-size-bytes.
+ *
+ * When the RTP session receives a NACK, it sends a
+ * GstRTPRetransmissionRequest event upstream. If the requested packet is
+ * still cached, it is queued as an RTX packet: with the retransmission
+ * payload type, a sequence number and SSRC of its own and the original
+ * sequence number in front of the payload (SSRC multiplexing). The
+ * queued RTX packets are pushed from the streaming thread in front of the
+ * next media packet, so that they stay serialized with the events of the
+ * stream. rtprtxreceive merges the RTX stream back
+ * into the media stream on the receiving side.
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include <gst/rtp/gstrtpbuffer.h>
+
+#include "gstrtprtxsend.h"
+#include "gstrtp-rtxcache.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_rtp_rtx_send_debug);
+#define GST_CAT_DEFAULT gst_rtp_rtx_send_debug
+
+#define DEFAULT_PROP_MAX_SIZE_TIME    500
+#define DEFAULT_PROP_MAX_SIZE_BYTES   (4 * 1024 * 1024)
+
+#define RTP_PT_MAP_SIZE               128
+
+/* The retransmissions of one media SSRC */
+typedef struct
+{
+  GstRtpRtxCache *cache;
+  guint32 rtx_ssrc;
+  guint16 rtx_seq;
+} GstRtpRtxSendStream;
+
+struct _GstRtpRtxSend
+{
+  GstElement parent_instance;
+
+  GstPad *sinkpad;
+  GstPad *srcpad;
+
+  /* Properties, protected by the object lock */
+  guint max_size_time;
+  guint max_size_bytes;
+  GstStructure *pt_map_structure;
+  /* Retransmission payload type per media payload type, -1 for none */
+  gint rtx_pt[RTP_PT_MAP_SIZE];
+
+  /* GstRtpRtxSendStream per media SSRC, protected by the object lock */
+  GHashTable *streams;
+  /* RTX packets waiting for the streaming thread, protected by the object
+   * lock */
+  GQueue pending;
+
+  /* Statistics, protected by the object lock */
+  guint64 requests;
+  guint64 retransmitted;
+};
+
+enum
+{
+  PROP_0,
+
+  PROP_MAX_SIZE_TIME,
+  PROP_MAX_SIZE_BYTES,
+  PROP_PAYLOAD_TYPE_MAP,
+  PROP_STATS,
+
+  PROP_LAST
+};
+
+#define gst_rtp_rtx_send_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstRtpRtxSend, gst_rtp_rtx_send, GST_TYPE_ELEMENT,
+    GST_DEBUG_CATEGORY_INIT (gst_rtp_rtx_send_debug, "nrtp_rtxsend", 0,
+        "RTP Retransmission Sender"));
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("application/x-rtp"));
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("application/x-rtp"));
+
+static GstRtpRtxSendStream *
+gst_rtp_rtx_send_stream_new (GstRtpRtxSend * self, guint32 ssrc)
+{
+  GstRtpRtxSendStream *stream = g_slice_new0 (GstRtpRtxSendStream);
+
+  stream->cache =
+      gst_rtp_rtx_cache_new (self->max_size_time * GST_MSECOND,
+      self->max_size_bytes);
+  do {
+    stream->rtx_ssrc = g_random_int ();
+  } while (stream->rtx_ssrc == ssrc);
+  stream->rtx_seq = g_random_int_range (0, G_MAXUINT16);
+
+  return stream;
+}
+
+static void
+gst_rtp_rtx_send_stream_free (GstRtpRtxSendStream * stream)
+{
+  gst_rtp_rtx_cache_free (stream->cache);
+  g_slice_free (GstRtpRtxSendStream, stream);
+}
+
+/* Called with the object lock */
+static void
+gst_rtp_rtx_send_set_pt_map (GstRtpRtxSend * self,
+    const GstStructure * structure)
+{
+  guint i;
+
+  for (i = 0; i < RTP_PT_MAP_SIZE; i++)
+    self->rtx_pt[i] = -1;
+
+  if (self->pt_map_structure)
+    gst_structure_free (self->pt_map_structure);
+  self->pt_map_structure = NULL;
+  if (structure == NULL)
+    return;
+
+  self->pt_map_structure = gst_structure_copy (structure);
+  for (i = 0; i < gst_structure_n_fields (structure); i++) {
+    const gchar *name = gst_structure_nth_field_name (structure, i);
+    guint64 pt;
+    guint rtx_pt;
+    gchar *end;
+
+    pt = g_ascii_strtoull (name, &end, 10);
+    if (end == name || *end != '\0' || pt >= RTP_PT_MAP_SIZE
+        || !gst_structure_get_uint (structure, name, &rtx_pt)
+        || rtx_pt >= RTP_PT_MAP_SIZE) {
+      GST_WARNING_OBJECT (self, "Ignoring invalid payload-type-map entry "
+          "'%s'", name);
+      continue;
+    }
+    self->rtx_pt[pt] = rtx_pt;
+  }
+}
+
+static GstStructure *
+gst_rtp_rtx_send_create_stats (GstRtpRtxSend * self)
+{
+  GHashTableIter iter;
+  gpointer value;
+  GstStructure *s;
+  guint64 bytes = 0;
+  guint packets = 0;
+
+  GST_OBJECT_LOCK (self);
+  g_hash_table_iter_init (&iter, self->streams);
+  while (g_hash_table_iter_next (&iter, NULL, &value)) {
+    GstRtpRtxSendStream *stream = value;
+
+    packets += gst_rtp_rtx_cache_get_packets (stream->cache);
+    bytes += gst_rtp_rtx_cache_get_bytes (stream->cache);
+  }
+  s = gst_structure_new ("application/x-rtp-rtx-send-stats",
+      "requests", G_TYPE_UINT64, self->requests,
+      "retransmitted", G_TYPE_UINT64, self->retransmitted,
+      "cached-packets", G_TYPE_UINT, packets,
+      "cached-bytes", G_TYPE_UINT64, bytes, NULL);
+  GST_OBJECT_UNLOCK (self);
+
+  return s;
+}
+
+static void
+gst_rtp_rtx_send_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstRtpRtxSend *self = GST_RTP_RTX_SEND (object);
+
+  switch (prop_id) {
+    case PROP_MAX_SIZE_TIME:
+      GST_OBJECT_LOCK (self);
+      self->max_size_time = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_MAX_SIZE_BYTES:
+      GST_OBJECT_LOCK (self);
+      self->max_size_bytes = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_PAYLOAD_TYPE_MAP:
+      GST_OBJECT_LOCK (self);
+      gst_rtp_rtx_send_set_pt_map (self, g_value_get_boxed (value));
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_rtp_rtx_send_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstRtpRtxSend *self = GST_RTP_RTX_SEND (object);
+
+  switch (prop_id) {
+    case PROP_MAX_SIZE_TIME:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, self->max_size_time);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_MAX_SIZE_BYTES:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, self->max_size_bytes);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_PAYLOAD_TYPE_MAP:
+      GST_OBJECT_LOCK (self);
+      g_value_set_boxed (value, self->pt_map_structure);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_rtp_rtx_send_create_stats (self));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_rtp_rtx_send_finalize (GObject * gobject)
+{
+  GstRtpRtxSend *self = GST_RTP_RTX_SEND (gobject);
+
+  g_hash_table_unref (self->streams);
+  g_queue_clear_full (&self->pending, (GDestroyNotify) gst_buffer_unref);
+  if (self->pt_map_structure)
+    gst_structure_free (self->pt_map_structure);
+
+  G_OBJECT_CLASS (parent_class)->finalize (gobject);
+}
+
+/* Keep @buffer if its payload type is retransmitted, called with the
+ * object lock */
+static void
+gst_rtp_rtx_send_cache (GstRtpRtxSend * self, GstBuffer * buffer)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  GstRtpRtxSendStream *stream;
+  GstClockTime timestamp;
+  guint32 ssrc;
+  guint16 seq;
+  guint8 pt;
+
+  if (!gst_rtp_buffer_map (buffer, GST_MAP_READ, &rtp))
+    return;
+  pt = gst_rtp_buffer_get_payload_type (&rtp);
+  ssrc = gst_rtp_buffer_get_ssrc (&rtp);
+  seq = gst_rtp_buffer_get_seq (&rtp);
+  gst_rtp_buffer_unmap (&rtp);
+
+  if (self->rtx_pt[pt] < 0)
+    return;
+
+  stream = g_hash_table_lookup (self->streams, GUINT_TO_POINTER (ssrc));
+  if (stream == NULL) {
+    stream = gst_rtp_rtx_send_stream_new (self, ssrc);
+    g_hash_table_insert (self->streams, GUINT_TO_POINTER (ssrc), stream);
+    GST_DEBUG_OBJECT (self, "Retransmitting ssrc 0x%08x as ssrc 0x%08x",
+        ssrc, stream->rtx_ssrc);
+  }
+
+  /* The time limit follows the stream, whatever the pace it is sent at */
+  timestamp = GST_BUFFER_DTS_OR_PTS (buffer);
+  gst_rtp_rtx_cache_add (stream->cache, seq, timestamp, buffer);
+}
+
+/* Called with the object lock */
+static void
+gst_rtp_rtx_send_clear_unlocked (GstRtpRtxSend * self)
+{
+  g_hash_table_remove_all (self->streams);
+  g_queue_clear_full (&self->pending, (GDestroyNotify) gst_buffer_unref);
+  g_queue_init (&self->pending);
+}
+
+/* Take the queued RTX packets as a list, called with the object lock */
+static GstBufferList *
+gst_rtp_rtx_send_take_pending_unlocked (GstRtpRtxSend * self)
+{
+  GstBufferList *list;
+  GstBuffer *rtx;
+
+  if (g_queue_is_empty (&self->pending))
+    return NULL;
+
+  list = gst_buffer_list_new_sized (self->pending.length);
+  while ((rtx = g_queue_pop_head (&self->pending)))
+    gst_buffer_list_add (list, rtx);
+
+  return list;
+}
+
+/* The retransmissions go first, they are late already */
+static GstFlowReturn
+gst_rtp_rtx_send_push_pending (GstRtpRtxSend * self, GstBufferList * pending)
+{
+  GstFlowReturn ret;
+
+  if (pending == NULL)
+    return GST_FLOW_OK;
+
+  GST_LOG_OBJECT (self, "Pushing %u retransmissions",
+      gst_buffer_list_length (pending));
+  ret = gst_pad_push_list (self->srcpad, pending);
+  /* Not linked or flushing, the media packet tells */
+  if (ret == GST_FLOW_NOT_LINKED || ret == GST_FLOW_FLUSHING)
+    ret = GST_FLOW_OK;
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_rtp_rtx_send_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstRtpRtxSend *self = GST_RTP_RTX_SEND (parent);
+  GstBufferList *pending;
+  GstFlowReturn ret;
+
+  GST_OBJECT_LOCK (self);
+  gst_rtp_rtx_send_cache (self, buffer);
+  pending = gst_rtp_rtx_send_take_pending_unlocked (self);
+  GST_OBJECT_UNLOCK (self);
+
+  ret = gst_rtp_rtx_send_push_pending (self, pending);
+  if (ret != GST_FLOW_OK) {
+    gst_buffer_unref (buffer);
+    return ret;
+  }
+
+  return gst_pad_push (self->srcpad, buffer);
+}
+
+static GstFlowReturn
+gst_rtp_rtx_send_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstRtpRtxSend *self = GST_RTP_RTX_SEND (parent);
+  GstBufferList *pending;
+  GstFlowReturn ret;
+  guint i, len;
+
+  len = gst_buffer_list_length (list);
+  GST_OBJECT_LOCK (self);
+  for (i = 0; i < len; i++)
+    gst_rtp_rtx_send_cache (self, gst_buffer_list_get (list, i));
+  pending = gst_rtp_rtx_send_take_pending_unlocked (self);
+  GST_OBJECT_UNLOCK (self);
+
+  ret = gst_rtp_rtx_send_push_pending (self, pending);
+  if (ret != GST_FLOW_OK) {
+    gst_buffer_list_unref (list);
+    return ret;
+  }
+
+  return gst_pad_push_list (self->srcpad, list);
+}
+
+static gboolean
+gst_rtp_rtx_send_sink_event (GstPad * pad, GstObject * parent,
+    GstEvent * event)
+{
+  GstRtpRtxSend *self = GST_RTP_RTX_SEND (parent);
+  GstBufferList *pending;
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_FLUSH_STOP:
+      GST_OBJECT_LOCK (self);
+      gst_rtp_rtx_send_clear_unlocked (self);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case GST_EVENT_EOS:
+      /* No media packet follows to push them in front of */
+      GST_OBJECT_LOCK (self);
+      pending = gst_rtp_rtx_send_take_pending_unlocked (self);
+      GST_OBJECT_UNLOCK (self);
+      gst_rtp_rtx_send_push_pending (self, pending);
+      break;
+    default:
+      break;
+  }
+
+  return gst_pad_push_event (self->srcpad, event);
+}
+
+/* Build the RTX packet of @buffer: the header with the retransmission
+ * payload type, sequence number and SSRC, followed by the original
+ * sequence number and payload, without padding */
+static GstBuffer *
+gst_rtp_rtx_send_make_rtx (GstBuffer * buffer, guint8 rtx_pt,
+    guint32 rtx_ssrc, guint16 rtx_seq)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  guint header_len, payload_len;
+  GstBuffer *rtx;
+  guint8 *data;
+
+  if (!gst_rtp_buffer_map (buffer, GST_MAP_READ, &rtp))
+    return NULL;
+
+  header_len = gst_rtp_buffer_get_header_len (&rtp);
+  payload_len = gst_rtp_buffer_get_payload_len (&rtp);
+  data = g_malloc (header_len + 2 + payload_len);
+  gst_buffer_extract (buffer, 0, data, header_len);
+  data[0] &= ~0x20;
+  data[1] = (data[1] & 0x80) | rtx_pt;
+  GST_WRITE_UINT16_BE (data + 2, rtx_seq);
+  GST_WRITE_UINT32_BE (data + 8, rtx_ssrc);
+  GST_WRITE_UINT16_BE (data + header_len, gst_rtp_buffer_get_seq (&rtp));
+  memcpy (data + header_len + 2, gst_rtp_buffer_get_payload (&rtp),
+      payload_len);
+  gst_rtp_buffer_unmap (&rtp);
+
+  rtx = gst_buffer_new_wrapped (data, header_len + 2 + payload_len);
+  gst_buffer_copy_into (rtx, buffer, GST_BUFFER_COPY_FLAGS |
+      GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
+
+  return rtx;
+}
+
+/* Answer a NACK of the RTP session with the cached packet. This runs in
+ * the thread that received the NACK, the packet is only queued for the
+ * streaming thread. */
+static void
+gst_rtp_rtx_send_retransmit (GstRtpRtxSend * self, const GstStructure * s)
+{
+  GstRtpRtxSendStream *stream;
+  GstBuffer *buffer = NULL, *rtx = NULL;
+  guint seqnum, ssrc;
+
+  if (!gst_structure_get_uint (s, "seqnum", &seqnum)
+      || !gst_structure_get_uint (s, "ssrc", &ssrc))
+    return;
+
+  GST_OBJECT_LOCK (self);
+  self->requests++;
+  stream = g_hash_table_lookup (self->streams, GUINT_TO_POINTER (ssrc));
+  if (stream)
+    buffer = gst_rtp_rtx_cache_lookup (stream->cache, seqnum);
+  if (buffer) {
+    GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+    guint8 pt;
+
+    gst_rtp_buffer_map (buffer, GST_MAP_READ, &rtp);
+    pt = gst_rtp_buffer_get_payload_type (&rtp);
+    gst_rtp_buffer_unmap (&rtp);
+
+    /* The payload type may have been dropped from the map since */
+    if (self->rtx_pt[pt] >= 0)
+      rtx = gst_rtp_rtx_send_make_rtx (buffer, self->rtx_pt[pt],
+          stream->rtx_ssrc, stream->rtx_seq++);
+    if (rtx) {
+      g_queue_push_tail (&self->pending, rtx);
+      self->retransmitted++;
+    }
+    gst_buffer_unref (buffer);
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  if (rtx == NULL)
+    GST_LOG_OBJECT (self, "Packet %u of ssrc 0x%08x is not cached", seqnum,
+        ssrc);
+  else
+    GST_LOG_OBJECT (self, "Retransmitting packet %u of ssrc 0x%08x", seqnum,
+        ssrc);
+}
+
+static gboolean
+gst_rtp_rtx_send_src_event (GstPad * pad, GstObject * parent,
+    GstEvent * event)
+{
+  GstRtpRtxSend *self = GST_RTP_RTX_SEND (parent);
+
+  if (GST_EVENT_TYPE (event) == GST_EVENT_CUSTOM_UPSTREAM
+      && gst_event_has_name (event, "GstRTPRetransmissionRequest")) {
+    gst_rtp_rtx_send_retransmit (self, gst_event_get_structure (event));
+    gst_event_unref (event);
+
+    return TRUE;
+  }
+
+  return gst_pad_push_event (self->sinkpad, event);
+}
+
+static GstStateChangeReturn
+gst_rtp_rtx_send_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstRtpRtxSend *self = GST_RTP_RTX_SEND (element);
+  GstStateChangeReturn ret;
+
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+  if (transition == GST_STATE_CHANGE_PAUSED_TO_READY) {
+    GST_OBJECT_LOCK (self);
+    gst_rtp_rtx_send_clear_unlocked (self);
+    self->requests = 0;
+    self->retransmitted = 0;
+    GST_OBJECT_UNLOCK (self);
+  }
+
+  return ret;
+}
+
+static void
+gst_rtp_rtx_send_class_init (GstRtpRtxSendClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *gstelement_class = GST_ELEMENT_CLASS (klass);
+
+  gobject_class->set_property = gst_rtp_rtx_send_set_property;
+  gobject_class->get_property = gst_rtp_rtx_send_get_property;
+  gobject_class->finalize = gst_rtp_rtx_send_finalize;
+
+  gstelement_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_rtp_rtx_send_change_state);
+
+  /**
+   * GstRtpRtxSend:max-size-time:
+   *
+   * How long in ms a packet is kept for retransmission, measured on the
+   * timestamps of the stream. It should cover the round trip time and
+   * the time the receiver waits before it asks for a packet. Applies to
+   * the streams that start after it is set.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_SIZE_TIME,
+      g_param_spec_uint ("max-size-time", "Max size time",
+          "Time in ms to keep packets for retransmission (0 = unlimited)",
+          0, G_MAXUINT, DEFAULT_PROP_MAX_SIZE_TIME,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpRtxSend:max-size-bytes:
+   *
+   * How many bytes of packets are kept per SSRC, whatever their age, so
+   * that a bitrate peak cannot make the cache grow without bounds.
+   * Applies to the streams that start after it is set.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_SIZE_BYTES,
+      g_param_spec_uint ("max-size-bytes", "Max size bytes",
+          "Bytes of packets to keep per SSRC for retransmission "
+          "(0 = unlimited)", 0, G_MAXUINT, DEFAULT_PROP_MAX_SIZE_BYTES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpRtxSend:payload-type-map:
+   *
+   * The retransmission payload type of each media payload type, as in
+   * rtprtxsend: an application/x-rtp-pt-map structure with a field of
+   * type G_TYPE_UINT per media payload type, named after it. Only the
+   * packets of these payload types are kept.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_PAYLOAD_TYPE_MAP,
+      g_param_spec_boxed ("payload-type-map", "Payload type map",
+          "Map of media payload types to retransmission payload types",
+          GST_TYPE_STRUCTURE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpRtxSend:stats:
+   *
+   * Statistics in a "application/x-rtp-rtx-send-stats" structure: the
+   * number of packets the receivers asked for as "requests" and the
+   * number of them that were still cached and sent again as
+   * "retransmitted", both G_TYPE_UINT64, and the size of the caches of all
+   * SSRCs as "cached-packets", G_TYPE_UINT, and "cached-bytes",
+   * G_TYPE_UINT64.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics", "Retransmission statistics",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_add_pad_template (gstelement_class,
+      gst_static_pad_template_get (&sink_template));
+  gst_element_class_add_pad_template (gstelement_class,
+      gst_static_pad_template_get (&src_template));
+
+  gst_element_class_set_static_metadata (gstelement_class,
+      "RTP retransmission sender",
+      "Codec/Network/RTP",
+      "Retransmit RTP packets from a bounded cache as in RFC 4588",
+      "Marc Leeman <marc.leeman@gmail.com>");
+}
+
+static void
+gst_rtp_rtx_send_init (GstRtpRtxSend * self)
+{
+  self->sinkpad = gst_pad_new_from_static_template (&sink_template, "sink");
+  gst_pad_set_chain_function (self->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_rtp_rtx_send_chain));
+  gst_pad_set_chain_list_function (self->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_rtp_rtx_send_chain_list));
+  gst_pad_set_event_function (self->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_rtp_rtx_send_sink_event));
+  GST_PAD_SET_PROXY_CAPS (self->sinkpad);
+  GST_PAD_SET_PROXY_ALLOCATION (self->sinkpad);
+  gst_element_add_pad (GST_ELEMENT (self), self->sinkpad);
+
+  self->srcpad = gst_pad_new_from_static_template (&src_template, "src");
+  gst_pad_set_event_function (self->srcpad,
+      GST_DEBUG_FUNCPTR (gst_rtp_rtx_send_src_event));
+  GST_PAD_SET_PROXY_CAPS (self->srcpad);
+  gst_element_add_pad (GST_ELEMENT (self), self->srcpad);
+
+  self->max_size_time = DEFAULT_PROP_MAX_SIZE_TIME;
+  self->max_size_bytes = DEFAULT_PROP_MAX_SIZE_BYTES;
+  gst_rtp_rtx_send_set_pt_map (self, NULL);
+  self->streams = g_hash_table_new_full (NULL, NULL, NULL,
+      (GDestroyNotify) gst_rtp_rtx_send_stream_free);
+  g_queue_init (&self->pending);
+}
+
+/* ex: set tabstop=2 shiftwidth=2 expandtab: */
@@ -0,0 +1,12 @@
+#ifndef _GST_RTP_RTX_SEND_H_
+#define _GST_RTP_RTX_SEND_H_
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+#define GST_TYPE_RTP_RTX_SEND (gst_rtp_rtx_send_get_type ())
+G_DECLARE_FINAL_TYPE (GstRtpRtxSend, gst_rtp_rtx_send, GST, RTP_RTX_SEND,
+    GstElement);
+G_END_DECLS
+
+#endif
@@ -0,0 +1,1651 @@
+/* GStreamer
+ * Copyright (C) <2018> Marc Leeman <marc.leeman@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION: gstrtpsendsink
+ * @title: GstRtpSendSink
+ * @short description: UDP sink that sends RTP packets to the network
+ * in batches.
+ *
+ * This element is used by #GstRtpSink to send RTP packets when batched
+ * sending is requested. Outgoing packets are collected until
+ * #GstRtpSendSink:batch-size packets are pending or the oldest pending
+ * packet has waited #GstRtpSendSink:batch-timeout microseconds. The
+ * batch is then sent with a single sendmmsg() call. Buffer lists are
+ * sent as soon as the whole list has been collected.
+ *
+ * On Linux, runs of equal-sized packets are sent as one UDP GSO
+ * (UDP_SEGMENT) super-datagram that the kernel or the network card
+ * splits into the original packets. When the kernel does not support
+ * UDP_SEGMENT, every packet is sent as a separate message.
+ *
+ * Besides #GstRtpSendSink:host and #GstRtpSendSink:port, more
+ * destinations can be added and removed at any time with the
+ * #GstRtpSendSink::add and #GstRtpSendSink::remove action signals, the
+ * same way as with multiudpsink. Every batch is sent to all destinations
+ * from the same mapped buffers, and #GstRtpSendSink::get-stats returns the
+ * number of packets and bytes sent to one destination.
+ *
+ * With #GstRtpSendSink:zerocopy on Linux, messages of at least
+ * #GstRtpSendSink:zerocopy-threshold bytes, typically UDP GSO
+ * super-datagrams of a high bitrate stream, are sent with MSG_ZEROCOPY.
+ * The kernel then transmits straight from the buffer memory instead of
+ * copying it, and the buffers are kept until the kernel reports on the
+ * socket error queue that it is done with them. Smaller messages are
+ * copied as before, for them the completion handling costs more than
+ * the copy.
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <errno.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#ifdef __linux__
+#include <netinet/udp.h>
+#include <linux/errqueue.h>
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#if defined (SO_ZEROCOPY) && defined (MSG_ZEROCOPY) && \
+    defined (SO_EE_ORIGIN_ZEROCOPY)
+#define HAVE_ZEROCOPY 1
+#endif
+#endif
+
+#ifndef HAVE_ZEROCOPY
+#define MSG_ZEROCOPY 0
+#endif
+
+#include <gio/gio.h>
+
+#include "gstrtpsendsink.h"
+#include "gstrtp-utils.h"
+#include "gstrtp-resolver.h"
+#include "gstrtp-sockopt.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_rtp_send_sink_debug);
+#define GST_CAT_DEFAULT gst_rtp_send_sink_debug
+
+#define DEFAULT_PROP_HOST             "localhost"
+#define DEFAULT_PROP_PORT             5004
+#define DEFAULT_PROP_TTL              64
+#define DEFAULT_PROP_TTL_MC           1
+#define DEFAULT_PROP_BATCH_SIZE       32
+#define DEFAULT_PROP_BATCH_TIMEOUT    1000
+#define DEFAULT_PROP_GSO              TRUE
+#define DEFAULT_PROP_ZEROCOPY         FALSE
+#define DEFAULT_PROP_ZEROCOPY_THRESHOLD 10240
+
+#define MAX_BATCH_SIZE                1024
+
+/* Kernel limits for one UDP GSO send */
+#define GSO_MAX_SEGMENTS              64
+#define GSO_MAX_BYTES                 65000
+
+/* How long stopping waits for the kernel to release zero-copy buffers */
+#define ZEROCOPY_DRAIN_TIMEOUT        (G_USEC_PER_SEC)
+
+/* Age in seconds up to which a cached address of a changed host property
+ * is used */
+#define HOST_CACHE_TTL                60
+
+#ifndef HAVE_SENDMMSG
+struct mmsghdr
+{
+  struct msghdr msg_hdr;
+  unsigned int msg_len;
+};
+#endif
+
+typedef struct
+{
+  gchar *host;
+  gint port;
+  /* Added from the host and port properties when starting */
+  gboolean primary;
+
+  struct sockaddr_storage addr;
+  socklen_t addr_len;
+
+  guint64 packets_sent;
+  guint64 bytes_sent;
+} GstRtpSendSinkDest;
+
+typedef union
+{
+  gchar buf[CMSG_SPACE (sizeof (guint16))];
+  struct cmsghdr align;
+} GstRtpSendSinkCmsg;
+
+/* The buffers of one zero-copy send, kept until the kernel reports that
+ * it no longer needs their memory. @id counts the zero-copy sends on the
+ * socket, like the kernel does. */
+typedef struct
+{
+  guint32 id;
+  GstBufferList *buffers;
+} GstRtpSendSinkZerocopy;
+
+struct _GstRtpSendSink
+{
+  GstBaseSink parent_instance;
+
+  /* Properties */
+  gchar *host;
+  gint port;
+  gint ttl;
+  gint ttl_mc;
+  guint batch_size;
+  guint batch_timeout;
+  gboolean gso;
+  gboolean zerocopy;
+  guint zerocopy_threshold;
+  /* Protected by the object lock */
+  GstRtpSocketOptions socket_options;
+  /* Bumped to ignore the result of a running lookup of the host, protected
+   * by the object lock */
+  guint primary_seq;
+
+  GSocket *socket;
+  /* Cancelled in unlock () to stop waiting for the socket */
+  GCancellable *cancellable;
+  gboolean gso_enabled;
+  gboolean zerocopy_enabled;
+
+  /* Pending batch, allocated in start () and protected by the lock */
+  GMutex lock;
+  /* The batch and the destinations are being sent, the lock is released
+   * while waiting for the socket. Signalled on idle_cond when done. */
+  gboolean sending;
+  GCond idle_cond;
+  /* GstRtpSendSinkDest, every batch is sent to each of them */
+  GPtrArray *dests;
+  guint n_pending;
+  guint max_pending;
+  GstBuffer **pending;
+  GstMapInfo *maps;
+  struct iovec *iovs;
+  struct mmsghdr *msgs;
+  GstRtpSendSinkCmsg *cmsgs;
+
+  GstClock *clock;
+  GstClockID timeout_id;
+
+  /* GstRtpSendSinkZerocopy waiting for completion and the zero-copy
+   * statistics, protected by the lock */
+  GQueue zc_pending;
+  guint32 zc_next_id;
+  guint64 zc_sends;
+  guint64 zc_completed;
+  guint64 zc_copied;
+  guint64 copied_sends;
+};
+
+enum
+{
+  PROP_0,
+
+  PROP_HOST,
+  PROP_PORT,
+  PROP_TTL,
+  PROP_TTL_MC,
+  PROP_BATCH_SIZE,
+  PROP_BATCH_TIMEOUT,
+  PROP_GSO,
+  PROP_USED_SOCKET,
+  PROP_ZEROCOPY,
+  PROP_ZEROCOPY_THRESHOLD,
+  PROP_ZEROCOPY_STATS,
+  PROP_SOCKET_OPTIONS,
+
+  PROP_LAST
+};
+
+enum
+{
+  SIGNAL_ADD,
+  SIGNAL_REMOVE,
+  SIGNAL_CLEAR,
+  SIGNAL_GET_STATS,
+
+  LAST_SIGNAL
+};
+
+static guint gst_rtp_send_sink_signals[LAST_SIGNAL] = { 0 };
+
+#define gst_rtp_send_sink_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstRtpSendSink, gst_rtp_send_sink,
+    GST_TYPE_BASE_SINK,
+    GST_DEBUG_CATEGORY_INIT (gst_rtp_send_sink_debug, "nrtp_sendsink", 0,
+        "RTP Batched Send Sink"));
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+static void gst_rtp_send_sink_update_primary (GstRtpSendSink * self);
+
+static void
+gst_rtp_send_sink_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstRtpSendSink *self = GST_RTP_SEND_SINK (object);
+
+  switch (prop_id) {
+    case PROP_HOST:
+      GST_OBJECT_LOCK (self);
+      g_free (self->host);
+      self->host = g_value_dup_string (value);
+      if (self->host == NULL)
+        self->host = g_strdup (DEFAULT_PROP_HOST);
+      GST_OBJECT_UNLOCK (self);
+      gst_rtp_send_sink_update_primary (self);
+      break;
+    case PROP_PORT:
+      GST_OBJECT_LOCK (self);
+      self->port = g_value_get_int (value);
+      GST_OBJECT_UNLOCK (self);
+      gst_rtp_send_sink_update_primary (self);
+      break;
+    case PROP_TTL:
+      self->ttl = g_value_get_int (value);
+      break;
+    case PROP_TTL_MC:
+      self->ttl_mc = g_value_get_int (value);
+      break;
+    case PROP_BATCH_SIZE:
+      self->batch_size = g_value_get_uint (value);
+      break;
+    case PROP_BATCH_TIMEOUT:
+      self->batch_timeout = g_value_get_uint (value);
+      break;
+    case PROP_GSO:
+      self->gso = g_value_get_boolean (value);
+      break;
+    case PROP_ZEROCOPY:
+      self->zerocopy = g_value_get_boolean (value);
+      break;
+    case PROP_ZEROCOPY_THRESHOLD:
+      g_mutex_lock (&self->lock);
+      self->zerocopy_threshold = g_value_get_uint (value);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_SOCKET_OPTIONS:
+      GST_OBJECT_LOCK (self);
+      gst_rtp_socket_options_from_structure (&self->socket_options,
+          gst_value_get_structure (value));
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_rtp_send_sink_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstRtpSendSink *self = GST_RTP_SEND_SINK (object);
+
+  switch (prop_id) {
+    case PROP_HOST:
+      GST_OBJECT_LOCK (self);
+      g_value_set_string (value, self->host);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_PORT:
+      GST_OBJECT_LOCK (self);
+      g_value_set_int (value, self->port);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_TTL:
+      g_value_set_int (value, self->ttl);
+      break;
+    case PROP_TTL_MC:
+      g_value_set_int (value, self->ttl_mc);
+      break;
+    case PROP_BATCH_SIZE:
+      g_value_set_uint (value, self->batch_size);
+      break;
+    case PROP_BATCH_TIMEOUT:
+      g_value_set_uint (value, self->batch_timeout);
+      break;
+    case PROP_GSO:
+      g_value_set_boolean (value, self->gso);
+      break;
+    case PROP_USED_SOCKET:
+      GST_OBJECT_LOCK (self);
+      g_value_set_object (value, self->socket);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_ZEROCOPY:
+      g_value_set_boolean (value, self->zerocopy);
+      break;
+    case PROP_ZEROCOPY_THRESHOLD:
+      g_mutex_lock (&self->lock);
+      g_value_set_uint (value, self->zerocopy_threshold);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_ZEROCOPY_STATS:
+      g_mutex_lock (&self->lock);
+      g_value_take_boxed (value,
+          gst_structure_new ("application/x-rtp-zerocopy-stats",
+              "enabled", G_TYPE_BOOLEAN, self->zerocopy_enabled,
+              "zerocopy-sends", G_TYPE_UINT64, self->zc_sends,
+              "copied-sends", G_TYPE_UINT64, self->copied_sends,
+              "completed", G_TYPE_UINT64, self->zc_completed,
+              "kernel-copied", G_TYPE_UINT64, self->zc_copied,
+              "in-flight", G_TYPE_UINT, self->zc_pending.length, NULL));
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_SOCKET_OPTIONS:
+      GST_OBJECT_LOCK (self);
+      g_value_take_boxed (value,
+          gst_rtp_socket_options_to_structure (&self->socket_options));
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_rtp_send_sink_finalize (GObject * gobject)
+{
+  GstRtpSendSink *self = GST_RTP_SEND_SINK (gobject);
+
+  g_free (self->host);
+  g_ptr_array_unref (self->dests);
+  gst_object_unref (self->clock);
+  g_object_unref (self->cancellable);
+
+  g_cond_clear (&self->idle_cond);
+  g_mutex_clear (&self->lock);
+  G_OBJECT_CLASS (parent_class)->finalize (gobject);
+}
+
+static GstRtpSendSinkDest *
+gst_rtp_send_sink_dest_new (const gchar * host, gint port,
+    GInetAddress * iaddr)
+{
+  GstRtpSendSinkDest *dest = g_slice_new0 (GstRtpSendSinkDest);
+  GSocketAddress *addr;
+
+  dest->host = g_strdup (host);
+  dest->port = port;
+
+  addr = g_inet_socket_address_new (iaddr, port);
+  dest->addr_len = g_socket_address_get_native_size (addr);
+  g_socket_address_to_native (addr, &dest->addr, sizeof (dest->addr), NULL);
+  g_object_unref (addr);
+
+  return dest;
+}
+
+static void
+gst_rtp_send_sink_dest_free (GstRtpSendSinkDest * dest)
+{
+  g_free (dest->host);
+  g_slice_free (GstRtpSendSinkDest, dest);
+}
+
+static gint
+gst_rtp_send_sink_find_dest_unlocked (GstRtpSendSink * self,
+    const gchar * host, gint port)
+{
+  guint i;
+
+  for (i = 0; i < self->dests->len; i++) {
+    GstRtpSendSinkDest *dest = g_ptr_array_index (self->dests, i);
+
+    if (dest->port == port && g_strcmp0 (dest->host, host) == 0)
+      return i;
+  }
+
+  return -1;
+}
+
+/* The batch and the destinations must not change while they are being
+ * sent */
+static void
+gst_rtp_send_sink_wait_idle_unlocked (GstRtpSendSink * self)
+{
+  while (self->sending)
+    g_cond_wait (&self->idle_cond, &self->lock);
+}
+
+static void
+gst_rtp_send_sink_add (GstRtpSendSink * self, const gchar * host, gint port)
+{
+  GstRtpSendSinkDest *dest;
+  GInetAddress *iaddr;
+  GError *error = NULL;
+
+  /* Resolve outside of the lock, sending goes on in the mean time */
+  iaddr = gst_rtp_utils_resolve_host (host, &error);
+  if (iaddr == NULL) {
+    GST_ELEMENT_WARNING (self, RESOURCE, NOT_FOUND,
+        ("Could not resolve hostname '%s'", host),
+        ("DNS resolver reported: %s", error->message));
+    g_error_free (error);
+    return;
+  }
+
+  dest = gst_rtp_send_sink_dest_new (host, port, iaddr);
+  g_object_unref (iaddr);
+
+  g_mutex_lock (&self->lock);
+  gst_rtp_send_sink_wait_idle_unlocked (self);
+  if (gst_rtp_send_sink_find_dest_unlocked (self, host, port) < 0) {
+    GST_DEBUG_OBJECT (self, "Adding destination %s:%d", host, port);
+    g_ptr_array_add (self->dests, dest);
+    dest = NULL;
+  }
+  g_mutex_unlock (&self->lock);
+
+  if (dest) {
+    GST_DEBUG_OBJECT (self, "Destination %s:%d already added", host, port);
+    gst_rtp_send_sink_dest_free (dest);
+  }
+}
+
+static void
+gst_rtp_send_sink_remove_primary_unlocked (GstRtpSendSink * self)
+{
+  guint i;
+
+  gst_rtp_send_sink_wait_idle_unlocked (self);
+  for (i = self->dests->len; i > 0; i--) {
+    GstRtpSendSinkDest *dest = g_ptr_array_index (self->dests, i - 1);
+
+    if (dest->primary)
+      g_ptr_array_remove_index (self->dests, i - 1);
+  }
+}
+
+/* The host and port properties are a destination like the added ones, as
+ * long as the element is started. It replaces the previous one, unless it
+ * was also added with the add signal. */
+static void
+gst_rtp_send_sink_set_primary_unlocked (GstRtpSendSink * self,
+    const gchar * host, gint port, GInetAddress * iaddr)
+{
+  GstRtpSendSinkDest *dest;
+
+  gst_rtp_send_sink_remove_primary_unlocked (self);
+  if (gst_rtp_send_sink_find_dest_unlocked (self, host, port) >= 0)
+    return;
+
+  dest = gst_rtp_send_sink_dest_new (host, port, iaddr);
+  dest->primary = TRUE;
+  g_ptr_array_insert (self->dests, 0, dest);
+}
+
+typedef struct
+{
+  GstRtpSendSink *sink;
+  gchar *host;
+  gint port;
+  guint seq;
+} GstRtpSendSinkLookup;
+
+static void
+gst_rtp_send_sink_lookup_free (GstRtpSendSinkLookup * lookup)
+{
+  gst_object_unref (lookup->sink);
+  g_free (lookup->host);
+  g_free (lookup);
+}
+
+static void
+gst_rtp_send_sink_primary_resolved (GInetAddress * iaddr,
+    const GError * error, GstRtpSendSinkLookup * lookup)
+{
+  GstRtpSendSink *self = lookup->sink;
+  gboolean current;
+
+  /* Checked with the lock held, stop () bumps the sequence number before
+   * it removes the primary destination */
+  g_mutex_lock (&self->lock);
+  GST_OBJECT_LOCK (self);
+  current = lookup->seq == self->primary_seq && self->socket != NULL;
+  GST_OBJECT_UNLOCK (self);
+
+  if (current && iaddr) {
+    GST_DEBUG_OBJECT (self, "Sending to %s:%d", lookup->host, lookup->port);
+    gst_rtp_send_sink_set_primary_unlocked (self, lookup->host,
+        lookup->port, iaddr);
+  }
+  g_mutex_unlock (&self->lock);
+
+  if (current && iaddr == NULL)
+    GST_ELEMENT_WARNING (self, RESOURCE, NOT_FOUND,
+        ("Could not resolve hostname '%s'", lookup->host),
+        ("DNS resolver reported: %s", error->message));
+}
+
+/* Apply a change of the host or port properties while started, like the
+ * host and port of multiudpsink replace its first client. The host is
+ * looked up without blocking the caller, the last change wins. */
+static void
+gst_rtp_send_sink_update_primary (GstRtpSendSink * self)
+{
+  GstRtpSendSinkLookup *lookup;
+
+  GST_OBJECT_LOCK (self);
+  if (self->socket == NULL) {
+    GST_OBJECT_UNLOCK (self);
+    return;
+  }
+  lookup = g_new0 (GstRtpSendSinkLookup, 1);
+  lookup->sink = gst_object_ref (self);
+  lookup->host = g_strdup (self->host);
+  lookup->port = self->port;
+  lookup->seq = ++self->primary_seq;
+  GST_OBJECT_UNLOCK (self);
+
+  gst_rtp_resolver_lookup_async (lookup->host, HOST_CACHE_TTL,
+      (GstRtpResolverFunc) gst_rtp_send_sink_primary_resolved, lookup,
+      (GDestroyNotify) gst_rtp_send_sink_lookup_free);
+}
+
+static void
+gst_rtp_send_sink_remove (GstRtpSendSink * self, const gchar * host,
+    gint port)
+{
+  gint index;
+
+  g_mutex_lock (&self->lock);
+  gst_rtp_send_sink_wait_idle_unlocked (self);
+  index = gst_rtp_send_sink_find_dest_unlocked (self, host, port);
+  if (index >= 0) {
+    GST_DEBUG_OBJECT (self, "Removing destination %s:%d", host, port);
+    g_ptr_array_remove_index (self->dests, index);
+  }
+  g_mutex_unlock (&self->lock);
+}
+
+static void
+gst_rtp_send_sink_clear (GstRtpSendSink * self)
+{
+  g_mutex_lock (&self->lock);
+  gst_rtp_send_sink_wait_idle_unlocked (self);
+  g_ptr_array_set_size (self->dests, 0);
+  g_mutex_unlock (&self->lock);
+}
+
+static GstStructure *
+gst_rtp_send_sink_get_stats (GstRtpSendSink * self, const gchar * host,
+    gint port)
+{
+  guint64 packets_sent = 0, bytes_sent = 0;
+  gint index;
+
+  g_mutex_lock (&self->lock);
+  index = gst_rtp_send_sink_find_dest_unlocked (self, host, port);
+  if (index >= 0) {
+    GstRtpSendSinkDest *dest = g_ptr_array_index (self->dests, index);
+
+    packets_sent = dest->packets_sent;
+    bytes_sent = dest->bytes_sent;
+  }
+  g_mutex_unlock (&self->lock);
+
+  if (index < 0)
+    GST_WARNING_OBJECT (self, "No destination %s:%d", host, port);
+
+  return gst_structure_new ("application/x-rtp-send-sink-stats",
+      "host", G_TYPE_STRING, host, "port", G_TYPE_INT, port,
+      "packets-sent", G_TYPE_UINT64, packets_sent,
+      "bytes-sent", G_TYPE_UINT64, bytes_sent, NULL);
+}
+
+static gint
+gst_rtp_send_sink_sendmmsg (gint fd, struct mmsghdr *msgs, guint n_msgs,
+    gint flags)
+{
+#ifdef HAVE_SENDMMSG
+  return sendmmsg (fd, msgs, n_msgs, flags);
+#else
+  guint i;
+
+  for (i = 0; i < n_msgs; i++) {
+    gssize len = sendmsg (fd, &msgs[i].msg_hdr, flags);
+
+    if (len < 0)
+      return i > 0 ? (gint) i : -1;
+    msgs[i].msg_len = len;
+  }
+
+  return n_msgs;
+#endif
+}
+
+static gboolean
+gst_rtp_send_sink_enable_zerocopy (GstRtpSendSink * self)
+{
+#ifdef HAVE_ZEROCOPY
+  GError *error = NULL;
+
+  if (!g_socket_set_option (self->socket, SOL_SOCKET, SO_ZEROCOPY, 1,
+          &error)) {
+    GST_WARNING_OBJECT (self, "Could not enable zero-copy sending: %s",
+        error->message);
+    g_clear_error (&error);
+    return FALSE;
+  }
+
+  return TRUE;
+#else
+  GST_WARNING_OBJECT (self, "Zero-copy sending is not supported");
+  return FALSE;
+#endif
+}
+
+static void
+gst_rtp_send_sink_zerocopy_free (GstRtpSendSinkZerocopy * zc)
+{
+  gst_buffer_list_unref (zc->buffers);
+  g_slice_free (GstRtpSendSinkZerocopy, zc);
+}
+
+/* Keep the buffers of a message that was sent with MSG_ZEROCOPY */
+static void
+gst_rtp_send_sink_zerocopy_track_unlocked (GstRtpSendSink * self,
+    struct msghdr *hdr)
+{
+  GstRtpSendSinkZerocopy *zc = g_slice_new (GstRtpSendSinkZerocopy);
+  guint first = hdr->msg_iov - self->iovs;
+  guint i;
+
+  zc->id = self->zc_next_id++;
+  zc->buffers = gst_buffer_list_new_sized (hdr->msg_iovlen);
+  for (i = 0; i < hdr->msg_iovlen; i++)
+    gst_buffer_list_add (zc->buffers,
+        gst_buffer_ref (self->pending[first + i]));
+
+  g_queue_push_tail (&self->zc_pending, zc);
+  self->zc_sends++;
+}
+
+/* Release the sends @lo to @hi, the range may wrap around */
+static void
+gst_rtp_send_sink_zerocopy_complete_unlocked (GstRtpSendSink * self,
+    guint32 lo, guint32 hi, gboolean copied)
+{
+  GList *l, *next;
+
+  for (l = self->zc_pending.head; l; l = next) {
+    GstRtpSendSinkZerocopy *zc = l->data;
+
+    next = l->next;
+    if ((guint32) (zc->id - lo) <= (guint32) (hi - lo)) {
+      g_queue_delete_link (&self->zc_pending, l);
+      gst_rtp_send_sink_zerocopy_free (zc);
+      self->zc_completed++;
+    }
+  }
+
+  /* The kernel copied after all, for instance on the loopback device */
+  if (copied)
+    self->zc_copied += (guint32) (hi - lo) + 1;
+}
+
+/* Read all completion notifications from the socket error queue without
+ * blocking. */
+static void
+gst_rtp_send_sink_zerocopy_reap_unlocked (GstRtpSendSink * self)
+{
+#ifdef HAVE_ZEROCOPY
+  gint fd = g_socket_get_fd (self->socket);
+  union
+  {
+    gchar buf[CMSG_SPACE (sizeof (struct sock_extended_err) +
+            sizeof (struct sockaddr_in6))];
+    struct cmsghdr align;
+  } control;
+
+  while (!g_queue_is_empty (&self->zc_pending)) {
+    struct msghdr msg = { 0, };
+    struct cmsghdr *cm;
+
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof (control.buf);
+    if (recvmsg (fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+      break;
+
+    for (cm = CMSG_FIRSTHDR (&msg); cm; cm = CMSG_NXTHDR (&msg, cm)) {
+      struct sock_extended_err err;
+
+      if (!(cm->cmsg_level == IPPROTO_IP && cm->cmsg_type == IP_RECVERR)
+          && !(cm->cmsg_level == IPPROTO_IPV6
+              && cm->cmsg_type == IPV6_RECVERR))
+        continue;
+
+      memcpy (&err, CMSG_DATA (cm), sizeof (err));
+      if (err.ee_errno != 0 || err.ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+        continue;
+
+      gst_rtp_send_sink_zerocopy_complete_unlocked (self, err.ee_info,
+          err.ee_data, (err.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0);
+    }
+  }
+#endif
+}
+
+/* Wait up to @timeout microseconds for completion notifications */
+static void
+gst_rtp_send_sink_zerocopy_wait_unlocked (GstRtpSendSink * self,
+    gint64 timeout)
+{
+  g_socket_condition_timed_wait (self->socket, G_IO_ERR, timeout, NULL,
+      NULL);
+  gst_rtp_send_sink_zerocopy_reap_unlocked (self);
+}
+
+/* Before the socket is closed, give the kernel some time to finish with
+ * the buffers it still uses. */
+static void
+gst_rtp_send_sink_zerocopy_drain_unlocked (GstRtpSendSink * self)
+{
+  gint64 end = g_get_monotonic_time () + ZEROCOPY_DRAIN_TIMEOUT;
+
+  gst_rtp_send_sink_zerocopy_reap_unlocked (self);
+  while (!g_queue_is_empty (&self->zc_pending)
+      && g_get_monotonic_time () < end)
+    gst_rtp_send_sink_zerocopy_wait_unlocked (self, 10000);
+
+  if (!g_queue_is_empty (&self->zc_pending))
+    GST_WARNING_OBJECT (self, "%u zero-copy sends did not complete",
+        self->zc_pending.length);
+
+  g_queue_foreach (&self->zc_pending, (GFunc) gst_rtp_send_sink_zerocopy_free,
+      NULL);
+  g_queue_clear (&self->zc_pending);
+}
+
+static gboolean
+gst_rtp_send_sink_probe_gso (GstRtpSendSink * self)
+{
+#ifdef __linux__
+  gint val = 0;
+  socklen_t len = sizeof (val);
+
+  if (getsockopt (g_socket_get_fd (self->socket), SOL_UDP, UDP_SEGMENT,
+          &val, &len) == 0)
+    return TRUE;
+#endif
+
+  return FALSE;
+}
+
+/* Number of packets starting at @first that can be sent as one GSO
+ * datagram: all segments have the same size, only the last one may be
+ * shorter. */
+static guint
+gst_rtp_send_sink_gso_segments (GstRtpSendSink * self, guint first)
+{
+  gsize size = self->maps[first].size;
+  gsize total = size;
+  guint count = 1;
+
+  while (first + count < self->n_pending && count < GSO_MAX_SEGMENTS) {
+    gsize next = self->maps[first + count].size;
+
+    if (next > size || total + next > GSO_MAX_BYTES)
+      break;
+
+    total += next;
+    count++;
+
+    if (next < size)
+      break;
+  }
+
+  return count;
+}
+
+static void
+gst_rtp_send_sink_set_gso_size (GstRtpSendSink * self, guint msg,
+    guint16 segment_size)
+{
+#ifdef __linux__
+  struct msghdr *hdr = &self->msgs[msg].msg_hdr;
+  struct cmsghdr *cm;
+
+  hdr->msg_control = self->cmsgs[msg].buf;
+  hdr->msg_controllen = sizeof (self->cmsgs[msg].buf);
+
+  cm = CMSG_FIRSTHDR (hdr);
+  cm->cmsg_level = SOL_UDP;
+  cm->cmsg_type = UDP_SEGMENT;
+  cm->cmsg_len = CMSG_LEN (sizeof (segment_size));
+  memcpy (CMSG_DATA (cm), &segment_size, sizeof (segment_size));
+#endif
+}
+
+/* Fill in the message headers for the pending packets to @dest, starting
+ * at packet @first. Returns the number of messages. */
+static guint
+gst_rtp_send_sink_build_msgs (GstRtpSendSink * self,
+    GstRtpSendSinkDest * dest, guint first)
+{
+  guint i = first, n_msgs = 0;
+
+  while (i < self->n_pending) {
+    struct msghdr *hdr = &self->msgs[n_msgs].msg_hdr;
+    guint count = 1;
+
+    if (self->gso_enabled)
+      count = gst_rtp_send_sink_gso_segments (self, i);
+
+    memset (hdr, 0, sizeof (*hdr));
+    hdr->msg_name = &dest->addr;
+    hdr->msg_namelen = dest->addr_len;
+    hdr->msg_iov = &self->iovs[i];
+    hdr->msg_iovlen = count;
+
+    if (count > 1)
+      gst_rtp_send_sink_set_gso_size (self, n_msgs, self->maps[i].size);
+
+    n_msgs++;
+    i += count;
+  }
+
+  return n_msgs;
+}
+
+static gboolean
+gst_rtp_send_sink_use_zerocopy (GstRtpSendSink * self, guint msg)
+{
+  struct msghdr *hdr = &self->msgs[msg].msg_hdr;
+  gsize size = 0;
+  guint i;
+
+  for (i = 0; i < hdr->msg_iovlen; i++)
+    size += hdr->msg_iov[i].iov_len;
+
+  return size >= self->zerocopy_threshold;
+}
+
+/* Number of messages from @first on that are all sent with or all sent
+ * without MSG_ZEROCOPY, the flag applies to a whole sendmmsg() call. */
+static guint
+gst_rtp_send_sink_zerocopy_run (GstRtpSendSink * self, guint first,
+    guint n_msgs, gint * flags)
+{
+  gboolean zerocopy;
+  guint count = 1;
+
+  if (!self->zerocopy_enabled) {
+    *flags = 0;
+    return n_msgs - first;
+  }
+
+  zerocopy = gst_rtp_send_sink_use_zerocopy (self, first);
+  while (first + count < n_msgs
+      && gst_rtp_send_sink_use_zerocopy (self, first + count) == zerocopy)
+    count++;
+
+  *flags = zerocopy ? MSG_ZEROCOPY : 0;
+
+  return count;
+}
+
+/* Wait up to @timeout microseconds, or forever when -1, for @condition
+ * on the socket without holding the lock. Returns FALSE when unlock () was
+ * called. */
+static gboolean
+gst_rtp_send_sink_wait_socket_unlocked (GstRtpSendSink * self,
+    GIOCondition condition, gint64 timeout)
+{
+  GError *error = NULL;
+  gboolean cancelled;
+
+  g_mutex_unlock (&self->lock);
+  g_socket_condition_timed_wait (self->socket, condition, timeout,
+      self->cancellable, &error);
+  g_mutex_lock (&self->lock);
+
+  cancelled = g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+  g_clear_error (&error);
+
+  return !cancelled;
+}
+
+/* Returns FALSE when sending was interrupted by unlock () */
+static gboolean
+gst_rtp_send_sink_send_unlocked (GstRtpSendSink * self,
+    GstRtpSendSinkDest * dest)
+{
+  gint fd = g_socket_get_fd (self->socket);
+  guint n_msgs, sent = 0;
+
+  n_msgs = gst_rtp_send_sink_build_msgs (self, dest, 0);
+
+  while (sent < n_msgs) {
+    struct msghdr *hdr = &self->msgs[sent].msg_hdr;
+    gint ret, i, flags;
+    guint count;
+
+    count = gst_rtp_send_sink_zerocopy_run (self, sent, n_msgs, &flags);
+    ret = gst_rtp_send_sink_sendmmsg (fd, self->msgs + sent, count, flags);
+    if (ret >= 0) {
+      for (i = 0; i < ret; i++) {
+        dest->packets_sent += self->msgs[sent + i].msg_hdr.msg_iovlen;
+        dest->bytes_sent += self->msgs[sent + i].msg_len;
+        if (flags & MSG_ZEROCOPY)
+          gst_rtp_send_sink_zerocopy_track_unlocked (self,
+              &self->msgs[sent + i].msg_hdr);
+        else if (self->zerocopy_enabled)
+          self->copied_sends++;
+      }
+      sent += ret;
+      continue;
+    }
+
+    /* The kernel limits the number of outstanding notifications */
+    if (errno == ENOBUFS && (flags & MSG_ZEROCOPY)
+        && !g_queue_is_empty (&self->zc_pending)) {
+      if (!gst_rtp_send_sink_wait_socket_unlocked (self, G_IO_ERR, 100000))
+        return FALSE;
+      gst_rtp_send_sink_zerocopy_reap_unlocked (self);
+      continue;
+    }
+
+    switch (errno) {
+      case EINTR:
+        break;
+      case EAGAIN:
+#if EAGAIN != EWOULDBLOCK
+      case EWOULDBLOCK:
+#endif
+        if (!gst_rtp_send_sink_wait_socket_unlocked (self, G_IO_OUT, -1))
+          return FALSE;
+        break;
+      case EIO:
+      case EINVAL:
+        if (hdr->msg_iovlen > 1) {
+          /* The route or device does not support segmentation offload,
+           * resend the remainder as separate packets. */
+          GST_WARNING_OBJECT (self, "UDP GSO send failed (%s), disabling GSO.",
+              g_strerror (errno));
+          self->gso_enabled = FALSE;
+          n_msgs = gst_rtp_send_sink_build_msgs (self, dest,
+              hdr->msg_iov - self->iovs);
+          sent = 0;
+          break;
+        }
+        /* fall through */
+      default:
+        /* Like udpsink, a failing send is not fatal for the stream, skip
+         * the message that could not be sent. */
+        GST_ELEMENT_WARNING (self, RESOURCE, WRITE, (NULL),
+            ("Error sending UDP packets: %s", g_strerror (errno)));
+        sent++;
+        break;
+    }
+  }
+
+  return TRUE;
+}
+
+static void
+gst_rtp_send_sink_cancel_timeout_unlocked (GstRtpSendSink * self)
+{
+  if (self->timeout_id) {
+    gst_clock_id_unschedule (self->timeout_id);
+    gst_clock_id_unref (self->timeout_id);
+    self->timeout_id = NULL;
+  }
+}
+
+static void
+gst_rtp_send_sink_flush_unlocked (GstRtpSendSink * self)
+{
+  guint i;
+
+  gst_rtp_send_sink_wait_idle_unlocked (self);
+  gst_rtp_send_sink_cancel_timeout_unlocked (self);
+
+  if (self->n_pending == 0)
+    return;
+
+  GST_LOG_OBJECT (self, "Sending batch of %u packets to %u destinations.",
+      self->n_pending, self->dests->len);
+
+  self->sending = TRUE;
+  for (i = 0; i < self->dests->len; i++) {
+    if (!gst_rtp_send_sink_send_unlocked (self,
+            g_ptr_array_index (self->dests, i))) {
+      GST_DEBUG_OBJECT (self, "Unlocked, dropping the rest of the batch.");
+      break;
+    }
+  }
+  self->sending = FALSE;
+  g_cond_broadcast (&self->idle_cond);
+
+  /* Buffers that were sent with MSG_ZEROCOPY keep an extra reference */
+  for (i = 0; i < self->n_pending; i++) {
+    gst_buffer_unmap (self->pending[i], &self->maps[i]);
+    gst_buffer_unref (self->pending[i]);
+    self->pending[i] = NULL;
+  }
+  self->n_pending = 0;
+
+  if (!g_queue_is_empty (&self->zc_pending))
+    gst_rtp_send_sink_zerocopy_reap_unlocked (self);
+}
+
+static void
+gst_rtp_send_sink_drop_unlocked (GstRtpSendSink * self)
+{
+  guint i;
+
+  gst_rtp_send_sink_wait_idle_unlocked (self);
+  gst_rtp_send_sink_cancel_timeout_unlocked (self);
+
+  for (i = 0; i < self->n_pending; i++) {
+    gst_buffer_unmap (self->pending[i], &self->maps[i]);
+    gst_buffer_unref (self->pending[i]);
+    self->pending[i] = NULL;
+  }
+  self->n_pending = 0;
+}
+
+static gboolean
+gst_rtp_send_sink_timeout_cb (GstClock * clock, GstClockTime time,
+    GstClockID id, gpointer user_data)
+{
+  GstRtpSendSink *self = GST_RTP_SEND_SINK (user_data);
+
+  g_mutex_lock (&self->lock);
+  /* Only flush if this timeout was not cancelled in the mean time */
+  if (self->timeout_id == id) {
+    GST_LOG_OBJECT (self, "Batch timeout expired.");
+    gst_rtp_send_sink_flush_unlocked (self);
+  }
+  g_mutex_unlock (&self->lock);
+
+  return TRUE;
+}
+
+static void
+gst_rtp_send_sink_add_unlocked (GstRtpSendSink * self, GstBuffer * buffer,
+    gboolean schedule)
+{
+  guint i;
+
+  gst_rtp_send_sink_wait_idle_unlocked (self);
+  i = self->n_pending;
+
+  if (!gst_buffer_map (buffer, &self->maps[i], GST_MAP_READ)) {
+    GST_WARNING_OBJECT (self, "Could not map buffer, dropping it.");
+    return;
+  }
+
+  self->pending[i] = gst_buffer_ref (buffer);
+  self->iovs[i].iov_base = self->maps[i].data;
+  self->iovs[i].iov_len = self->maps[i].size;
+  self->n_pending++;
+
+  if (self->n_pending == self->max_pending) {
+    gst_rtp_send_sink_flush_unlocked (self);
+  } else if (schedule && self->n_pending == 1 && self->batch_timeout > 0) {
+    GstClockTime at;
+
+    at = gst_clock_get_time (self->clock) + self->batch_timeout * GST_USECOND;
+    self->timeout_id = gst_clock_new_single_shot_id (self->clock, at);
+    gst_clock_id_wait_async (self->timeout_id, gst_rtp_send_sink_timeout_cb,
+        gst_object_ref (self), (GDestroyNotify) gst_object_unref);
+  }
+}
+
+static GstFlowReturn
+gst_rtp_send_sink_render (GstBaseSink * bsink, GstBuffer * buffer)
+{
+  GstRtpSendSink *self = GST_RTP_SEND_SINK (bsink);
+
+  g_mutex_lock (&self->lock);
+  gst_rtp_send_sink_add_unlocked (self, buffer, TRUE);
+  if (self->batch_timeout == 0)
+    gst_rtp_send_sink_flush_unlocked (self);
+  g_mutex_unlock (&self->lock);
+
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+gst_rtp_send_sink_render_list (GstBaseSink * bsink, GstBufferList * list)
+{
+  GstRtpSendSink *self = GST_RTP_SEND_SINK (bsink);
+  guint i, len;
+
+  len = gst_buffer_list_length (list);
+
+  g_mutex_lock (&self->lock);
+  for (i = 0; i < len; i++)
+    gst_rtp_send_sink_add_unlocked (self, gst_buffer_list_get (list, i),
+        FALSE);
+  /* A list is a natural batch, no need to wait for more packets */
+  gst_rtp_send_sink_flush_unlocked (self);
+  g_mutex_unlock (&self->lock);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+gst_rtp_send_sink_event (GstBaseSink * bsink, GstEvent * event)
+{
+  GstRtpSendSink *self = GST_RTP_SEND_SINK (bsink);
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_EOS:
+      g_mutex_lock (&self->lock);
+      gst_rtp_send_sink_flush_unlocked (self);
+      g_mutex_unlock (&self->lock);
+      break;
+    case GST_EVENT_FLUSH_STOP:
+      g_mutex_lock (&self->lock);
+      gst_rtp_send_sink_drop_unlocked (self);
+      g_mutex_unlock (&self->lock);
+      break;
+    default:
+      break;
+  }
+
+  return GST_BASE_SINK_CLASS (parent_class)->event (bsink, event);
+}
+
+static gboolean
+gst_rtp_send_sink_unlock (GstBaseSink * bsink)
+{
+  GstRtpSendSink *self = GST_RTP_SEND_SINK (bsink);
+
+  g_cancellable_cancel (self->cancellable);
+
+  return TRUE;
+}
+
+static gboolean
+gst_rtp_send_sink_unlock_stop (GstBaseSink * bsink)
+{
+  GstRtpSendSink *self = GST_RTP_SEND_SINK (bsink);
+
+  g_cancellable_reset (self->cancellable);
+
+  return TRUE;
+}
+
+static gboolean
+gst_rtp_send_sink_start (GstBaseSink * bsink)
+{
+  GstRtpSendSink *self = GST_RTP_SEND_SINK (bsink);
+  GInetAddress *iaddr, *any;
+  GSocketAddress *bind_addr;
+  GstRtpSocketOptions opts;
+  GSocket *socket;
+  GError *error = NULL;
+  gchar *host;
+  gint port;
+
+  GST_OBJECT_LOCK (self);
+  host = g_strdup (self->host);
+  port = self->port;
+  GST_OBJECT_UNLOCK (self);
+
+  iaddr = gst_rtp_utils_resolve_host (host, &error);
+  if (iaddr == NULL)
+    goto resolve_failed;
+
+  g_mutex_lock (&self->lock);
+  gst_rtp_send_sink_set_primary_unlocked (self, host, port, iaddr);
+  g_mutex_unlock (&self->lock);
+  g_free (host);
+
+  socket = g_socket_new (g_inet_address_get_family (iaddr),
+      G_SOCKET_TYPE_DATAGRAM, G_SOCKET_PROTOCOL_UDP, &error);
+  if (socket == NULL)
+    goto no_socket;
+
+  GST_OBJECT_LOCK (self);
+  opts = self->socket_options;
+  GST_OBJECT_UNLOCK (self);
+  gst_rtp_socket_options_apply (GST_OBJECT (self), socket, &opts, TRUE);
+
+  any = g_inet_address_new_any (g_inet_address_get_family (iaddr));
+  bind_addr = g_inet_socket_address_new (any, 0);
+  g_object_unref (any);
+  if (!g_socket_bind (socket, bind_addr, TRUE, &error)) {
+    g_object_unref (bind_addr);
+    goto bind_failed;
+  }
+  g_object_unref (bind_addr);
+
+  if (g_inet_address_get_is_multicast (iaddr))
+    g_socket_set_multicast_ttl (socket, self->ttl_mc);
+  else
+    g_socket_set_ttl (socket, self->ttl);
+  g_object_unref (iaddr);
+
+  GST_OBJECT_LOCK (self);
+  self->socket = socket;
+  GST_OBJECT_UNLOCK (self);
+
+  self->gso_enabled = self->gso && gst_rtp_send_sink_probe_gso (self);
+  self->zerocopy_enabled = self->zerocopy
+      && gst_rtp_send_sink_enable_zerocopy (self);
+  self->zc_next_id = 0;
+  self->zc_sends = 0;
+  self->zc_completed = 0;
+  self->zc_copied = 0;
+  self->copied_sends = 0;
+
+  self->max_pending = CLAMP (self->batch_size, 1, MAX_BATCH_SIZE);
+  self->n_pending = 0;
+  self->pending = g_new0 (GstBuffer *, self->max_pending);
+  self->maps = g_new0 (GstMapInfo, self->max_pending);
+  self->iovs = g_new0 (struct iovec, self->max_pending);
+  self->msgs = g_new0 (struct mmsghdr, self->max_pending);
+  self->cmsgs = g_new0 (GstRtpSendSinkCmsg, self->max_pending);
+
+  GST_DEBUG_OBJECT (self, "Sending to port %d in batches of %u packets, "
+      "GSO %s, zero-copy %s.", port, self->max_pending,
+      self->gso_enabled ? "enabled" : "disabled",
+      self->zerocopy_enabled ? "enabled" : "disabled");
+
+  return TRUE;
+
+resolve_failed:
+  GST_ELEMENT_ERROR (self, RESOURCE, NOT_FOUND,
+      ("Could not resolve hostname '%s'", host),
+      ("DNS resolver reported: %s", error->message));
+  g_free (host);
+  g_error_free (error);
+  return FALSE;
+
+no_socket:
+  GST_ELEMENT_ERROR (self, RESOURCE, OPEN_WRITE, (NULL),
+      ("Could not create socket: %s", error->message));
+  g_error_free (error);
+  g_object_unref (iaddr);
+  goto remove_primary;
+
+bind_failed:
+  GST_ELEMENT_ERROR (self, RESOURCE, SETTINGS, (NULL),
+      ("Could not bind socket: %s", error->message));
+  g_error_free (error);
+  g_object_unref (socket);
+  g_object_unref (iaddr);
+
+remove_primary:
+  g_mutex_lock (&self->lock);
+  gst_rtp_send_sink_remove_primary_unlocked (self);
+  g_mutex_unlock (&self->lock);
+  return FALSE;
+}
+
+static gboolean
+gst_rtp_send_sink_stop (GstBaseSink * bsink)
+{
+  GstRtpSendSink *self = GST_RTP_SEND_SINK (bsink);
+  GSocket *socket;
+
+  /* Lookups of the host that are still running are ignored */
+  GST_OBJECT_LOCK (self);
+  self->primary_seq++;
+  GST_OBJECT_UNLOCK (self);
+
+  g_mutex_lock (&self->lock);
+  gst_rtp_send_sink_drop_unlocked (self);
+  gst_rtp_send_sink_zerocopy_drain_unlocked (self);
+  self->zerocopy_enabled = FALSE;
+  gst_rtp_send_sink_remove_primary_unlocked (self);
+  self->max_pending = 0;
+  g_clear_pointer (&self->pending, g_free);
+  g_clear_pointer (&self->maps, g_free);
+  g_clear_pointer (&self->iovs, g_free);
+  g_clear_pointer (&self->msgs, g_free);
+  g_clear_pointer (&self->cmsgs, g_free);
+  g_mutex_unlock (&self->lock);
+
+  GST_OBJECT_LOCK (self);
+  socket = self->socket;
+  self->socket = NULL;
+  GST_OBJECT_UNLOCK (self);
+
+  if (socket) {
+    g_socket_close (socket, NULL);
+    g_object_unref (socket);
+  }
+
+  return TRUE;
+}
+
+static void
+gst_rtp_send_sink_class_init (GstRtpSendSinkClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *gstelement_class = GST_ELEMENT_CLASS (klass);
+  GstBaseSinkClass *gstbasesink_class = GST_BASE_SINK_CLASS (klass);
+
+  gobject_class->set_property = gst_rtp_send_sink_set_property;
+  gobject_class->get_property = gst_rtp_send_sink_get_property;
+  gobject_class->finalize = gst_rtp_send_sink_finalize;
+
+  gstbasesink_class->start = GST_DEBUG_FUNCPTR (gst_rtp_send_sink_start);
+  gstbasesink_class->stop = GST_DEBUG_FUNCPTR (gst_rtp_send_sink_stop);
+  gstbasesink_class->unlock = GST_DEBUG_FUNCPTR (gst_rtp_send_sink_unlock);
+  gstbasesink_class->unlock_stop =
+      GST_DEBUG_FUNCPTR (gst_rtp_send_sink_unlock_stop);
+  gstbasesink_class->render = GST_DEBUG_FUNCPTR (gst_rtp_send_sink_render);
+  gstbasesink_class->render_list =
+      GST_DEBUG_FUNCPTR (gst_rtp_send_sink_render_list);
+  gstbasesink_class->event = GST_DEBUG_FUNCPTR (gst_rtp_send_sink_event);
+
+  /**
+   * GstRtpSendSink:host:
+   *
+   * The host or IP address to send the packets to. A change while the
+   * element is started replaces the destination as soon as the host is
+   * resolved, the lookup does not block.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_HOST,
+      g_param_spec_string ("host", "Host",
+          "The host or IP address to send the packets to", DEFAULT_PROP_HOST,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSendSink:port:
+   *
+   * The port to send the packets to. A change while the element is
+   * started replaces the destination like a change of
+   * #GstRtpSendSink:host.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_PORT,
+      g_param_spec_int ("port", "Port", "The port to send the packets to",
+          0, G_MAXUINT16, DEFAULT_PROP_PORT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSendSink:ttl:
+   *
+   * Set the unicast TTL parameter.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_TTL,
+      g_param_spec_int ("ttl", "Unicast TTL",
+          "Used for setting the unicast TTL parameter",
+          0, 255, DEFAULT_PROP_TTL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSendSink:ttl-mc:
+   *
+   * Set the multicast TTL parameter.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_TTL_MC,
+      g_param_spec_int ("ttl-mc", "Multicast TTL",
+          "Used for setting the multicast TTL parameter", 0, 255,
+          DEFAULT_PROP_TTL_MC, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSendSink:batch-size:
+   *
+   * The maximum number of packets that are sent with one system call.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_BATCH_SIZE,
+      g_param_spec_uint ("batch-size", "Batch size",
+          "Maximum number of packets sent with one system call",
+          1, MAX_BATCH_SIZE, DEFAULT_PROP_BATCH_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSendSink:batch-timeout:
+   *
+   * The maximum time in microseconds a packet waits for the batch to
+   * fill up before the batch is sent anyway, 0 sends every buffer that is
+   * not part of a buffer list immediately.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_BATCH_TIMEOUT,
+      g_param_spec_uint ("batch-timeout", "Batch timeout",
+          "Maximum time in microseconds a packet waits in an incomplete batch",
+          0, G_MAXUINT, DEFAULT_PROP_BATCH_TIMEOUT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSendSink:gso:
+   *
+   * Send runs of equal-sized packets as one UDP GSO datagram when the
+   * kernel supports it.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_GSO,
+      g_param_spec_boolean ("gso", "GSO",
+          "Use UDP generic segmentation offload when available",
+          DEFAULT_PROP_GSO, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSendSink:used-socket:
+   *
+   * The socket that is used to send packets, only valid between
+   * the PAUSED and READY states.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_USED_SOCKET,
+      g_param_spec_object ("used-socket", "Socket Handle",
+          "Socket currently in use for sending packets", G_TYPE_SOCKET,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSendSink:zerocopy:
+   *
+   * Send messages of at least #GstRtpSendSink:zerocopy-threshold bytes
+   * with MSG_ZEROCOPY, so the kernel does not copy the packet data. The
+   * buffers are kept until the kernel completes the send. Only supported
+   * on Linux. The value is applied when going to PAUSED.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_ZEROCOPY,
+      g_param_spec_boolean ("zerocopy", "Zero-copy",
+          "Send large messages without copying them into the kernel",
+          DEFAULT_PROP_ZEROCOPY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSendSink:zerocopy-threshold:
+   *
+   * The smallest message in bytes that is sent with MSG_ZEROCOPY, smaller
+   * ones are copied. With UDP GSO, a message holds a whole run of
+   * equal-sized packets.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_ZEROCOPY_THRESHOLD,
+      g_param_spec_uint ("zerocopy-threshold", "Zero-copy threshold",
+          "Smallest message in bytes that is sent without copying",
+          0, G_MAXUINT, DEFAULT_PROP_ZEROCOPY_THRESHOLD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSendSink:zerocopy-stats:
+   *
+   * Zero-copy statistics. This property returns a #GstStructure with name
+   * application/x-rtp-zerocopy-stats with the following fields:
+   *
+   * - "enabled" G_TYPE_BOOLEAN: whether zero-copy sending is in use
+   * - "zerocopy-sends" G_TYPE_UINT64: messages sent with MSG_ZEROCOPY
+   * - "copied-sends" G_TYPE_UINT64: messages below the threshold that
+   *   were copied
+   * - "completed" G_TYPE_UINT64: zero-copy sends the kernel completed
+   * - "kernel-copied" G_TYPE_UINT64: zero-copy sends the kernel copied
+   *   anyway, for instance on the loopback device
+   * - "in-flight" G_TYPE_UINT: zero-copy sends that still hold buffers
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_ZEROCOPY_STATS,
+      g_param_spec_boxed ("zerocopy-stats", "Zero-copy statistics",
+          "Zero-copy send statistics", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSendSink:socket-options:
+   *
+   * Send buffer size, busy polling, priority, DSCP and incoming CPU of
+   * the socket, as an application/x-rtp-socket-options structure with
+   * the fields "buffer-size", "busy-poll", "priority", "dscp" and
+   * "incoming-cpu". A value of -1 leaves the system default. The options
+   * are set when the socket is created, the values in effect are logged.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_SOCKET_OPTIONS,
+      g_param_spec_boxed ("socket-options", "Socket options",
+          "Options set on the socket", GST_TYPE_STRUCTURE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSendSink::add:
+   * @object: the #GstRtpSendSink
+   * @host: the host or IP address of the new destination
+   * @port: the port of the new destination
+   *
+   * Also send the packets to @host and @port, takes effect with the next
+   * batch.
+   *
+   * Since: 1.16.1.2
+   */
+  gst_rtp_send_sink_signals[SIGNAL_ADD] =
+      g_signal_new_class_handler ("add", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_CALLBACK (gst_rtp_send_sink_add), NULL, NULL, NULL,
+      G_TYPE_NONE, 2, G_TYPE_STRING, G_TYPE_INT);
+
+  /**
+   * GstRtpSendSink::remove:
+   * @object: the #GstRtpSendSink
+   * @host: the host or IP address of the destination
+   * @port: the port of the destination
+   *
+   * Stop sending packets to @host and @port.
+   *
+   * Since: 1.16.1.2
+   */
+  gst_rtp_send_sink_signals[SIGNAL_REMOVE] =
+      g_signal_new_class_handler ("remove", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_CALLBACK (gst_rtp_send_sink_remove), NULL, NULL, NULL,
+      G_TYPE_NONE, 2, G_TYPE_STRING, G_TYPE_INT);
+
+  /**
+   * GstRtpSendSink::clear:
+   * @object: the #GstRtpSendSink
+   *
+   * Remove all destinations.
+   *
+   * Since: 1.16.1.2
+   */
+  gst_rtp_send_sink_signals[SIGNAL_CLEAR] =
+      g_signal_new_class_handler ("clear", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_CALLBACK (gst_rtp_send_sink_clear), NULL, NULL, NULL,
+      G_TYPE_NONE, 0);
+
+  /**
+   * GstRtpSendSink::get-stats:
+   * @object: the #GstRtpSendSink
+   * @host: the host or IP address of the destination
+   * @port: the port of the destination
+   *
+   * Get the number of packets and bytes sent to a destination, in the
+   * "packets-sent" and "bytes-sent" #guint64 fields.
+   *
+   * Returns: (transfer full): a new #GstStructure
+   *
+   * Since: 1.16.1.2
+   */
+  gst_rtp_send_sink_signals[SIGNAL_GET_STATS] =
+      g_signal_new_class_handler ("get-stats", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_CALLBACK (gst_rtp_send_sink_get_stats), NULL, NULL, NULL,
+      GST_TYPE_STRUCTURE, 2, G_TYPE_STRING, G_TYPE_INT);
+
+  gst_element_class_add_pad_template (gstelement_class,
+      gst_static_pad_template_get (&sink_template));
+
+  gst_element_class_set_static_metadata (gstelement_class,
+      "RTP batched send sink",
+      "Sink/Network",
+      "Send RTP packets to the network in batches",
+      "Marc Leeman <marc.leeman@gmail.com>");
+}
+
+static void
+gst_rtp_send_sink_init (GstRtpSendSink * self)
+{
+  self->host = g_strdup (DEFAULT_PROP_HOST);
+  self->port = DEFAULT_PROP_PORT;
+  self->ttl = DEFAULT_PROP_TTL;
+  self->ttl_mc = DEFAULT_PROP_TTL_MC;
+  self->batch_size = DEFAULT_PROP_BATCH_SIZE;
+  self->batch_timeout = DEFAULT_PROP_BATCH_TIMEOUT;
+  self->gso = DEFAULT_PROP_GSO;
+  self->zerocopy = DEFAULT_PROP_ZEROCOPY;
+  self->zerocopy_threshold = DEFAULT_PROP_ZEROCOPY_THRESHOLD;
+  gst_rtp_socket_options_init (&self->socket_options);
+  g_queue_init (&self->zc_pending);
+  self->dests =
+      g_ptr_array_new_with_free_func ((GDestroyNotify)
+      gst_rtp_send_sink_dest_free);
+
+  /* The batch timeout does not depend on the pipeline clock */
+  self->clock = gst_system_clock_obtain ();
+
+  self->cancellable = g_cancellable_new ();
+
+  g_mutex_init (&self->lock);
+  g_cond_init (&self->idle_cond);
+}
+
+/* ex: set tabstop=2 shiftwidth=2 expandtab: */
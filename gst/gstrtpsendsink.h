@@ -0,0 +1,13 @@
+#ifndef _GST_RTP_SEND_SINK_H_
+#define _GST_RTP_SEND_SINK_H_
+
+#include <gst/gst.h>
+#include <gst/base/gstbasesink.h>
+
+G_BEGIN_DECLS
+#define GST_TYPE_RTP_SEND_SINK (gst_rtp_send_sink_get_type ())
+G_DECLARE_FINAL_TYPE (GstRtpSendSink, gst_rtp_send_sink, GST, RTP_SEND_SINK,
+    GstBaseSink);
+G_END_DECLS
+
+#endif
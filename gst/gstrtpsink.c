@@ -39,26 +39,92 @@
  * This element also implements the URI scheme `rtp://` allowing to send
  * data on the network by bins that allow use the URI to determine the sink.
  * The RTP URI handler also allows setting properties through the URI query.
+ *
+ * Besides the address of the URI, the same RTP and RTCP packets can be
+ * sent to more receivers with #GstRtpSink:destinations or the
+ * #GstRtpSink::add and #GstRtpSink::remove action signals, while playing
+ * as well. The payloading and the RTP session are shared by all
+ * receivers.
+ *
+ * A hostname in the URI is resolved without blocking the state change to
+ * READY; going to PAUSED completes asynchronously once the lookup
+ * finished, and the address is cached for #GstRtpSink:dns-cache-ttl
+ * seconds for all elements in the process.
+ *
+ * The streaming threads of the internal elements can be pinned to
+ * dedicated cores with #GstRtpSink:cpu-affinity and scheduled as
+ * real-time threads with #GstRtpSink:realtime-priority.
+ *
+ * With #GstRtpSink:fec, the stream is protected with SMPTE 2022-1 column
+ * and row FEC sent next to the RTP and RTCP ports, which #GstRtpSrc:fec
+ * receives to recover lost packets without retransmissions.
+ *
+ * With #GstRtpSink:rtx, the sent packets are kept for a while to answer
+ * the NACKs of #GstRtpSrc:rtx receivers with RFC 4588 retransmissions.
  */
 #ifdef HAVE_CONFIG_H
 #include <config.h>
 #endif
 
+#include <string.h>
+
 #include <gio/gio.h>
+#include <gst/rtp/gstrtpdefs.h>
 
 #include "gstrtpsink.h"
 #include "gstrtp-utils.h"
+#include "gstrtp-stats.h"
+#include "gstrtp-resolver.h"
+#include "gstrtp-sockopt.h"
+#include "gstrtp-thread.h"
 
 GST_DEBUG_CATEGORY_STATIC (gst_rtp_sink_debug);
 #define GST_CAT_DEFAULT gst_rtp_sink_debug
 
 #define DEFAULT_PROP_TTL              64
 #define DEFAULT_PROP_TTL_MC           1
+#define DEFAULT_PROP_BATCH_SIZE       1
+#define DEFAULT_PROP_BATCH_TIMEOUT    1000
+#define DEFAULT_PROP_DESTINATIONS     NULL
+#define DEFAULT_PROP_PACING           FALSE
+#define DEFAULT_PROP_PACING_BITRATE   0
+#define DEFAULT_PROP_ZEROCOPY         FALSE
+#define DEFAULT_PROP_ZEROCOPY_THRESHOLD 10240
+#define DEFAULT_PROP_DNS_CACHE_TTL    60
+#define DEFAULT_PROP_BUFFER_SIZE      0
+#define DEFAULT_PROP_BUSY_POLL        0
+#define DEFAULT_PROP_PRIORITY         -1
+#define DEFAULT_PROP_DSCP             -1
+#define DEFAULT_PROP_INCOMING_CPU     -1
+#define DEFAULT_PROP_CPU_AFFINITY     NULL
+#define DEFAULT_PROP_REALTIME_PRIORITY 0
+#define DEFAULT_PROP_FEC              FALSE
+#define DEFAULT_PROP_FEC_COLUMNS      10
+#define DEFAULT_PROP_FEC_ROWS         10
+#define DEFAULT_PROP_RTX              FALSE
+#define DEFAULT_PROP_RTX_PT_MAP       "96:97"
+#define DEFAULT_PROP_RTX_CACHE_TIME   500
+#define DEFAULT_PROP_RTX_CACHE_SIZE   (4 * 1024 * 1024)
 
 #define DEFAULT_PROP_ADDRESS          "0.0.0.0"
 #define DEFAULT_PROP_PORT             5004
 #define DEFAULT_PROP_URI              "rtp://"DEFAULT_PROP_ADDRESS":"G_STRINGIFY(DEFAULT_PROP_PORT)
 
+/* SMPTE 2022-1 sends the column FEC two and the row FEC four ports above
+ * the RTP port */
+#define FEC_COLUMN_PORT_OFFSET        2
+#define FEC_ROW_PORT_OFFSET           4
+
+static const guint fec_port_offsets[] = { FEC_COLUMN_PORT_OFFSET,
+  FEC_ROW_PORT_OFFSET
+};
+
+typedef struct
+{
+  gchar *host;
+  guint port;
+} GstRtpSinkDest;
+
 struct _GstRtpSink
 {
   GstBin parent_instance;
@@ -67,14 +133,60 @@ struct _GstRtpSink
   GstUri *uri;
   gint ttl;
   gint ttl_mc;
+  guint batch_size;
+  guint batch_timeout;
+  /* GstRtpSinkDest, protected by the object lock */
+  GPtrArray *destinations;
+  gboolean pacing;
+  guint64 pacing_bitrate;
+  gboolean zerocopy;
+  guint zerocopy_threshold;
+  guint dns_cache_ttl;
+  GstRtpSocketOptions socket_options;
+  gchar *cpu_affinity;
+  gboolean fec;
+  guint fec_columns;
+  guint fec_rows;
+  gboolean rtx;
+  gchar *rtx_pt_map;
+  guint rtx_cache_time;
+  guint rtx_cache_size;
+  /* Protected by the object lock */
+  gint realtime_priority;
+
+  /* CPUs of cpu-affinity, parsed when going to READY and protected by the
+   * object lock */
+  GArray *cpus;
+
+  /* Lookup of the URI host, protected by the object lock. A lookup only
+   * applies its result when resolve_seq did not change since it started */
+  guint resolve_seq;
+  gboolean resolving;
+  /* Protected by the state lock */
+  gboolean async_pending;
+  /* Holds the RTP packets back until the RTP sink knows the host */
+  GstPad *block_pad;
+  gulong block_id;
 
   /* Internal elements */
   GstElement *rtpbin;
   GstElement *funnel_rtp;
   GstElement *funnel_rtcp;
+  GstElement *pacer;
   GstElement *rtp_sink;
   GstElement *rtcp_src;
   GstElement *rtcp_sink;
+  /* With FEC only, the encoder in front of rtp_sink and the udpsink of the
+   * column and the row FEC stream */
+  GstElement *fec_enc;
+  GstElement *fec_sink[2];
+  /* With RTX only, the rtx-pt-map parsed when building the graph */
+  GstStructure *rtx_pt_map_structure;
+
+  GstRtpStats *stats;
+
+  /* Requested sink pads, protected by the lock */
+  guint n_sessions;
 
   GMutex lock;
 };
@@ -88,10 +200,45 @@ enum
   PROP_PORT,
   PROP_TTL,
   PROP_TTL_MC,
+  PROP_BATCH_SIZE,
+  PROP_BATCH_TIMEOUT,
+  PROP_DESTINATIONS,
+  PROP_PACING,
+  PROP_PACING_BITRATE,
+  PROP_PACING_STATS,
+  PROP_STATS,
+  PROP_ZEROCOPY,
+  PROP_ZEROCOPY_THRESHOLD,
+  PROP_DNS_CACHE_TTL,
+  PROP_BUFFER_SIZE,
+  PROP_BUSY_POLL,
+  PROP_PRIORITY,
+  PROP_DSCP,
+  PROP_INCOMING_CPU,
+  PROP_CPU_AFFINITY,
+  PROP_REALTIME_PRIORITY,
+  PROP_FEC,
+  PROP_FEC_COLUMNS,
+  PROP_FEC_ROWS,
+  PROP_RTX,
+  PROP_RTX_PT_MAP,
+  PROP_RTX_CACHE_TIME,
+  PROP_RTX_CACHE_SIZE,
 
   PROP_LAST
 };
 
+enum
+{
+  SIGNAL_ADD,
+  SIGNAL_REMOVE,
+  SIGNAL_GET_STATS,
+
+  LAST_SIGNAL
+};
+
+static guint gst_rtp_sink_signals[LAST_SIGNAL] = { 0 };
+
 static void gst_rtp_sink_uri_handler_init (gpointer g_iface,
     gpointer iface_data);
 
@@ -111,7 +258,210 @@ static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink_%u",
 
 static GstStateChangeReturn
 gst_rtp_sink_change_state (GstElement * element, GstStateChange transition);
+static void gst_rtp_sink_handle_message (GstBin * bin, GstMessage * message);
+static gboolean gst_rtp_sink_setup_graph (GstRtpSink * self);
+static void gst_rtp_sink_resolve (GstRtpSink * self);
+
+static void
+gst_rtp_sink_dest_free (GstRtpSinkDest * dest)
+{
+  g_free (dest->host);
+  g_slice_free (GstRtpSinkDest, dest);
+}
+
+static gint
+gst_rtp_sink_find_dest (GPtrArray * destinations, const gchar * host,
+    guint port)
+{
+  guint i;
+
+  for (i = 0; i < destinations->len; i++) {
+    GstRtpSinkDest *dest = g_ptr_array_index (destinations, i);
+
+    if (dest->port == port && g_strcmp0 (dest->host, host) == 0)
+      return i;
+  }
+
+  return -1;
+}
+
+/* Emit @signal on the RTP sink with @port and on the RTCP and FEC sinks
+ * with the matching ports, all sinks take the same add/remove signals. */
+static void
+gst_rtp_sink_forward_dest (GstRtpSink * self, const gchar * signal,
+    const gchar * host, guint port)
+{
+  guint i;
+
+  if (self->rtp_sink)
+    g_signal_emit_by_name (self->rtp_sink, signal, host, (gint) port, NULL);
+  if (self->rtcp_sink)
+    g_signal_emit_by_name (self->rtcp_sink, signal, host, (gint) port + 1,
+        NULL);
+  for (i = 0; i < G_N_ELEMENTS (self->fec_sink); i++) {
+    if (self->fec_sink[i])
+      g_signal_emit_by_name (self->fec_sink[i], signal, host,
+          (gint) (port + fec_port_offsets[i]), NULL);
+  }
+}
+
+static void
+gst_rtp_sink_add (GstRtpSink * self, const gchar * host, gint port)
+{
+  GstRtpSinkDest *dest = NULL;
+
+  if (host == NULL || port <= 0 || port > G_MAXUINT16) {
+    GST_WARNING_OBJECT (self, "Invalid destination %s:%d", GST_STR_NULL (host),
+        port);
+    return;
+  }
+
+  GST_OBJECT_LOCK (self);
+  if (gst_rtp_sink_find_dest (self->destinations, host, port) < 0) {
+    dest = g_slice_new (GstRtpSinkDest);
+    dest->host = g_strdup (host);
+    dest->port = port;
+    g_ptr_array_add (self->destinations, dest);
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  if (dest) {
+    GST_DEBUG_OBJECT (self, "Adding destination %s:%d", host, port);
+    gst_rtp_sink_forward_dest (self, "add", host, port);
+  }
+}
+
+static void
+gst_rtp_sink_remove (GstRtpSink * self, const gchar * host, gint port)
+{
+  gint index;
+
+  GST_OBJECT_LOCK (self);
+  index = gst_rtp_sink_find_dest (self->destinations, host, port);
+  if (index >= 0)
+    g_ptr_array_remove_index (self->destinations, index);
+  GST_OBJECT_UNLOCK (self);
+
+  if (index >= 0) {
+    GST_DEBUG_OBJECT (self, "Removing destination %s:%d", host, port);
+    gst_rtp_sink_forward_dest (self, "remove", host, port);
+  }
+}
+
+static GstStructure *
+gst_rtp_sink_get_stats (GstRtpSink * self, const gchar * host, gint port)
+{
+  GstStructure *stats = NULL;
+
+  if (self->rtp_sink)
+    g_signal_emit_by_name (self->rtp_sink, "get-stats", host, port, &stats);
+
+  return stats;
+}
+
+/* Replace the destinations by the comma separated list in @str, the
+ * destinations that are in both lists are left alone. */
+static void
+gst_rtp_sink_set_destinations (GstRtpSink * self, const gchar * str)
+{
+  GPtrArray *removed, *added;
+  gchar **entries = NULL;
+  guint i;
+
+  if (str)
+    entries = g_strsplit (str, ",", -1);
+
+  added =
+      g_ptr_array_new_with_free_func ((GDestroyNotify)
+      gst_rtp_sink_dest_free);
+
+  GST_OBJECT_LOCK (self);
+  removed = self->destinations;
+  self->destinations =
+      g_ptr_array_new_with_free_func ((GDestroyNotify)
+      gst_rtp_sink_dest_free);
+
+  for (i = 0; entries && entries[i]; i++) {
+    GstRtpSinkDest *dest;
+    gchar *host;
+    guint port;
+    gint index;
+
+    g_strstrip (entries[i]);
+    if (entries[i][0] == '\0')
+      continue;
+
+    if (!gst_rtp_utils_parse_address (entries[i], &host, &port)) {
+      GST_WARNING_OBJECT (self, "Ignoring invalid destination '%s'",
+          entries[i]);
+      continue;
+    }
+    if (host == NULL)
+      host = g_strdup (gst_uri_get_host (self->uri));
+
+    if (gst_rtp_sink_find_dest (self->destinations, host, port) >= 0) {
+      g_free (host);
+      continue;
+    }
 
+    dest = g_slice_new (GstRtpSinkDest);
+    dest->host = host;
+    dest->port = port;
+    g_ptr_array_add (self->destinations, dest);
+
+    index = gst_rtp_sink_find_dest (removed, host, port);
+    if (index >= 0) {
+      g_ptr_array_remove_index (removed, index);
+    } else {
+      dest = g_slice_new (GstRtpSinkDest);
+      dest->host = g_strdup (host);
+      dest->port = port;
+      g_ptr_array_add (added, dest);
+    }
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  g_strfreev (entries);
+
+  for (i = 0; i < removed->len; i++) {
+    GstRtpSinkDest *dest = g_ptr_array_index (removed, i);
+
+    gst_rtp_sink_forward_dest (self, "remove", dest->host, dest->port);
+  }
+  for (i = 0; i < added->len; i++) {
+    GstRtpSinkDest *dest = g_ptr_array_index (added, i);
+
+    gst_rtp_sink_forward_dest (self, "add", dest->host, dest->port);
+  }
+
+  g_ptr_array_unref (removed);
+  g_ptr_array_unref (added);
+}
+
+static gchar *
+gst_rtp_sink_get_destinations (GstRtpSink * self)
+{
+  GString *str = g_string_new (NULL);
+  guint i;
+
+  GST_OBJECT_LOCK (self);
+  for (i = 0; i < self->destinations->len; i++) {
+    GstRtpSinkDest *dest = g_ptr_array_index (self->destinations, i);
+
+    if (i > 0)
+      g_string_append_c (str, ',');
+    if (strchr (dest->host, ':'))
+      g_string_append_printf (str, "[%s]:%u", dest->host, dest->port);
+    else
+      g_string_append_printf (str, "%s:%u", dest->host, dest->port);
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  if (str->len == 0)
+    return g_string_free (str, TRUE);
+
+  return g_string_free (str, FALSE);
+}
 static void
 gst_rtp_sink_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
@@ -141,12 +491,14 @@ gst_rtp_sink_set_property (GObject * object, guint prop_id,
     }
     case PROP_ADDRESS:
       gst_uri_set_host (self->uri, g_value_get_string (value));
-      g_object_set_property (G_OBJECT (self->rtp_sink), "host", value);
-      g_object_set_property (G_OBJECT (self->rtcp_sink), "host", value);
+      /* The sinks get the address once it is resolved */
+      if (self->rtp_sink)
+        gst_rtp_sink_resolve (self);
       break;
 
     case PROP_PORT:{
       guint port = g_value_get_uint (value);
+      guint i;
 
       /* According to RFC 3550, 11, RTCP receiver port should be even
        * number and RTCP port should be the RTP port + 1 */
@@ -155,19 +507,109 @@ gst_rtp_sink_set_property (GObject * object, guint prop_id,
             "Port %u is odd, this is not standard (see RFC 3550).", port);
 
       gst_uri_set_port (self->uri, port);
-      g_object_set (self->rtp_sink, "port", port, NULL);
-      g_object_set (self->rtcp_sink, "port", port + 1, NULL);
+      if (self->rtp_sink)
+        g_object_set (self->rtp_sink, "port", port, NULL);
+      if (self->rtcp_sink)
+        g_object_set (self->rtcp_sink, "port", port + 1, NULL);
+      for (i = 0; i < G_N_ELEMENTS (self->fec_sink); i++) {
+        if (self->fec_sink[i])
+          g_object_set (self->fec_sink[i], "port",
+              (gint) (port + fec_port_offsets[i]), NULL);
+      }
       break;
     }
     case PROP_TTL:
       self->ttl = g_value_get_int (value);
-      g_object_set (self->rtp_sink, "ttl", self->ttl, NULL);
-      g_object_set (self->rtcp_sink, "ttl", self->ttl, NULL);
+      if (self->rtp_sink)
+        g_object_set (self->rtp_sink, "ttl", self->ttl, NULL);
+      if (self->rtcp_sink)
+        g_object_set (self->rtcp_sink, "ttl", self->ttl, NULL);
       break;
     case PROP_TTL_MC:
       self->ttl_mc = g_value_get_int (value);
-      g_object_set (self->rtp_sink, "ttl-mc", self->ttl_mc, NULL);
-      g_object_set (self->rtcp_sink, "ttl-mc", self->ttl_mc, NULL);
+      if (self->rtp_sink)
+        g_object_set (self->rtp_sink, "ttl-mc", self->ttl_mc, NULL);
+      if (self->rtcp_sink)
+        g_object_set (self->rtcp_sink, "ttl-mc", self->ttl_mc, NULL);
+      break;
+    case PROP_BATCH_SIZE:
+      self->batch_size = g_value_get_uint (value);
+      break;
+    case PROP_BATCH_TIMEOUT:
+      self->batch_timeout = g_value_get_uint (value);
+      break;
+    case PROP_DESTINATIONS:
+      gst_rtp_sink_set_destinations (self, g_value_get_string (value));
+      break;
+    case PROP_PACING:
+      self->pacing = g_value_get_boolean (value);
+      break;
+    case PROP_PACING_BITRATE:
+      self->pacing_bitrate = g_value_get_uint64 (value);
+      if (self->pacer)
+        g_object_set (self->pacer, "bitrate", self->pacing_bitrate, NULL);
+      break;
+    case PROP_ZEROCOPY:
+      self->zerocopy = g_value_get_boolean (value);
+      break;
+    case PROP_ZEROCOPY_THRESHOLD:
+      self->zerocopy_threshold = g_value_get_uint (value);
+      if (self->rtp_sink && self->zerocopy)
+        g_object_set (self->rtp_sink, "zerocopy-threshold",
+            self->zerocopy_threshold, NULL);
+      break;
+    case PROP_DNS_CACHE_TTL:
+      self->dns_cache_ttl = g_value_get_uint (value);
+      break;
+    case PROP_BUFFER_SIZE:
+      self->socket_options.buffer_size = g_value_get_int (value);
+      if (self->socket_options.buffer_size == 0)
+        self->socket_options.buffer_size = -1;
+      break;
+    case PROP_BUSY_POLL:
+      self->socket_options.busy_poll = g_value_get_int (value);
+      if (self->socket_options.busy_poll == 0)
+        self->socket_options.busy_poll = -1;
+      break;
+    case PROP_PRIORITY:
+      self->socket_options.priority = g_value_get_int (value);
+      break;
+    case PROP_DSCP:
+      self->socket_options.dscp = g_value_get_int (value);
+      break;
+    case PROP_INCOMING_CPU:
+      self->socket_options.incoming_cpu = g_value_get_int (value);
+      break;
+    case PROP_CPU_AFFINITY:
+      g_free (self->cpu_affinity);
+      self->cpu_affinity = g_value_dup_string (value);
+      break;
+    case PROP_REALTIME_PRIORITY:
+      GST_OBJECT_LOCK (self);
+      self->realtime_priority = g_value_get_int (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_FEC:
+      self->fec = g_value_get_boolean (value);
+      break;
+    case PROP_FEC_COLUMNS:
+      self->fec_columns = g_value_get_uint (value);
+      break;
+    case PROP_FEC_ROWS:
+      self->fec_rows = g_value_get_uint (value);
+      break;
+    case PROP_RTX:
+      self->rtx = g_value_get_boolean (value);
+      break;
+    case PROP_RTX_PT_MAP:
+      g_free (self->rtx_pt_map);
+      self->rtx_pt_map = g_value_dup_string (value);
+      break;
+    case PROP_RTX_CACHE_TIME:
+      self->rtx_cache_time = g_value_get_uint (value);
+      break;
+    case PROP_RTX_CACHE_SIZE:
+      self->rtx_cache_size = g_value_get_uint (value);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -202,6 +644,84 @@ gst_rtp_sink_get_property (GObject * object, guint prop_id,
     case PROP_TTL_MC:
       g_value_set_int (value, self->ttl_mc);
       break;
+    case PROP_BATCH_SIZE:
+      g_value_set_uint (value, self->batch_size);
+      break;
+    case PROP_BATCH_TIMEOUT:
+      g_value_set_uint (value, self->batch_timeout);
+      break;
+    case PROP_DESTINATIONS:
+      g_value_take_string (value, gst_rtp_sink_get_destinations (self));
+      break;
+    case PROP_PACING:
+      g_value_set_boolean (value, self->pacing);
+      break;
+    case PROP_PACING_BITRATE:
+      g_value_set_uint64 (value, self->pacing_bitrate);
+      break;
+    case PROP_PACING_STATS:
+      if (self->pacer)
+        g_object_get_property (G_OBJECT (self->pacer), "stats", value);
+      else
+        g_value_set_boxed (value, NULL);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_rtp_stats_get_structure (self->stats,
+              "application/x-rtp-sink-stats"));
+      break;
+    case PROP_ZEROCOPY:
+      g_value_set_boolean (value, self->zerocopy);
+      break;
+    case PROP_ZEROCOPY_THRESHOLD:
+      g_value_set_uint (value, self->zerocopy_threshold);
+      break;
+    case PROP_DNS_CACHE_TTL:
+      g_value_set_uint (value, self->dns_cache_ttl);
+      break;
+    case PROP_BUFFER_SIZE:
+      g_value_set_int (value, MAX (self->socket_options.buffer_size, 0));
+      break;
+    case PROP_BUSY_POLL:
+      g_value_set_int (value, MAX (self->socket_options.busy_poll, 0));
+      break;
+    case PROP_PRIORITY:
+      g_value_set_int (value, self->socket_options.priority);
+      break;
+    case PROP_DSCP:
+      g_value_set_int (value, self->socket_options.dscp);
+      break;
+    case PROP_INCOMING_CPU:
+      g_value_set_int (value, self->socket_options.incoming_cpu);
+      break;
+    case PROP_CPU_AFFINITY:
+      g_value_set_string (value, self->cpu_affinity);
+      break;
+    case PROP_REALTIME_PRIORITY:
+      GST_OBJECT_LOCK (self);
+      g_value_set_int (value, self->realtime_priority);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_FEC:
+      g_value_set_boolean (value, self->fec);
+      break;
+    case PROP_FEC_COLUMNS:
+      g_value_set_uint (value, self->fec_columns);
+      break;
+    case PROP_FEC_ROWS:
+      g_value_set_uint (value, self->fec_rows);
+      break;
+    case PROP_RTX:
+      g_value_set_boolean (value, self->rtx);
+      break;
+    case PROP_RTX_PT_MAP:
+      g_value_set_string (value, self->rtx_pt_map);
+      break;
+    case PROP_RTX_CACHE_TIME:
+      g_value_set_uint (value, self->rtx_cache_time);
+      break;
+    case PROP_RTX_CACHE_SIZE:
+      g_value_set_uint (value, self->rtx_cache_size);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -215,6 +735,12 @@ gst_rtp_sink_finalize (GObject * gobject)
 
   if (self->uri)
     gst_uri_unref (self->uri);
+  g_ptr_array_unref (self->destinations);
+  gst_rtp_stats_free (self->stats);
+  g_free (self->cpu_affinity);
+  g_free (self->rtx_pt_map);
+  if (self->rtx_pt_map_structure)
+    gst_structure_free (self->rtx_pt_map_structure);
 
   g_mutex_clear (&self->lock);
   G_OBJECT_CLASS (parent_class)->finalize (gobject);
@@ -245,13 +771,23 @@ gst_rtp_sink_request_new_pad (GstElement * element,
 {
   GstRtpSink *self = GST_RTP_SINK (element);
   GstPad *pad = NULL;
+  gboolean refused;
 
-  if (self->rtpbin == NULL) {
-    GST_ELEMENT_ERROR (self, CORE, MISSING_PLUGIN, (NULL),
-        ("%s", "rtpbin element is not available"));
+  /* The FEC matrix follows the sequence numbers of one SSRC */
+  GST_RTP_SINK_LOCK (self);
+  refused = self->fec && self->n_sessions > 0;
+  GST_RTP_SINK_UNLOCK (self);
+  if (refused) {
+    GST_ELEMENT_WARNING (self, RESOURCE, SETTINGS,
+        ("FEC protects a single session only."),
+        ("Refusing a second session with fec enabled"));
     return NULL;
   }
 
+  /* Requesting a pad before going to READY builds the graph as well */
+  if (gst_rtp_sink_setup_graph (self) == FALSE)
+    return NULL;
+
   if (gst_rtp_sink_setup_elements (self) == FALSE)
     return NULL;
 
@@ -259,6 +795,7 @@ gst_rtp_sink_request_new_pad (GstElement * element,
 
   pad = gst_element_get_request_pad (self->rtpbin, "send_rtp_sink_%u");
   g_return_val_if_fail (pad != NULL, NULL);
+  self->n_sessions++;
 
   GST_RTP_SINK_UNLOCK (self);
 
@@ -274,6 +811,8 @@ gst_rtp_sink_release_pad (GstElement * element, GstPad * pad)
   GST_RTP_SINK_LOCK (self);
   gst_element_release_request_pad (self->rtpbin, rpad);
   gst_object_unref (rpad);
+  if (self->n_sessions > 0)
+    self->n_sessions--;
 
   gst_pad_set_active (pad, FALSE);
   gst_element_remove_pad (GST_ELEMENT (self), pad);
@@ -286,11 +825,13 @@ gst_rtp_sink_class_init (GstRtpSinkClass * klass)
 {
   GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
   GstElementClass *gstelement_class = GST_ELEMENT_CLASS (klass);
+  GstBinClass *gstbin_class = GST_BIN_CLASS (klass);
 
   gobject_class->set_property = gst_rtp_sink_set_property;
   gobject_class->get_property = gst_rtp_sink_get_property;
   gobject_class->finalize = gst_rtp_sink_finalize;
   gstelement_class->change_state = gst_rtp_sink_change_state;
+  gstbin_class->handle_message = gst_rtp_sink_handle_message;
 
   gstelement_class->request_new_pad =
       GST_DEBUG_FUNCPTR (gst_rtp_sink_request_new_pad);
@@ -360,79 +901,551 @@ gst_rtp_sink_class_init (GstRtpSinkClass * klass)
           "Used for setting the multicast TTL parameter", 0, 255,
           DEFAULT_PROP_TTL_MC, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
-  gst_element_class_add_pad_template (gstelement_class,
-      gst_static_pad_template_get (&sink_template));
+  /**
+   * GstRtpSink:batch-size:
+   *
+   * The maximum number of RTP packets that are sent with one system call.
+   * The default of 1 uses a regular udpsink element; larger values collect
+   * packets and send them with sendmmsg(), using UDP GSO for runs of
+   * equal-sized packets where the kernel supports it. The value is
+   * applied when going to READY.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_BATCH_SIZE,
+      g_param_spec_uint ("batch-size", "Batch size",
+          "Maximum number of RTP packets sent with one system call "
+          "(1 = one packet per call)", 1, 1024, DEFAULT_PROP_BATCH_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
-  gst_element_class_set_static_metadata (gstelement_class,
-      "RTP Sink element",
-      "Generic/Bin/Sink",
-      "Simple RTP sink", "Marc Leeman <marc.leeman@gmail.com>");
-}
+  /**
+   * GstRtpSink:batch-timeout:
+   *
+   * The maximum time in microseconds an RTP packet waits for a batch to
+   * fill up before it is sent anyway. Only used when
+   * #GstRtpSink:batch-size is larger than 1.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_BATCH_TIMEOUT,
+      g_param_spec_uint ("batch-timeout", "Batch timeout",
+          "Maximum time in microseconds an RTP packet waits in an incomplete "
+          "batch", 0, G_MAXUINT, DEFAULT_PROP_BATCH_TIMEOUT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
-static void
-gst_rtp_sink_rtpbin_element_added_cb (GstBin * element,
-    GstElement * new_element, gpointer data)
-{
-  GstRtpSink *self = GST_RTP_SINK (data);
-  GST_INFO_OBJECT (self,
-      "Element %" GST_PTR_FORMAT " added element %" GST_PTR_FORMAT ".", element,
-      new_element);
-}
+  /**
+   * GstRtpSink:destinations:
+   *
+   * Comma separated list of additional receivers as address:port pairs,
+   * entries without an address use the address of the URI. The RTCP of a
+   * receiver goes to its port + 1. Can be changed while playing, the
+   * receivers that are in both the old and the new list are not
+   * interrupted.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_DESTINATIONS,
+      g_param_spec_string ("destinations", "Destinations",
+          "Comma separated list of additional address:port destinations",
+          DEFAULT_PROP_DESTINATIONS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
-static void
-gst_rtp_sink_rtpbin_pad_added_cb (GstElement * element, GstPad * pad,
-    gpointer data)
-{
-  GstRtpSink *self = GST_RTP_SINK (data);
-  GstCaps *caps = gst_pad_query_caps (pad, NULL);
-  GstPad *upad;
+  /**
+   * GstRtpSink:pacing:
+   *
+   * Spread the RTP packets evenly over time with a token bucket instead
+   * of sending a frame as one burst. The rate is
+   * #GstRtpSink:pacing-bitrate, or derived from the buffer timestamps
+   * when that is 0. The value is applied when going to READY.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_PACING,
+      g_param_spec_boolean ("pacing", "Pacing",
+          "Spread RTP packets evenly over time", DEFAULT_PROP_PACING,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
-  /* Expose RTP data pad only */
-  GST_INFO_OBJECT (self,
-      "Element %" GST_PTR_FORMAT " added pad %" GST_PTR_FORMAT "with caps %"
-      GST_PTR_FORMAT ".", element, pad, caps);
+  /**
+   * GstRtpSink:pacing-bitrate:
+   *
+   * The pacing rate in bits per second, 0 derives the rate from the
+   * buffer timestamps. Only used when #GstRtpSink:pacing is enabled.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_PACING_BITRATE,
+      g_param_spec_uint64 ("pacing-bitrate", "Pacing bitrate",
+          "Pacing rate in bits per second (0 = derive from timestamps)",
+          0, G_MAXUINT64, DEFAULT_PROP_PACING_BITRATE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
-  /* Sanity checks */
-  if (GST_PAD_DIRECTION (pad) == GST_PAD_SINK) {
-    /* Src pad, do not expose */
-    gst_caps_unref (caps);
-    return;
-  }
+  /**
+   * GstRtpSink:pacing-stats:
+   *
+   * The #GstRtpPacer:stats of the pacer, with the queue depth and the
+   * pacing delay, or %NULL when pacing is not enabled.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_PACING_STATS,
+      g_param_spec_boxed ("pacing-stats", "Pacing statistics",
+          "Statistics of the packet pacer", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
-  if (G_LIKELY (caps)) {
-    GstCaps *ref_caps = gst_caps_new_empty_simple ("application/x-rtcp");
+  /**
+   * GstRtpSink:stats:
+   *
+   * Send statistics, counted as the packets leave the #GstRtpBin. Reading
+   * them does not take any lock that the streaming threads use for every
+   * packet, so they can be polled frequently. This property returns a
+   * #GstStructure with name application/x-rtp-sink-stats with the
+   * following fields:
+   *
+   * - "packets" G_TYPE_UINT64: number of RTP packets sent
+   * - "bytes" G_TYPE_UINT64: number of RTP bytes sent
+   * - "sources" GST_TYPE_ARRAY: an application/x-rtp-source-stats
+   *   structure per SSRC with the fields "session" and "ssrc" as
+   *   G_TYPE_UINT, and "packets" and "bytes" as G_TYPE_UINT64
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Send statistics per SSRC", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
-    if (gst_caps_can_intersect (caps, ref_caps)) {
-      /* SRC RTCP caps, do not expose */
-      gst_caps_unref (ref_caps);
-      gst_caps_unref (caps);
+  /**
+   * GstRtpSink:zerocopy:
+   *
+   * Send large RTP messages with MSG_ZEROCOPY so the kernel transmits
+   * straight from the buffer memory. Mostly useful for high bitrate
+   * streams together with #GstRtpSink:batch-size, where runs of packets
+   * are sent as one UDP GSO message. Enabling this uses nrtp_sendsink to
+   * send the RTP data. Only supported on Linux. The value is applied when
+   * going to READY.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_ZEROCOPY,
+      g_param_spec_boolean ("zerocopy", "Zero-copy",
+          "Send large RTP messages without copying them into the kernel",
+          DEFAULT_PROP_ZEROCOPY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
-      return;
-    }
-    gst_caps_unref (ref_caps);
-  } else {
-    GST_ERROR_OBJECT (self, "Pad with no caps detected.");
-    gst_caps_unref (caps);
+  /**
+   * GstRtpSink:zerocopy-threshold:
+   *
+   * The smallest message in bytes that is sent without copying when
+   * #GstRtpSink:zerocopy is enabled, smaller messages are copied because
+   * that is cheaper than waiting for the completion.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_ZEROCOPY_THRESHOLD,
+      g_param_spec_uint ("zerocopy-threshold", "Zero-copy threshold",
+          "Smallest RTP message in bytes that is sent without copying",
+          0, G_MAXUINT, DEFAULT_PROP_ZEROCOPY_THRESHOLD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
-    return;
-  }
-  gst_caps_unref (caps);
+  /**
+   * GstRtpSink:dns-cache-ttl:
+   *
+   * The host of the URI is resolved without blocking the state change,
+   * going to PAUSED completes asynchronously until the lookup finished.
+   * The resolved addresses are shared by all elements in the process and
+   * reused for this many seconds, 0 always looks the host up again.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_DNS_CACHE_TTL,
+      g_param_spec_uint ("dns-cache-ttl", "DNS cache TTL",
+          "Seconds a resolved host is reused (0 = no caching)",
+          0, G_MAXUINT, DEFAULT_PROP_DNS_CACHE_TTL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
-  upad = gst_element_get_compatible_pad (self->funnel_rtp, pad, NULL);
-  if (upad == NULL) {
-    GST_ERROR_OBJECT (self, "No compatible pad found to link pad.");
-    gst_caps_unref (caps);
+  /**
+   * GstRtpSink:buffer-size:
+   *
+   * Size in bytes of the send buffer of the RTP and RTCP sockets
+   * (SO_SNDBUF), 0 keeps the system default. Sizes above net.core.wmem_max
+   * need CAP_NET_ADMIN. Any of the socket options uses nrtp_sendsink to
+   * send the RTP data. The options are applied when the sockets are opened
+   * and the values in effect are logged.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_BUFFER_SIZE,
+      g_param_spec_int ("buffer-size", "Buffer size",
+          "Size of the socket send buffer in bytes (0 = system default)",
+          0, G_MAXINT, DEFAULT_PROP_BUFFER_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
-    return;
-  }
-  GST_INFO_OBJECT (self, "Linking with pad %" GST_PTR_FORMAT ".", upad);
-  gst_pad_link (pad, upad);
-  gst_object_unref (upad);
-}
+  /**
+   * GstRtpSink:busy-poll:
+   *
+   * Time in microseconds to busy poll the device queue for incoming RTCP
+   * packets when the sockets are empty (SO_BUSY_POLL), 0 keeps the system
+   * default.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_BUSY_POLL,
+      g_param_spec_int ("busy-poll", "Busy poll",
+          "Busy poll time of the sockets in us (0 = system default)",
+          0, G_MAXINT, DEFAULT_PROP_BUSY_POLL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
-static void
-gst_rtp_sink_rtpbin_pad_removed_cb (GstElement * element, GstPad * pad,
-    gpointer data)
+  /**
+   * GstRtpSink:priority:
+   *
+   * Protocol priority of the sockets (SO_PRIORITY), which selects the
+   * queue of the sent packets with a multiqueue qdisc. -1 keeps the system
+   * default.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_PRIORITY,
+      g_param_spec_int ("priority", "Priority",
+          "Protocol priority of the sockets (-1 = system default)",
+          -1, G_MAXINT, DEFAULT_PROP_PRIORITY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSink:dscp:
+   *
+   * Differentiated services code point of the sent RTP and RTCP packets,
+   * for example 46 (EF) for audio or 34 (AF41) for video. -1 keeps the
+   * system default.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_DSCP,
+      g_param_spec_int ("dscp", "DSCP",
+          "DSCP of the sent packets (-1 = system default)",
+          -1, 63, DEFAULT_PROP_DSCP,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSink:incoming-cpu:
+   *
+   * Steer the received RTCP packets to the receive queue of this CPU
+   * (SO_INCOMING_CPU), -1 keeps the system default.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_INCOMING_CPU,
+      g_param_spec_int ("incoming-cpu", "Incoming CPU",
+          "CPU whose receive queue the sockets use (-1 = system default)",
+          -1, G_MAXINT, DEFAULT_PROP_INCOMING_CPU,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSink:cpu-affinity:
+   *
+   * Comma separated list of CPUs and CPU ranges, like "2,4-5", that the
+   * streaming threads of the internal elements, the pacer and the RTCP
+   * receiver, are pinned to when they start. Unset lets the threads run on
+   * any CPU.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_CPU_AFFINITY,
+      g_param_spec_string ("cpu-affinity", "CPU affinity",
+          "CPUs to run the streaming threads on, like 2,4-5 (NULL = all)",
+          DEFAULT_PROP_CPU_AFFINITY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSink:realtime-priority:
+   *
+   * Run the streaming threads of the internal elements with the SCHED_FIFO
+   * policy at this priority, 0 keeps the normal scheduling. Needs
+   * CAP_SYS_NICE or a matching RLIMIT_RTPRIO, otherwise a warning is
+   * logged and the threads keep their priority.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_REALTIME_PRIORITY,
+      g_param_spec_int ("realtime-priority", "Real-time priority",
+          "SCHED_FIFO priority of the streaming threads (0 = not real-time)",
+          0, GST_RTP_THREAD_MAX_PRIORITY, DEFAULT_PROP_REALTIME_PRIORITY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSink:fec:
+   *
+   * Protect the RTP stream with SMPTE 2022-1 FEC: the column FEC is sent to
+   * the RTP port + 2 and the row FEC to the RTP port + 4 of every
+   * receiver. The media packets are arranged in a matrix of
+   * #GstRtpSink:fec-columns by #GstRtpSink:fec-rows, so the FEC adds
+   * 1 / fec-rows + 1 / fec-columns to the bandwidth. The FEC is generated
+   * by an nrtp_fecenc element, after the pacer. The matrix follows the
+   * sequence numbers of a single SSRC, so FEC is only available with a
+   * single session: a second sink pad is refused and going to READY
+   * fails when more were requested.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_FEC,
+      g_param_spec_boolean ("fec", "FEC",
+          "Send SMPTE 2022-1 column and row FEC streams", DEFAULT_PROP_FEC,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSink:fec-columns:
+   *
+   * L, the number of columns of the FEC matrix. A burst of up to L lost
+   * packets is recovered from the column FEC. Columns and rows together
+   * cover at most 100 packets.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_FEC_COLUMNS,
+      g_param_spec_uint ("fec-columns", "FEC columns",
+          "Number of columns (L) of the FEC matrix", 1, 20,
+          DEFAULT_PROP_FEC_COLUMNS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSink:fec-rows:
+   *
+   * D, the number of rows of the FEC matrix, the number of packets each
+   * column FEC packet protects.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_FEC_ROWS,
+      g_param_spec_uint ("fec-rows", "FEC rows",
+          "Number of rows (D) of the FEC matrix", 1, 20,
+          DEFAULT_PROP_FEC_ROWS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSink:rtx:
+   *
+   * Keep the sent packets of the payload types in #GstRtpSink:rtx-pt-map
+   * and retransmit them as in RFC 4588 when a receiver asks for them with
+   * an RTCP NACK, with a payload type and an SSRC of their own on the RTP
+   * port. The packets are kept by an nrtp_rtxsend element for
+   * #GstRtpSink:rtx-cache-time and at most #GstRtpSink:rtx-cache-size
+   * bytes per stream, whichever is reached first.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_RTX,
+      g_param_spec_boolean ("rtx", "RTX",
+          "Retransmit the packets receivers ask for with NACKs",
+          DEFAULT_PROP_RTX, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSink:rtx-pt-map:
+   *
+   * The payload type the retransmissions of each media payload type are
+   * sent with, as comma separated "pt:rtx-pt" pairs, like "96:97,98:99".
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_RTX_PT_MAP,
+      g_param_spec_string ("rtx-pt-map", "RTX payload type map",
+          "Comma separated media:retransmission payload type pairs",
+          DEFAULT_PROP_RTX_PT_MAP,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSink:rtx-cache-time:
+   *
+   * How long the sent packets are kept for retransmission, in
+   * milliseconds, 0 to only limit the cache by its size. It should cover
+   * the latency of the receivers.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_RTX_CACHE_TIME,
+      g_param_spec_uint ("rtx-cache-time", "RTX cache time",
+          "Time to keep packets for retransmission in ms (0 = unlimited)",
+          0, G_MAXUINT, DEFAULT_PROP_RTX_CACHE_TIME,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSink:rtx-cache-size:
+   *
+   * How many bytes of sent packets are kept for retransmission per stream,
+   * 0 to only limit the cache by time. Bounds the memory of high bitrate
+   * streams, for which the time limit alone can hold a lot of packets.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_RTX_CACHE_SIZE,
+      g_param_spec_uint ("rtx-cache-size", "RTX cache size",
+          "Bytes to keep for retransmission per stream (0 = unlimited)",
+          0, G_MAXUINT, DEFAULT_PROP_RTX_CACHE_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSink::add:
+   * @object: the #GstRtpSink
+   * @host: the address of the receiver
+   * @port: the RTP port of the receiver
+   *
+   * Also send the RTP and RTCP packets to @host, on @port and @port + 1.
+   *
+   * Since: 1.16.1.2
+   */
+  gst_rtp_sink_signals[SIGNAL_ADD] =
+      g_signal_new_class_handler ("add", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_CALLBACK (gst_rtp_sink_add), NULL, NULL, NULL,
+      G_TYPE_NONE, 2, G_TYPE_STRING, G_TYPE_INT);
+
+  /**
+   * GstRtpSink::remove:
+   * @object: the #GstRtpSink
+   * @host: the address of the receiver
+   * @port: the RTP port of the receiver
+   *
+   * Stop sending to a receiver added with #GstRtpSink::add or
+   * #GstRtpSink:destinations.
+   *
+   * Since: 1.16.1.2
+   */
+  gst_rtp_sink_signals[SIGNAL_REMOVE] =
+      g_signal_new_class_handler ("remove", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_CALLBACK (gst_rtp_sink_remove), NULL, NULL, NULL,
+      G_TYPE_NONE, 2, G_TYPE_STRING, G_TYPE_INT);
+
+  /**
+   * GstRtpSink::get-stats:
+   * @object: the #GstRtpSink
+   * @host: the address of the receiver
+   * @port: the RTP port of the receiver
+   *
+   * Get the RTP statistics of one receiver, including the URI one, with at
+   * least the "packets-sent" and "bytes-sent" #guint64 fields.
+   *
+   * Returns: (transfer full) (nullable): a new #GstStructure, %NULL when
+   * the element is not in the READY state or higher
+   *
+   * Since: 1.16.1.2
+   */
+  gst_rtp_sink_signals[SIGNAL_GET_STATS] =
+      g_signal_new_class_handler ("get-stats", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_CALLBACK (gst_rtp_sink_get_stats), NULL, NULL, NULL,
+      GST_TYPE_STRUCTURE, 2, G_TYPE_STRING, G_TYPE_INT);
+
+  gst_element_class_add_pad_template (gstelement_class,
+      gst_static_pad_template_get (&sink_template));
+
+  gst_element_class_set_static_metadata (gstelement_class,
+      "RTP Sink element",
+      "Generic/Bin/Sink",
+      "Simple RTP sink", "Marc Leeman <marc.leeman@gmail.com>");
+}
+
+static void
+gst_rtp_sink_rtpbin_element_added_cb (GstBin * element,
+    GstElement * new_element, gpointer data)
+{
+  GstRtpSink *self = GST_RTP_SINK (data);
+  GST_INFO_OBJECT (self,
+      "Element %" GST_PTR_FORMAT " added element %" GST_PTR_FORMAT ".", element,
+      new_element);
+}
+
+/* The statistics of a session are counted on its own source pad of
+ * rtpbin, in front of the funnel */
+typedef struct
+{
+  GstRtpSink *sink;
+  guint session;
+} GstRtpSinkStatsProbe;
+
+static GstPadProbeReturn
+gst_rtp_sink_on_send_rtp (GstPad * pad, GstPadProbeInfo * info,
+    GstRtpSinkStatsProbe * probe)
+{
+  GstRtpStats *stats = probe->sink->stats;
+
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST (info);
+    guint i, len = gst_buffer_list_length (list);
+
+    for (i = 0; i < len; i++)
+      gst_rtp_stats_add_buffer (stats, probe->session,
+          gst_buffer_list_get (list, i), 0);
+  } else {
+    gst_rtp_stats_add_buffer (stats, probe->session,
+        GST_PAD_PROBE_INFO_BUFFER (info), 0);
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+gst_rtp_sink_rtpbin_pad_added_cb (GstElement * element, GstPad * pad,
+    gpointer data)
+{
+  GstRtpSink *self = GST_RTP_SINK (data);
+  GstCaps *caps = gst_pad_query_caps (pad, NULL);
+  GstRtpSinkStatsProbe *probe;
+  GstPad *upad;
+
+  /* Expose RTP data pad only */
+  GST_INFO_OBJECT (self,
+      "Element %" GST_PTR_FORMAT " added pad %" GST_PTR_FORMAT "with caps %"
+      GST_PTR_FORMAT ".", element, pad, caps);
+
+  /* Sanity checks */
+  if (GST_PAD_DIRECTION (pad) == GST_PAD_SINK) {
+    /* Src pad, do not expose */
+    gst_caps_unref (caps);
+    return;
+  }
+
+  if (G_LIKELY (caps)) {
+    GstCaps *ref_caps = gst_caps_new_empty_simple ("application/x-rtcp");
+
+    if (gst_caps_can_intersect (caps, ref_caps)) {
+      /* SRC RTCP caps, do not expose */
+      gst_caps_unref (ref_caps);
+      gst_caps_unref (caps);
+
+      return;
+    }
+    gst_caps_unref (ref_caps);
+  } else {
+    GST_ERROR_OBJECT (self, "Pad with no caps detected.");
+    gst_caps_unref (caps);
+
+    return;
+  }
+  gst_caps_unref (caps);
+
+  upad = gst_element_get_compatible_pad (self->funnel_rtp, pad, NULL);
+  if (upad == NULL) {
+    GST_ERROR_OBJECT (self, "No compatible pad found to link pad.");
+    gst_caps_unref (caps);
+
+    return;
+  }
+  GST_INFO_OBJECT (self, "Linking with pad %" GST_PTR_FORMAT ".", upad);
+  gst_pad_link (pad, upad);
+  gst_object_unref (upad);
+
+  if (g_str_has_prefix (GST_PAD_NAME (pad), "send_rtp_src_")) {
+    probe = g_new (GstRtpSinkStatsProbe, 1);
+    probe->sink = self;
+    probe->session = g_ascii_strtoull (GST_PAD_NAME (pad) +
+        strlen ("send_rtp_src_"), NULL, 10);
+    gst_pad_add_probe (pad,
+        GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+        (GstPadProbeCallback) gst_rtp_sink_on_send_rtp, probe, g_free);
+  }
+}
+
+static void
+gst_rtp_sink_rtpbin_pad_removed_cb (GstElement * element, GstPad * pad,
+    gpointer data)
 {
   GstRtpSink *self = GST_RTP_SINK (data);
   GST_INFO_OBJECT (self,
@@ -440,37 +1453,221 @@ gst_rtp_sink_rtpbin_pad_removed_cb (GstElement * element, GstPad * pad,
       pad);
 }
 
+/* Create the FEC encoder and the udpsink of the column and the row FEC
+ * stream, which start like the RTP sink once the host is resolved */
 static gboolean
-gst_rtp_sink_start (GstRtpSink * self)
+gst_rtp_sink_setup_fec (GstRtpSink * self)
 {
-  GSocket *socket = NULL;
-  GInetAddress *iaddr = NULL;
-  gchar *remote_addr = NULL;
-  GError *error = NULL;
+  gchar name[16];
+  guint i, j;
+
+  self->fec_enc = gst_element_factory_make ("nrtp_fecenc", NULL);
+  if (self->fec_enc == NULL)
+    goto missing_plugin;
+  g_object_set (self->fec_enc, "columns", self->fec_columns, "rows",
+      self->fec_rows, NULL);
+  gst_bin_add (GST_BIN (self), self->fec_enc);
+
+  /* The retransmissions are not part of the protected stream */
+  if (self->rtx_pt_map_structure) {
+    gchar *rtx_pts = gst_rtp_utils_get_rtx_pts (self->rtx_pt_map_structure);
+
+    g_object_set (self->fec_enc, "ignore-pts", rtx_pts, NULL);
+    g_free (rtx_pts);
+  }
+
+  for (i = 0; i < G_N_ELEMENTS (self->fec_sink); i++) {
+    self->fec_sink[i] = gst_element_factory_make ("udpsink", NULL);
+    if (self->fec_sink[i] == NULL)
+      goto missing_plugin;
+
+    /* The first FEC packet only follows a row of packets, the sinks must
+     * not hold back prerolling */
+    g_object_set (self->fec_sink[i], "ttl", self->ttl, "ttl-mc",
+        self->ttl_mc, "async", FALSE, NULL);
+    gst_element_set_locked_state (self->fec_sink[i], TRUE);
+
+    GST_OBJECT_LOCK (self);
+    for (j = 0; j < self->destinations->len; j++) {
+      GstRtpSinkDest *dest = g_ptr_array_index (self->destinations, j);
+
+      g_signal_emit_by_name (self->fec_sink[i], "add", dest->host,
+          (gint) (dest->port + fec_port_offsets[i]), NULL);
+    }
+    GST_OBJECT_UNLOCK (self);
+
+    gst_bin_add (GST_BIN (self), self->fec_sink[i]);
+    g_snprintf (name, sizeof (name), "fec_%u", i);
+    gst_element_link_pads (self->fec_enc, name, self->fec_sink[i], "sink");
+  }
+
+  return TRUE;
+
+missing_plugin:
+  {
+    GST_ELEMENT_ERROR (self, CORE, MISSING_PLUGIN, (NULL),
+        ("%s", "No element available to send FEC"));
+    return FALSE;
+  }
+}
+
+static void gst_rtp_sink_teardown_rtp_sink (GstRtpSink * self);
 
-  /* Should not be NULL */
-  g_return_val_if_fail (self->uri != NULL, FALSE);
+/* The element that sends the RTP data depends on the batch-size, zerocopy
+ * and socket properties and pacing and FEC are optional, so they are only
+ * created when going to READY. What was added is removed again when a
+ * part is missing. */
+static gboolean
+gst_rtp_sink_setup_rtp_sink (GstRtpSink * self)
+{
+  GstElement *upstream = self->funnel_rtp;
+  GstPad *pad;
+  guint i, n_sessions;
+
+  if (self->batch_size > 1 || self->zerocopy
+      || gst_rtp_socket_options_is_set (&self->socket_options)) {
+    self->rtp_sink = gst_element_factory_make ("nrtp_sendsink", NULL);
+    /* Paced packets are not held back to fill up a batch, the pacer
+     * pushes the packets that may leave together as a list */
+    if (self->rtp_sink) {
+      GstStructure *options =
+          gst_rtp_socket_options_to_structure (&self->socket_options);
+
+      g_object_set (self->rtp_sink, "batch-size", self->batch_size,
+          "batch-timeout", self->pacing ? 0 : self->batch_timeout,
+          "zerocopy", self->zerocopy,
+          "zerocopy-threshold", self->zerocopy_threshold,
+          "socket-options", options, NULL);
+      gst_structure_free (options);
+    }
+  } else {
+    self->rtp_sink = gst_element_factory_make ("udpsink", NULL);
+  }
 
-  iaddr = g_inet_address_new_from_string (gst_uri_get_host (self->uri));
-  if (!iaddr) {
-    GList *results;
-    GResolver *resolver = NULL;
+  if (self->rtp_sink == NULL) {
+    GST_ELEMENT_ERROR (self, CORE, MISSING_PLUGIN, (NULL),
+        ("%s", "No element available to send RTP data"));
+    return FALSE;
+  }
 
-    resolver = g_resolver_get_default ();
-    results =
-        g_resolver_lookup_by_name (resolver, gst_uri_get_host (self->uri), NULL,
-        &error);
+  /* The host is set and the sink started once the host is resolved */
+  g_object_set (self->rtp_sink, "ttl", self->ttl, "ttl-mc", self->ttl_mc,
+      NULL);
+  gst_element_set_locked_state (self->rtp_sink, TRUE);
 
-    if (!results) {
-      g_object_unref (resolver);
-      goto dns_resolve_failed;
+  /* The RTCP sink lives as long as the element once built and already
+   * knows the destinations */
+  GST_OBJECT_LOCK (self);
+  for (i = 0; i < self->destinations->len; i++) {
+    GstRtpSinkDest *dest = g_ptr_array_index (self->destinations, i);
+
+    g_signal_emit_by_name (self->rtp_sink, "add", dest->host,
+        (gint) dest->port, NULL);
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  gst_bin_add (GST_BIN (self), self->rtp_sink);
+
+  if (self->pacing) {
+    self->pacer = gst_element_factory_make ("nrtp_pacer", NULL);
+    if (self->pacer == NULL) {
+      GST_ELEMENT_ERROR (self, CORE, MISSING_PLUGIN, (NULL),
+          ("%s", "No element available to pace RTP data"));
+      goto failed;
     }
+    g_object_set (self->pacer, "bitrate", self->pacing_bitrate, NULL);
 
-    iaddr = G_INET_ADDRESS (g_object_ref (results->data));
+    gst_bin_add (GST_BIN (self), self->pacer);
+    gst_element_link (upstream, self->pacer);
+    upstream = self->pacer;
+  }
 
-    g_resolver_free_addresses (results);
-    g_object_unref (resolver);
+  /* The FEC protects the packets as they leave, after the pacer */
+  if (self->fec) {
+    GST_RTP_SINK_LOCK (self);
+    n_sessions = self->n_sessions;
+    GST_RTP_SINK_UNLOCK (self);
+    if (n_sessions > 1) {
+      GST_ELEMENT_ERROR (self, RESOURCE, SETTINGS,
+          ("FEC protects a single session only."),
+          ("%u sessions were requested with fec enabled", n_sessions));
+      goto failed;
+    }
+    if (!gst_rtp_sink_setup_fec (self))
+      goto failed;
+    gst_element_link_pads (upstream, "src", self->fec_enc, "sink");
+    upstream = self->fec_enc;
+  }
+  gst_element_link_pads (upstream, "src", self->rtp_sink, "sink");
+
+  pad = gst_element_get_static_pad (self->rtp_sink, "sink");
+  self->block_pad = gst_pad_get_peer (pad);
+  gst_object_unref (pad);
+  self->block_id = gst_pad_add_probe (self->block_pad,
+      GST_PAD_PROBE_TYPE_BLOCK_DOWNSTREAM, NULL, NULL, NULL);
+
+  return TRUE;
+
+failed:
+  {
+    gst_rtp_sink_teardown_rtp_sink (self);
+    return FALSE;
   }
+}
+
+static void
+gst_rtp_sink_unblock (GstRtpSink * self)
+{
+  if (self->block_pad == NULL)
+    return;
+
+  gst_pad_remove_probe (self->block_pad, self->block_id);
+  gst_object_unref (self->block_pad);
+  self->block_pad = NULL;
+  self->block_id = 0;
+}
+
+static void
+gst_rtp_sink_teardown_rtp_sink (GstRtpSink * self)
+{
+  guint i;
+
+  gst_rtp_sink_unblock (self);
+
+  for (i = 0; i < G_N_ELEMENTS (self->fec_sink); i++) {
+    if (self->fec_sink[i]) {
+      gst_element_set_state (self->fec_sink[i], GST_STATE_NULL);
+      gst_bin_remove (GST_BIN (self), self->fec_sink[i]);
+      self->fec_sink[i] = NULL;
+    }
+  }
+  if (self->fec_enc) {
+    gst_element_set_state (self->fec_enc, GST_STATE_NULL);
+    gst_bin_remove (GST_BIN (self), self->fec_enc);
+    self->fec_enc = NULL;
+  }
+
+  if (self->pacer) {
+    gst_element_set_state (self->pacer, GST_STATE_NULL);
+    gst_bin_remove (GST_BIN (self), self->pacer);
+    self->pacer = NULL;
+  }
+
+  if (self->rtp_sink == NULL)
+    return;
+
+  gst_element_set_state (self->rtp_sink, GST_STATE_NULL);
+  gst_bin_remove (GST_BIN (self), self->rtp_sink);
+  self->rtp_sink = NULL;
+}
+
+/* Start receiving and sending RTCP with @iaddr as the remote address */
+static void
+gst_rtp_sink_start_rtcp (GstRtpSink * self, GInetAddress * iaddr)
+{
+  GSocket *socket = NULL;
+  gchar *remote_addr = NULL;
+
   remote_addr = g_inet_address_to_string (iaddr);
 
   if (g_inet_address_get_is_multicast (iaddr)) {
@@ -486,29 +1683,242 @@ gst_rtp_sink_start (GstRtpSink * self)
 
     g_object_set (self->rtcp_src, "address", any_addr, "port", 0, NULL);
   }
-  g_object_unref (iaddr);
+  g_free (remote_addr);
 
   gst_element_set_locked_state (self->rtcp_src, FALSE);
   gst_element_sync_state_with_parent (self->rtcp_src);
 
   /* share the socket created by the sink */
   g_object_get (self->rtcp_src, "used-socket", &socket, NULL);
+  gst_rtp_socket_options_apply (GST_OBJECT (self), socket,
+      &self->socket_options, TRUE);
   g_object_set (self->rtcp_sink, "socket", socket, "auto-multicast", FALSE,
       "close-socket", FALSE, NULL);
   g_object_unref (socket);
 
   gst_element_set_locked_state (self->rtcp_sink, FALSE);
   gst_element_sync_state_with_parent (self->rtcp_sink);
+}
 
-  return TRUE;
+/* Start sending FEC stream @index to @host, with the socket options of the
+ * RTP data */
+static void
+gst_rtp_sink_start_fec (GstRtpSink * self, guint index, const gchar * host)
+{
+  GstElement *sink = self->fec_sink[index];
+  GSocket *socket = NULL;
+
+  g_object_set (sink, "host", host, "port",
+      gst_uri_get_port (self->uri) + fec_port_offsets[index], NULL);
+  if (!gst_element_is_locked_state (sink))
+    return;
+
+  gst_element_set_locked_state (sink, FALSE);
+  gst_element_sync_state_with_parent (sink);
+
+  g_object_get (sink, "used-socket", &socket, NULL);
+  if (socket) {
+    gst_rtp_socket_options_apply (GST_OBJECT (self), socket,
+        &self->socket_options, TRUE);
+    g_object_unref (socket);
+  }
+}
+
+/* Called with the state lock. Like decodebin, the bin posts the async
+ * messages for itself so that it only prerolls once the host is known. */
+static void
+gst_rtp_sink_async_start (GstRtpSink * self)
+{
+  GstMessage *message;
+
+  self->async_pending = TRUE;
+  message = gst_message_new_async_start (GST_OBJECT_CAST (self));
+  GST_BIN_CLASS (parent_class)->handle_message (GST_BIN_CAST (self),
+      message);
+}
+
+static void
+gst_rtp_sink_async_done (GstRtpSink * self)
+{
+  GstMessage *message;
+
+  if (!self->async_pending)
+    return;
+
+  message = gst_message_new_async_done (GST_OBJECT_CAST (self),
+      GST_CLOCK_TIME_NONE);
+  GST_BIN_CLASS (parent_class)->handle_message (GST_BIN_CAST (self),
+      message);
+  self->async_pending = FALSE;
+}
+
+typedef struct
+{
+  GstRtpSink *sink;
+  guint seq;
+} GstRtpSinkLookup;
+
+static void
+gst_rtp_sink_lookup_free (GstRtpSinkLookup * lookup)
+{
+  gst_object_unref (lookup->sink);
+  g_free (lookup);
+}
+
+/* Called right away for numeric and cached hosts, from a resolver
+ * thread otherwise */
+static void
+gst_rtp_sink_resolved (GInetAddress * iaddr, const GError * error,
+    GstRtpSinkLookup * lookup)
+{
+  GstRtpSink *self = lookup->sink;
+  gboolean current;
+  gchar *host;
+  guint i;
+
+  GST_STATE_LOCK (self);
+
+  GST_OBJECT_LOCK (self);
+  current = lookup->seq == self->resolve_seq;
+  if (current)
+    self->resolving = FALSE;
+  GST_OBJECT_UNLOCK (self);
+
+  /* The element stopped or the address changed in the mean time */
+  if (!current || self->rtp_sink == NULL)
+    goto done;
+
+  if (iaddr == NULL)
+    goto dns_resolve_failed;
+
+  host = g_inet_address_to_string (iaddr);
+  GST_DEBUG_OBJECT (self, "Sending to %s", host);
+  g_object_set (self->rtp_sink, "host", host, "port",
+      gst_uri_get_port (self->uri), NULL);
+  g_object_set (self->rtcp_sink, "host", host, "port",
+      gst_uri_get_port (self->uri) + 1, NULL);
+
+  if (gst_element_is_locked_state (self->rtcp_src))
+    gst_rtp_sink_start_rtcp (self, iaddr);
+
+  if (gst_element_is_locked_state (self->rtp_sink)) {
+    gst_element_set_locked_state (self->rtp_sink, FALSE);
+    gst_element_sync_state_with_parent (self->rtp_sink);
+  }
+  for (i = 0; i < G_N_ELEMENTS (self->fec_sink); i++) {
+    if (self->fec_sink[i])
+      gst_rtp_sink_start_fec (self, i, host);
+  }
+  gst_rtp_sink_unblock (self);
+  g_free (host);
+
+done:
+  gst_rtp_sink_async_done (self);
+  GST_STATE_UNLOCK (self);
+  return;
 
 dns_resolve_failed:
   GST_ELEMENT_ERROR (self, RESOURCE, NOT_FOUND,
-      ("Could not resolve hostname '%s'", GST_STR_NULL (remote_addr)),
+      ("Could not resolve hostname '%s'",
+          GST_STR_NULL (gst_uri_get_host (self->uri))),
       ("DNS resolver reported: %s", error->message));
-  g_free (remote_addr);
-  g_error_free (error);
-  return FALSE;
+  goto done;
+}
+
+/* Look up the host of the URI without blocking, a lookup that is still
+ * running is superseded */
+static void
+gst_rtp_sink_resolve (GstRtpSink * self)
+{
+  GstRtpSinkLookup *lookup;
+  gchar *host;
+
+  lookup = g_new0 (GstRtpSinkLookup, 1);
+  lookup->sink = gst_object_ref (self);
+
+  GST_OBJECT_LOCK (self);
+  lookup->seq = ++self->resolve_seq;
+  self->resolving = TRUE;
+  host = g_strdup (gst_uri_get_host (self->uri));
+  GST_OBJECT_UNLOCK (self);
+
+  gst_rtp_resolver_lookup_async (host, self->dns_cache_ttl,
+      (GstRtpResolverFunc) gst_rtp_sink_resolved, lookup,
+      (GDestroyNotify) gst_rtp_sink_lookup_free);
+  g_free (host);
+}
+
+/* Results of lookups that are still running are ignored */
+static void
+gst_rtp_sink_stop_resolve (GstRtpSink * self)
+{
+  GST_OBJECT_LOCK (self);
+  self->resolve_seq++;
+  self->resolving = FALSE;
+  GST_OBJECT_UNLOCK (self);
+}
+
+static gboolean
+gst_rtp_sink_setup_threads (GstRtpSink * self)
+{
+  GArray *cpus = NULL;
+
+  if (self->cpu_affinity && self->cpu_affinity[0] != '\0') {
+    cpus = gst_rtp_thread_parse_cpus (self->cpu_affinity);
+    if (cpus == NULL)
+      goto invalid_cpus;
+  }
+
+  GST_OBJECT_LOCK (self);
+  g_clear_pointer (&self->cpus, g_array_unref);
+  self->cpus = cpus;
+  GST_OBJECT_UNLOCK (self);
+
+  return TRUE;
+
+invalid_cpus:
+  {
+    GST_ELEMENT_ERROR (self, RESOURCE, SETTINGS, (NULL),
+        ("Invalid cpu-affinity '%s'", self->cpu_affinity));
+    return FALSE;
+  }
+}
+
+/* Stream-status messages are handled in the thread they are about, so a
+ * thread entering its loop is tuned right there */
+static void
+gst_rtp_sink_tune_thread (GstRtpSink * self, GstMessage * message)
+{
+  GstStreamStatusType type;
+  GArray *cpus = NULL;
+  gint priority;
+
+  gst_message_parse_stream_status (message, &type, NULL);
+  if (type != GST_STREAM_STATUS_TYPE_ENTER)
+    return;
+
+  GST_OBJECT_LOCK (self);
+  if (self->cpus)
+    cpus = g_array_ref (self->cpus);
+  priority = self->realtime_priority;
+  GST_OBJECT_UNLOCK (self);
+
+  if (cpus || priority > 0)
+    gst_rtp_thread_tune (GST_MESSAGE_SRC (message), cpus, priority);
+
+  if (cpus)
+    g_array_unref (cpus);
+}
+
+static void
+gst_rtp_sink_handle_message (GstBin * bin, GstMessage * message)
+{
+  GstRtpSink *self = GST_RTP_SINK (bin);
+
+  if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_STREAM_STATUS)
+    gst_rtp_sink_tune_thread (self, message);
+
+  GST_BIN_CLASS (parent_class)->handle_message (bin, message);
 }
 
 static GstStateChangeReturn
@@ -523,26 +1933,61 @@ gst_rtp_sink_change_state (GstElement * element, GstStateChange transition)
 
   switch (transition) {
     case GST_STATE_CHANGE_NULL_TO_READY:
+      if (gst_rtp_sink_setup_threads (self) == FALSE)
+        return GST_STATE_CHANGE_FAILURE;
+      if (gst_rtp_sink_setup_graph (self) == FALSE)
+        return GST_STATE_CHANGE_FAILURE;
+      if (gst_rtp_sink_setup_rtp_sink (self) == FALSE)
+        return GST_STATE_CHANGE_FAILURE;
       break;
-    case GST_STATE_CHANGE_READY_TO_PAUSED:
+    case GST_STATE_CHANGE_READY_TO_PAUSED:{
+      gboolean resolving;
+
+      /* Only preroll once the lookup of the host finished */
+      GST_OBJECT_LOCK (self);
+      resolving = self->resolving;
+      GST_OBJECT_UNLOCK (self);
+      if (resolving)
+        gst_rtp_sink_async_start (self);
+      break;
+    }
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      gst_rtp_sink_async_done (self);
       break;
     default:
       break;
   }
 
   ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
-  if (ret == GST_STATE_CHANGE_FAILURE)
+  if (ret == GST_STATE_CHANGE_FAILURE) {
+    gst_rtp_sink_async_done (self);
+    /* A retry sets up the RTP sink again */
+    if (transition == GST_STATE_CHANGE_NULL_TO_READY) {
+      gst_rtp_sink_stop_resolve (self);
+      gst_rtp_sink_teardown_rtp_sink (self);
+    }
     return ret;
+  }
 
   switch (transition) {
     case GST_STATE_CHANGE_NULL_TO_READY:
-      if (gst_rtp_sink_start (self) == FALSE)
-        return GST_STATE_CHANGE_FAILURE;
+      /* The state change does not wait for DNS, the RTP sink and the RTCP
+       * elements start once the host is resolved */
+      gst_rtp_sink_resolve (self);
       break;
     case GST_STATE_CHANGE_READY_TO_PAUSED:
+      if (self->async_pending)
+        ret = GST_STATE_CHANGE_ASYNC;
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
       break;
+    case GST_STATE_CHANGE_READY_TO_NULL:
+      gst_rtp_sink_stop_resolve (self);
+      gst_rtp_sink_teardown_rtp_sink (self);
+      GST_OBJECT_LOCK (self);
+      g_clear_pointer (&self->cpus, g_array_unref);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       break;
   }
@@ -550,86 +1995,105 @@ gst_rtp_sink_change_state (GstElement * element, GstStateChange transition)
   return ret;
 }
 
-
-static void
-gst_rtp_sink_init (GstRtpSink * self)
+/* nrtp_rtxsend keeps the packets of a session for retransmission in
+ * front of its rtpsession, which forwards the NACKs to it as upstream
+ * events */
+static GstElement *
+gst_rtp_sink_rtpbin_request_aux_sender_cb (GstElement * rtpbin,
+    guint session_id, GstRtpSink * self)
 {
-  const gchar *missing_plugin = NULL;
-  GstCaps *caps;
+  GstElement *bin, *rtx_send;
+  GstPad *pad;
+  gchar name[32];
+
+  rtx_send = gst_element_factory_make ("nrtp_rtxsend", NULL);
+  if (rtx_send == NULL) {
+    GST_ELEMENT_WARNING (self, CORE, MISSING_PLUGIN, (NULL),
+        ("%s", "No element available to retransmit packets"));
+    return NULL;
+  }
+  g_object_set (rtx_send, "payload-type-map", self->rtx_pt_map_structure,
+      "max-size-time", self->rtx_cache_time, "max-size-bytes",
+      self->rtx_cache_size, NULL);
 
-  self->rtpbin = NULL;
-  self->funnel_rtp = NULL;
-  self->funnel_rtcp = NULL;
-  self->rtp_sink = NULL;
-  self->rtcp_src = NULL;
-  self->rtcp_sink = NULL;
+  bin = gst_bin_new (NULL);
+  gst_bin_add (GST_BIN (bin), rtx_send);
 
-  self->uri = gst_uri_from_string (DEFAULT_PROP_URI);
-  self->ttl = DEFAULT_PROP_TTL;
-  self->ttl_mc = DEFAULT_PROP_TTL_MC;
+  pad = gst_element_get_static_pad (rtx_send, "sink");
+  g_snprintf (name, sizeof (name), "sink_%u", session_id);
+  gst_element_add_pad (bin, gst_ghost_pad_new (name, pad));
+  gst_object_unref (pad);
 
-  g_mutex_init (&self->lock);
+  pad = gst_element_get_static_pad (rtx_send, "src");
+  g_snprintf (name, sizeof (name), "src_%u", session_id);
+  gst_element_add_pad (bin, gst_ghost_pad_new (name, pad));
+  gst_object_unref (pad);
+
+  return bin;
+}
+
+/* Build rtpbin and the RTCP elements. The graph is only built when going
+ * to READY or when the first pad is requested, and then stays as the
+ * request pads link into rtpbin. */
+static gboolean
+gst_rtp_sink_setup_graph (GstRtpSink * self)
+{
+  const gchar *missing_plugin = NULL;
+  GstCaps *caps;
+  guint i;
+
+  if (self->rtpbin)
+    return TRUE;
+
+  if (self->rtx && self->rtx_pt_map_structure == NULL) {
+    self->rtx_pt_map_structure =
+        gst_rtp_utils_parse_rtx_pt_map (self->rtx_pt_map);
+    if (self->rtx_pt_map_structure == NULL) {
+      GST_ELEMENT_ERROR (self, RESOURCE, SETTINGS, (NULL),
+          ("Invalid rtx-pt-map '%s'", GST_STR_NULL (self->rtx_pt_map)));
+      return FALSE;
+    }
+  }
 
-  /* Construct the RTP sender pipeline.
-   *
-   *           *-> [send_rtp_sink_%u]   --------  [send_rtp_src_%u]  -> udpsink
-   *                                   | rtpbin |
-   * udpsrc     -> [recv_rtcp_sink_%u]  --------  [send_rtcp_src_%u] -> * udpsink
-   */
   self->rtpbin = gst_element_factory_make ("rtpbin", NULL);
   if (self->rtpbin == NULL) {
     missing_plugin = "rtpmanager";
     goto missing_plugin;
   }
 
-  gst_bin_add (GST_BIN (self), self->rtpbin);
-
-  /* Add rtpbin callbacks to monitor the operation of rtpbin */
-  g_signal_connect (self->rtpbin, "element-added",
-      G_CALLBACK (gst_rtp_sink_rtpbin_element_added_cb), self);
-  g_signal_connect (self->rtpbin, "pad-added",
-      G_CALLBACK (gst_rtp_sink_rtpbin_pad_added_cb), self);
-  g_signal_connect (self->rtpbin, "pad-removed",
-      G_CALLBACK (gst_rtp_sink_rtpbin_pad_removed_cb), self);
-
-  GST_OBJECT_FLAG_SET (GST_OBJECT (self), GST_ELEMENT_FLAG_SINK);
-  gst_bin_set_suppressed_flags (GST_BIN (self),
-      GST_ELEMENT_FLAG_SOURCE | GST_ELEMENT_FLAG_SINK);
-
   self->funnel_rtp = gst_element_factory_make ("funnel", NULL);
-  if (self->funnel_rtp == NULL) {
-    missing_plugin = "funnel";
-    goto missing_plugin;
-  }
-
   self->funnel_rtcp = gst_element_factory_make ("funnel", NULL);
-  if (self->funnel_rtcp == NULL) {
+  if (self->funnel_rtp == NULL || self->funnel_rtcp == NULL) {
     missing_plugin = "funnel";
     goto missing_plugin;
   }
 
-  self->rtp_sink = gst_element_factory_make ("udpsink", NULL);
-  if (self->rtp_sink == NULL) {
-    missing_plugin = "udp";
-    goto missing_plugin;
-  }
-
   self->rtcp_src = gst_element_factory_make ("udpsrc", NULL);
-  if (self->rtcp_src == NULL) {
+  self->rtcp_sink = gst_element_factory_make ("udpsink", NULL);
+  if (self->rtcp_src == NULL || self->rtcp_sink == NULL) {
     missing_plugin = "udp";
     goto missing_plugin;
   }
 
-  self->rtcp_sink = gst_element_factory_make ("udpsink", NULL);
-  if (self->rtcp_sink == NULL) {
-    missing_plugin = "udp";
-    goto missing_plugin;
+  gst_bin_add (GST_BIN (self), self->rtpbin);
+
+  /* Add rtpbin callbacks to monitor the operation of rtpbin */
+  g_signal_connect (self->rtpbin, "element-added",
+      G_CALLBACK (gst_rtp_sink_rtpbin_element_added_cb), self);
+  g_signal_connect (self->rtpbin, "pad-added",
+      G_CALLBACK (gst_rtp_sink_rtpbin_pad_added_cb), self);
+  g_signal_connect (self->rtpbin, "pad-removed",
+      G_CALLBACK (gst_rtp_sink_rtpbin_pad_removed_cb), self);
+
+  if (self->rtx_pt_map_structure) {
+    g_object_set (self->rtpbin, "rtp-profile", GST_RTP_PROFILE_AVPF, NULL);
+    g_signal_connect (self->rtpbin, "request-aux-sender",
+        G_CALLBACK (gst_rtp_sink_rtpbin_request_aux_sender_cb), self);
   }
 
   gst_bin_add (GST_BIN (self), self->funnel_rtp);
   gst_bin_add (GST_BIN (self), self->funnel_rtcp);
 
-  gst_bin_add (GST_BIN (self), self->rtp_sink);
   gst_bin_add (GST_BIN (self), self->rtcp_src);
   gst_bin_add (GST_BIN (self), self->rtcp_sink);
 
@@ -641,21 +2105,97 @@ gst_rtp_sink_init (GstRtpSink * self)
   g_object_set (self->rtcp_src, "caps", caps, NULL);
   gst_caps_unref (caps);
 
-  gst_element_link (self->funnel_rtp, self->rtp_sink);
+  /* The properties were only stored so far, the host is set once it is
+   * resolved */
+  g_object_set (self->rtcp_sink, "ttl", self->ttl, "ttl-mc", self->ttl_mc,
+      NULL);
+
+  GST_OBJECT_LOCK (self);
+  for (i = 0; i < self->destinations->len; i++) {
+    GstRtpSinkDest *dest = g_ptr_array_index (self->destinations, i);
+
+    g_signal_emit_by_name (self->rtcp_sink, "add", dest->host,
+        (gint) dest->port + 1, NULL);
+  }
+  GST_OBJECT_UNLOCK (self);
+
   gst_element_link (self->funnel_rtcp, self->rtcp_sink);
 
-  if (missing_plugin == NULL)
-    return;
+  return TRUE;
 
 missing_plugin:
   {
-    GST_ERROR_OBJECT (self, "'%s' plugin is missing.", missing_plugin);
-    /* Just make our element valid, so we fail cleanly */
-    gst_element_add_pad (GST_ELEMENT (self),
-        gst_pad_new_from_static_template (&sink_template, "sink_%u"));
+    g_clear_pointer (&self->rtpbin, gst_object_unref);
+    g_clear_pointer (&self->funnel_rtp, gst_object_unref);
+    g_clear_pointer (&self->funnel_rtcp, gst_object_unref);
+    g_clear_pointer (&self->rtcp_src, gst_object_unref);
+    g_clear_pointer (&self->rtcp_sink, gst_object_unref);
+    GST_ELEMENT_ERROR (self, CORE, MISSING_PLUGIN, (NULL),
+        ("'%s' plugin is missing.", missing_plugin));
+    return FALSE;
   }
 }
 
+static void
+gst_rtp_sink_init (GstRtpSink * self)
+{
+  self->rtpbin = NULL;
+  self->funnel_rtp = NULL;
+  self->funnel_rtcp = NULL;
+  self->pacer = NULL;
+  self->rtp_sink = NULL;
+  self->rtcp_src = NULL;
+  self->rtcp_sink = NULL;
+  self->fec_enc = NULL;
+  self->fec_sink[0] = self->fec_sink[1] = NULL;
+
+  self->uri = gst_uri_from_string (DEFAULT_PROP_URI);
+  self->ttl = DEFAULT_PROP_TTL;
+  self->ttl_mc = DEFAULT_PROP_TTL_MC;
+  self->batch_size = DEFAULT_PROP_BATCH_SIZE;
+  self->batch_timeout = DEFAULT_PROP_BATCH_TIMEOUT;
+  self->destinations =
+      g_ptr_array_new_with_free_func ((GDestroyNotify)
+      gst_rtp_sink_dest_free);
+  self->pacing = DEFAULT_PROP_PACING;
+  self->pacing_bitrate = DEFAULT_PROP_PACING_BITRATE;
+  self->zerocopy = DEFAULT_PROP_ZEROCOPY;
+  self->zerocopy_threshold = DEFAULT_PROP_ZEROCOPY_THRESHOLD;
+  self->dns_cache_ttl = DEFAULT_PROP_DNS_CACHE_TTL;
+  gst_rtp_socket_options_init (&self->socket_options);
+  self->cpu_affinity = DEFAULT_PROP_CPU_AFFINITY;
+  self->realtime_priority = DEFAULT_PROP_REALTIME_PRIORITY;
+  self->fec = DEFAULT_PROP_FEC;
+  self->fec_columns = DEFAULT_PROP_FEC_COLUMNS;
+  self->fec_rows = DEFAULT_PROP_FEC_ROWS;
+  self->rtx = DEFAULT_PROP_RTX;
+  self->rtx_pt_map = g_strdup (DEFAULT_PROP_RTX_PT_MAP);
+  self->rtx_cache_time = DEFAULT_PROP_RTX_CACHE_TIME;
+  self->rtx_cache_size = DEFAULT_PROP_RTX_CACHE_SIZE;
+  self->stats = gst_rtp_stats_new (FALSE);
+
+  g_mutex_init (&self->lock);
+
+  GST_OBJECT_FLAG_SET (GST_OBJECT (self), GST_ELEMENT_FLAG_SINK);
+  gst_bin_set_suppressed_flags (GST_BIN (self),
+      GST_ELEMENT_FLAG_SOURCE | GST_ELEMENT_FLAG_SINK);
+
+  /* The RTP sender pipeline, built when going to READY or when the first
+   * pad is requested.
+   *
+   *           *-> [send_rtp_sink_%u]   --------  [send_rtp_src_%u]  -> udpsink
+   *                                   | rtpbin |
+   * udpsrc     -> [recv_rtcp_sink_%u]  --------  [send_rtcp_src_%u] -> * udpsink
+   *
+   * The RTP udpsink is added when going to READY, it is replaced by
+   * nrtp_sendsink when batched or zero-copy sending or socket options are
+   * enabled. With pacing, an nrtp_pacer is put in front of it, and with
+   * FEC an nrtp_fecenc that also feeds the udpsinks of the FEC streams.
+   * With RTX, rtpbin gets an nrtp_rtxsend per session as its auxiliary
+   * sender.
+   */
+}
+
 static GstURIType
 gst_rtp_sink_uri_get_type (GType type)
 {
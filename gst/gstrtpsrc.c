@@ -34,6 +34,31 @@
  * This element hooks up the correct sockets to support both RTP as the
  * accompanying RTCP layer.
  *
+ * More RTP sessions can be received by the same element with the ports
+ * property, each session exposes its own source pads.
+ *
+ * By default the packets go through the jitterbuffer of #GstRtpBin, which
+ * reorders them and smooths out network jitter at the cost of the
+ * configured latency. With the low-latency mode, each session only has an
+ * rtpsession for RTCP and an rtpssrcdemux for the pad per sender; the
+ * packets are pushed out in arrival order on the thread that received
+ * them.
+ *
+ * To keep the tail latency low on dedicated cores, the streaming threads
+ * of the internal elements can be pinned with #GstRtpSrc:cpu-affinity and
+ * scheduled as real-time threads with #GstRtpSrc:realtime-priority, and
+ * with #GstRtpSrc:spin-time the RTP socket is polled for a while before
+ * the receive thread goes to sleep.
+ *
+ * Where retransmissions take too long, #GstRtpSrc:fec receives the SMPTE
+ * 2022-1 column and row FEC streams next to the RTP and RTCP ports and
+ * recovers lost packets before they reach the jitterbuffer.
+ *
+ * Where the round trip is short enough, #GstRtpSrc:rtx asks the sender
+ * for the packets the jitterbuffer misses with RTCP NACKs and merges the
+ * RFC 4588 retransmissions that #GstRtpSink:rtx sends back into the
+ * stream before the latency runs out.
+ *
  * This Bin handles taking in of data from the network and provides the
  * RTP payloaded data.
  */
@@ -44,9 +69,18 @@
 #include <gio/gio.h>
 #include <gst/net/net.h>
 #include <gst/rtp/gstrtppayloads.h>
+#include <gst/rtp/gstrtcpbuffer.h>
+#include <gst/rtp/gstrtpdefs.h>
 
 #include "gstrtpsrc.h"
 #include "gstrtp-utils.h"
+#include "gstrtp-addrtable.h"
+#include "gstrtp-histogram.h"
+#include "gstrtp-stats.h"
+#include "gstrtp-filter.h"
+#include "gstrtp-uring.h"
+#include "gstrtp-sockopt.h"
+#include "gstrtp-thread.h"
 
 GST_DEBUG_CATEGORY_STATIC (gst_rtp_src_debug);
 #define GST_CAT_DEFAULT gst_rtp_src_debug
@@ -55,11 +89,129 @@ GST_DEBUG_CATEGORY_STATIC (gst_rtp_src_debug);
 #define DEFAULT_PROP_TTL_MC           1
 #define DEFAULT_PROP_ENCODING_NAME    NULL
 #define DEFAULT_PROP_LATENCY          200
+#define DEFAULT_PROP_BATCH_SIZE       1
+#define DEFAULT_PROP_POOL_SIZE        0
+#define DEFAULT_PROP_MTU              1500
+#define DEFAULT_PROP_RECEIVE_THREADS  1
+#define DEFAULT_PROP_PORTS            NULL
+#define DEFAULT_PROP_KERNEL_TIMESTAMPS FALSE
+#define DEFAULT_PROP_PT_MAP           NULL
+#define DEFAULT_PROP_KERNEL_FILTER    FALSE
+#define DEFAULT_PROP_FILTER_SSRCS     NULL
+#define DEFAULT_PROP_FILTER_PTS       NULL
+#define DEFAULT_PROP_IO_URING         FALSE
+#define DEFAULT_PROP_MODE             GST_RTP_SRC_MODE_DEFAULT
+#define DEFAULT_PROP_ADAPTIVE_LATENCY FALSE
+#define DEFAULT_PROP_MIN_LATENCY      20
+#define DEFAULT_PROP_MAX_LATENCY      1000
+#define DEFAULT_PROP_BUFFER_SIZE      0
+#define DEFAULT_PROP_BUSY_POLL        0
+#define DEFAULT_PROP_PRIORITY         -1
+#define DEFAULT_PROP_DSCP             -1
+#define DEFAULT_PROP_INCOMING_CPU     -1
+#define DEFAULT_PROP_CPU_AFFINITY     NULL
+#define DEFAULT_PROP_REALTIME_PRIORITY 0
+#define DEFAULT_PROP_SPIN_TIME        0
+#define DEFAULT_PROP_EXPECTED_BITRATE 0
+#define DEFAULT_PROP_FEC              FALSE
+#define DEFAULT_PROP_RTX              FALSE
+#define DEFAULT_PROP_RTX_PT_MAP       "96:97"
+
+/* The adaptive latency is reconsidered at this interval. It aims for this
+ * many times the largest interarrival jitter, raises the latency right
+ * away when that is more or when packets came too late, and only lowers
+ * it after the target stayed this many intervals a fifth below it. */
+#define ADAPTIVE_LATENCY_INTERVAL     GST_SECOND
+#define ADAPTIVE_LATENCY_JITTER_FACTOR 4
+#define ADAPTIVE_LATENCY_HOLD         5
+/* Smallest raise in ms after late packets */
+#define ADAPTIVE_LATENCY_MIN_STEP     10
+
+/* With an expected bitrate, the receive buffer holds the data of the
+ * latency but at least this many ms. The kernel charges the buffer with
+ * the memory of the packets, which is up to twice their size, and the
+ * buffer is allowed to grow this many times on overflows. */
+#define BUFFER_SIZE_MIN_TIME          100
+#define BUFFER_SIZE_OVERHEAD          2
+#define BUFFER_SIZE_GROWTH            4
+
+/* SMPTE 2022-1 sends the column FEC two and the row FEC four ports above
+ * the RTP port */
+#define FEC_COLUMN_PORT_OFFSET        2
+#define FEC_ROW_PORT_OFFSET           4
 
 #define DEFAULT_PROP_ADDRESS          "0.0.0.0"
 #define DEFAULT_PROP_PORT             5004
 #define DEFAULT_PROP_URI              "rtp://"DEFAULT_PROP_ADDRESS":"G_STRINGIFY(DEFAULT_PROP_PORT)
 
+typedef enum
+{
+  GST_RTP_SRC_MODE_DEFAULT,
+  GST_RTP_SRC_MODE_LOW_LATENCY,
+} GstRtpSrcMode;
+
+#define GST_TYPE_RTP_SRC_MODE (gst_rtp_src_mode_get_type ())
+static GType
+gst_rtp_src_mode_get_type (void)
+{
+  static GType mode_type = 0;
+  static const GEnumValue modes[] = {
+    {GST_RTP_SRC_MODE_DEFAULT, "Reorder and smooth in the jitterbuffer",
+        "default"},
+    {GST_RTP_SRC_MODE_LOW_LATENCY, "Push packets without a jitterbuffer",
+        "low-latency"},
+    {0, NULL, NULL},
+  };
+
+  if (!mode_type)
+    mode_type = g_enum_register_static ("GstRtpSrcMode", modes);
+
+  return mode_type;
+}
+
+/* One RTP session on the shared rtpbin with its own sockets. The main
+ * session receives on the URI and always exists, the sessions from the
+ * ports property are added when going to READY. */
+typedef struct
+{
+  GstRtpSrc *src;
+  guint id;
+  /* NULL for the main session, which follows the URI */
+  gchar *host;
+  guint port;
+
+  GstElement *rtp_src;
+  GstElement *rtcp_src;
+  GstElement *rtcp_sink;
+
+  /* Low-latency mode only, they replace the session of rtpbin */
+  GstElement *rtpsession;
+  GstElement *demux;
+
+  /* With FEC only, the decoder between rtp_src and the manager and the
+   * udpsrc of the column and the row FEC stream */
+  GstElement *fec_dec;
+  GstElement *fec_src[2];
+
+  /* From the caps of rtp_src, only used by its streaming thread */
+  guint clock_rate;
+
+  gulong rtcp_recv_probe;
+  gulong rtcp_send_probe;
+  /* Where to send RTCP for each sender SSRC, read without locking */
+  GstRtpAddrTable *rtcp_addrs;
+  GSocket *rtcp_socket;
+} GstRtpSrcSession;
+
+#define GST_RTP_SRC_PT_MAP_SIZE 128
+
+/* RTP caps per payload type, replaced as a whole when the encoding-name or
+ * pt-map properties change. */
+typedef struct
+{
+  GstCaps *caps[GST_RTP_SRC_PT_MAP_SIZE];
+} GstRtpSrcPtMap;
+
 struct _GstRtpSrc
 {
   GstBin parent_instance;
@@ -68,17 +220,66 @@ struct _GstRtpSrc
   GstUri *uri;
   gint ttl;
   gint ttl_mc;
+  /* Protected by the object lock */
   gchar *encoding_name;
+  gchar *pt_map_str;
+  guint batch_size;
+  guint pool_size;
+  guint mtu;
+  guint receive_threads;
+  gchar *ports;
+  gboolean kernel_timestamps;
+  gboolean kernel_filter;
+  gchar *filter_ssrcs;
+  gchar *filter_pts;
+  gboolean io_uring;
+  guint latency;
+  GstRtpSrcMode mode;
+  gboolean adaptive_latency;
+  guint min_latency;
+  guint max_latency;
+  GstRtpSocketOptions socket_options;
+  gchar *cpu_affinity;
+  guint spin_time;
+  guint64 expected_bitrate;
+  gboolean fec;
+  gboolean rtx;
+  gchar *rtx_pt_map;
+  /* Protected by the object lock */
+  gint realtime_priority;
+
+  /* CPUs of cpu-affinity, parsed when going to READY and protected by the
+   * object lock */
+  GArray *cpus;
+
+  /* Caps of the kernel arrival timestamp meta */
+  GstCaps *timestamp_caps;
+
+  GstRtpStats *stats;
+
+  /* Protected by the object lock, built again when encoding-name or
+   * pt-map change. A change only replaces the table when no later change
+   * was made in the mean time, pt_map_seq counts them. */
+  GstRtpSrcPtMap *pt_map;
+  guint pt_map_seq;
+
+  /* Socket filters of all sessions, built when going to READY */
+  GBytes *rtp_filter;
+  GBytes *rtcp_filter;
+
+  /* The rtx-pt-map when retransmissions are requested, parsed when going
+   * to READY */
+  GstStructure *rtx_pt_map_structure;
 
   /* Internal elements */
   GstElement *rtpbin;
-  GstElement *rtp_src;
-  GstElement *rtcp_src;
-  GstElement *rtcp_sink;
+  /* GstRtpSrcSession, indexed by session id */
+  GPtrArray *sessions;
 
-  gulong rtcp_recv_probe;
-  gulong rtcp_send_probe;
-  GSocketAddress *rtcp_send_addr;
+  /* Adaptive latency, protected by the lock */
+  GstClockID adapt_id;
+  guint64 adapt_late;
+  guint adapt_hold;
 
   GMutex lock;
 };
@@ -94,6 +295,35 @@ enum
   PROP_TTL_MC,
   PROP_ENCODING_NAME,
   PROP_LATENCY,
+  PROP_BATCH_SIZE,
+  PROP_POOL_SIZE,
+  PROP_MTU,
+  PROP_RECEIVE_THREADS,
+  PROP_PORTS,
+  PROP_KERNEL_TIMESTAMPS,
+  PROP_LATENCY_HISTOGRAM,
+  PROP_STATS,
+  PROP_PT_MAP,
+  PROP_KERNEL_FILTER,
+  PROP_FILTER_SSRCS,
+  PROP_FILTER_PTS,
+  PROP_IO_URING,
+  PROP_MODE,
+  PROP_ADAPTIVE_LATENCY,
+  PROP_MIN_LATENCY,
+  PROP_MAX_LATENCY,
+  PROP_BUFFER_SIZE,
+  PROP_BUSY_POLL,
+  PROP_PRIORITY,
+  PROP_DSCP,
+  PROP_INCOMING_CPU,
+  PROP_CPU_AFFINITY,
+  PROP_REALTIME_PRIORITY,
+  PROP_SPIN_TIME,
+  PROP_EXPECTED_BITRATE,
+  PROP_FEC,
+  PROP_RTX,
+  PROP_RTX_PT_MAP,
 
   PROP_LAST
 };
@@ -110,6 +340,9 @@ G_DEFINE_TYPE_WITH_CODE (GstRtpSrc, gst_rtp_src, GST_TYPE_BIN,
 #define GST_RTP_SRC_LOCK(obj) (g_mutex_lock (GST_RTP_SRC_GET_LOCK(obj)))
 #define GST_RTP_SRC_UNLOCK(obj) (g_mutex_unlock (GST_RTP_SRC_GET_LOCK(obj)))
 
+#define GST_RTP_SRC_MAIN_SESSION(obj) \
+    ((GstRtpSrcSession *) g_ptr_array_index (((GstRtpSrc*)(obj))->sessions, 0))
+
 static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src_%u",
     GST_PAD_SRC,
     GST_PAD_SOMETIMES,
@@ -117,6 +350,182 @@ static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src_%u",
 
 static GstStateChangeReturn
 gst_rtp_src_change_state (GstElement * element, GstStateChange transition);
+static void gst_rtp_src_handle_message (GstBin * bin, GstMessage * message);
+
+static GstCaps *
+gst_rtp_src_pt_caps_new (const gchar * media, const gchar * encoding_name,
+    guint clock_rate, const gchar * encoding_params)
+{
+  GstCaps *caps = gst_caps_new_simple ("application/x-rtp",
+      "encoding-name", G_TYPE_STRING, encoding_name,
+      "clock-rate", G_TYPE_INT, clock_rate,
+      "media", G_TYPE_STRING, media, NULL);
+
+  if (encoding_params)
+    gst_caps_set_simple (caps, "encoding-params", G_TYPE_STRING,
+        encoding_params, NULL);
+
+  return caps;
+}
+
+static const GstRTPPayloadInfo *
+gst_rtp_src_payload_info_for_name (const gchar * encoding_name)
+{
+  const GstRTPPayloadInfo *p;
+
+  /* Unfortunately, the media needs to be passed in the function. Since
+   * it is not known, try for video if video not found. */
+  p = gst_rtp_payload_info_for_name ("video", encoding_name);
+  if (p == NULL)
+    p = gst_rtp_payload_info_for_name ("audio", encoding_name);
+
+  return p;
+}
+
+/* Parse one "pt:encoding-name/clock-rate[/encoding-params]" entry of the
+ * pt-map property, as in an SDP rtpmap attribute. */
+static GstCaps *
+gst_rtp_src_parse_pt_map_entry (const gchar * entry, guint * pt)
+{
+  const GstRTPPayloadInfo *p;
+  GstCaps *caps = NULL;
+  gchar **fields;
+  gchar *name, *end;
+  guint64 clock_rate;
+
+  fields = g_strsplit_set (entry, ":/", 4);
+  if (g_strv_length (fields) < 3)
+    goto done;
+
+  *pt = g_ascii_strtoull (fields[0], &end, 10);
+  if (end == fields[0] || *end != '\0' || *pt >= GST_RTP_SRC_PT_MAP_SIZE)
+    goto done;
+
+  clock_rate = g_ascii_strtoull (fields[2], &end, 10);
+  if (end == fields[2] || *end != '\0' || clock_rate == 0
+      || clock_rate > G_MAXINT)
+    goto done;
+
+  name = g_ascii_strup (fields[1], -1);
+  p = gst_rtp_src_payload_info_for_name (name);
+  caps = gst_rtp_src_pt_caps_new (p ? p->media : "application", name,
+      clock_rate, fields[3]);
+  g_free (name);
+
+done:
+  g_strfreev (fields);
+  return caps;
+}
+
+/* Build the immutable caps of every payload type. The entries of
+ * @pt_map_str come first, then the @encoding_name, which applies to all
+ * other payload types, and finally the static payload types. */
+static GstRtpSrcPtMap *
+gst_rtp_src_pt_map_new (GstRtpSrc * self, const gchar * encoding_name,
+    const gchar * pt_map_str)
+{
+  GstRtpSrcPtMap *map = g_new0 (GstRtpSrcPtMap, 1);
+  const GstRTPPayloadInfo *p;
+  GstCaps *caps;
+  guint pt;
+
+  if (pt_map_str) {
+    gchar **entries = g_strsplit (pt_map_str, ",", -1);
+    guint i;
+
+    for (i = 0; entries[i]; i++) {
+      g_strstrip (entries[i]);
+      if (entries[i][0] == '\0')
+        continue;
+
+      caps = gst_rtp_src_parse_pt_map_entry (entries[i], &pt);
+      if (caps == NULL) {
+        GST_WARNING_OBJECT (self, "Ignoring invalid pt-map entry '%s'",
+            entries[i]);
+        continue;
+      }
+      gst_caps_replace (&map->caps[pt], caps);
+      gst_caps_unref (caps);
+    }
+    g_strfreev (entries);
+  }
+
+  caps = NULL;
+  if (encoding_name != NULL) {
+    p = gst_rtp_src_payload_info_for_name (encoding_name);
+    if (p)
+      caps = gst_rtp_src_pt_caps_new (p->media, p->encoding_name,
+          p->clock_rate, NULL);
+  }
+
+  for (pt = 0; pt < GST_RTP_SRC_PT_MAP_SIZE; pt++) {
+    if (map->caps[pt])
+      continue;
+
+    /* The encoding-name has more relevant information. If not set, try to
+     * look it up with a static one. Needs to be guarded because some
+     * encoders do not use dynamic values for H.264 */
+    if (caps) {
+      map->caps[pt] = gst_caps_ref (caps);
+    } else if (!GST_RTP_PAYLOAD_IS_DYNAMIC (pt)) {
+      p = gst_rtp_payload_info_for_pt (pt);
+      if (p)
+        map->caps[pt] = gst_rtp_src_pt_caps_new (p->media, p->encoding_name,
+            p->clock_rate, NULL);
+    }
+  }
+
+  if (caps)
+    gst_caps_unref (caps);
+
+  return map;
+}
+
+static void
+gst_rtp_src_pt_map_free (GstRtpSrcPtMap * map)
+{
+  guint pt;
+
+  for (pt = 0; pt < GST_RTP_SRC_PT_MAP_SIZE; pt++) {
+    if (map->caps[pt])
+      gst_caps_unref (map->caps[pt]);
+  }
+  g_free (map);
+}
+
+/* Replace the table after the properties changed. It is built without
+ * the object lock, the debug output of invalid entries needs it. */
+static void
+gst_rtp_src_update_pt_map (GstRtpSrc * self)
+{
+  GstRtpSrcPtMap *map, *old = NULL;
+  gchar *encoding_name, *pt_map_str;
+  guint seq;
+
+  GST_OBJECT_LOCK (self);
+  seq = ++self->pt_map_seq;
+  encoding_name = g_strdup (self->encoding_name);
+  pt_map_str = g_strdup (self->pt_map_str);
+  GST_OBJECT_UNLOCK (self);
+
+  map = gst_rtp_src_pt_map_new (self, encoding_name, pt_map_str);
+  g_free (encoding_name);
+  g_free (pt_map_str);
+
+  GST_OBJECT_LOCK (self);
+  if (seq == self->pt_map_seq) {
+    old = self->pt_map;
+    self->pt_map = map;
+    map = NULL;
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  if (old)
+    gst_rtp_src_pt_map_free (old);
+  /* Superseded by a later change */
+  if (map)
+    gst_rtp_src_pt_map_free (map);
+}
 
 /**
  * gst_rtp_src_rtpbin_request_pt_map_cb:
@@ -124,52 +533,31 @@ gst_rtp_src_change_state (GstElement * element, GstStateChange transition);
  *
  * #GstRtpBin callback to map a pt on RTP caps.
  *
- * Returns: (transfer none): the guess on the RTP caps based on the PT
- * and caps.
+ * Returns: (transfer full): the RTP caps from the payload type table, or
+ * %NULL if the payload type is unknown.
  */
 static GstCaps *
 gst_rtp_src_rtpbin_request_pt_map_cb (GstElement * rtpbin, guint session_id,
     guint pt, gpointer data)
 {
   GstRtpSrc *self = GST_RTP_SRC (data);
-  const GstRTPPayloadInfo *p = NULL;
+  GstCaps *caps = NULL;
 
   GST_DEBUG_OBJECT (self,
       "Requesting caps for session-id 0x%x and pt %u.", session_id, pt);
 
-  /* the encoding-name has more relevant information */
-  if (self->encoding_name != NULL) {
-    /* Unfortunately, the media needs to be passed in the function. Since
-     * it is not known, try for video if video not found. */
-    p = gst_rtp_payload_info_for_name ("video", self->encoding_name);
-    if (p == NULL)
-      p = gst_rtp_payload_info_for_name ("audio", self->encoding_name);
-  }
-
-  /* If info has been found before based on the encoding-name, go with
-   * it. If not, try to look it up on with a static one. Needs to be guarded
-   * because some encoders do not use dynamic values for H.264 */
-  if (p == NULL) {
-    /* Static payload types, this is a simple lookup */
-    if (!GST_RTP_PAYLOAD_IS_DYNAMIC (pt)) {
-      p = gst_rtp_payload_info_for_pt (pt);
-    }
-  }
-
-  if (p != NULL) {
-    GstCaps *ret = gst_caps_new_simple ("application/x-rtp",
-        "encoding-name", G_TYPE_STRING, p->encoding_name,
-        "clock-rate", G_TYPE_INT, p->clock_rate,
-        "media", G_TYPE_STRING, p->media, NULL);
-
-    GST_DEBUG_OBJECT (self, "Decided on caps %" GST_PTR_FORMAT, ret);
+  GST_OBJECT_LOCK (self);
+  if (pt < GST_RTP_SRC_PT_MAP_SIZE && self->pt_map->caps[pt])
+    caps = gst_caps_ref (self->pt_map->caps[pt]);
+  GST_OBJECT_UNLOCK (self);
 
-    return ret;
-  }
+  if (caps)
+    GST_DEBUG_OBJECT (self, "Decided on caps %" GST_PTR_FORMAT, caps);
+  else
+    GST_DEBUG_OBJECT (self, "Could not determine caps based on pt and"
+        " the encoding-name was not set.");
 
-  GST_DEBUG_OBJECT (self, "Could not determine caps based on pt and"
-      " the encoding-name was not set.");
-  return NULL;
+  return caps;
 }
 
 static void
@@ -177,6 +565,7 @@ gst_rtp_src_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
 {
   GstRtpSrc *self = GST_RTP_SRC (object);
+  GstRtpSrcSession *session = GST_RTP_SRC_MAIN_SESSION (self);
   GstCaps *caps;
 
   switch (prop_id) {
@@ -204,12 +593,13 @@ gst_rtp_src_set_property (GObject * object, guint prop_id,
       GInetAddress *addr;
 
       gst_uri_set_host (self->uri, g_value_get_string (value));
-      g_object_set_property (G_OBJECT (self->rtp_src), "address", value);
+      if (session->rtp_src)
+        g_object_set_property (G_OBJECT (session->rtp_src), "address", value);
 
       addr = g_inet_address_new_from_string (gst_uri_get_host (self->uri));
-      if (g_inet_address_get_is_multicast (addr)) {
-        g_object_set (self->rtcp_src, "address", gst_uri_get_host (self->uri),
-            NULL);
+      if (session->rtcp_src && g_inet_address_get_is_multicast (addr)) {
+        g_object_set (session->rtcp_src, "address",
+            gst_uri_get_host (self->uri), NULL);
       }
       g_object_unref (addr);
       break;
@@ -224,8 +614,10 @@ gst_rtp_src_set_property (GObject * object, guint prop_id,
             "Port %u is odd, this is not standard (see RFC 3550).", port);
 
       gst_uri_set_port (self->uri, port);
-      g_object_set (self->rtp_src, "port", port, NULL);
-      g_object_set (self->rtcp_src, "port", port + 1, NULL);
+      if (session->rtp_src)
+        g_object_set (session->rtp_src, "port", port, NULL);
+      if (session->rtcp_src)
+        g_object_set (session->rtcp_src, "port", port + 1, NULL);
       break;
     }
     case PROP_TTL:
@@ -235,16 +627,123 @@ gst_rtp_src_set_property (GObject * object, guint prop_id,
       self->ttl_mc = g_value_get_int (value);
       break;
     case PROP_ENCODING_NAME:
+      GST_OBJECT_LOCK (self);
       g_free (self->encoding_name);
       self->encoding_name = g_value_dup_string (value);
-      if (self->rtp_src) {
+      GST_OBJECT_UNLOCK (self);
+      gst_rtp_src_update_pt_map (self);
+      if (session->rtp_src) {
+        guint i;
+
         caps = gst_rtp_src_rtpbin_request_pt_map_cb (NULL, 0, 96, self);
-        g_object_set (G_OBJECT (self->rtp_src), "caps", caps, NULL);
-        gst_caps_unref (caps);
+        for (i = 0; i < self->sessions->len; i++) {
+          session = g_ptr_array_index (self->sessions, i);
+          g_object_set (G_OBJECT (session->rtp_src), "caps", caps, NULL);
+        }
+        if (caps)
+          gst_caps_unref (caps);
       }
       break;
+    case PROP_PT_MAP:
+      GST_OBJECT_LOCK (self);
+      g_free (self->pt_map_str);
+      self->pt_map_str = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (self);
+      gst_rtp_src_update_pt_map (self);
+      break;
+    case PROP_KERNEL_FILTER:
+      self->kernel_filter = g_value_get_boolean (value);
+      break;
+    case PROP_FILTER_SSRCS:
+      g_free (self->filter_ssrcs);
+      self->filter_ssrcs = g_value_dup_string (value);
+      break;
+    case PROP_FILTER_PTS:
+      g_free (self->filter_pts);
+      self->filter_pts = g_value_dup_string (value);
+      break;
+    case PROP_IO_URING:
+      self->io_uring = g_value_get_boolean (value);
+      break;
+    case PROP_MODE:
+      self->mode = g_value_get_enum (value);
+      break;
+    case PROP_ADAPTIVE_LATENCY:
+      self->adaptive_latency = g_value_get_boolean (value);
+      break;
+    case PROP_MIN_LATENCY:
+      self->min_latency = g_value_get_uint (value);
+      break;
+    case PROP_MAX_LATENCY:
+      self->max_latency = g_value_get_uint (value);
+      break;
+    case PROP_BUFFER_SIZE:
+      self->socket_options.buffer_size = g_value_get_int (value);
+      if (self->socket_options.buffer_size == 0)
+        self->socket_options.buffer_size = -1;
+      break;
+    case PROP_BUSY_POLL:
+      self->socket_options.busy_poll = g_value_get_int (value);
+      if (self->socket_options.busy_poll == 0)
+        self->socket_options.busy_poll = -1;
+      break;
+    case PROP_PRIORITY:
+      self->socket_options.priority = g_value_get_int (value);
+      break;
+    case PROP_DSCP:
+      self->socket_options.dscp = g_value_get_int (value);
+      break;
+    case PROP_INCOMING_CPU:
+      self->socket_options.incoming_cpu = g_value_get_int (value);
+      break;
+    case PROP_CPU_AFFINITY:
+      g_free (self->cpu_affinity);
+      self->cpu_affinity = g_value_dup_string (value);
+      break;
+    case PROP_REALTIME_PRIORITY:
+      GST_OBJECT_LOCK (self);
+      self->realtime_priority = g_value_get_int (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_SPIN_TIME:
+      self->spin_time = g_value_get_uint (value);
+      break;
+    case PROP_EXPECTED_BITRATE:
+      self->expected_bitrate = g_value_get_uint64 (value);
+      break;
+    case PROP_FEC:
+      self->fec = g_value_get_boolean (value);
+      break;
+    case PROP_RTX:
+      self->rtx = g_value_get_boolean (value);
+      break;
+    case PROP_RTX_PT_MAP:
+      g_free (self->rtx_pt_map);
+      self->rtx_pt_map = g_value_dup_string (value);
+      break;
     case PROP_LATENCY:
-      g_object_set (self->rtpbin, "latency", g_value_get_uint (value), NULL);
+      self->latency = g_value_get_uint (value);
+      if (self->rtpbin)
+        g_object_set (self->rtpbin, "latency", self->latency, NULL);
+      break;
+    case PROP_BATCH_SIZE:
+      self->batch_size = g_value_get_uint (value);
+      break;
+    case PROP_POOL_SIZE:
+      self->pool_size = g_value_get_uint (value);
+      break;
+    case PROP_MTU:
+      self->mtu = g_value_get_uint (value);
+      break;
+    case PROP_RECEIVE_THREADS:
+      self->receive_threads = g_value_get_uint (value);
+      break;
+    case PROP_PORTS:
+      g_free (self->ports);
+      self->ports = g_value_dup_string (value);
+      break;
+    case PROP_KERNEL_TIMESTAMPS:
+      self->kernel_timestamps = g_value_get_boolean (value);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -252,6 +751,34 @@ gst_rtp_src_set_property (GObject * object, guint prop_id,
   }
 }
 
+#define LATENCY_HISTOGRAM_KEY "nrtp-latency-histogram"
+
+/* One histogram per exposed pad, with the pad names as field names */
+static GstStructure *
+gst_rtp_src_create_latency_histogram (GstRtpSrc * self)
+{
+  GstStructure *s, *histogram;
+  GstRtpHistogram *h;
+  GList *l;
+
+  s = gst_structure_new_empty ("application/x-rtp-src-latency");
+
+  GST_OBJECT_LOCK (self);
+  for (l = GST_ELEMENT (self)->srcpads; l; l = l->next) {
+    h = g_object_get_data (G_OBJECT (l->data), LATENCY_HISTOGRAM_KEY);
+    if (h == NULL)
+      continue;
+
+    histogram = gst_rtp_histogram_to_structure (h);
+    gst_structure_set (s, GST_PAD_NAME (l->data), GST_TYPE_STRUCTURE,
+        histogram, NULL);
+    gst_structure_free (histogram);
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  return s;
+}
+
 static void
 gst_rtp_src_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
@@ -280,10 +807,108 @@ gst_rtp_src_get_property (GObject * object, guint prop_id,
       g_value_set_int (value, self->ttl_mc);
       break;
     case PROP_ENCODING_NAME:
+      GST_OBJECT_LOCK (self);
       g_value_set_string (value, self->encoding_name);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_PT_MAP:
+      GST_OBJECT_LOCK (self);
+      g_value_set_string (value, self->pt_map_str);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_KERNEL_FILTER:
+      g_value_set_boolean (value, self->kernel_filter);
+      break;
+    case PROP_FILTER_SSRCS:
+      g_value_set_string (value, self->filter_ssrcs);
+      break;
+    case PROP_FILTER_PTS:
+      g_value_set_string (value, self->filter_pts);
+      break;
+    case PROP_IO_URING:
+      g_value_set_boolean (value, self->io_uring);
+      break;
+    case PROP_MODE:
+      g_value_set_enum (value, self->mode);
+      break;
+    case PROP_ADAPTIVE_LATENCY:
+      g_value_set_boolean (value, self->adaptive_latency);
+      break;
+    case PROP_MIN_LATENCY:
+      g_value_set_uint (value, self->min_latency);
+      break;
+    case PROP_MAX_LATENCY:
+      g_value_set_uint (value, self->max_latency);
+      break;
+    case PROP_BUFFER_SIZE:
+      g_value_set_int (value, MAX (self->socket_options.buffer_size, 0));
+      break;
+    case PROP_BUSY_POLL:
+      g_value_set_int (value, MAX (self->socket_options.busy_poll, 0));
+      break;
+    case PROP_PRIORITY:
+      g_value_set_int (value, self->socket_options.priority);
+      break;
+    case PROP_DSCP:
+      g_value_set_int (value, self->socket_options.dscp);
+      break;
+    case PROP_INCOMING_CPU:
+      g_value_set_int (value, self->socket_options.incoming_cpu);
+      break;
+    case PROP_CPU_AFFINITY:
+      g_value_set_string (value, self->cpu_affinity);
+      break;
+    case PROP_REALTIME_PRIORITY:
+      GST_OBJECT_LOCK (self);
+      g_value_set_int (value, self->realtime_priority);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_SPIN_TIME:
+      g_value_set_uint (value, self->spin_time);
+      break;
+    case PROP_EXPECTED_BITRATE:
+      g_value_set_uint64 (value, self->expected_bitrate);
+      break;
+    case PROP_FEC:
+      g_value_set_boolean (value, self->fec);
+      break;
+    case PROP_RTX:
+      g_value_set_boolean (value, self->rtx);
+      break;
+    case PROP_RTX_PT_MAP:
+      g_value_set_string (value, self->rtx_pt_map);
       break;
     case PROP_LATENCY:
-      g_object_get_property (G_OBJECT (self->rtpbin), "latency", value);
+      /* The adaptive latency only changes the one of rtpbin */
+      if (self->rtpbin)
+        g_object_get_property (G_OBJECT (self->rtpbin), "latency", value);
+      else
+        g_value_set_uint (value, self->latency);
+      break;
+    case PROP_BATCH_SIZE:
+      g_value_set_uint (value, self->batch_size);
+      break;
+    case PROP_POOL_SIZE:
+      g_value_set_uint (value, self->pool_size);
+      break;
+    case PROP_MTU:
+      g_value_set_uint (value, self->mtu);
+      break;
+    case PROP_RECEIVE_THREADS:
+      g_value_set_uint (value, self->receive_threads);
+      break;
+    case PROP_PORTS:
+      g_value_set_string (value, self->ports);
+      break;
+    case PROP_KERNEL_TIMESTAMPS:
+      g_value_set_boolean (value, self->kernel_timestamps);
+      break;
+    case PROP_LATENCY_HISTOGRAM:
+      g_value_take_boxed (value, gst_rtp_src_create_latency_histogram (self));
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_rtp_stats_get_structure (self->stats,
+              "application/x-rtp-src-stats"));
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -299,6 +924,16 @@ gst_rtp_src_finalize (GObject * gobject)
   if (self->uri)
     gst_uri_unref (self->uri);
   g_free (self->encoding_name);
+  g_free (self->pt_map_str);
+  gst_rtp_src_pt_map_free (self->pt_map);
+  g_free (self->filter_ssrcs);
+  g_free (self->filter_pts);
+  g_free (self->ports);
+  g_free (self->cpu_affinity);
+  g_free (self->rtx_pt_map);
+  g_ptr_array_unref (self->sessions);
+  gst_caps_unref (self->timestamp_caps);
+  gst_rtp_stats_free (self->stats);
 
   g_mutex_clear (&self->lock);
   G_OBJECT_CLASS (parent_class)->finalize (gobject);
@@ -309,11 +944,13 @@ gst_rtp_src_class_init (GstRtpSrcClass * klass)
 {
   GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
   GstElementClass *gstelement_class = GST_ELEMENT_CLASS (klass);
+  GstBinClass *gstbin_class = GST_BIN_CLASS (klass);
 
   gobject_class->set_property = gst_rtp_src_set_property;
   gobject_class->get_property = gst_rtp_src_get_property;
   gobject_class->finalize = gst_rtp_src_finalize;
   gstelement_class->change_state = gst_rtp_src_change_state;
+  gstbin_class->handle_message = gst_rtp_src_handle_message;
 
   /**
    * GstRtpSrc:uri:
@@ -394,11 +1031,83 @@ gst_rtp_src_class_init (GstRtpSrcClass * klass)
           DEFAULT_PROP_ENCODING_NAME,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstRtpSrc:pt-map:
+   *
+   * Caps for dynamic payload types, as a comma separated list of
+   * pt:encoding-name/clock-rate[/encoding-params] entries in the format of
+   * an SDP rtpmap attribute, e.g. "96:H264/90000,97:OPUS/48000/2". These
+   * entries take precedence over #GstRtpSrc:encoding-name, which is used
+   * for all other payload types. The caps of every payload type are
+   * computed once when either property changes, so the #GstRtpBin can
+   * look them up without any string matching or allocation.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_PT_MAP,
+      g_param_spec_string ("pt-map", "Payload type map",
+          "Comma separated list of pt:encoding-name/clock-rate[/params]",
+          DEFAULT_PROP_PT_MAP, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSrc:kernel-filter:
+   *
+   * Attach a classic BPF program to the RTP and RTCP sockets of all
+   * sessions, so that the kernel drops packets that are not RTP version 2,
+   * or do not match #GstRtpSrc:filter-ssrcs and #GstRtpSrc:filter-pts,
+   * before they are copied to userspace. This saves CPU on busy multicast
+   * groups that carry other traffic. Only supported on Linux. The value
+   * is applied when going to READY.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_KERNEL_FILTER,
+      g_param_spec_boolean ("kernel-filter", "Kernel filter",
+          "Drop unwanted packets in the kernel with a socket filter",
+          DEFAULT_PROP_KERNEL_FILTER,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSrc:filter-ssrcs:
+   *
+   * Comma separated list of up to 64 SSRCs, decimal or hexadecimal with a
+   * 0x prefix, that #GstRtpSrc:kernel-filter accepts. RTCP is accepted if
+   * its first packet comes from one of these SSRCs. Empty accepts all.
+   * With #GstRtpSrc:rtx, the retransmission payload types are accepted
+   * from any SSRC, as the sender picks a random SSRC for them, while the
+   * RTCP of the retransmission SSRCs is still dropped.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_FILTER_SSRCS,
+      g_param_spec_string ("filter-ssrcs", "Filter SSRCs",
+          "Comma separated list of SSRCs accepted by the kernel filter",
+          DEFAULT_PROP_FILTER_SSRCS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSrc:filter-pts:
+   *
+   * Comma separated list of up to 64 payload types that
+   * #GstRtpSrc:kernel-filter accepts on the RTP sockets. Empty accepts
+   * all.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_FILTER_PTS,
+      g_param_spec_string ("filter-pts", "Filter payload types",
+          "Comma separated list of payload types accepted by the kernel "
+          "filter", DEFAULT_PROP_FILTER_PTS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /**
    * GstRtpSrc:latency:
    *
    * Set the size of the latency buffer in the
-   * GstRtpBin/GstRtpJitterBuffer to compensate for network jitter.
+   * GstRtpBin/GstRtpJitterBuffer to compensate for network jitter. It
+   * has no effect in the low-latency #GstRtpSrc:mode. With
+   * #GstRtpSrc:adaptive-latency, this is the initial latency and reading
+   * it returns the current one.
    *
    * Since: 1.14.4.1
    */
@@ -408,52 +1117,524 @@ gst_rtp_src_class_init (GstRtpSrcClass * klass)
           G_MAXUINT, DEFAULT_PROP_LATENCY,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
-  gst_element_class_add_pad_template (gstelement_class,
-      gst_static_pad_template_get (&src_template));
-
-  gst_element_class_set_static_metadata (gstelement_class,
-      "RTP Source element",
-      "Generic/Bin/Src",
-      "Simple RTP src", "Marc Leeman <marc.leeman@gmail.com>");
-}
+  /**
+   * GstRtpSrc:batch-size:
+   *
+   * The maximum number of RTP packets that are read from the socket with
+   * one system call and pushed into the #GstRtpBin as one #GstBufferList.
+   * The default of 1 uses a regular udpsrc element; larger values use
+   * recvmmsg() where available, which reduces the per-packet overhead for
+   * high packet rates. The value is applied when going to READY.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_BATCH_SIZE,
+      g_param_spec_uint ("batch-size", "Batch size",
+          "Maximum number of RTP packets read with one system call "
+          "(1 = one packet per call)", 1, 1024, DEFAULT_PROP_BATCH_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
-static void
-gst_rtp_src_rtpbin_pad_added_cb (GstElement * element, GstPad * pad,
-    gpointer data)
-{
-  GstRtpSrc *self = GST_RTP_SRC (data);
-  GstCaps *caps = gst_pad_query_caps (pad, NULL);
-  GstPad *upad;
-  gchar name[48];
+  /**
+   * GstRtpSrc:pool-size:
+   *
+   * The number of MTU-sized buffers that are preallocated to read RTP
+   * packets into. The buffers are recycled once the #GstRtpBin releases
+   * them, so no memory is allocated per packet once the pool is warmed
+   * up. Size it to cover the packets held by the jitterbuffer, packets
+   * that do not fit are allocated as before. 0 disables the pool. A
+   * non-zero value uses nrtp_recvsrc to receive the RTP data.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_POOL_SIZE,
+      g_param_spec_uint ("pool-size", "Pool size",
+          "Number of preallocated RTP receive buffers (0 = disabled)",
+          0, G_MAXUINT16, DEFAULT_PROP_POOL_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
-  /* Expose RTP data pad only */
-  GST_INFO_OBJECT (self,
-      "Element %" GST_PTR_FORMAT " added pad %" GST_PTR_FORMAT "with caps %"
-      GST_PTR_FORMAT ".", element, pad, caps);
+  /**
+   * GstRtpSrc:mtu:
+   *
+   * The size of the buffers RTP packets are read into when the packets
+   * are received in batches or into a pool, set it for jumbo frames.
+   * Larger packets are dropped.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_MTU,
+      g_param_spec_uint ("mtu", "MTU",
+          "Maximum size of a received RTP packet", 64, G_MAXUINT16,
+          DEFAULT_PROP_MTU, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
-  /* Sanity checks */
-  if (GST_PAD_DIRECTION (pad) == GST_PAD_SINK) {
-    /* Sink pad, do not expose */
-    gst_caps_unref (caps);
-    return;
-  }
+  /**
+   * GstRtpSrc:receive-threads:
+   *
+   * The number of threads that receive RTP packets. Each thread reads its
+   * own socket, bound to the same port with SO_REUSEPORT, and the packets
+   * are merged in sequence number order before they enter the #GstRtpBin.
+   * Use this when a single high bitrate stream saturates one core. A
+   * value larger than 1 uses nrtp_recvsrc to receive the RTP data.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_RECEIVE_THREADS,
+      g_param_spec_uint ("receive-threads", "Receive threads",
+          "Number of threads receiving RTP packets on SO_REUSEPORT sockets",
+          1, 64, DEFAULT_PROP_RECEIVE_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
-  if (G_LIKELY (caps)) {
-    GstCaps *ref_caps = gst_caps_new_empty_simple ("application/x-rtcp");
+  /**
+   * GstRtpSrc:ports:
+   *
+   * Additional RTP sessions to receive, as a comma separated list of
+   * ports or address:port pairs, e.g. "5006,239.1.1.2:5008". Entries
+   * without an address use the address of the URI. Each entry becomes its
+   * own session on the shared #GstRtpBin, with RTCP on the next port, and
+   * uses the same settings as the session of the URI. The list is applied
+   * when going to READY.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_PORTS,
+      g_param_spec_string ("ports", "Ports",
+          "Comma separated list of [address:]port of additional sessions",
+          DEFAULT_PROP_PORTS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
-    if (gst_caps_can_intersect (caps, ref_caps)) {
-      /* SRC RTCP caps, do not expose */
-      gst_caps_unref (ref_caps);
-      gst_caps_unref (caps);
+  /**
+   * GstRtpSrc:kernel-timestamps:
+   *
+   * Let the kernel timestamp the arrival of every RTP packet. The time is
+   * attached to the buffers as a #GstReferenceTimestampMeta with caps
+   * timestamp/x-unix and the time from arrival until the packet leaves
+   * the element is reported in #GstRtpSrc:latency-histogram. Enabling this
+   * uses nrtp_recvsrc to receive the RTP data. The value is applied when
+   * going to READY.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_KERNEL_TIMESTAMPS,
+      g_param_spec_boolean ("kernel-timestamps", "Kernel timestamps",
+          "Timestamp packet arrival in the kernel and measure the latency",
+          DEFAULT_PROP_KERNEL_TIMESTAMPS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
-      return;
-    }
-    gst_caps_unref (ref_caps);
-  } else {
-    GST_ERROR_OBJECT (self, "Pad with no caps detected.");
-    gst_caps_unref (caps);
+  /**
+   * GstRtpSrc:io-uring:
+   *
+   * Receive the RTP data with nrtp_recvsrc using a multishot io_uring
+   * request, which reads packets into a ring of #GstRtpSrc:pool-size
+   * buffers without a system call per packet. If the system does not
+   * support it, the RTP data is received as if this was not set. The
+   * value is applied when going to READY.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_IO_URING,
+      g_param_spec_boolean ("io-uring", "io_uring",
+          "Receive with io_uring when the system supports it",
+          DEFAULT_PROP_IO_URING, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
-    return;
+  /**
+   * GstRtpSrc:mode:
+   *
+   * How the received packets are handled before they are pushed out. The
+   * default mode buffers them in the jitterbuffer for
+   * #GstRtpSrc:latency. The low-latency mode skips the jitterbuffer:
+   * RTCP is still sent and received and every sender still gets its own
+   * source pad, but the packets are pushed out in arrival order, without
+   * reordering or lost packet events, on the thread that received them.
+   * The value is applied when going to READY.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_MODE,
+      g_param_spec_enum ("mode", "Mode",
+          "Handling of the packets between the sockets and the source pads",
+          GST_TYPE_RTP_SRC_MODE, DEFAULT_PROP_MODE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSrc:adaptive-latency:
+   *
+   * Adjust the #GstRtpSrc:latency of the jitterbuffers to the network
+   * while playing, between #GstRtpSrc:min-latency and
+   * #GstRtpSrc:max-latency. Every second the latency is compared with
+   * four times the largest interarrival jitter of the senders. It is
+   * raised right away when that is higher or when the jitterbuffers had
+   * to drop packets that came too late, and lowered in steps of a quarter
+   * once the jitter stayed well below it for five seconds.
+   *
+   * Every adjustment is posted as an element message with a
+   * #GstStructure named application/x-rtp-src-latency-changed with the
+   * fields:
+   *
+   * - "latency" G_TYPE_UINT: the new latency in milliseconds
+   * - "previous-latency" G_TYPE_UINT: the old latency in milliseconds
+   * - "jitter" G_TYPE_UINT64: the largest jitter in nanoseconds
+   * - "late" G_TYPE_UINT64: the packets that came too late since the
+   *   previous check
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_ADAPTIVE_LATENCY,
+      g_param_spec_boolean ("adaptive-latency", "Adaptive latency",
+          "Adjust the latency to the measured jitter and late packets",
+          DEFAULT_PROP_ADAPTIVE_LATENCY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSrc:min-latency:
+   *
+   * The lowest latency in milliseconds that #GstRtpSrc:adaptive-latency
+   * goes to.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_MIN_LATENCY,
+      g_param_spec_uint ("min-latency", "Minimum latency",
+          "Lowest adaptive latency in ms", 0, G_MAXUINT,
+          DEFAULT_PROP_MIN_LATENCY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSrc:max-latency:
+   *
+   * The highest latency in milliseconds that #GstRtpSrc:adaptive-latency
+   * goes to.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_LATENCY,
+      g_param_spec_uint ("max-latency", "Maximum latency",
+          "Highest adaptive latency in ms", 0, G_MAXUINT,
+          DEFAULT_PROP_MAX_LATENCY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSrc:buffer-size:
+   *
+   * Size in bytes of the receive buffer of the RTP and RTCP sockets
+   * (SO_RCVBUF), 0 keeps the system default. Sizes above net.core.rmem_max
+   * need CAP_NET_ADMIN. Any of the socket options uses nrtp_recvsrc to
+   * receive the RTP data. The options are applied when going to READY and
+   * the values in effect are logged.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_BUFFER_SIZE,
+      g_param_spec_int ("buffer-size", "Buffer size",
+          "Size of the socket receive buffer in bytes (0 = system default)",
+          0, G_MAXINT, DEFAULT_PROP_BUFFER_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSrc:busy-poll:
+   *
+   * Time in microseconds to busy poll the device queue for new packets
+   * when the sockets are empty (SO_BUSY_POLL), 0 keeps the system default.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_BUSY_POLL,
+      g_param_spec_int ("busy-poll", "Busy poll",
+          "Busy poll time of the sockets in us (0 = system default)",
+          0, G_MAXINT, DEFAULT_PROP_BUSY_POLL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSrc:priority:
+   *
+   * Protocol priority of the sockets (SO_PRIORITY), -1 keeps the system
+   * default.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_PRIORITY,
+      g_param_spec_int ("priority", "Priority",
+          "Protocol priority of the sockets (-1 = system default)",
+          -1, G_MAXINT, DEFAULT_PROP_PRIORITY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSrc:dscp:
+   *
+   * Differentiated services code point of the RTCP packets that are sent
+   * back, -1 keeps the system default.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_DSCP,
+      g_param_spec_int ("dscp", "DSCP",
+          "DSCP of the sent packets (-1 = system default)",
+          -1, 63, DEFAULT_PROP_DSCP,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSrc:incoming-cpu:
+   *
+   * Steer the packets of the sockets to the receive queue of this CPU
+   * (SO_INCOMING_CPU), -1 keeps the system default.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_INCOMING_CPU,
+      g_param_spec_int ("incoming-cpu", "Incoming CPU",
+          "CPU whose receive queue the sockets use (-1 = system default)",
+          -1, G_MAXINT, DEFAULT_PROP_INCOMING_CPU,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSrc:cpu-affinity:
+   *
+   * Comma separated list of CPUs and CPU ranges, like "2,4-5", that the
+   * streaming threads of the internal elements are pinned to when they
+   * start. Unset lets the threads run on any CPU.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_CPU_AFFINITY,
+      g_param_spec_string ("cpu-affinity", "CPU affinity",
+          "CPUs to run the streaming threads on, like 2,4-5 (NULL = all)",
+          DEFAULT_PROP_CPU_AFFINITY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSrc:realtime-priority:
+   *
+   * Run the streaming threads of the internal elements with the SCHED_FIFO
+   * policy at this priority, 0 keeps the normal scheduling. Needs
+   * CAP_SYS_NICE or a matching RLIMIT_RTPRIO, otherwise a warning is
+   * logged and the threads keep their priority.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_REALTIME_PRIORITY,
+      g_param_spec_int ("realtime-priority", "Real-time priority",
+          "SCHED_FIFO priority of the streaming threads (0 = not real-time)",
+          0, GST_RTP_THREAD_MAX_PRIORITY, DEFAULT_PROP_REALTIME_PRIORITY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSrc:spin-time:
+   *
+   * Keep polling an empty RTP socket for this many microseconds before
+   * blocking on it, see #GstRtpRecvSrc:spin-time. Combined with
+   * #GstRtpSrc:cpu-affinity on an isolated core, this removes the wakeup
+   * latency of the receive thread at the cost of that core. A non-zero
+   * value uses nrtp_recvsrc to receive the RTP data.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_SPIN_TIME,
+      g_param_spec_uint ("spin-time", "Spin time",
+          "Time in us to poll an empty socket before blocking (0 = never)",
+          0, G_USEC_PER_SEC, DEFAULT_PROP_SPIN_TIME,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSrc:expected-bitrate:
+   *
+   * Bitrate in bits per second the senders are expected to send at. The
+   * receive buffer of the RTP socket is then sized to hold the data of the
+   * configured latency, unless #GstRtpSrc:buffer-size is set, and the
+   * packets the kernel drops because the buffer is full are detected, see
+   * #GstRtpRecvSrc:detect-overflows. On overflows the buffer is raised up
+   * to four times its initial size, after that a warning is posted. A
+   * non-zero value uses nrtp_recvsrc to receive the RTP data.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_EXPECTED_BITRATE,
+      g_param_spec_uint64 ("expected-bitrate", "Expected bitrate",
+          "Expected bitrate in bits/s to size the receive buffer for "
+          "(0 = unknown)", 0, G_MAXUINT64, DEFAULT_PROP_EXPECTED_BITRATE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSrc:fec:
+   *
+   * Receive SMPTE 2022-1 FEC on the two ports above the RTCP port, the
+   * column FEC on the RTP port + 2 and the row FEC on the RTP port + 4,
+   * and recover lost packets before they reach the jitterbuffer. The
+   * same applies to every session of #GstRtpSrc:ports, so their ports
+   * need to be at least six apart. The recovery is counted in the stats
+   * of the nrtp_fecdec element of each session.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_FEC,
+      g_param_spec_boolean ("fec", "FEC",
+          "Recover lost packets with the SMPTE 2022-1 column and row FEC "
+          "streams", DEFAULT_PROP_FEC,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSrc:rtx:
+   *
+   * Ask the senders to retransmit the packets that are still missing when
+   * the jitterbuffer expects them, with RTCP NACKs as in RFC 4585, and
+   * merge the RFC 4588 retransmissions, which arrive on the RTP port with
+   * an SSRC of their own, back into the stream. A packet is only waited
+   * for as long as the latency allows, so the latency should cover the
+   * round trip to the sender. Not available in the low-latency mode,
+   * which has no jitterbuffer. The payload types of #GstRtpSrc:rtx-pt-map
+   * are added to #GstRtpSrc:filter-pts when that is set, and are not
+   * checked against #GstRtpSrc:filter-ssrcs.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_RTX,
+      g_param_spec_boolean ("rtx", "RTX",
+          "Request lost packets with NACKs and receive the retransmissions",
+          DEFAULT_PROP_RTX, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSrc:rtx-pt-map:
+   *
+   * The payload type the retransmissions of each media payload type are
+   * sent with, as comma separated "pt:rtx-pt" pairs, like "96:97,98:99".
+   * It has to match #GstRtpSink:rtx-pt-map of the sender.
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_RTX_PT_MAP,
+      g_param_spec_string ("rtx-pt-map", "RTX payload type map",
+          "Comma separated media:retransmission payload type pairs",
+          DEFAULT_PROP_RTX_PT_MAP,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSrc:latency-histogram:
+   *
+   * The time packets spend between their arrival on the socket and being
+   * pushed out of a source pad, including the socket buffer and the
+   * jitterbuffer. Only measured with #GstRtpSrc:kernel-timestamps. This
+   * property returns a #GstStructure with name
+   * application/x-rtp-src-latency that has a field of type
+   * GST_TYPE_STRUCTURE per source pad, named after the pad. Each is an
+   * application/x-rtp-latency-histogram structure with the fields:
+   *
+   * - "count" G_TYPE_UINT64: number of packets measured
+   * - "average" G_TYPE_UINT64: average latency in nanoseconds
+   * - "max" G_TYPE_UINT64: largest latency in nanoseconds
+   * - "p50", "p90", "p99" G_TYPE_UINT64: percentiles in nanoseconds,
+   *   rounded up to the limit of their bucket
+   * - "buckets" GST_TYPE_ARRAY of G_TYPE_UINT64: number of packets below
+   *   1us, from 1us to 2us, 2us to 4us and so on
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_LATENCY_HISTOGRAM,
+      g_param_spec_boxed ("latency-histogram", "Latency histogram",
+          "Histogram of the packet latency per source pad",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpSrc:stats:
+   *
+   * Receive statistics of all sessions, counted as the packets come off
+   * the sockets. Reading them does not take any lock that the streaming
+   * threads use for every packet, so they can be polled frequently. A
+   * sender that leaves with a BYE or times out is dropped from "sources"
+   * but stays in the totals. This property returns
+   * a #GstStructure with name application/x-rtp-src-stats with the
+   * following fields:
+   *
+   * - "packets" G_TYPE_UINT64: number of RTP packets received
+   * - "bytes" G_TYPE_UINT64: number of RTP bytes received
+   * - "lost" G_TYPE_UINT64: number of packets missing from the sequence
+   * - "socket-drops" G_TYPE_UINT64: number of packets the kernel dropped
+   *   because the socket buffer was full, if the system reports it
+   * - "sources" GST_TYPE_ARRAY: an application/x-rtp-source-stats
+   *   structure per sender with the fields "session" and "ssrc" as
+   *   G_TYPE_UINT, "packets", "bytes", "lost", "reordered" and
+   *   "duplicates" as G_TYPE_UINT64, and "jitter" as G_TYPE_UINT, the
+   *   interarrival jitter in clock rate units
+   *
+   * Since: 1.16.1.2
+   */
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Receive statistics per SSRC", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_add_pad_template (gstelement_class,
+      gst_static_pad_template_get (&src_template));
+
+  gst_element_class_set_static_metadata (gstelement_class,
+      "RTP Source element",
+      "Generic/Bin/Src",
+      "Simple RTP src", "Marc Leeman <marc.leeman@gmail.com>");
+}
+
+static GstPadProbeReturn
+gst_rtp_src_on_src_data (GstPad * pad, GstPadProbeInfo * info,
+    GstRtpHistogram * histogram)
+{
+  GstRtpSrc *self = GST_RTP_SRC (GST_PAD_PARENT (pad));
+  GstReferenceTimestampMeta *meta;
+  GstClockTime now;
+  GstBuffer *buffer;
+  guint i, len = 1;
+
+  now = g_get_real_time () * GST_USECOND;
+
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST)
+    len = gst_buffer_list_length (GST_PAD_PROBE_INFO_BUFFER_LIST (info));
+
+  for (i = 0; i < len; i++) {
+    if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST)
+      buffer = gst_buffer_list_get (GST_PAD_PROBE_INFO_BUFFER_LIST (info), i);
+    else
+      buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+
+    meta = gst_buffer_get_reference_timestamp_meta (buffer,
+        self->timestamp_caps);
+    if (meta)
+      gst_rtp_histogram_add (histogram,
+          now > meta->timestamp ? now - meta->timestamp : 0);
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+gst_rtp_src_rtpbin_pad_added_cb (GstElement * element, GstPad * pad,
+    gpointer data)
+{
+  GstRtpSrc *self = GST_RTP_SRC (data);
+  GstCaps *caps = gst_pad_query_caps (pad, NULL);
+  GstPad *upad;
+  gchar name[48];
+
+  /* Expose RTP data pad only */
+  GST_INFO_OBJECT (self,
+      "Element %" GST_PTR_FORMAT " added pad %" GST_PTR_FORMAT "with caps %"
+      GST_PTR_FORMAT ".", element, pad, caps);
+
+  /* Sanity checks */
+  if (GST_PAD_DIRECTION (pad) == GST_PAD_SINK) {
+    /* Sink pad, do not expose */
+    gst_caps_unref (caps);
+    return;
+  }
+
+  if (G_LIKELY (caps)) {
+    GstCaps *ref_caps = gst_caps_new_empty_simple ("application/x-rtcp");
+
+    if (gst_caps_can_intersect (caps, ref_caps)) {
+      /* SRC RTCP caps, do not expose */
+      gst_caps_unref (ref_caps);
+      gst_caps_unref (caps);
+
+      return;
+    }
+    gst_caps_unref (ref_caps);
+  } else {
+    GST_ERROR_OBJECT (self, "Pad with no caps detected.");
+    gst_caps_unref (caps);
+
+    return;
   }
   gst_caps_unref (caps);
 
@@ -461,6 +1642,16 @@ gst_rtp_src_rtpbin_pad_added_cb (GstElement * element, GstPad * pad,
   g_snprintf (name, 48, "src_%u", GST_ELEMENT (self)->numpads);
   upad = gst_ghost_pad_new (name, pad);
 
+  if (self->kernel_timestamps) {
+    GstRtpHistogram *histogram = gst_rtp_histogram_new ();
+
+    g_object_set_data_full (G_OBJECT (upad), LATENCY_HISTOGRAM_KEY,
+        histogram, (GDestroyNotify) gst_rtp_histogram_free);
+    gst_pad_add_probe (upad,
+        GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+        (GstPadProbeCallback) gst_rtp_src_on_src_data, histogram, NULL);
+  }
+
   gst_pad_set_active (upad, TRUE);
   gst_element_add_pad (GST_ELEMENT (self), upad);
 
@@ -477,157 +1668,1393 @@ gst_rtp_src_rtpbin_pad_removed_cb (GstElement * element, GstPad * pad,
       pad);
 }
 
-static void
-gst_rtp_src_rtpbin_on_ssrc_collision_cb (GstElement * rtpbin, guint session_id,
-    guint ssrc, gpointer data)
+static void
+gst_rtp_src_rtpbin_on_ssrc_collision_cb (GstElement * rtpbin, guint session_id,
+    guint ssrc, gpointer data)
+{
+  GstRtpSrc *self = GST_RTP_SRC (data);
+
+  GST_INFO_OBJECT (self,
+      "Dectected an SSRC collision: session-id 0x%x, ssrc 0x%x.", session_id,
+      ssrc);
+}
+
+static void
+gst_rtp_src_rtpbin_on_new_ssrc_cb (GstElement * rtpbin, guint session_id,
+    guint ssrc, gpointer data)
+{
+  GstRtpSrc *self = GST_RTP_SRC (data);
+
+  GST_INFO_OBJECT (self, "Dectected a new SSRC: session-id 0x%x, ssrc 0x%x.",
+      session_id, ssrc);
+}
+
+static void
+gst_rtp_src_rtpbin_on_ssrc_leave_cb (GstElement * rtpbin, guint session_id,
+    guint ssrc, gpointer data)
+{
+  GstRtpSrc *self = GST_RTP_SRC (data);
+  GstRtpSrcSession *session;
+
+  if (session_id >= self->sessions->len)
+    return;
+
+  session = g_ptr_array_index (self->sessions, session_id);
+  GST_DEBUG_OBJECT (self, "Forgetting the RTCP address and statistics of "
+      "ssrc 0x%x in session %u.", ssrc, session_id);
+  gst_rtp_addr_table_remove (session->rtcp_addrs, ssrc);
+  gst_rtp_stats_remove_source (self->stats, session_id, ssrc);
+}
+
+/* Remember where the RTCP of each sender comes from, the table only
+ * changes when a sender appears or moves. */
+static void
+gst_rtp_src_learn_rtcp_address (GstRtpSrcSession * session,
+    GstBuffer * buffer)
+{
+  GstRTCPBuffer rtcp = GST_RTCP_BUFFER_INIT;
+  GstRTCPPacket packet;
+  GstNetAddressMeta *meta;
+  guint32 ssrc;
+  gboolean have_ssrc = FALSE;
+
+  meta = gst_buffer_get_net_address_meta (buffer);
+  if (meta == NULL)
+    return;
+
+  if (!gst_rtcp_buffer_map (buffer, GST_MAP_READ, &rtcp))
+    return;
+
+  if (gst_rtcp_buffer_get_first_packet (&rtcp, &packet)) {
+    switch (gst_rtcp_packet_get_type (&packet)) {
+      case GST_RTCP_TYPE_SR:
+        gst_rtcp_packet_sr_get_sender_info (&packet, &ssrc, NULL, NULL, NULL,
+            NULL);
+        have_ssrc = TRUE;
+        break;
+      case GST_RTCP_TYPE_RR:
+        ssrc = gst_rtcp_packet_rr_get_ssrc (&packet);
+        have_ssrc = TRUE;
+        break;
+      default:
+        break;
+    }
+  }
+  gst_rtcp_buffer_unmap (&rtcp);
+
+  if (have_ssrc)
+    gst_rtp_addr_table_update (session->rtcp_addrs, ssrc, meta->addr);
+}
+
+static GstPadProbeReturn
+gst_rtp_src_on_recv_rtcp (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  GstRtpSrcSession *session = user_data;
+
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    GstBufferList *buffer_list = info->data;
+    guint i;
+
+    for (i = 0; i < gst_buffer_list_length (buffer_list); i++)
+      gst_rtp_src_learn_rtcp_address (session,
+          gst_buffer_list_get (buffer_list, i));
+  } else {
+    gst_rtp_src_learn_rtcp_address (session, info->data);
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+#define MAX_REPORT_ADDRESSES 32
+
+/* Add the return address of the sender @ssrc to @addrs, or the fallback
+ * address when @ssrc is unknown, unless there is none or it is already
+ * there */
+static guint
+gst_rtp_src_add_report_address (GstRtpSrcSession * session, guint32 ssrc,
+    GSocketAddress ** addrs, guint n_addrs)
+{
+  GSocketAddress *addr;
+  guint i;
+
+  if (n_addrs == MAX_REPORT_ADDRESSES)
+    return n_addrs;
+
+  addr = gst_rtp_addr_table_lookup (session->rtcp_addrs, ssrc);
+  if (addr == NULL)
+    return n_addrs;
+
+  for (i = 0; i < n_addrs; i++) {
+    if (gst_rtp_utils_socket_address_equal (addrs[i], addr)) {
+      g_object_unref (addr);
+      return n_addrs;
+    }
+  }
+  addrs[n_addrs] = addr;
+
+  return n_addrs + 1;
+}
+
+/* Collect the return addresses of the senders the report blocks and the
+ * NACKs in @buffer are about, without duplicates. */
+static guint
+gst_rtp_src_get_report_addresses (GstRtpSrcSession * session,
+    GstBuffer * buffer, GSocketAddress ** addrs)
+{
+  GstRTCPBuffer rtcp = GST_RTCP_BUFFER_INIT;
+  GstRTCPPacket packet;
+  gboolean more;
+  guint n_addrs = 0;
+
+  if (!gst_rtcp_buffer_map (buffer, GST_MAP_READ, &rtcp))
+    return 0;
+
+  for (more = gst_rtcp_buffer_get_first_packet (&rtcp, &packet); more;
+      more = gst_rtcp_packet_move_to_next (&packet)) {
+    GstRTCPType type = gst_rtcp_packet_get_type (&packet);
+    guint i, count;
+
+    if (type == GST_RTCP_TYPE_RTPFB) {
+      n_addrs = gst_rtp_src_add_report_address (session,
+          gst_rtcp_packet_fb_get_media_ssrc (&packet), addrs, n_addrs);
+      continue;
+    }
+
+    if (type != GST_RTCP_TYPE_SR && type != GST_RTCP_TYPE_RR)
+      continue;
+
+    count = gst_rtcp_packet_get_rb_count (&packet);
+    for (i = 0; i < count; i++) {
+      guint32 ssrc;
+
+      gst_rtcp_packet_get_rb (&packet, i, &ssrc, NULL, NULL, NULL, NULL,
+          NULL, NULL);
+      n_addrs = gst_rtp_src_add_report_address (session, ssrc, addrs,
+          n_addrs);
+    }
+  }
+  gst_rtcp_buffer_unmap (&rtcp);
+
+  return n_addrs;
+}
+
+/* Address the writable @buffer to the sender it reports on. When a
+ * compound packet reports on senders at different addresses, a copy is
+ * sent to each of the other senders directly on the shared RTCP socket.
+ * Packets without report blocks go to the fallback address. */
+static void
+gst_rtp_src_address_rtcp (GstRtpSrcSession * session, GstBuffer * buffer)
+{
+  GSocketAddress *addrs[MAX_REPORT_ADDRESSES];
+  guint n_addrs, i;
+
+  n_addrs = gst_rtp_src_get_report_addresses (session, buffer, addrs);
+  if (n_addrs == 0) {
+    addrs[0] = gst_rtp_addr_table_get_fallback (session->rtcp_addrs);
+    if (addrs[0] == NULL)
+      return;
+    n_addrs = 1;
+  }
+
+  if (n_addrs > 1 && session->rtcp_socket) {
+    GstMapInfo map;
+
+    if (gst_buffer_map (buffer, &map, GST_MAP_READ)) {
+      for (i = 1; i < n_addrs; i++) {
+        GError *error = NULL;
+
+        if (g_socket_send_to (session->rtcp_socket, addrs[i],
+                (const gchar *) map.data, map.size, NULL, &error) < 0) {
+          GST_WARNING_OBJECT (session->src, "Could not send RTCP: %s",
+              error->message);
+          g_clear_error (&error);
+        }
+      }
+      gst_buffer_unmap (buffer, &map);
+    }
+  }
+
+  gst_buffer_add_net_address_meta (buffer, addrs[0]);
+
+  for (i = 0; i < n_addrs; i++)
+    g_object_unref (addrs[i]);
+}
+
+static GstPadProbeReturn
+gst_rtp_src_on_send_rtcp (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  GstRtpSrcSession *session = user_data;
+
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    GstBufferList *buffer_list = info->data;
+    guint i;
+
+    info->data = buffer_list = gst_buffer_list_make_writable (buffer_list);
+    for (i = 0; i < gst_buffer_list_length (buffer_list); i++)
+      gst_rtp_src_address_rtcp (session,
+          gst_buffer_list_get_writable (buffer_list, i));
+  } else {
+    info->data = gst_buffer_make_writable (info->data);
+    gst_rtp_src_address_rtcp (session, info->data);
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+static GstRtpSrcSession *
+gst_rtp_src_session_new (GstRtpSrc * self, const gchar * host, guint port)
+{
+  GstRtpSrcSession *session = g_slice_new0 (GstRtpSrcSession);
+
+  session->src = self;
+  session->id = self->sessions->len;
+  session->host = g_strdup (host);
+  session->port = port;
+  session->rtcp_addrs = gst_rtp_addr_table_new ();
+
+  g_ptr_array_add (self->sessions, session);
+
+  return session;
+}
+
+static void
+gst_rtp_src_session_free (GstRtpSrcSession * session)
+{
+  g_clear_object (&session->rtcp_socket);
+  gst_rtp_addr_table_free (session->rtcp_addrs);
+  g_free (session->host);
+  g_slice_free (GstRtpSrcSession, session);
+}
+
+static const gchar *
+gst_rtp_src_session_get_host (GstRtpSrcSession * session)
+{
+  if (session->host)
+    return session->host;
+
+  return gst_uri_get_host (session->src->uri);
+}
+
+static guint
+gst_rtp_src_session_get_port (GstRtpSrcSession * session)
+{
+  if (session->id == 0)
+    return gst_uri_get_port (session->src->uri);
+
+  return session->port;
+}
+
+/* Create the RTCP udpsrc and dynudpsink of @session, returns the name of
+ * the missing plugin on failure. */
+static const gchar *
+gst_rtp_src_session_setup_rtcp (GstRtpSrcSession * session)
+{
+  GstRtpSrc *self = session->src;
+
+  session->rtcp_src = gst_element_factory_make ("udpsrc", NULL);
+  if (session->rtcp_src == NULL)
+    return "udp";
+
+  session->rtcp_sink = gst_element_factory_make ("dynudpsink", NULL);
+  if (session->rtcp_sink == NULL) {
+    gst_object_unref (session->rtcp_src);
+    session->rtcp_src = NULL;
+    return "udp";
+  }
+
+  /* Add elements as needed, since udpsrc/udpsink for RTCP share a socket,
+   * not all at the same moment */
+  gst_bin_add (GST_BIN (self), session->rtcp_src);
+  gst_bin_add (GST_BIN (self), session->rtcp_sink);
+
+  g_object_set (session->rtcp_sink, "sync", FALSE, "async", FALSE, NULL);
+  gst_element_set_locked_state (session->rtcp_sink, TRUE);
+
+  return NULL;
+}
+
+/* The element that handles the RTP and RTCP of @session and the name of
+ * its pad @pad: the pads of rtpbin are numbered by session, the ones of
+ * the rtpsession of the low-latency mode are not. */
+static GstElement *
+gst_rtp_src_session_get_manager (GstRtpSrcSession * session,
+    const gchar * pad, gchar * name, gsize size)
+{
+  if (session->rtpsession) {
+    g_strlcpy (name, pad, size);
+    return session->rtpsession;
+  }
+
+  g_snprintf (name, size, "%s_%u", pad, session->id);
+  return session->src->rtpbin;
+}
+
+static GstCaps *
+gst_rtp_src_session_request_pt_map_cb (GstElement * rtpsession, guint pt,
+    GstRtpSrcSession * session)
+{
+  return gst_rtp_src_rtpbin_request_pt_map_cb (NULL, session->id, pt,
+      session->src);
+}
+
+static void
+gst_rtp_src_session_on_new_ssrc_cb (GstElement * rtpsession, guint ssrc,
+    GstRtpSrcSession * session)
+{
+  gst_rtp_src_rtpbin_on_new_ssrc_cb (NULL, session->id, ssrc, session->src);
+}
+
+static void
+gst_rtp_src_session_on_ssrc_leave_cb (GstElement * rtpsession, guint ssrc,
+    GstRtpSrcSession * session)
+{
+  gst_rtp_src_rtpbin_on_ssrc_leave_cb (NULL, session->id, ssrc,
+      session->src);
+}
+
+/* In the low-latency mode @session gets its own rtpsession and
+ * rtpssrcdemux instead of a session on rtpbin. Both push on the thread
+ * that calls them, so the packets leave on the receive thread. */
+static gboolean
+gst_rtp_src_session_setup_low_latency (GstRtpSrcSession * session)
+{
+  GstRtpSrc *self = session->src;
+
+  session->rtpsession = gst_element_factory_make ("rtpsession", NULL);
+  session->demux = gst_element_factory_make ("rtpssrcdemux", NULL);
+  if (session->rtpsession == NULL || session->demux == NULL)
+    goto missing_plugin;
+
+  g_signal_connect (session->rtpsession, "request-pt-map",
+      G_CALLBACK (gst_rtp_src_session_request_pt_map_cb), session);
+  g_signal_connect (session->rtpsession, "on-new-ssrc",
+      G_CALLBACK (gst_rtp_src_session_on_new_ssrc_cb), session);
+  g_signal_connect (session->rtpsession, "on-bye-ssrc",
+      G_CALLBACK (gst_rtp_src_session_on_ssrc_leave_cb), session);
+  g_signal_connect (session->rtpsession, "on-timeout",
+      G_CALLBACK (gst_rtp_src_session_on_ssrc_leave_cb), session);
+  g_signal_connect (session->demux, "pad-added",
+      G_CALLBACK (gst_rtp_src_rtpbin_pad_added_cb), self);
+
+  gst_bin_add (GST_BIN (self), session->rtpsession);
+  gst_bin_add (GST_BIN (self), session->demux);
+
+  return TRUE;
+
+missing_plugin:
+  {
+    GST_ELEMENT_ERROR (self, CORE, MISSING_PLUGIN, (NULL),
+        ("'%s' plugin is missing.", "rtpmanager"));
+    g_clear_object (&session->rtpsession);
+    g_clear_object (&session->demux);
+    return FALSE;
+  }
+}
+
+/* Link the RTCP elements of @session to the element that manages it,
+ * which is created first in the low-latency mode. */
+static gboolean
+gst_rtp_src_session_setup_manager (GstRtpSrcSession * session)
+{
+  GstRtpSrc *self = session->src;
+  GstElement *manager;
+  gchar name[48];
+
+  if (self->mode == GST_RTP_SRC_MODE_LOW_LATENCY
+      && !gst_rtp_src_session_setup_low_latency (session))
+    return FALSE;
+
+  manager = gst_rtp_src_session_get_manager (session, "recv_rtcp_sink",
+      name, sizeof (name));
+  gst_element_link_pads (session->rtcp_src, "src", manager, name);
+  manager = gst_rtp_src_session_get_manager (session, "send_rtcp_src",
+      name, sizeof (name));
+  gst_element_link_pads (manager, name, session->rtcp_sink, "sink");
+
+  return TRUE;
+}
+
+static GstPadProbeReturn
+gst_rtp_src_on_recv_rtp (GstPad * pad, GstPadProbeInfo * info,
+    GstRtpSrcSession * session)
+{
+  GstRtpStats *stats = session->src->stats;
+
+  if (info->type & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+    GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+    GstCaps *caps;
+    GSocket *socket = NULL;
+    gint clock_rate;
+
+    switch (GST_EVENT_TYPE (event)) {
+      case GST_EVENT_STREAM_START:
+        /* The socket is opened by now */
+        g_object_get (session->rtp_src, "used-socket", &socket, NULL);
+        gst_rtp_stats_set_socket (stats, session->id, socket);
+        g_clear_object (&socket);
+        break;
+      case GST_EVENT_CAPS:
+        gst_event_parse_caps (event, &caps);
+        if (gst_structure_get_int (gst_caps_get_structure (caps, 0),
+                "clock-rate", &clock_rate))
+          session->clock_rate = clock_rate;
+        break;
+      default:
+        break;
+    }
+  } else if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST (info);
+    guint i, len = gst_buffer_list_length (list);
+
+    for (i = 0; i < len; i++)
+      gst_rtp_stats_add_buffer (stats, session->id,
+          gst_buffer_list_get (list, i), session->clock_rate);
+  } else {
+    gst_rtp_stats_add_buffer (stats, session->id,
+        GST_PAD_PROBE_INFO_BUFFER (info), session->clock_rate);
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* Receive buffer size for the expected bitrate */
+static gint
+gst_rtp_src_get_buffer_size (GstRtpSrc * self)
+{
+  guint64 size;
+
+  size = gst_util_uint64_scale (self->expected_bitrate,
+      MAX (self->latency, BUFFER_SIZE_MIN_TIME) * BUFFER_SIZE_OVERHEAD,
+      8 * 1000);
+
+  return MIN (size, G_MAXINT / BUFFER_SIZE_GROWTH);
+}
+
+/* Create the FEC decoder of @session and the udpsrc of the column and row
+ * FEC streams, which are received like RTCP on the multicast group or on
+ * any address. */
+static gboolean
+gst_rtp_src_session_setup_fec (GstRtpSrcSession * session)
+{
+  static const guint offsets[] = { FEC_COLUMN_PORT_OFFSET,
+    FEC_ROW_PORT_OFFSET
+  };
+  GstRtpSrc *self = session->src;
+  GInetAddress *addr;
+  gboolean multicast;
+  gchar name[16];
+  guint i;
+
+  session->fec_dec = gst_element_factory_make ("nrtp_fecdec", NULL);
+  if (session->fec_dec == NULL)
+    goto missing_plugin;
+  gst_bin_add (GST_BIN (self), session->fec_dec);
+
+  /* The retransmissions are not part of the protected stream */
+  if (self->rtx_pt_map_structure) {
+    gchar *rtx_pts = gst_rtp_utils_get_rtx_pts (self->rtx_pt_map_structure);
+
+    g_object_set (session->fec_dec, "ignore-pts", rtx_pts, NULL);
+    g_free (rtx_pts);
+  }
+
+  addr = g_inet_address_new_from_string (gst_rtp_src_session_get_host
+      (session));
+  multicast = addr && g_inet_address_get_is_multicast (addr);
+  g_clear_object (&addr);
+
+  for (i = 0; i < G_N_ELEMENTS (offsets); i++) {
+    session->fec_src[i] = gst_element_factory_make ("udpsrc", NULL);
+    if (session->fec_src[i] == NULL)
+      goto missing_plugin;
+
+    if (multicast)
+      g_object_set (session->fec_src[i], "address",
+          gst_rtp_src_session_get_host (session), NULL);
+    g_object_set (session->fec_src[i], "port",
+        gst_rtp_src_session_get_port (session) + offsets[i], NULL);
+
+    gst_bin_add (GST_BIN (self), session->fec_src[i]);
+    g_snprintf (name, sizeof (name), "fec_%u", i);
+    gst_element_link_pads (session->fec_src[i], "src", session->fec_dec,
+        name);
+  }
+
+  return TRUE;
+
+missing_plugin:
+  {
+    GST_ELEMENT_ERROR (self, CORE, MISSING_PLUGIN, (NULL),
+        ("%s", "No element available to receive FEC"));
+    return FALSE;
+  }
+}
+
+/* The element that receives the RTP data depends on the batch-size,
+ * pool-size, receive-threads, socket, spin-time and expected-bitrate
+ * properties, so it is only created when going to READY. */
+static gboolean
+gst_rtp_src_session_setup_rtp_src (GstRtpSrcSession * session)
+{
+  GstRtpSrc *self = session->src;
+  GstRtpSocketOptions socket_options = self->socket_options;
+  gint max_buffer_size = 0;
+  GstElement *manager, *upstream;
+  GstCaps *caps = NULL;
+  GstPad *pad;
+  gchar name[48];
+  gboolean io_uring = FALSE;
+
+  if (self->io_uring) {
+    io_uring = gst_rtp_uring_is_supported ();
+    if (!io_uring)
+      GST_WARNING_OBJECT (self, "io_uring is not supported, receiving the "
+          "RTP data without it");
+  }
+
+  if (self->batch_size > 1 || self->pool_size > 0
+      || self->receive_threads > 1 || self->kernel_timestamps || io_uring
+      || gst_rtp_socket_options_is_set (&self->socket_options)
+      || self->spin_time > 0 || self->expected_bitrate > 0) {
+    session->rtp_src = gst_element_factory_make ("nrtp_recvsrc", NULL);
+    if (session->rtp_src) {
+      GstStructure *options;
+
+      if (self->expected_bitrate > 0) {
+        if (socket_options.buffer_size < 0)
+          socket_options.buffer_size = gst_rtp_src_get_buffer_size (self);
+        max_buffer_size = MIN ((gint64) socket_options.buffer_size *
+            BUFFER_SIZE_GROWTH, G_MAXINT);
+        GST_DEBUG_OBJECT (self, "Receive buffer of %d bytes for %"
+            G_GUINT64_FORMAT " bits/s", socket_options.buffer_size,
+            self->expected_bitrate);
+      }
+      options = gst_rtp_socket_options_to_structure (&socket_options);
+
+      g_object_set (session->rtp_src, "batch-size", self->batch_size,
+          "pool-size", self->pool_size, "mtu", self->mtu,
+          "n-threads", self->receive_threads,
+          "timestamping", self->kernel_timestamps,
+          "socket-filter", self->rtp_filter, "io-uring", io_uring,
+          "socket-options", options, "spin-time", self->spin_time,
+          "detect-overflows", self->expected_bitrate > 0,
+          "max-buffer-size", max_buffer_size, NULL);
+      gst_structure_free (options);
+    }
+  } else {
+    session->rtp_src = gst_element_factory_make ("udpsrc", NULL);
+  }
+
+  if (session->rtp_src == NULL) {
+    GST_ELEMENT_ERROR (self, CORE, MISSING_PLUGIN, (NULL),
+        ("%s", "No element available to receive RTP data"));
+    return FALSE;
+  }
+
+  g_object_set (session->rtp_src,
+      "address", gst_rtp_src_session_get_host (session),
+      "port", gst_rtp_src_session_get_port (session), NULL);
+
+  if (self->encoding_name != NULL)
+    caps = gst_rtp_src_rtpbin_request_pt_map_cb (NULL, session->id, 96, self);
+  if (caps) {
+    g_object_set (session->rtp_src, "caps", caps, NULL);
+    gst_caps_unref (caps);
+  }
+
+  pad = gst_element_get_static_pad (session->rtp_src, "src");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER |
+      GST_PAD_PROBE_TYPE_BUFFER_LIST | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      (GstPadProbeCallback) gst_rtp_src_on_recv_rtp, session, NULL);
+  gst_object_unref (pad);
+
+  gst_bin_add (GST_BIN (self), session->rtp_src);
+  upstream = session->rtp_src;
+
+  /* Lost packets are recovered before the jitterbuffer */
+  if (self->fec) {
+    if (!gst_rtp_src_session_setup_fec (session))
+      return FALSE;
+    gst_element_link_pads (session->rtp_src, "src", session->fec_dec,
+        "sink");
+    upstream = session->fec_dec;
+  }
+
+  manager = gst_rtp_src_session_get_manager (session, "recv_rtp_sink",
+      name, sizeof (name));
+  gst_element_link_pads (upstream, "src", manager, name);
+
+  /* rtpsession only has its source pad once the sink pad is requested */
+  if (session->demux)
+    gst_element_link_pads (session->rtpsession, "recv_rtp_src",
+        session->demux, "sink");
+
+  return TRUE;
+}
+
+static void
+gst_rtp_src_release_rtpbin_pad (GstRtpSrc * self, const gchar * format,
+    guint id)
+{
+  GstPad *pad;
+  gchar name[48];
+
+  if (self->rtpbin == NULL)
+    return;
+
+  g_snprintf (name, 48, format, id);
+  pad = gst_element_get_static_pad (self->rtpbin, name);
+  if (pad == NULL)
+    return;
+
+  gst_element_release_request_pad (self->rtpbin, pad);
+  gst_object_unref (pad);
+}
+
+static void
+gst_rtp_src_session_teardown (GstRtpSrcSession * session)
+{
+  GstRtpSrc *self = session->src;
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (session->fec_src); i++) {
+    if (session->fec_src[i]) {
+      gst_element_set_state (session->fec_src[i], GST_STATE_NULL);
+      gst_bin_remove (GST_BIN (self), session->fec_src[i]);
+      session->fec_src[i] = NULL;
+    }
+  }
+  if (session->fec_dec) {
+    gst_element_set_state (session->fec_dec, GST_STATE_NULL);
+    gst_bin_remove (GST_BIN (self), session->fec_dec);
+    session->fec_dec = NULL;
+  }
+
+  if (session->rtp_src) {
+    gst_element_set_state (session->rtp_src, GST_STATE_NULL);
+    gst_bin_remove (GST_BIN (self), session->rtp_src);
+    session->rtp_src = NULL;
+  }
+  gst_rtp_stats_set_socket (self->stats, session->id, NULL);
+
+  if (session->rtpsession) {
+    gst_element_set_state (session->rtpsession, GST_STATE_NULL);
+    gst_bin_remove (GST_BIN (self), session->rtpsession);
+    session->rtpsession = NULL;
+  }
+  if (session->demux) {
+    gst_element_set_state (session->demux, GST_STATE_NULL);
+    gst_bin_remove (GST_BIN (self), session->demux);
+    session->demux = NULL;
+  }
+
+  gst_rtp_src_release_rtpbin_pad (self, "recv_rtp_sink_%u", session->id);
+  gst_rtp_src_release_rtpbin_pad (self, "recv_rtcp_sink_%u", session->id);
+  gst_rtp_src_release_rtpbin_pad (self, "send_rtcp_src_%u", session->id);
+
+  if (session->rtcp_src) {
+    gst_element_set_state (session->rtcp_src, GST_STATE_NULL);
+    gst_bin_remove (GST_BIN (self), session->rtcp_src);
+    session->rtcp_src = NULL;
+  }
+  if (session->rtcp_sink) {
+    gst_element_set_locked_state (session->rtcp_sink, FALSE);
+    gst_element_set_state (session->rtcp_sink, GST_STATE_NULL);
+    gst_bin_remove (GST_BIN (self), session->rtcp_sink);
+    session->rtcp_sink = NULL;
+  }
+}
+
+/* Build the socket filters of filter-ssrcs and filter-pts, which all
+ * sessions attach to their sockets */
+static gboolean
+gst_rtp_src_setup_filters (GstRtpSrc * self)
+{
+  GArray *ssrcs = NULL, *pts = NULL, *rtx_pts = NULL;
+  gchar *filter_pts = NULL;
+
+  if (!self->kernel_filter)
+    return TRUE;
+
+  if (self->filter_ssrcs) {
+    ssrcs = gst_rtp_filter_parse_list (self->filter_ssrcs, G_MAXUINT32);
+    if (ssrcs == NULL)
+      goto invalid_ssrcs;
+  }
+
+  if (self->filter_pts) {
+    pts = gst_rtp_filter_parse_list (self->filter_pts, 127);
+    if (pts == NULL)
+      goto invalid_pts;
+  }
+
+  /* Let the retransmissions of the filtered payload types through too.
+   * The sender picks a random SSRC for them, so they skip filter-ssrcs. */
+  if (self->rtx_pt_map_structure) {
+    gchar *rtx_pt_list =
+        gst_rtp_utils_get_rtx_pts (self->rtx_pt_map_structure);
+
+    rtx_pts = gst_rtp_filter_parse_list (rtx_pt_list, 127);
+    if (pts) {
+      filter_pts = g_strdup_printf ("%s,%s", self->filter_pts, rtx_pt_list);
+      g_array_unref (pts);
+      pts = gst_rtp_filter_parse_list (filter_pts, 127);
+      g_free (filter_pts);
+    }
+    g_free (rtx_pt_list);
+    if (pts == NULL && self->filter_pts)
+      goto invalid_pts;
+  }
+
+  self->rtp_filter = gst_rtp_filter_new (FALSE, ssrcs, pts, rtx_pts);
+  self->rtcp_filter = gst_rtp_filter_new (TRUE, ssrcs, pts, NULL);
+  if (self->rtp_filter == NULL)
+    GST_WARNING_OBJECT (self, "Socket filters are not supported");
+
+  if (ssrcs)
+    g_array_unref (ssrcs);
+  if (pts)
+    g_array_unref (pts);
+  if (rtx_pts)
+    g_array_unref (rtx_pts);
+
+  return TRUE;
+
+invalid_ssrcs:
+  {
+    GST_ELEMENT_ERROR (self, RESOURCE, SETTINGS, (NULL),
+        ("Invalid filter-ssrcs '%s'", self->filter_ssrcs));
+    return FALSE;
+  }
+invalid_pts:
+  {
+    GST_ELEMENT_ERROR (self, RESOURCE, SETTINGS, (NULL),
+        ("Invalid filter-pts '%s'", self->filter_pts));
+    if (ssrcs)
+      g_array_unref (ssrcs);
+    if (rtx_pts)
+      g_array_unref (rtx_pts);
+    return FALSE;
+  }
+}
+
+static gboolean
+gst_rtp_src_setup_threads (GstRtpSrc * self)
+{
+  GArray *cpus = NULL;
+
+  if (self->cpu_affinity && self->cpu_affinity[0] != '\0') {
+    cpus = gst_rtp_thread_parse_cpus (self->cpu_affinity);
+    if (cpus == NULL)
+      goto invalid_cpus;
+  }
+
+  GST_OBJECT_LOCK (self);
+  g_clear_pointer (&self->cpus, g_array_unref);
+  self->cpus = cpus;
+  GST_OBJECT_UNLOCK (self);
+
+  return TRUE;
+
+invalid_cpus:
+  {
+    GST_ELEMENT_ERROR (self, RESOURCE, SETTINGS, (NULL),
+        ("Invalid cpu-affinity '%s'", self->cpu_affinity));
+    return FALSE;
+  }
+}
+
+/* Stream-status messages are handled in the thread they are about, so a
+ * thread entering its loop is tuned right there */
+static void
+gst_rtp_src_tune_thread (GstRtpSrc * self, GstMessage * message)
+{
+  GstStreamStatusType type;
+  GArray *cpus = NULL;
+  gint priority;
+
+  gst_message_parse_stream_status (message, &type, NULL);
+  if (type != GST_STREAM_STATUS_TYPE_ENTER)
+    return;
+
+  GST_OBJECT_LOCK (self);
+  if (self->cpus)
+    cpus = g_array_ref (self->cpus);
+  priority = self->realtime_priority;
+  GST_OBJECT_UNLOCK (self);
+
+  if (cpus || priority > 0)
+    gst_rtp_thread_tune (GST_MESSAGE_SRC (message), cpus, priority);
+
+  if (cpus)
+    g_array_unref (cpus);
+}
+
+static void
+gst_rtp_src_handle_message (GstBin * bin, GstMessage * message)
+{
+  GstRtpSrc *self = GST_RTP_SRC (bin);
+
+  if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_STREAM_STATUS)
+    gst_rtp_src_tune_thread (self, message);
+
+  GST_BIN_CLASS (parent_class)->handle_message (bin, message);
+}
+
+static void
+gst_rtp_src_attach_filter (GstRtpSrc * self, GstElement * element,
+    GBytes * filter)
+{
+  GSocket *socket = NULL;
+  GError *error = NULL;
+
+  g_object_get (element, "used-socket", &socket, NULL);
+  if (socket == NULL)
+    return;
+
+  if (!gst_rtp_filter_attach (socket, filter, &error)) {
+    GST_WARNING_OBJECT (self, "%s", error->message);
+    g_clear_error (&error);
+  }
+  g_object_unref (socket);
+}
+
+/* Create the elements of @session and link them */
+static gboolean
+gst_rtp_src_session_setup (GstRtpSrcSession * session)
 {
-  GstRtpSrc *self = GST_RTP_SRC (data);
+  GstRtpSrc *self = session->src;
+  const gchar *missing_plugin;
+  GInetAddress *addr;
 
-  GST_INFO_OBJECT (self,
-      "Dectected an SSRC collision: session-id 0x%x, ssrc 0x%x.", session_id,
-      ssrc);
+  missing_plugin = gst_rtp_src_session_setup_rtcp (session);
+  if (missing_plugin) {
+    GST_ELEMENT_ERROR (self, CORE, MISSING_PLUGIN, (NULL),
+        ("'%s' plugin is missing.", missing_plugin));
+    return FALSE;
+  }
+
+  addr = g_inet_address_new_from_string (gst_rtp_src_session_get_host
+      (session));
+  if (addr && g_inet_address_get_is_multicast (addr))
+    g_object_set (session->rtcp_src, "address",
+        gst_rtp_src_session_get_host (session), NULL);
+  g_clear_object (&addr);
+  g_object_set (session->rtcp_src, "port",
+      gst_rtp_src_session_get_port (session) + 1, NULL);
+
+  if (!gst_rtp_src_session_setup_manager (session))
+    return FALSE;
+
+  return gst_rtp_src_session_setup_rtp_src (session);
 }
 
-static void
-gst_rtp_src_rtpbin_on_new_ssrc_cb (GstElement * rtpbin, guint session_id,
-    guint ssrc, gpointer data)
+/* Parse the rtx-pt-map when retransmissions are requested, which needs
+ * the jitterbuffer of rtpbin to know when to ask for a packet */
+static gboolean
+gst_rtp_src_setup_rtx (GstRtpSrc * self)
 {
-  GstRtpSrc *self = GST_RTP_SRC (data);
+  if (!self->rtx)
+    return TRUE;
 
-  GST_INFO_OBJECT (self, "Dectected a new SSRC: session-id 0x%x, ssrc 0x%x.",
-      session_id, ssrc);
+  if (self->mode == GST_RTP_SRC_MODE_LOW_LATENCY) {
+    GST_WARNING_OBJECT (self, "No retransmissions in the low-latency mode");
+    return TRUE;
+  }
+
+  self->rtx_pt_map_structure =
+      gst_rtp_utils_parse_rtx_pt_map (self->rtx_pt_map);
+  if (self->rtx_pt_map_structure == NULL) {
+    GST_ELEMENT_ERROR (self, RESOURCE, SETTINGS, (NULL),
+        ("Invalid rtx-pt-map '%s'", GST_STR_NULL (self->rtx_pt_map)));
+    return FALSE;
+  }
+
+  return TRUE;
 }
 
-static GstPadProbeReturn
-gst_rtp_src_on_recv_rtcp (GstPad * pad, GstPadProbeInfo * info,
-    gpointer user_data)
+/* rtprtxreceive restores the original packets from the retransmissions
+ * of a session before they reach the jitterbuffer */
+static GstElement *
+gst_rtp_src_rtpbin_request_aux_receiver_cb (GstElement * rtpbin,
+    guint session_id, GstRtpSrc * self)
 {
-  GstRtpSrc *self = GST_RTP_SRC (user_data);
-  GstBuffer *buffer;
-  GstNetAddressMeta *meta;
+  GstElement *bin, *rtx_receive;
+  GstPad *pad;
+  gchar name[32];
+
+  rtx_receive = gst_element_factory_make ("rtprtxreceive", NULL);
+  if (rtx_receive == NULL) {
+    GST_ELEMENT_WARNING (self, CORE, MISSING_PLUGIN, (NULL),
+        ("'%s' plugin is missing, not receiving retransmissions.",
+            "rtpmanager"));
+    return NULL;
+  }
+  g_object_set (rtx_receive, "payload-type-map", self->rtx_pt_map_structure,
+      NULL);
 
-  if (info->type == GST_PAD_PROBE_TYPE_BUFFER_LIST) {
-    GstBufferList *buffer_list = info->data;
-    buffer = gst_buffer_list_get (buffer_list, 0);
-  } else {
-    buffer = info->data;
+  bin = gst_bin_new (NULL);
+  gst_bin_add (GST_BIN (bin), rtx_receive);
+
+  pad = gst_element_get_static_pad (rtx_receive, "sink");
+  g_snprintf (name, sizeof (name), "sink_%u", session_id);
+  gst_element_add_pad (bin, gst_ghost_pad_new (name, pad));
+  gst_object_unref (pad);
+
+  pad = gst_element_get_static_pad (rtx_receive, "src");
+  g_snprintf (name, sizeof (name), "src_%u", session_id);
+  gst_element_add_pad (bin, gst_ghost_pad_new (name, pad));
+  gst_object_unref (pad);
+
+  return bin;
+}
+
+static gboolean
+gst_rtp_src_setup_rtpbin (GstRtpSrc * self)
+{
+  self->rtpbin = gst_element_factory_make ("rtpbin", NULL);
+  if (self->rtpbin == NULL) {
+    GST_ELEMENT_ERROR (self, CORE, MISSING_PLUGIN, (NULL),
+        ("'%s' plugin is missing.", "rtpmanager"));
+    return FALSE;
   }
 
-  meta = gst_buffer_get_net_address_meta (buffer);
+  g_object_set (self->rtpbin, "latency", self->latency, NULL);
+  gst_bin_add (GST_BIN (self), self->rtpbin);
 
-  GST_OBJECT_LOCK (self);
-  g_clear_object (&self->rtcp_send_addr);
-  self->rtcp_send_addr = g_object_ref (meta->addr);
-  GST_OBJECT_UNLOCK (self);
+  if (self->rtx_pt_map_structure) {
+    g_object_set (self->rtpbin, "do-retransmission", TRUE,
+        "rtp-profile", GST_RTP_PROFILE_AVPF, NULL);
+    g_signal_connect (self->rtpbin, "request-aux-receiver",
+        G_CALLBACK (gst_rtp_src_rtpbin_request_aux_receiver_cb), self);
+  }
 
-  return GST_PAD_PROBE_OK;
+  /* Add rtpbin callbacks to monitor the operation of rtpbin */
+  g_signal_connect (self->rtpbin, "pad-added",
+      G_CALLBACK (gst_rtp_src_rtpbin_pad_added_cb), self);
+  g_signal_connect (self->rtpbin, "pad-removed",
+      G_CALLBACK (gst_rtp_src_rtpbin_pad_removed_cb), self);
+  g_signal_connect (self->rtpbin, "request-pt-map",
+      G_CALLBACK (gst_rtp_src_rtpbin_request_pt_map_cb), self);
+  g_signal_connect (self->rtpbin, "on-new-ssrc",
+      G_CALLBACK (gst_rtp_src_rtpbin_on_new_ssrc_cb), self);
+  g_signal_connect (self->rtpbin, "on-ssrc-collision",
+      G_CALLBACK (gst_rtp_src_rtpbin_on_ssrc_collision_cb), self);
+  g_signal_connect (self->rtpbin, "on-bye-ssrc",
+      G_CALLBACK (gst_rtp_src_rtpbin_on_ssrc_leave_cb), self);
+  g_signal_connect (self->rtpbin, "on-timeout",
+      G_CALLBACK (gst_rtp_src_rtpbin_on_ssrc_leave_cb), self);
+
+  return TRUE;
 }
 
-static inline void
-gst_rtp_src_attach_net_address_meta (GstRtpSrc * self, GstBuffer * buffer)
+/* The whole graph is only built when going to READY, creating the element
+ * does not create any of the internal elements. Add a session for each
+ * entry of the ports property, they share the rtpbin, the payload type
+ * map and the receive settings of the main session. */
+static gboolean
+gst_rtp_src_setup_sessions (GstRtpSrc * self)
 {
-  GST_OBJECT_LOCK (self);
-  if (self->rtcp_send_addr)
-    gst_buffer_add_net_address_meta (buffer, self->rtcp_send_addr);
-  GST_OBJECT_UNLOCK (self);
+  gchar **entries;
+  guint i;
+
+  if (!gst_rtp_src_setup_rtx (self))
+    return FALSE;
+
+  if (!gst_rtp_src_setup_filters (self))
+    return FALSE;
+
+  if (!gst_rtp_src_setup_threads (self))
+    return FALSE;
+
+  /* The low-latency mode uses an rtpsession per session instead */
+  if (self->mode != GST_RTP_SRC_MODE_LOW_LATENCY
+      && !gst_rtp_src_setup_rtpbin (self))
+    return FALSE;
+
+  if (!gst_rtp_src_session_setup (GST_RTP_SRC_MAIN_SESSION (self)))
+    return FALSE;
+
+  if (self->ports == NULL || self->ports[0] == '\0')
+    return TRUE;
+
+  entries = g_strsplit (self->ports, ",", -1);
+  for (i = 0; entries[i]; i++) {
+    GstRtpSrcSession *session;
+    gchar *host;
+    guint port;
+
+    g_strstrip (entries[i]);
+    if (entries[i][0] == '\0')
+      continue;
+
+    if (!gst_rtp_utils_parse_address (entries[i], &host, &port))
+      goto invalid_entry;
+
+    session = gst_rtp_src_session_new (self, host, port);
+    g_free (host);
+
+    if (!gst_rtp_src_session_setup (session))
+      goto failed;
+
+    GST_DEBUG_OBJECT (self, "Receiving session %u on %s:%u", session->id,
+        gst_rtp_src_session_get_host (session), port);
+  }
+  g_strfreev (entries);
+
+  return TRUE;
+
+invalid_entry:
+  {
+    GST_ELEMENT_ERROR (self, RESOURCE, SETTINGS, (NULL),
+        ("Invalid entry '%s' in ports '%s'", entries[i], self->ports));
+    g_strfreev (entries);
+    return FALSE;
+  }
+failed:
+  {
+    g_strfreev (entries);
+    return FALSE;
+  }
 }
 
-static GstPadProbeReturn
-gst_rtp_src_on_send_rtcp (GstPad * pad, GstPadProbeInfo * info,
-    gpointer user_data)
+static void
+gst_rtp_src_teardown_sessions (GstRtpSrc * self)
 {
-  GstRtpSrc *self = GST_RTP_SRC (user_data);
+  GstElement *rtpbin;
+  GList *pads, *l;
+  guint i;
 
-  if (info->type == GST_PAD_PROBE_TYPE_BUFFER_LIST) {
-    GstBufferList *buffer_list = info->data;
-    GstBuffer *buffer;
-    gint i;
+  for (i = 0; i < self->sessions->len; i++)
+    gst_rtp_src_session_teardown (g_ptr_array_index (self->sessions, i));
 
-    info->data = buffer_list = gst_buffer_list_make_writable (buffer_list);
-    for (i = 0; i < gst_buffer_list_length (buffer_list); i++) {
-      buffer = gst_buffer_list_get (buffer_list, i);
-      gst_rtp_src_attach_net_address_meta (self, buffer);
-    }
-  } else {
-    GstBuffer *buffer = info->data;
-    info->data = buffer = gst_buffer_make_writable (buffer);
-    gst_rtp_src_attach_net_address_meta (self, buffer);
+  /* Only keep the main session */
+  g_ptr_array_set_size (self->sessions, 1);
+
+  /* Cleared under the lock, for the adaptive latency callback */
+  GST_RTP_SRC_LOCK (self);
+  rtpbin = self->rtpbin;
+  self->rtpbin = NULL;
+  GST_RTP_SRC_UNLOCK (self);
+  if (rtpbin) {
+    gst_element_set_state (rtpbin, GST_STATE_NULL);
+    gst_bin_remove (GST_BIN (self), rtpbin);
   }
 
-  return GST_PAD_PROBE_OK;
+  /* The source pads lost their targets with the elements behind them */
+  GST_OBJECT_LOCK (self);
+  pads = g_list_copy_deep (GST_ELEMENT (self)->srcpads,
+      (GCopyFunc) gst_object_ref, NULL);
+  GST_OBJECT_UNLOCK (self);
+  for (l = pads; l; l = l->next)
+    gst_element_remove_pad (GST_ELEMENT (self), l->data);
+  g_list_free_full (pads, gst_object_unref);
+
+  g_clear_pointer (&self->rtp_filter, g_bytes_unref);
+  g_clear_pointer (&self->rtcp_filter, g_bytes_unref);
+  g_clear_pointer (&self->rtx_pt_map_structure, gst_structure_free);
+
+  GST_OBJECT_LOCK (self);
+  g_clear_pointer (&self->cpus, g_array_unref);
+  GST_OBJECT_UNLOCK (self);
 }
 
 static gboolean
-gst_rtp_src_start (GstRtpSrc * self)
+gst_rtp_src_session_start (GstRtpSrcSession * session)
 {
+  GstRtpSrc *self = session->src;
   GstPad *pad;
   GSocket *socket;
   GInetAddress *addr;
   GstCaps *caps;
-
-  /* Should not be NULL */
-  g_return_val_if_fail (self->uri != NULL, FALSE);
+  guint i;
 
   /* share the socket created by the source */
-  g_object_get (G_OBJECT (self->rtcp_src), "used-socket", &socket, NULL);
+  g_object_get (G_OBJECT (session->rtcp_src), "used-socket", &socket, NULL);
   if (!G_IS_SOCKET (socket)) {
     GST_WARNING_OBJECT (self, "Could not retrieve RTCP src socket.");
+  } else {
+    gst_rtp_socket_options_apply (GST_OBJECT (self), socket,
+        &self->socket_options, FALSE);
+  }
+
+  for (i = 0; i < G_N_ELEMENTS (session->fec_src); i++) {
+    GSocket *fec_socket = NULL;
+
+    if (session->fec_src[i] == NULL)
+      continue;
+
+    g_object_get (session->fec_src[i], "used-socket", &fec_socket, NULL);
+    if (fec_socket) {
+      gst_rtp_socket_options_apply (GST_OBJECT (self), fec_socket,
+          &self->socket_options, FALSE);
+      g_object_unref (fec_socket);
+    }
   }
 
-  addr = g_inet_address_new_from_string (gst_uri_get_host (self->uri));
+  addr =
+      g_inet_address_new_from_string (gst_rtp_src_session_get_host (session));
   if (g_inet_address_get_is_multicast (addr)) {
+    GSocketAddress *group_addr;
+
     /* mc-ttl is not supported by dynudpsink */
     g_socket_set_multicast_ttl (socket, self->ttl_mc);
     /* In multicast, send RTCP to the multicast group */
-    self->rtcp_send_addr =
-        g_inet_socket_address_new (addr, gst_uri_get_port (self->uri) + 1);
+    group_addr = g_inet_socket_address_new (addr,
+        gst_rtp_src_session_get_port (session) + 1);
+    gst_rtp_addr_table_set_fallback (session->rtcp_addrs, group_addr);
+    g_object_unref (group_addr);
   } else {
-    /* In unicast, send RTCP to the detected sender address */
+    /* In unicast, send RTCP to the detected address of each sender */
     g_socket_set_ttl (socket, self->ttl);
-    pad = gst_element_get_static_pad (self->rtcp_src, "src");
-    self->rtcp_recv_probe = gst_pad_add_probe (pad,
+    pad = gst_element_get_static_pad (session->rtcp_src, "src");
+    session->rtcp_recv_probe = gst_pad_add_probe (pad,
         GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
-        gst_rtp_src_on_recv_rtcp, self, NULL);
+        gst_rtp_src_on_recv_rtcp, session, NULL);
     gst_object_unref (pad);
   }
   g_object_unref (addr);
 
   /* no need to set address if unicast */
   caps = gst_caps_new_empty_simple ("application/x-rtcp");
-  g_object_set (self->rtcp_src, "caps", caps, NULL);
+  g_object_set (session->rtcp_src, "caps", caps, NULL);
   gst_caps_unref (caps);
 
-  pad = gst_element_get_static_pad (self->rtcp_sink, "sink");
-  self->rtcp_send_probe = gst_pad_add_probe (pad,
+  /* The udpsrc sockets are open by now. nrtp_recvsrc opens its sockets
+   * later and attaches the filter itself. */
+  if (self->rtp_filter) {
+    gst_rtp_src_attach_filter (self, session->rtp_src, self->rtp_filter);
+    gst_rtp_src_attach_filter (self, session->rtcp_src, self->rtcp_filter);
+  }
+
+  pad = gst_element_get_static_pad (session->rtcp_sink, "sink");
+  session->rtcp_send_probe = gst_pad_add_probe (pad,
       GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
-      gst_rtp_src_on_send_rtcp, self, NULL);
+      gst_rtp_src_on_send_rtcp, session, NULL);
   gst_object_unref (pad);
 
-  g_object_set (self->rtcp_sink, "socket", socket, "close-socket", FALSE, NULL);
-  g_object_unref (socket);
+  g_object_set (session->rtcp_sink, "socket", socket, "close-socket", FALSE,
+      NULL);
+  session->rtcp_socket = socket;
 
-  gst_element_set_locked_state (self->rtcp_sink, FALSE);
-  gst_element_sync_state_with_parent (self->rtcp_sink);
+  gst_element_set_locked_state (session->rtcp_sink, FALSE);
+  gst_element_sync_state_with_parent (session->rtcp_sink);
 
   return TRUE;
 }
 
 static void
-gst_rtp_src_stop (GstRtpSrc * self)
+gst_rtp_src_session_stop (GstRtpSrcSession * session)
 {
   GstPad *pad;
 
-  if (self->rtcp_recv_probe) {
-    pad = gst_element_get_static_pad (self->rtcp_src, "src");
-    gst_pad_remove_probe (pad, self->rtcp_recv_probe);
-    self->rtcp_recv_probe = 0;
+  if (session->rtcp_recv_probe) {
+    pad = gst_element_get_static_pad (session->rtcp_src, "src");
+    gst_pad_remove_probe (pad, session->rtcp_recv_probe);
+    session->rtcp_recv_probe = 0;
     gst_object_unref (pad);
   }
 
-  pad = gst_element_get_static_pad (self->rtcp_sink, "sink");
-  gst_pad_remove_probe (pad, self->rtcp_send_probe);
-  self->rtcp_send_probe = 0;
-  gst_object_unref (pad);
+  if (session->rtcp_send_probe) {
+    pad = gst_element_get_static_pad (session->rtcp_sink, "sink");
+    gst_pad_remove_probe (pad, session->rtcp_send_probe);
+    session->rtcp_send_probe = 0;
+    gst_object_unref (pad);
+  }
+
+  g_clear_object (&session->rtcp_socket);
+  gst_rtp_addr_table_clear (session->rtcp_addrs);
+}
+
+static gboolean
+gst_rtp_src_start (GstRtpSrc * self)
+{
+  guint i;
+
+  /* Should not be NULL */
+  g_return_val_if_fail (self->uri != NULL, FALSE);
+
+  for (i = 0; i < self->sessions->len; i++) {
+    if (!gst_rtp_src_session_start (g_ptr_array_index (self->sessions, i)))
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+static void
+gst_rtp_src_stop (GstRtpSrc * self)
+{
+  guint i;
+
+  for (i = 0; i < self->sessions->len; i++)
+    gst_rtp_src_session_stop (g_ptr_array_index (self->sessions, i));
+}
+
+/* Total of the packets the jitterbuffers of @rtpbin dropped for being too
+ * late */
+static guint64
+gst_rtp_src_get_late_packets (GstElement * rtpbin)
+{
+  GValue item = G_VALUE_INIT;
+  GstIterator *it;
+  guint64 late = 0;
+  gboolean done = FALSE;
+
+  it = gst_bin_iterate_elements (GST_BIN (rtpbin));
+  while (!done) {
+    GstElement *element;
+    GstElementFactory *factory;
+    GstStructure *stats;
+    guint64 num_late;
+
+    switch (gst_iterator_next (it, &item)) {
+      case GST_ITERATOR_OK:
+        element = g_value_get_object (&item);
+        factory = gst_element_get_factory (element);
+        if (factory
+            && g_strcmp0 (GST_OBJECT_NAME (factory), "rtpjitterbuffer") == 0) {
+          g_object_get (element, "stats", &stats, NULL);
+          if (gst_structure_get_uint64 (stats, "num-late", &num_late))
+            late += num_late;
+          gst_structure_free (stats);
+        }
+        g_value_reset (&item);
+        break;
+      case GST_ITERATOR_RESYNC:
+        gst_iterator_resync (it);
+        late = 0;
+        break;
+      default:
+        done = TRUE;
+        break;
+    }
+  }
+  g_value_unset (&item);
+  gst_iterator_free (it);
+
+  return late;
+}
+
+static gboolean
+gst_rtp_src_adapt_latency_cb (GstClock * clock, GstClockTime time,
+    GstClockID id, gpointer user_data)
+{
+  GstRtpSrc *self = GST_RTP_SRC (user_data);
+  GstElement *rtpbin;
+  GstClockTime jitter;
+  guint64 total, late;
+  guint latency, target, update;
+
+  /* Stopping does not wait for a callback that already runs, the ref keeps
+   * rtpbin alive when it is torn down in the mean time */
+  GST_RTP_SRC_LOCK (self);
+  if (self->adapt_id != id || self->rtpbin == NULL) {
+    GST_RTP_SRC_UNLOCK (self);
+    return TRUE;
+  }
+  rtpbin = gst_object_ref (self->rtpbin);
+  GST_RTP_SRC_UNLOCK (self);
+
+  g_object_get (rtpbin, "latency", &latency, NULL);
+  jitter = gst_rtp_stats_get_max_jitter (self->stats);
+  total = gst_rtp_src_get_late_packets (rtpbin);
+
+  GST_RTP_SRC_LOCK (self);
+  /* Stopped in the mean time */
+  if (self->adapt_id != id) {
+    GST_RTP_SRC_UNLOCK (self);
+    gst_object_unref (rtpbin);
+    return TRUE;
+  }
+
+  late = total > self->adapt_late ? total - self->adapt_late : 0;
+  self->adapt_late = total;
+
+  target = ADAPTIVE_LATENCY_JITTER_FACTOR * GST_TIME_AS_MSECONDS (jitter);
+  update = latency;
+  if (late > 0) {
+    update = MAX (target, latency + MAX (latency / 2,
+            ADAPTIVE_LATENCY_MIN_STEP));
+    self->adapt_hold = 0;
+  } else if (target > latency) {
+    update = target;
+    self->adapt_hold = 0;
+  } else if (target < latency - latency / 5) {
+    if (++self->adapt_hold >= ADAPTIVE_LATENCY_HOLD) {
+      update = MAX (target, latency - latency / 4);
+      self->adapt_hold = 0;
+    }
+  } else {
+    self->adapt_hold = 0;
+  }
+  update = CLAMP (update, self->min_latency,
+      MAX (self->min_latency, self->max_latency));
+  GST_RTP_SRC_UNLOCK (self);
+
+  if (update == latency) {
+    gst_object_unref (rtpbin);
+    return TRUE;
+  }
+
+  GST_INFO_OBJECT (self, "Changing the latency from %u to %u ms, jitter %"
+      GST_TIME_FORMAT ", %" G_GUINT64_FORMAT " late packets", latency,
+      update, GST_TIME_ARGS (jitter), late);
+  g_object_set (rtpbin, "latency", update, NULL);
+  gst_object_unref (rtpbin);
+
+  gst_element_post_message (GST_ELEMENT_CAST (self),
+      gst_message_new_element (GST_OBJECT_CAST (self),
+          gst_structure_new ("application/x-rtp-src-latency-changed",
+              "latency", G_TYPE_UINT, update,
+              "previous-latency", G_TYPE_UINT, latency,
+              "jitter", G_TYPE_UINT64, jitter,
+              "late", G_TYPE_UINT64, late, NULL)));
+
+  return TRUE;
+}
+
+static void
+gst_rtp_src_start_adaptive_latency (GstRtpSrc * self)
+{
+  GstClock *clock;
+  guint latency, max_latency;
+
+  if (!self->adaptive_latency || self->mode == GST_RTP_SRC_MODE_LOW_LATENCY)
+    return;
+
+  /* Start from the configured latency, within the bounds */
+  max_latency = MAX (self->min_latency, self->max_latency);
+  g_object_get (self->rtpbin, "latency", &latency, NULL);
+  if (latency < self->min_latency || latency > max_latency)
+    g_object_set (self->rtpbin, "latency",
+        CLAMP (latency, self->min_latency, max_latency), NULL);
+
+  clock = gst_system_clock_obtain ();
+  GST_RTP_SRC_LOCK (self);
+  self->adapt_late = gst_rtp_src_get_late_packets (self->rtpbin);
+  self->adapt_hold = 0;
+  self->adapt_id = gst_clock_new_periodic_id (clock,
+      gst_clock_get_time (clock) + ADAPTIVE_LATENCY_INTERVAL,
+      ADAPTIVE_LATENCY_INTERVAL);
+  gst_clock_id_wait_async (self->adapt_id, gst_rtp_src_adapt_latency_cb,
+      gst_object_ref (self), (GDestroyNotify) gst_object_unref);
+  GST_RTP_SRC_UNLOCK (self);
+  gst_object_unref (clock);
+}
+
+static void
+gst_rtp_src_stop_adaptive_latency (GstRtpSrc * self)
+{
+  GST_RTP_SRC_LOCK (self);
+  if (self->adapt_id) {
+    gst_clock_id_unschedule (self->adapt_id);
+    gst_clock_id_unref (self->adapt_id);
+    self->adapt_id = NULL;
+  }
+  GST_RTP_SRC_UNLOCK (self);
 }
 
 static GstStateChangeReturn
@@ -640,46 +3067,103 @@ gst_rtp_src_change_state (GstElement * element, GstStateChange transition)
       gst_element_state_get_name (GST_STATE_TRANSITION_CURRENT (transition)),
       gst_element_state_get_name (GST_STATE_TRANSITION_NEXT (transition)));
 
+  switch (transition) {
+    case GST_STATE_CHANGE_NULL_TO_READY:
+      if (gst_rtp_src_setup_sessions (self) == FALSE) {
+        gst_rtp_src_teardown_sessions (self);
+        return GST_STATE_CHANGE_FAILURE;
+      }
+      break;
+    default:
+      break;
+  }
+
   ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
   if (ret == GST_STATE_CHANGE_FAILURE)
-    return ret;
+    goto failure;
 
   switch (transition) {
     case GST_STATE_CHANGE_NULL_TO_READY:
-      if (gst_rtp_src_start (self) == FALSE)
-        return GST_STATE_CHANGE_FAILURE;
+      if (gst_rtp_src_start (self) == FALSE) {
+        ret = GST_STATE_CHANGE_FAILURE;
+        goto failure;
+      }
       break;
     case GST_STATE_CHANGE_READY_TO_PAUSED:
       ret = GST_STATE_CHANGE_NO_PREROLL;
       break;
+    case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
+      gst_rtp_src_start_adaptive_latency (self);
+      break;
     case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
+      gst_rtp_src_stop_adaptive_latency (self);
       ret = GST_STATE_CHANGE_NO_PREROLL;
       break;
     case GST_STATE_CHANGE_READY_TO_NULL:
       gst_rtp_src_stop (self);
+      gst_rtp_src_teardown_sessions (self);
       break;
     default:
       break;
   }
 
   return ret;
+
+failure:
+  {
+    /* Do not leave the graph built when going to READY behind, the next
+     * attempt builds it again */
+    if (transition == GST_STATE_CHANGE_NULL_TO_READY) {
+      gst_rtp_src_stop (self);
+      gst_rtp_src_teardown_sessions (self);
+    }
+    return ret;
+  }
 }
 
 static void
 gst_rtp_src_init (GstRtpSrc * self)
 {
-  gchar name[48];
-  const gchar *missing_plugin = NULL;
-
   self->rtpbin = NULL;
-  self->rtp_src = NULL;
-  self->rtcp_src = NULL;
-  self->rtcp_sink = NULL;
+  self->sessions =
+      g_ptr_array_new_with_free_func ((GDestroyNotify)
+      gst_rtp_src_session_free);
 
   self->uri = gst_uri_from_string (DEFAULT_PROP_URI);
   self->ttl = DEFAULT_PROP_TTL;
   self->ttl_mc = DEFAULT_PROP_TTL_MC;
   self->encoding_name = DEFAULT_PROP_ENCODING_NAME;
+  self->pt_map_str = DEFAULT_PROP_PT_MAP;
+  self->pt_map = gst_rtp_src_pt_map_new (self, self->encoding_name,
+      self->pt_map_str);
+  self->kernel_filter = DEFAULT_PROP_KERNEL_FILTER;
+  self->filter_ssrcs = DEFAULT_PROP_FILTER_SSRCS;
+  self->filter_pts = DEFAULT_PROP_FILTER_PTS;
+  self->io_uring = DEFAULT_PROP_IO_URING;
+  self->latency = DEFAULT_PROP_LATENCY;
+  self->mode = DEFAULT_PROP_MODE;
+  self->adaptive_latency = DEFAULT_PROP_ADAPTIVE_LATENCY;
+  self->min_latency = DEFAULT_PROP_MIN_LATENCY;
+  self->max_latency = DEFAULT_PROP_MAX_LATENCY;
+  gst_rtp_socket_options_init (&self->socket_options);
+  self->cpu_affinity = DEFAULT_PROP_CPU_AFFINITY;
+  self->realtime_priority = DEFAULT_PROP_REALTIME_PRIORITY;
+  self->spin_time = DEFAULT_PROP_SPIN_TIME;
+  self->expected_bitrate = DEFAULT_PROP_EXPECTED_BITRATE;
+  self->fec = DEFAULT_PROP_FEC;
+  self->rtx = DEFAULT_PROP_RTX;
+  self->rtx_pt_map = g_strdup (DEFAULT_PROP_RTX_PT_MAP);
+  self->batch_size = DEFAULT_PROP_BATCH_SIZE;
+  self->pool_size = DEFAULT_PROP_POOL_SIZE;
+  self->mtu = DEFAULT_PROP_MTU;
+  self->receive_threads = DEFAULT_PROP_RECEIVE_THREADS;
+  self->ports = DEFAULT_PROP_PORTS;
+  self->kernel_timestamps = DEFAULT_PROP_KERNEL_TIMESTAMPS;
+  self->timestamp_caps = gst_caps_new_empty_simple ("timestamp/x-unix");
+  self->stats = gst_rtp_stats_new (TRUE);
+
+  /* The main session, it receives on the address and port of the URI */
+  gst_rtp_src_session_new (self, NULL, 0);
 
   GST_OBJECT_FLAG_SET (GST_OBJECT (self), GST_ELEMENT_FLAG_SOURCE);
   gst_bin_set_suppressed_flags (GST_BIN (self),
@@ -687,78 +3171,29 @@ gst_rtp_src_init (GstRtpSrc * self)
 
   g_mutex_init (&self->lock);
 
-  /* Construct the RTP receiver pipeline.
+  /* The RTP receiver pipeline, built when going to READY.
    *
    * udpsrc -> [recv_rtp_sink_%u]  --------  [recv_rtp_src_%u_%u_%u]
    *                              | rtpbin |
    * udpsrc -> [recv_rtcp_sink_%u] --------  [send_rtcp_src_%u] -> udpsink
    *
-   * This pipeline is fixed for now, note that optionally an FEC stream could
-   * be added later.
+   * The RTP udpsrc is replaced by nrtp_recvsrc when batched receiving,
+   * the buffer pool, multiple receive threads, socket options, spinning or
+   * the expected bitrate are enabled. With FEC, an nrtp_fecdec between it
+   * and rtpbin recovers lost packets from the column and row FEC streams
+   * of two more udpsrc. With RTX, rtpbin gets an rtprtxreceive per session
+   * as its auxiliary receiver. The sessions from the ports property are
+   * added to the same rtpbin. Nothing is created before, so instantiating
+   * the element for inspection or URI handler probing stays cheap, and
+   * everything is removed again when going back to NULL.
+   *
+   * In the low-latency mode, every session is linked to its own rtpsession
+   * instead, which feeds an rtpssrcdemux that exposes a pad per sender:
+   *
+   * udpsrc -> [recv_rtp_sink]  ------------ [recv_rtp_src] -> rtpssrcdemux
+   *                           | rtpsession |
+   * udpsrc -> [recv_rtcp_sink] ------------ [send_rtcp_src] -> udpsink
    */
-
-  self->rtpbin = gst_element_factory_make ("rtpbin", NULL);
-  if (self->rtpbin == NULL) {
-    missing_plugin = "rtpmanager";
-    goto missing_plugin;
-  }
-
-  gst_bin_add (GST_BIN (self), self->rtpbin);
-
-  /* Add rtpbin callbacks to monitor the operation of rtpbin */
-  g_signal_connect (self->rtpbin, "pad-added",
-      G_CALLBACK (gst_rtp_src_rtpbin_pad_added_cb), self);
-  g_signal_connect (self->rtpbin, "pad-removed",
-      G_CALLBACK (gst_rtp_src_rtpbin_pad_removed_cb), self);
-  g_signal_connect (self->rtpbin, "request-pt-map",
-      G_CALLBACK (gst_rtp_src_rtpbin_request_pt_map_cb), self);
-  g_signal_connect (self->rtpbin, "on-new-ssrc",
-      G_CALLBACK (gst_rtp_src_rtpbin_on_new_ssrc_cb), self);
-  g_signal_connect (self->rtpbin, "on-ssrc-collision",
-      G_CALLBACK (gst_rtp_src_rtpbin_on_ssrc_collision_cb), self);
-
-  self->rtp_src = gst_element_factory_make ("udpsrc", NULL);
-  if (self->rtp_src == NULL) {
-    missing_plugin = "udp";
-    goto missing_plugin;
-  }
-
-  self->rtcp_src = gst_element_factory_make ("udpsrc", NULL);
-  if (self->rtcp_src == NULL) {
-    missing_plugin = "udp";
-    goto missing_plugin;
-  }
-
-  self->rtcp_sink = gst_element_factory_make ("dynudpsink", NULL);
-  if (self->rtcp_sink == NULL) {
-    missing_plugin = "udp";
-    goto missing_plugin;
-  }
-
-  /* Add elements as needed, since udpsrc/udpsink for RTCP share a socket,
-   * not all at the same moment */
-  gst_bin_add (GST_BIN (self), self->rtp_src);
-  gst_bin_add (GST_BIN (self), self->rtcp_src);
-  gst_bin_add (GST_BIN (self), self->rtcp_sink);
-
-  g_object_set (self->rtcp_sink, "sync", FALSE, "async", FALSE, NULL);
-  gst_element_set_locked_state (self->rtcp_sink, TRUE);
-
-  /* pads are all named */
-  g_snprintf (name, 48, "recv_rtp_sink_%u", GST_ELEMENT (self)->numpads);
-  gst_element_link_pads (self->rtp_src, "src", self->rtpbin, name);
-  g_snprintf (name, 48, "recv_rtcp_sink_%u", GST_ELEMENT (self)->numpads);
-  gst_element_link_pads (self->rtcp_src, "src", self->rtpbin, name);
-  g_snprintf (name, 48, "send_rtcp_src_%u", GST_ELEMENT (self)->numpads);
-  gst_element_link_pads (self->rtpbin, name, self->rtcp_sink, "sink");
-
-  if (missing_plugin == NULL)
-    return;
-
-missing_plugin:
-  {
-    GST_ERROR_OBJECT (self, "'%s' plugin is missing.", missing_plugin);
-  }
 }
 
 static GstURIType
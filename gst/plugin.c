@@ -4,6 +4,12 @@
 
 #include "gstrtpsink.h"
 #include "gstrtpsrc.h"
+#include "gstrtprecvsrc.h"
+#include "gstrtpsendsink.h"
+#include "gstrtppacer.h"
+#include "gstrtpfecdec.h"
+#include "gstrtpfecenc.h"
+#include "gstrtprtxsend.h"
 
 
 static gboolean
@@ -18,6 +24,24 @@ plugin_init (GstPlugin * plugin)
   ret |= gst_element_register (plugin, "nrtp_rtpsink",
       GST_RANK_PRIMARY + 1, GST_TYPE_RTP_SINK);
 
+  ret |= gst_element_register (plugin, "nrtp_recvsrc",
+      GST_RANK_NONE, GST_TYPE_RTP_RECV_SRC);
+
+  ret |= gst_element_register (plugin, "nrtp_sendsink",
+      GST_RANK_NONE, GST_TYPE_RTP_SEND_SINK);
+
+  ret |= gst_element_register (plugin, "nrtp_pacer",
+      GST_RANK_NONE, GST_TYPE_RTP_PACER);
+
+  ret |= gst_element_register (plugin, "nrtp_fecdec",
+      GST_RANK_NONE, GST_TYPE_RTP_FEC_DEC);
+
+  ret |= gst_element_register (plugin, "nrtp_fecenc",
+      GST_RANK_NONE, GST_TYPE_RTP_FEC_ENC);
+
+  ret |= gst_element_register (plugin, "nrtp_rtxsend",
+      GST_RANK_NONE, GST_TYPE_RTP_RTX_SEND);
+
   return ret;
 }
 
@@ -0,0 +1,306 @@
+/* GStreamer
+ * Copyright (C) <2018> Marc Leeman <marc.leeman@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/rtp/gstrtpbuffer.h>
+
+/* A matrix of L columns and D rows, the sequence numbers wrap */
+#define L 4
+#define D 3
+#define BASE_SEQ 65530
+
+static GstBuffer *
+create_media (guint16 seq)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  guint len = 100 + (seq % 7) * 30;
+  GstBuffer *buf;
+  guint8 *payload;
+  guint i;
+
+  buf = gst_rtp_buffer_new_allocate (len, 0, 0);
+  gst_rtp_buffer_map (buf, GST_MAP_WRITE, &rtp);
+  gst_rtp_buffer_set_payload_type (&rtp, 96);
+  gst_rtp_buffer_set_seq (&rtp, seq);
+  gst_rtp_buffer_set_timestamp (&rtp, seq * 3000);
+  gst_rtp_buffer_set_ssrc (&rtp, 0x12345678);
+  gst_rtp_buffer_set_marker (&rtp, seq % 3 == 0);
+  payload = gst_rtp_buffer_get_payload (&rtp);
+  for (i = 0; i < len; i++)
+    payload[i] = seq + i * 7;
+  gst_rtp_buffer_unmap (&rtp);
+
+  return buf;
+}
+
+/* A SMPTE 2022-1 FEC packet over @n packets of @media */
+static GstBuffer *
+create_fec (GstBuffer ** media, guint n, guint16 base, guint offset,
+    gboolean row)
+{
+  guint8 *data, pxcc = 0, marker = 0, pt = 0;
+  guint16 length = 0;
+  guint32 ts = 0;
+  gsize i, j, max_len = 0;
+  GstMapInfo map;
+  GstBuffer *buf;
+
+  for (i = 0; i < n; i++)
+    max_len = MAX (max_len, gst_buffer_get_size (media[i]) - 12);
+
+  data = g_malloc0 (12 + 16 + max_len);
+  for (i = 0; i < n; i++) {
+    gst_buffer_map (media[i], &map, GST_MAP_READ);
+    for (j = 12; j < map.size; j++)
+      data[16 + j] ^= map.data[j];
+    length ^= map.size - 12;
+    pxcc ^= map.data[0] & 0x3f;
+    marker ^= map.data[1] >> 7;
+    pt ^= map.data[1] & 0x7f;
+    ts ^= GST_READ_UINT32_BE (map.data + 4);
+    gst_buffer_unmap (media[i], &map);
+  }
+
+  data[0] = 0x80 | pxcc;
+  data[1] = (marker << 7) | 97;
+  GST_WRITE_UINT16_BE (data + 12, base);
+  GST_WRITE_UINT16_BE (data + 14, length);
+  data[16] = 0x80 | pt;
+  GST_WRITE_UINT32_BE (data + 20, ts);
+  data[24] = row ? 0x40 : 0x00;
+  data[25] = offset;
+  data[26] = n;
+
+  buf = gst_buffer_new_wrapped (data, 12 + 16 + max_len);
+
+  return buf;
+}
+
+static GstBuffer *
+create_row_fec (GstBuffer ** media, guint row)
+{
+  return create_fec (media + row * L, L, BASE_SEQ + row * L, 1, TRUE);
+}
+
+static GstBuffer *
+create_column_fec (GstBuffer ** media, guint column)
+{
+  GstBuffer *packets[D];
+  guint i;
+
+  for (i = 0; i < D; i++)
+    packets[i] = media[i * L + column];
+
+  return create_fec (packets, D, BASE_SEQ + column, L, FALSE);
+}
+
+static void
+create_matrix (GstBuffer ** media)
+{
+  guint i;
+
+  for (i = 0; i < L * D; i++)
+    media[i] = create_media (BASE_SEQ + i);
+}
+
+static void
+free_matrix (GstBuffer ** media)
+{
+  guint i;
+
+  for (i = 0; i < L * D; i++)
+    gst_buffer_unref (media[i]);
+}
+
+static void
+setup_harnesses (GstHarness ** h, GstHarness ** fec)
+{
+  *h = gst_harness_new_with_padnames ("nrtp_fecdec", "sink", "src");
+  gst_harness_set_src_caps_str (*h, "application/x-rtp");
+  *fec = gst_harness_new_with_element ((*h)->element, "fec_0", NULL);
+  gst_harness_set_src_caps_str (*fec, "application/x-rtp");
+}
+
+static void
+check_recovered (GstHarness * h, GstBuffer * expected)
+{
+  GstBuffer *buf = gst_harness_pull (h);
+  GstMapInfo map, expected_map;
+
+  gst_buffer_map (buf, &map, GST_MAP_READ);
+  gst_buffer_map (expected, &expected_map, GST_MAP_READ);
+  fail_unless_equals_uint64 (map.size, expected_map.size);
+  fail_unless (memcmp (map.data, expected_map.data, map.size) == 0);
+  gst_buffer_unmap (expected, &expected_map);
+  gst_buffer_unmap (buf, &map);
+  gst_buffer_unref (buf);
+}
+
+static guint64
+get_stats_uint64 (GstElement * fecdec, const gchar * field)
+{
+  GstStructure *stats;
+  guint64 value = 0;
+
+  g_object_get (fecdec, "stats", &stats, NULL);
+  fail_unless (stats != NULL);
+  fail_unless (gst_structure_get_uint64 (stats, field, &value));
+  gst_structure_free (stats);
+
+  return value;
+}
+
+GST_START_TEST (test_recover_row)
+{
+  GstBuffer *media[L * D];
+  GstHarness *h, *fec;
+  guint i;
+
+  create_matrix (media);
+  setup_harnesses (&h, &fec);
+
+  /* The third packet of the first row is lost */
+  for (i = 0; i < L; i++) {
+    if (i != 2)
+      fail_unless_equals_int (gst_harness_push (h,
+              gst_buffer_ref (media[i])), GST_FLOW_OK);
+  }
+  fail_unless_equals_int (gst_harness_buffers_received (h), L - 1);
+
+  fail_unless_equals_int (gst_harness_push (fec, create_row_fec (media, 0)),
+      GST_FLOW_OK);
+  fail_unless_equals_int (gst_harness_buffers_received (h), L);
+  for (i = 0; i < L - 1; i++)
+    gst_buffer_unref (gst_harness_pull (h));
+  check_recovered (h, media[2]);
+
+  fail_unless_equals_uint64 (get_stats_uint64 (h->element, "recovered"), 1);
+  fail_unless_equals_uint64 (get_stats_uint64 (h->element, "fec-packets"), 1);
+
+  /* The original arriving late is dropped */
+  fail_unless_equals_int (gst_harness_push (h, gst_buffer_ref (media[2])),
+      GST_FLOW_OK);
+  fail_unless_equals_int (gst_harness_buffers_received (h), L);
+  fail_unless_equals_uint64 (get_stats_uint64 (h->element, "duplicates"), 1);
+
+  gst_harness_teardown (fec);
+  gst_harness_teardown (h);
+  free_matrix (media);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_recover_matrix)
+{
+  GstBuffer *media[L * D];
+  GstHarness *h, *fec;
+  guint i;
+
+  create_matrix (media);
+  setup_harnesses (&h, &fec);
+
+  /* Two packets of the first row and one of the second are lost. The
+   * second row FEC recovers its packet right away, the first row needs
+   * the first column FEC to give back one packet before its row FEC
+   * recovers the other */
+  for (i = 0; i < L * D; i++) {
+    if (i != 0 && i != 1 && i != L + 1)
+      fail_unless_equals_int (gst_harness_push (h,
+              gst_buffer_ref (media[i])), GST_FLOW_OK);
+  }
+  for (i = 0; i < D; i++)
+    fail_unless_equals_int (gst_harness_push (fec, create_row_fec (media,
+                i)), GST_FLOW_OK);
+  /* The second row is recovered right away */
+  fail_unless_equals_int (gst_harness_buffers_received (h), L * D - 2);
+  fail_unless_equals_uint64 (get_stats_uint64 (h->element, "recovered"), 1);
+
+  fail_unless_equals_int (gst_harness_push (fec, create_column_fec (media,
+              0)), GST_FLOW_OK);
+  fail_unless_equals_int (gst_harness_buffers_received (h), L * D);
+  fail_unless_equals_uint64 (get_stats_uint64 (h->element, "recovered"), 3);
+
+  /* The losses come out last, in the order they were recovered */
+  for (i = 0; i < L * D - 3; i++)
+    gst_buffer_unref (gst_harness_pull (h));
+  check_recovered (h, media[L + 1]);
+  check_recovered (h, media[0]);
+  check_recovered (h, media[1]);
+
+  gst_harness_teardown (fec);
+  gst_harness_teardown (h);
+  free_matrix (media);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_unrecoverable)
+{
+  GstBuffer *media[L * D];
+  GstHarness *h, *fec;
+  guint i;
+
+  create_matrix (media);
+  setup_harnesses (&h, &fec);
+
+  /* Two losses in a row without column FEC */
+  for (i = 0; i < L; i++) {
+    if (i != 1 && i != 2)
+      fail_unless_equals_int (gst_harness_push (h,
+              gst_buffer_ref (media[i])), GST_FLOW_OK);
+  }
+  fail_unless_equals_int (gst_harness_push (fec, create_row_fec (media, 0)),
+      GST_FLOW_OK);
+  fail_unless_equals_int (gst_harness_buffers_received (h), L - 2);
+
+  /* Given up once the packets leave the window */
+  for (i = 0; i < 300; i++)
+    fail_unless_equals_int (gst_harness_push (h,
+            create_media (BASE_SEQ + L * D + i)), GST_FLOW_OK);
+  fail_unless_equals_uint64 (get_stats_uint64 (h->element, "recovered"), 0);
+  fail_unless_equals_uint64 (get_stats_uint64 (h->element, "unrecoverable"),
+      1);
+
+  /* Garbage on the FEC port is ignored */
+  fail_unless_equals_int (gst_harness_push (fec,
+          gst_buffer_new_allocate (NULL, 10, NULL)), GST_FLOW_OK);
+
+  gst_harness_teardown (fec);
+  gst_harness_teardown (h);
+  free_matrix (media);
+}
+
+GST_END_TEST;
+
+static Suite *
+rtpfecdec_suite (void)
+{
+  Suite *s = suite_create ("rtpfecdec");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_recover_row);
+  tcase_add_test (tc_chain, test_recover_matrix);
+  tcase_add_test (tc_chain, test_unrecoverable);
+
+  return s;
+}
+
+GST_CHECK_MAIN (rtpfecdec);
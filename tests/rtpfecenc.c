@@ -0,0 +1,270 @@
+/* GStreamer
+ * Copyright (C) <2018> Marc Leeman <marc.leeman@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/rtp/gstrtpbuffer.h>
+
+/* A matrix of L columns and D rows, the sequence numbers wrap */
+#define L 4
+#define D 3
+#define BASE_SEQ 65530
+
+static GstBuffer *
+create_media (guint16 seq)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  guint len = 100 + (seq % 7) * 30;
+  GstBuffer *buf;
+  guint8 *payload;
+  guint i;
+
+  buf = gst_rtp_buffer_new_allocate (len, 0, 0);
+  gst_rtp_buffer_map (buf, GST_MAP_WRITE, &rtp);
+  gst_rtp_buffer_set_payload_type (&rtp, 96);
+  gst_rtp_buffer_set_seq (&rtp, seq);
+  gst_rtp_buffer_set_timestamp (&rtp, seq * 3000);
+  gst_rtp_buffer_set_ssrc (&rtp, 0x12345678);
+  gst_rtp_buffer_set_marker (&rtp, seq % 3 == 0);
+  payload = gst_rtp_buffer_get_payload (&rtp);
+  for (i = 0; i < len; i++)
+    payload[i] = seq + i * 7;
+  gst_rtp_buffer_unmap (&rtp);
+
+  return buf;
+}
+
+/* An encoder with harnesses on its media, column and row FEC pads */
+static void
+setup_harnesses (GstHarness ** h, GstHarness ** column, GstHarness ** row)
+{
+  GstElement *fecenc = gst_element_factory_make ("nrtp_fecenc", NULL);
+
+  g_object_set (fecenc, "columns", L, "rows", D, NULL);
+  *h = gst_harness_new_with_element (fecenc, "sink", "src");
+  *column = gst_harness_new_with_element ((*h)->element, NULL, "fec_0");
+  *row = gst_harness_new_with_element ((*h)->element, NULL, "fec_1");
+  gst_harness_set_src_caps_str (*h, "application/x-rtp");
+  gst_object_unref (fecenc);
+}
+
+static void
+teardown_harnesses (GstHarness * h, GstHarness * column, GstHarness * row)
+{
+  gst_harness_teardown (row);
+  gst_harness_teardown (column);
+  gst_harness_teardown (h);
+}
+
+/* Check the FEC header of @buf against the packets it should protect */
+static void
+check_fec_header (GstBuffer * buf, guint16 sn_base, gboolean row,
+    guint offset, guint na)
+{
+  GstMapInfo map;
+
+  gst_buffer_map (buf, &map, GST_MAP_READ);
+  fail_unless (map.size > 12 + 16);
+  fail_unless_equals_int (map.data[0] >> 6, 2);
+  fail_unless_equals_int (GST_READ_UINT16_BE (map.data + 12), sn_base);
+  fail_unless_equals_int (map.data[24] >> 6 & 0x01, row);
+  fail_unless_equals_int (map.data[25], offset);
+  fail_unless_equals_int (map.data[26], na);
+  gst_buffer_unmap (buf, &map);
+}
+
+static guint64
+get_stats_uint64 (GstElement * element, const gchar * field)
+{
+  GstStructure *stats;
+  guint64 value = 0;
+
+  g_object_get (element, "stats", &stats, NULL);
+  fail_unless (stats != NULL);
+  fail_unless (gst_structure_get_uint64 (stats, field, &value));
+  gst_structure_free (stats);
+
+  return value;
+}
+
+GST_START_TEST (test_matrix)
+{
+  GstHarness *h, *column, *row;
+  GstBuffer *buf;
+  guint i;
+
+  setup_harnesses (&h, &column, &row);
+
+  for (i = 0; i < L * D; i++) {
+    fail_unless_equals_int (gst_harness_push (h,
+            create_media (BASE_SEQ + i)), GST_FLOW_OK);
+
+    /* A row FEC packet follows every row, the column FEC packets follow
+     * the last row */
+    fail_unless_equals_int (gst_harness_buffers_received (row),
+        (i + 1) / L);
+    fail_unless_equals_int (gst_harness_buffers_received (column),
+        i < (D - 1) * L ? 0 : i - (D - 1) * L + 1);
+  }
+  fail_unless_equals_int (gst_harness_buffers_received (h), L * D);
+
+  for (i = 0; i < D; i++) {
+    buf = gst_harness_pull (row);
+    check_fec_header (buf, BASE_SEQ + i * L, TRUE, 1, L);
+    gst_buffer_unref (buf);
+  }
+  for (i = 0; i < L; i++) {
+    buf = gst_harness_pull (column);
+    check_fec_header (buf, BASE_SEQ + i, FALSE, L, D);
+    gst_buffer_unref (buf);
+  }
+
+  fail_unless_equals_uint64 (get_stats_uint64 (h->element, "media-packets"),
+      L * D);
+  fail_unless_equals_uint64 (get_stats_uint64 (h->element, "fec-packets"),
+      L + D);
+
+  teardown_harnesses (h, column, row);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_recover)
+{
+  GstHarness *h, *column, *row, *dec, *dec_fec;
+  GstBuffer *media[L * D];
+  GstBuffer *buf;
+  guint i;
+
+  setup_harnesses (&h, &column, &row);
+  for (i = 0; i < L * D; i++) {
+    media[i] = create_media (BASE_SEQ + i);
+    gst_harness_push (h, gst_buffer_ref (media[i]));
+  }
+
+  dec = gst_harness_new_with_padnames ("nrtp_fecdec", "sink", "src");
+  gst_harness_set_src_caps_str (dec, "application/x-rtp");
+  dec_fec = gst_harness_new_with_element (dec->element, "fec_0", NULL);
+  gst_harness_set_src_caps_str (dec_fec, "application/x-rtp");
+
+  /* Lose two packets of the first row and one of the second, which takes
+   * both the row and the column FEC to recover */
+  for (i = 0; i < L * D; i++) {
+    buf = gst_harness_pull (h);
+    if (i == 0 || i == 1 || i == L + 1)
+      gst_buffer_unref (buf);
+    else
+      gst_harness_push (dec, buf);
+  }
+  while ((buf = gst_harness_try_pull (row)))
+    gst_harness_push (dec_fec, buf);
+  while ((buf = gst_harness_try_pull (column)))
+    gst_harness_push (dec_fec, buf);
+
+  fail_unless_equals_int (gst_harness_buffers_received (dec), L * D);
+  for (i = 0; i < L * D - 3; i++)
+    gst_buffer_unref (gst_harness_pull (dec));
+  for (i = 0; i < 3; i++) {
+    GstMapInfo map, expected_map;
+    guint16 seq;
+
+    buf = gst_harness_pull (dec);
+    gst_buffer_map (buf, &map, GST_MAP_READ);
+    seq = GST_READ_UINT16_BE (map.data + 2) - BASE_SEQ;
+    fail_unless (seq == 0 || seq == 1 || seq == L + 1);
+    gst_buffer_map (media[seq], &expected_map, GST_MAP_READ);
+    fail_unless_equals_uint64 (map.size, expected_map.size);
+    fail_unless (memcmp (map.data, expected_map.data, map.size) == 0);
+    gst_buffer_unmap (media[seq], &expected_map);
+    gst_buffer_unmap (buf, &map);
+    gst_buffer_unref (buf);
+  }
+
+  gst_harness_teardown (dec_fec);
+  gst_harness_teardown (dec);
+  teardown_harnesses (h, column, row);
+  for (i = 0; i < L * D; i++)
+    gst_buffer_unref (media[i]);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_flush_on_eos)
+{
+  GstHarness *h, *column, *row;
+  GstBuffer *buf;
+  guint i;
+
+  setup_harnesses (&h, &column, &row);
+
+  /* The gap in the sequence numbers ends the first matrix after one
+   * packet, which is protected on its own */
+  fail_unless_equals_int (gst_harness_push (h, create_media (BASE_SEQ - 10)),
+      GST_FLOW_OK);
+  fail_unless_equals_int (gst_harness_push (h, create_media (BASE_SEQ)),
+      GST_FLOW_OK);
+  fail_unless_equals_int (gst_harness_buffers_received (column), 1);
+  fail_unless_equals_int (gst_harness_buffers_received (row), 1);
+  buf = gst_harness_pull (column);
+  check_fec_header (buf, BASE_SEQ - 10, FALSE, 1, 1);
+  gst_buffer_unref (buf);
+  gst_buffer_unref (gst_harness_pull (row));
+
+  /* A row and a packet of the second matrix */
+  for (i = 1; i < L + 1; i++)
+    fail_unless_equals_int (gst_harness_push (h,
+            create_media (BASE_SEQ + i)), GST_FLOW_OK);
+  fail_unless_equals_int (gst_harness_buffers_received (column), 1);
+  fail_unless_equals_int (gst_harness_buffers_received (row), 2);
+  gst_buffer_unref (gst_harness_pull (row));
+
+  /* The last matrix is finished with the packets sent so far */
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+  buf = gst_harness_pull (column);
+  check_fec_header (buf, BASE_SEQ, FALSE, L, 2);
+  gst_buffer_unref (buf);
+  for (i = 1; i < L; i++) {
+    buf = gst_harness_pull (column);
+    check_fec_header (buf, BASE_SEQ + i, FALSE, 1, 1);
+    gst_buffer_unref (buf);
+  }
+  buf = gst_harness_pull (row);
+  check_fec_header (buf, BASE_SEQ + L, TRUE, 1, 1);
+  gst_buffer_unref (buf);
+
+  teardown_harnesses (h, column, row);
+}
+
+GST_END_TEST;
+
+static Suite *
+rtpfecenc_suite (void)
+{
+  Suite *s = suite_create ("rtpfecenc");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_matrix);
+  tcase_add_test (tc_chain, test_recover);
+  tcase_add_test (tc_chain, test_flush_on_eos);
+
+  return s;
+}
+
+GST_CHECK_MAIN (rtpfecenc);
@@ -0,0 +1,184 @@
+/* GStreamer
+ * Copyright (C) <2018> Marc Leeman <marc.leeman@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+
+#define PACKET_SIZE 1000
+
+static GstBuffer *
+create_packet (GstClockTime pts)
+{
+  GstBuffer *buf = gst_buffer_new_allocate (NULL, PACKET_SIZE, NULL);
+
+  gst_buffer_memset (buf, 0, 0, PACKET_SIZE);
+  GST_BUFFER_PTS (buf) = pts;
+
+  return buf;
+}
+
+static guint64
+get_stats_uint64 (GstElement * pacer, const gchar * field)
+{
+  GstStructure *stats;
+  guint64 value = 0;
+
+  g_object_get (pacer, "stats", &stats, NULL);
+  fail_unless (stats != NULL);
+  fail_unless (gst_structure_get_uint64 (stats, field, &value));
+  gst_structure_free (stats);
+
+  return value;
+}
+
+GST_START_TEST (test_pace_bitrate)
+{
+  GstHarness *h;
+  GstStructure *stats;
+  gint64 start, elapsed;
+  guint i, max_depth;
+
+  h = gst_harness_new ("nrtp_pacer");
+  /* 100 kB/s with room for a single packet */
+  g_object_set (h->element, "bitrate", (guint64) 800000,
+      "burst", PACKET_SIZE, NULL);
+  gst_harness_set_src_caps_str (h, "application/x-rtp");
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < 11; i++)
+    fail_unless_equals_int (gst_harness_push (h, create_packet (0)),
+        GST_FLOW_OK);
+  for (i = 0; i < 11; i++)
+    gst_buffer_unref (gst_harness_pull (h));
+  elapsed = g_get_monotonic_time () - start;
+
+  /* The first packet leaves at once, the next ones every 10 ms */
+  fail_unless (elapsed >= 90 * 1000, "Packets left after %" G_GINT64_FORMAT
+      " us", elapsed);
+
+  g_object_get (h->element, "stats", &stats, NULL);
+  fail_unless (gst_structure_get_uint (stats, "max-queue-depth",
+          &max_depth));
+  fail_unless (max_depth >= 9);
+  gst_structure_free (stats);
+  fail_unless_equals_uint64 (get_stats_uint64 (h->element, "packets-paced"),
+      11);
+  fail_unless (get_stats_uint64 (h->element, "max-delay") >=
+      80 * GST_MSECOND);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_pace_from_timestamps)
+{
+  GstHarness *h;
+  guint64 bitrate;
+  guint i, j;
+
+  h = gst_harness_new ("nrtp_pacer");
+  gst_harness_set_src_caps_str (h, "application/x-rtp");
+
+  /* Frames of 10 packets every 10 ms make 1 MB/s */
+  for (i = 0; i < 5; i++) {
+    for (j = 0; j < 10; j++)
+      fail_unless_equals_int (gst_harness_push (h,
+              create_packet (i * 10 * GST_MSECOND)), GST_FLOW_OK);
+  }
+  for (i = 0; i < 50; i++)
+    gst_buffer_unref (gst_harness_pull (h));
+
+  /* Paced somewhat faster than the stream */
+  bitrate = get_stats_uint64 (h->element, "bitrate");
+  fail_unless (bitrate >= 8000000 && bitrate <= 12000000,
+      "Unexpected pacing bitrate %" G_GUINT64_FORMAT, bitrate);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_flush)
+{
+  GstHarness *h;
+  GstStructure *stats;
+  guint i, depth;
+
+  h = gst_harness_new ("nrtp_pacer");
+  g_object_set (h->element, "bitrate", (guint64) 8000, "burst", PACKET_SIZE,
+      NULL);
+  gst_harness_set_src_caps_str (h, "application/x-rtp");
+
+  /* At 1 kB/s these would take seconds, a flush drops them */
+  for (i = 0; i < 5; i++)
+    fail_unless_equals_int (gst_harness_push (h, create_packet (0)),
+        GST_FLOW_OK);
+  fail_unless (gst_harness_push_event (h, gst_event_new_flush_start ()));
+  fail_unless (gst_harness_push_event (h, gst_event_new_flush_stop (TRUE)));
+
+  fail_unless (get_stats_uint64 (h->element, "packets-paced") <= 1);
+  g_object_get (h->element, "stats", &stats, NULL);
+  fail_unless (gst_structure_get_uint (stats, "queue-depth", &depth));
+  fail_unless_equals_int (depth, 0);
+  gst_structure_free (stats);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_latency)
+{
+  GstHarness *h;
+
+  h = gst_harness_new ("nrtp_pacer");
+  gst_harness_set_src_caps_str (h, "application/x-rtp");
+  gst_harness_set_upstream_latency (h, 5 * GST_MSECOND);
+
+  /* Nothing is known about the rate yet */
+  fail_unless_equals_uint64 (gst_harness_query_latency (h), 5 * GST_MSECOND);
+
+  /* A burst of 1000 bytes takes 10 ms at 100 kB/s */
+  g_object_set (h->element, "bitrate", (guint64) 800000,
+      "burst", PACKET_SIZE, NULL);
+  fail_unless_equals_uint64 (gst_harness_query_latency (h),
+      15 * GST_MSECOND);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static Suite *
+rtppacer_suite (void)
+{
+  Suite *s = suite_create ("rtppacer");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_pace_bitrate);
+  tcase_add_test (tc_chain, test_pace_from_timestamps);
+  tcase_add_test (tc_chain, test_flush);
+  tcase_add_test (tc_chain, test_latency);
+
+  return s;
+}
+
+GST_CHECK_MAIN (rtppacer);
@@ -0,0 +1,705 @@
+/* GStreamer
+ * Copyright (C) <2018> Marc Leeman <marc.leeman@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef __linux__
+#include <sys/socket.h>
+#endif
+
+#include <gio/gio.h>
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+
+GST_DEBUG_CATEGORY_STATIC (rtprecvsrc_test_debug);
+#define GST_CAT_DEFAULT rtprecvsrc_test_debug
+
+#define PACKET_SIZE 200
+#define N_PACKETS 20000
+
+typedef struct
+{
+  GSocket *socket;
+  GSocketAddress *addr;
+  guint n_packets;
+} SenderData;
+
+static GstHarness *
+setup_recvsrc (guint batch_size, guint pool_size, guint n_threads,
+    guint16 * port)
+{
+  GstHarness *h;
+  GSocket *socket;
+  GSocketAddress *addr;
+
+  h = gst_harness_new ("nrtp_recvsrc");
+  g_object_set (h->element, "address", "127.0.0.1", "port", 0,
+      "batch-size", batch_size, "pool-size", pool_size,
+      "n-threads", n_threads, NULL);
+  gst_harness_use_systemclock (h);
+  gst_harness_play (h);
+
+  g_object_get (h->element, "used-socket", &socket, NULL);
+  fail_unless (G_IS_SOCKET (socket));
+  addr = g_socket_get_local_address (socket, NULL);
+  *port = g_inet_socket_address_get_port (G_INET_SOCKET_ADDRESS (addr));
+  g_object_unref (addr);
+  g_object_unref (socket);
+
+  return h;
+}
+
+static GSocket *
+setup_sender (guint16 port, GSocketAddress ** addr)
+{
+  GInetAddress *iaddr = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+  GSocket *socket;
+
+  socket = g_socket_new (G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_DATAGRAM,
+      G_SOCKET_PROTOCOL_UDP, NULL);
+  fail_unless (socket != NULL);
+  *addr = g_inet_socket_address_new (iaddr, port);
+  g_object_unref (iaddr);
+
+  return socket;
+}
+
+static void
+send_packet (GSocket * socket, GSocketAddress * addr, guint16 seqnum)
+{
+  guint8 data[PACKET_SIZE] = { 0, };
+
+  /* Minimal RTP header, the payload is not looked at */
+  data[0] = 0x80;
+  data[1] = 96;
+  GST_WRITE_UINT16_BE (data + 2, seqnum);
+
+  g_socket_send_to (socket, addr, (const gchar *) data, sizeof (data), NULL,
+      NULL);
+}
+
+static gpointer
+sender_thread (SenderData * data)
+{
+  guint i;
+
+  for (i = 0; i < data->n_packets; i++) {
+    send_packet (data->socket, data->addr, i);
+    /* Give the receiver a chance to keep up on the loopback device */
+    if ((i & 0x3f) == 0x3f)
+      g_usleep (200);
+  }
+
+  return NULL;
+}
+
+GST_START_TEST (test_receive_batch)
+{
+  GstHarness *h;
+  GSocket *socket;
+  GSocketAddress *addr;
+  GstBuffer *buf;
+  guint16 port;
+  guint i;
+
+  h = setup_recvsrc (16, 0, 1, &port);
+  socket = setup_sender (port, &addr);
+
+  for (i = 0; i < 40; i++)
+    send_packet (socket, addr, i);
+
+  for (i = 0; i < 40; i++) {
+    GstMapInfo map;
+
+    buf = gst_harness_pull (h);
+    fail_unless (buf != NULL);
+    fail_unless_equals_int (gst_buffer_get_size (buf), PACKET_SIZE);
+    fail_unless (GST_BUFFER_PTS_IS_VALID (buf));
+
+    gst_buffer_map (buf, &map, GST_MAP_READ);
+    fail_unless_equals_int (GST_READ_UINT16_BE (map.data + 2), i);
+    gst_buffer_unmap (buf, &map);
+
+    gst_buffer_unref (buf);
+  }
+
+  g_object_unref (addr);
+  g_object_unref (socket);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static gdouble
+measure_packet_rate (guint batch_size, guint n_threads, guint * received)
+{
+  GstHarness *h;
+  GThread *thread;
+  SenderData data;
+  GstBuffer *buf;
+  gint64 start, end, deadline;
+  guint16 port;
+
+  h = setup_recvsrc (batch_size, 0, n_threads, &port);
+  data.socket = setup_sender (port, &data.addr);
+  data.n_packets = N_PACKETS;
+
+  *received = 0;
+  start = g_get_monotonic_time ();
+  deadline = start + 10 * G_USEC_PER_SEC;
+  thread = g_thread_new ("sender", (GThreadFunc) sender_thread, &data);
+
+  end = start;
+  while (*received < N_PACKETS && g_get_monotonic_time () < deadline) {
+    buf = gst_harness_try_pull (h);
+    if (buf == NULL) {
+      g_usleep (100);
+      continue;
+    }
+    end = g_get_monotonic_time ();
+    *received += 1;
+    gst_buffer_unref (buf);
+  }
+
+  g_thread_join (thread);
+  g_object_unref (data.addr);
+  g_object_unref (data.socket);
+  gst_harness_teardown (h);
+
+  if (end == start)
+    return 0.0;
+
+  return *received * (gdouble) G_USEC_PER_SEC / (end - start);
+}
+
+/* Report the packet rate for single and batched receiving over the
+ * loopback interface. The actual gain depends on the machine, so only
+ * the delivery is checked, the numbers are logged. */
+GST_START_TEST (test_receive_rate)
+{
+  guint received_single, received_batch, received_threads;
+  gdouble rate_single, rate_batch, rate_threads;
+
+  rate_single = measure_packet_rate (1, 1, &received_single);
+  rate_batch = measure_packet_rate (32, 1, &received_batch);
+  rate_threads = measure_packet_rate (32, 4, &received_threads);
+
+  GST_INFO ("batch-size 1: %u/%u packets, %.0f packets/s",
+      received_single, N_PACKETS, rate_single);
+  GST_INFO ("batch-size 32: %u/%u packets, %.0f packets/s (x%.2f)",
+      received_batch, N_PACKETS, rate_batch,
+      rate_single > 0 ? rate_batch / rate_single : 0.0);
+  GST_INFO ("batch-size 32, 4 threads: %u/%u packets, %.0f packets/s (x%.2f)",
+      received_threads, N_PACKETS, rate_threads,
+      rate_single > 0 ? rate_threads / rate_single : 0.0);
+
+  fail_unless (received_single > 0);
+  fail_unless (received_batch > 0);
+  fail_unless (received_threads > 0);
+}
+
+GST_END_TEST;
+
+/* Receive a number of rounds of packets, releasing every packet before
+ * the next round, and return the allocation statistics. */
+static GstStructure *
+receive_rounds (guint pool_size, guint rounds, guint per_round)
+{
+  GstHarness *h;
+  GSocket *socket;
+  GSocketAddress *addr;
+  GstStructure *stats;
+  guint16 port;
+  guint i, j;
+
+  h = setup_recvsrc (8, pool_size, 1, &port);
+  socket = setup_sender (port, &addr);
+
+  for (i = 0; i < rounds; i++) {
+    for (j = 0; j < per_round; j++)
+      send_packet (socket, addr, i * per_round + j);
+
+    for (j = 0; j < per_round; j++) {
+      GstBuffer *buf = gst_harness_pull (h);
+
+      fail_unless (buf != NULL);
+      fail_unless_equals_int (gst_buffer_get_size (buf), PACKET_SIZE);
+      gst_buffer_unref (buf);
+    }
+  }
+
+  g_object_get (h->element, "stats", &stats, NULL);
+
+  g_object_unref (addr);
+  g_object_unref (socket);
+  gst_harness_teardown (h);
+
+  return stats;
+}
+
+GST_START_TEST (test_pool_recycles_buffers)
+{
+  GstStructure *stats;
+  guint64 packets, allocations, pool_misses;
+
+  /* Without a pool, every packet gets a new buffer */
+  stats = receive_rounds (0, 10, 16);
+  fail_unless (gst_structure_get (stats,
+          "packets-received", G_TYPE_UINT64, &packets,
+          "allocations", G_TYPE_UINT64, &allocations, NULL));
+  GST_INFO ("no pool: %" G_GUINT64_FORMAT " allocations for %"
+      G_GUINT64_FORMAT " packets", allocations, packets);
+  fail_unless_equals_uint64 (packets, 160);
+  fail_unless (allocations >= packets);
+  gst_structure_free (stats);
+
+  /* With a pool that is larger than the number of packets in flight, the
+   * only allocations are the ones done when the pool is activated. */
+  stats = receive_rounds (32, 10, 16);
+  fail_unless (gst_structure_get (stats,
+          "packets-received", G_TYPE_UINT64, &packets,
+          "allocations", G_TYPE_UINT64, &allocations,
+          "pool-misses", G_TYPE_UINT64, &pool_misses, NULL));
+  GST_INFO ("pool of 32: %" G_GUINT64_FORMAT " allocations for %"
+      G_GUINT64_FORMAT " packets", allocations, packets);
+  fail_unless_equals_uint64 (packets, 160);
+  fail_unless_equals_uint64 (allocations, 32);
+  fail_unless_equals_uint64 (pool_misses, 0);
+  gst_structure_free (stats);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_pool_exhausted)
+{
+  GstHarness *h;
+  GSocket *socket;
+  GSocketAddress *addr;
+  GstStructure *stats;
+  GQueue held = G_QUEUE_INIT;
+  guint64 packets, pool_misses;
+  guint16 port;
+  guint i;
+
+  /* Holding on to more buffers than the pool contains falls back to
+   * allocating, without losing packets. */
+  h = setup_recvsrc (8, 16, 1, &port);
+  socket = setup_sender (port, &addr);
+
+  for (i = 0; i < 40; i++)
+    send_packet (socket, addr, i);
+
+  for (i = 0; i < 40; i++) {
+    GstBuffer *buf = gst_harness_pull (h);
+
+    fail_unless (buf != NULL);
+    g_queue_push_tail (&held, buf);
+  }
+
+  g_object_get (h->element, "stats", &stats, NULL);
+  fail_unless (gst_structure_get (stats,
+          "packets-received", G_TYPE_UINT64, &packets,
+          "pool-misses", G_TYPE_UINT64, &pool_misses, NULL));
+  fail_unless_equals_uint64 (packets, 40);
+  fail_unless (pool_misses >= 40 - 16);
+  gst_structure_free (stats);
+
+  g_object_unref (addr);
+  g_object_unref (socket);
+  gst_harness_teardown (h);
+
+  /* Released after the pool is gone */
+  g_queue_clear_full (&held, (GDestroyNotify) gst_buffer_unref);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_receive_threads)
+{
+  GstHarness *h;
+  GSocket *socket;
+  GSocketAddress *addr;
+  GstStructure *stats;
+  guint8 seen[400] = { 0, };
+  guint64 packets;
+  guint sockets;
+  guint16 port;
+  guint i;
+
+  h = setup_recvsrc (8, 0, 4, &port);
+  socket = setup_sender (port, &addr);
+
+  g_object_get (h->element, "stats", &stats, NULL);
+  fail_unless (gst_structure_get_uint (stats, "sockets", &sockets));
+  fail_unless_equals_int (sockets, 4);
+  gst_structure_free (stats);
+
+  for (i = 0; i < G_N_ELEMENTS (seen); i++) {
+    send_packet (socket, addr, i);
+    if ((i & 0x1f) == 0x1f)
+      g_usleep (1000);
+  }
+
+  /* Every packet arrives exactly once, whichever thread received it */
+  for (i = 0; i < G_N_ELEMENTS (seen); i++) {
+    GstBuffer *buf = gst_harness_pull (h);
+    guint8 data[2];
+    guint16 seqnum;
+
+    fail_unless (buf != NULL);
+    fail_unless_equals_int (gst_buffer_get_size (buf), PACKET_SIZE);
+    fail_unless (GST_BUFFER_PTS_IS_VALID (buf));
+
+    gst_buffer_extract (buf, 2, data, 2);
+    seqnum = GST_READ_UINT16_BE (data);
+    fail_unless (seqnum < G_N_ELEMENTS (seen));
+    fail_if (seen[seqnum]);
+    seen[seqnum] = 1;
+
+    gst_buffer_unref (buf);
+  }
+
+  /* The threads count on their own */
+  g_object_get (h->element, "stats", &stats, NULL);
+  fail_unless (gst_structure_get_uint64 (stats, "packets-received",
+          &packets));
+  fail_unless_equals_uint64 (packets, G_N_ELEMENTS (seen));
+  gst_structure_free (stats);
+
+  g_object_unref (addr);
+  g_object_unref (socket);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_timestamping)
+{
+  GstHarness *h;
+  GSocket *socket;
+  GSocketAddress *addr;
+  GstStructure *stats, *delay;
+  GstCaps *caps;
+  guint64 count;
+  gint64 before;
+  guint16 port;
+  guint i;
+
+  h = gst_harness_new ("nrtp_recvsrc");
+  g_object_set (h->element, "address", "127.0.0.1", "port", 0,
+      "batch-size", 8, "timestamping", TRUE, NULL);
+  gst_harness_use_systemclock (h);
+  gst_harness_play (h);
+
+  g_object_get (h->element, "used-socket", &socket, NULL);
+  addr = g_socket_get_local_address (socket, NULL);
+  port = g_inet_socket_address_get_port (G_INET_SOCKET_ADDRESS (addr));
+  g_object_unref (addr);
+  g_object_unref (socket);
+
+  socket = setup_sender (port, &addr);
+  caps = gst_caps_new_empty_simple ("timestamp/x-unix");
+
+  before = g_get_real_time ();
+  for (i = 0; i < 10; i++)
+    send_packet (socket, addr, i);
+
+  /* The arrival time is taken by the kernel, between sending and now */
+  for (i = 0; i < 10; i++) {
+    GstBuffer *buf = gst_harness_pull (h);
+    GstReferenceTimestampMeta *meta;
+
+    fail_unless (buf != NULL);
+    meta = gst_buffer_get_reference_timestamp_meta (buf, caps);
+    fail_unless (meta != NULL);
+    fail_unless (meta->timestamp >= before * GST_USECOND);
+    fail_unless (meta->timestamp <= g_get_real_time () * GST_USECOND);
+
+    gst_buffer_unref (buf);
+  }
+
+  g_object_get (h->element, "stats", &stats, NULL);
+  fail_unless (gst_structure_get (stats, "socket-delay", GST_TYPE_STRUCTURE,
+          &delay, NULL));
+  fail_unless (gst_structure_get_uint64 (delay, "count", &count));
+  fail_unless_equals_int (count, 10);
+  fail_unless (gst_structure_has_field_typed (delay, "buckets",
+          GST_TYPE_ARRAY));
+  gst_structure_free (delay);
+  gst_structure_free (stats);
+
+  gst_caps_unref (caps);
+  g_object_unref (addr);
+  g_object_unref (socket);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_io_uring)
+{
+  GstHarness *h;
+  GSocket *socket;
+  GSocketAddress *addr;
+  GstStructure *stats;
+  GQueue held = G_QUEUE_INIT;
+  guint64 packets, pool_misses;
+  gboolean io_uring;
+  guint pool_size;
+  guint16 port;
+  guint i;
+
+  /* Falls back to recvmmsg() where io_uring is not available, the packets
+   * must arrive either way. */
+  h = gst_harness_new ("nrtp_recvsrc");
+  g_object_set (h->element, "address", "127.0.0.1", "port", 0,
+      "batch-size", 8, "pool-size", 16, "io-uring", TRUE, NULL);
+  gst_harness_use_systemclock (h);
+  gst_harness_play (h);
+
+  g_object_get (h->element, "used-socket", &socket, NULL);
+  addr = g_socket_get_local_address (socket, NULL);
+  port = g_inet_socket_address_get_port (G_INET_SOCKET_ADDRESS (addr));
+  g_object_unref (addr);
+  g_object_unref (socket);
+  socket = setup_sender (port, &addr);
+
+  /* Holding all buffers of the ring stops the receive, the remaining
+   * packets wait in the socket buffer until the buffers are released. */
+  for (i = 0; i < 40; i++)
+    send_packet (socket, addr, i);
+
+  for (i = 0; i < 16; i++) {
+    GstBuffer *buf = gst_harness_pull (h);
+
+    fail_unless (buf != NULL);
+    fail_unless_equals_int (gst_buffer_get_size (buf), PACKET_SIZE);
+    g_queue_push_tail (&held, buf);
+  }
+  g_queue_clear_full (&held, (GDestroyNotify) gst_buffer_unref);
+
+  for (i = 16; i < 40; i++) {
+    GstBuffer *buf = gst_harness_pull (h);
+    guint8 data[4];
+
+    fail_unless (buf != NULL);
+    gst_buffer_extract (buf, 0, data, 4);
+    fail_unless_equals_int (GST_READ_UINT16_BE (data + 2), i);
+    g_queue_push_tail (&held, buf);
+  }
+
+  g_object_get (h->element, "stats", &stats, NULL);
+  fail_unless (gst_structure_get (stats,
+          "packets-received", G_TYPE_UINT64, &packets,
+          "pool-misses", G_TYPE_UINT64, &pool_misses,
+          "pool-size", G_TYPE_UINT, &pool_size,
+          "io-uring", G_TYPE_BOOLEAN, &io_uring, NULL));
+  GST_INFO ("io_uring %s, %" G_GUINT64_FORMAT " pool misses",
+      io_uring ? "used" : "not supported", pool_misses);
+  fail_unless_equals_uint64 (packets, 40);
+  fail_unless_equals_int (pool_size, 16);
+  fail_unless (pool_misses > 0);
+  gst_structure_free (stats);
+
+  g_object_unref (addr);
+  g_object_unref (socket);
+  gst_harness_teardown (h);
+
+  /* Released after the ring is stopped */
+  g_queue_clear_full (&held, (GDestroyNotify) gst_buffer_unref);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_spin)
+{
+  GstHarness *h;
+  GSocket *socket;
+  GSocketAddress *addr;
+  guint16 port;
+  guint i;
+
+  /* The packets arrive while spinning as well as after blocking */
+  h = gst_harness_new ("nrtp_recvsrc");
+  g_object_set (h->element, "address", "127.0.0.1", "port", 0,
+      "batch-size", 8, "spin-time", 1000, NULL);
+  gst_harness_use_systemclock (h);
+  gst_harness_play (h);
+
+  g_object_get (h->element, "used-socket", &socket, NULL);
+  addr = g_socket_get_local_address (socket, NULL);
+  port = g_inet_socket_address_get_port (G_INET_SOCKET_ADDRESS (addr));
+  g_object_unref (addr);
+  g_object_unref (socket);
+  socket = setup_sender (port, &addr);
+
+  for (i = 0; i < 20; i++) {
+    GstBuffer *buf;
+    guint8 data[4];
+
+    send_packet (socket, addr, i);
+    if (i % 5 == 0)
+      g_usleep (5000);
+
+    buf = gst_harness_pull (h);
+    fail_unless (buf != NULL);
+    gst_buffer_extract (buf, 0, data, 4);
+    fail_unless_equals_int (GST_READ_UINT16_BE (data + 2), i);
+    gst_buffer_unref (buf);
+  }
+
+  g_object_unref (addr);
+  g_object_unref (socket);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+#ifdef __linux__
+GST_START_TEST (test_socket_options)
+{
+  GstHarness *h;
+  GstStructure *options;
+  GSocket *socket;
+  gint value;
+
+  /* Both are allowed without CAP_NET_ADMIN, the kernel doubles the buffer
+   * size it was given */
+  options = gst_structure_new ("application/x-rtp-socket-options",
+      "buffer-size", G_TYPE_INT, 65536, "priority", G_TYPE_INT, 3, NULL);
+  h = gst_harness_new ("nrtp_recvsrc");
+  g_object_set (h->element, "address", "127.0.0.1", "port", 0,
+      "socket-options", options, NULL);
+  gst_structure_free (options);
+  gst_harness_play (h);
+
+  g_object_get (h->element, "used-socket", &socket, NULL);
+  fail_unless (G_IS_SOCKET (socket));
+  fail_unless (g_socket_get_option (socket, SOL_SOCKET, SO_RCVBUF, &value,
+          NULL));
+  fail_unless_equals_int (value, 2 * 65536);
+  fail_unless (g_socket_get_option (socket, SOL_SOCKET, SO_PRIORITY, &value,
+          NULL));
+  fail_unless_equals_int (value, 3);
+  g_object_unref (socket);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_overflow)
+{
+  GstHarness *h;
+  GstStructure *options, *stats;
+  const GstStructure *s;
+  GstMessage *message;
+  GSocket *socket;
+  GSocketAddress *addr;
+  GstBus *bus;
+  guint64 drops, total, kernel_drops;
+  gint size;
+  guint16 port;
+  guint i;
+
+  options = gst_structure_new ("application/x-rtp-socket-options",
+      "buffer-size", G_TYPE_INT, 4096, NULL);
+  h = gst_harness_new ("nrtp_recvsrc");
+  g_object_set (h->element, "address", "127.0.0.1", "port", 0,
+      "batch-size", 8, "socket-options", options, "detect-overflows", TRUE,
+      "max-buffer-size", 65536, NULL);
+  gst_structure_free (options);
+  bus = gst_bus_new ();
+  gst_element_set_bus (h->element, bus);
+  gst_harness_use_systemclock (h);
+
+  /* A live source only reads when playing, the packets sent before that
+   * overflow the small receive buffer */
+  fail_unless (gst_element_set_state (h->element, GST_STATE_PAUSED) ==
+      GST_STATE_CHANGE_NO_PREROLL);
+  g_object_get (h->element, "used-socket", &socket, NULL);
+  addr = g_socket_get_local_address (socket, NULL);
+  port = g_inet_socket_address_get_port (G_INET_SOCKET_ADDRESS (addr));
+  g_object_unref (addr);
+  g_object_unref (socket);
+
+  socket = setup_sender (port, &addr);
+  for (i = 0; i < 200; i++)
+    send_packet (socket, addr, i);
+
+  /* The packets that fit carry the drop counter */
+  gst_harness_play (h);
+  gst_buffer_unref (gst_harness_pull (h));
+
+  message = gst_bus_timed_pop_filtered (bus, 5 * GST_SECOND,
+      GST_MESSAGE_ELEMENT);
+  fail_unless (message != NULL);
+  s = gst_message_get_structure (message);
+  fail_unless (gst_structure_has_name (s,
+          "application/x-rtp-recv-src-overflow"));
+  fail_unless (gst_structure_get (s, "drops", G_TYPE_UINT64, &drops,
+          "total-drops", G_TYPE_UINT64, &total, "buffer-size", G_TYPE_INT,
+          &size, NULL));
+  fail_unless (drops > 0);
+  fail_unless_equals_uint64 (drops, total);
+  /* Doubled once */
+  fail_unless_equals_int (size, 2 * 4096);
+  gst_message_unref (message);
+
+  g_object_get (h->element, "stats", &stats, NULL);
+  fail_unless (gst_structure_get_uint64 (stats, "kernel-drops",
+          &kernel_drops));
+  fail_unless (kernel_drops >= total);
+  gst_structure_free (stats);
+
+  g_object_unref (addr);
+  g_object_unref (socket);
+  gst_harness_teardown (h);
+  gst_object_unref (bus);
+}
+
+GST_END_TEST;
+#endif
+
+static Suite *
+rtprecvsrc_suite (void)
+{
+  Suite *s = suite_create ("rtprecvsrc");
+  TCase *tc_chain = tcase_create ("general");
+
+  GST_DEBUG_CATEGORY_INIT (rtprecvsrc_test_debug, "rtprecvsrc-test", 0,
+      "nrtp_recvsrc test");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_set_timeout (tc_chain, 60);
+  tcase_add_test (tc_chain, test_receive_batch);
+  tcase_add_test (tc_chain, test_receive_rate);
+  tcase_add_test (tc_chain, test_pool_recycles_buffers);
+  tcase_add_test (tc_chain, test_pool_exhausted);
+  tcase_add_test (tc_chain, test_receive_threads);
+  tcase_add_test (tc_chain, test_timestamping);
+  tcase_add_test (tc_chain, test_io_uring);
+  tcase_add_test (tc_chain, test_spin);
+#ifdef __linux__
+  tcase_add_test (tc_chain, test_socket_options);
+  tcase_add_test (tc_chain, test_overflow);
+#endif
+
+  return s;
+}
+
+GST_CHECK_MAIN (rtprecvsrc);
@@ -0,0 +1,326 @@
+/* GStreamer
+ * Copyright (C) <2018> Marc Leeman <marc.leeman@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/rtp/gstrtpbuffer.h>
+
+#define SSRC 0x12345678
+#define PAYLOAD_LEN 100
+
+static GstBuffer *
+create_media (guint16 seq, guint8 pt, GstClockTime pts)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  GstBuffer *buf;
+  guint8 *payload;
+  guint i;
+
+  buf = gst_rtp_buffer_new_allocate (PAYLOAD_LEN, 0, 0);
+  gst_rtp_buffer_map (buf, GST_MAP_WRITE, &rtp);
+  gst_rtp_buffer_set_payload_type (&rtp, pt);
+  gst_rtp_buffer_set_seq (&rtp, seq);
+  gst_rtp_buffer_set_timestamp (&rtp, seq * 3000);
+  gst_rtp_buffer_set_ssrc (&rtp, SSRC);
+  payload = gst_rtp_buffer_get_payload (&rtp);
+  for (i = 0; i < PAYLOAD_LEN; i++)
+    payload[i] = seq + i * 7;
+  gst_rtp_buffer_unmap (&rtp);
+  GST_BUFFER_PTS (buf) = pts;
+
+  return buf;
+}
+
+/* A sender retransmitting payload type 96 as 97 */
+static GstHarness *
+setup_harness (guint max_size_time, guint max_size_bytes)
+{
+  GstElement *rtxsend = gst_element_factory_make ("nrtp_rtxsend", NULL);
+  GstStructure *pt_map;
+  GstHarness *h;
+
+  pt_map = gst_structure_new ("application/x-rtp-pt-map",
+      "96", G_TYPE_UINT, 97, NULL);
+  g_object_set (rtxsend, "payload-type-map", pt_map, "max-size-time",
+      max_size_time, "max-size-bytes", max_size_bytes, NULL);
+  gst_structure_free (pt_map);
+
+  h = gst_harness_new_with_element (rtxsend, "sink", "src");
+  gst_harness_set_src_caps_str (h, "application/x-rtp");
+  gst_object_unref (rtxsend);
+
+  return h;
+}
+
+static void
+push_media (GstHarness * h, guint16 first, guint count, guint8 pt)
+{
+  guint i;
+
+  for (i = 0; i < count; i++) {
+    guint16 seq = first + i;
+
+    fail_unless_equals_int (gst_harness_push (h, create_media (seq, pt,
+                i * 10 * GST_MSECOND)), GST_FLOW_OK);
+    gst_buffer_unref (gst_harness_pull (h));
+  }
+}
+
+static void
+request (GstHarness * h, guint16 seq)
+{
+  gst_harness_push_upstream_event (h,
+      gst_event_new_custom (GST_EVENT_CUSTOM_UPSTREAM,
+          gst_structure_new ("GstRTPRetransmissionRequest",
+              "seqnum", G_TYPE_UINT, (guint) seq,
+              "ssrc", G_TYPE_UINT, (guint) SSRC, NULL)));
+}
+
+/* The retransmissions go out in front of the next media packet, push one
+ * that is not retransmitted and return what came before it */
+static GstBuffer *
+pull_rtx (GstHarness * h)
+{
+  GstBuffer *buf;
+
+  fail_unless_equals_int (gst_harness_push (h, create_media (0, 98, 0)),
+      GST_FLOW_OK);
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 2);
+  buf = gst_harness_pull (h);
+  gst_buffer_unref (gst_harness_pull (h));
+
+  return buf;
+}
+
+static void
+check_no_rtx (GstHarness * h)
+{
+  fail_unless_equals_int (gst_harness_push (h, create_media (0, 98, 0)),
+      GST_FLOW_OK);
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 1);
+  gst_buffer_unref (gst_harness_pull (h));
+}
+
+/* Check that @buf is the retransmission of packet @seq */
+static void
+check_rtx (GstBuffer * buf, guint16 seq)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  guint8 *payload;
+  guint i;
+
+  fail_unless (gst_rtp_buffer_map (buf, GST_MAP_READ, &rtp));
+  fail_unless_equals_int (gst_rtp_buffer_get_payload_type (&rtp), 97);
+  fail_unless (gst_rtp_buffer_get_ssrc (&rtp) != SSRC);
+  fail_unless_equals_int (gst_rtp_buffer_get_timestamp (&rtp), seq * 3000);
+  fail_unless_equals_int (gst_rtp_buffer_get_payload_len (&rtp),
+      2 + PAYLOAD_LEN);
+  payload = gst_rtp_buffer_get_payload (&rtp);
+  fail_unless_equals_int (GST_READ_UINT16_BE (payload), seq);
+  for (i = 0; i < PAYLOAD_LEN; i++)
+    fail_unless_equals_int (payload[2 + i], (guint8) (seq + i * 7));
+  gst_rtp_buffer_unmap (&rtp);
+}
+
+static guint64
+get_stat (GstHarness * h, const gchar * field)
+{
+  GstStructure *stats;
+  guint64 value = 0;
+
+  g_object_get (h->element, "stats", &stats, NULL);
+  if (!gst_structure_get_uint64 (stats, field, &value)) {
+    guint v;
+
+    fail_unless (gst_structure_get_uint (stats, field, &v));
+    value = v;
+  }
+  gst_structure_free (stats);
+
+  return value;
+}
+
+GST_START_TEST (test_retransmit)
+{
+  GstHarness *h = setup_harness (0, 0);
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  GstBuffer *buf;
+  guint32 rtx_ssrc;
+  guint16 rtx_seq;
+
+  /* The sequence numbers wrap */
+  push_media (h, 65530, 10, 96);
+  fail_unless_equals_int (get_stat (h, "cached-packets"), 10);
+
+  request (h, 65533);
+  buf = pull_rtx (h);
+  check_rtx (buf, 65533);
+  gst_rtp_buffer_map (buf, GST_MAP_READ, &rtp);
+  rtx_ssrc = gst_rtp_buffer_get_ssrc (&rtp);
+  rtx_seq = gst_rtp_buffer_get_seq (&rtp);
+  gst_rtp_buffer_unmap (&rtp);
+  gst_buffer_unref (buf);
+
+  /* The retransmissions have their own sequence numbers */
+  request (h, 2);
+  buf = pull_rtx (h);
+  check_rtx (buf, 2);
+  gst_rtp_buffer_map (buf, GST_MAP_READ, &rtp);
+  fail_unless_equals_int (gst_rtp_buffer_get_ssrc (&rtp), rtx_ssrc);
+  fail_unless_equals_int (gst_rtp_buffer_get_seq (&rtp),
+      (guint16) (rtx_seq + 1));
+  gst_rtp_buffer_unmap (&rtp);
+  gst_buffer_unref (buf);
+
+  /* Neither sent yet nor from an unknown sender */
+  request (h, 100);
+  check_no_rtx (h);
+
+  fail_unless_equals_int (get_stat (h, "requests"), 3);
+  fail_unless_equals_int (get_stat (h, "retransmitted"), 2);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_unmapped_pt)
+{
+  GstHarness *h = setup_harness (0, 0);
+
+  push_media (h, 1000, 5, 98);
+  fail_unless_equals_int (get_stat (h, "cached-packets"), 0);
+
+  request (h, 1002);
+  check_no_rtx (h);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_byte_limit)
+{
+  /* Room for 10 packets of 12 + PAYLOAD_LEN bytes */
+  GstHarness *h = setup_harness (0, 10 * (12 + PAYLOAD_LEN));
+  GstBuffer *buf;
+
+  push_media (h, 1000, 50, 96);
+  fail_unless_equals_int (get_stat (h, "cached-packets"), 10);
+  fail_unless_equals_int (get_stat (h, "cached-bytes"),
+      10 * (12 + PAYLOAD_LEN));
+
+  request (h, 1039);
+  check_no_rtx (h);
+
+  request (h, 1040);
+  buf = pull_rtx (h);
+  check_rtx (buf, 1040);
+  gst_buffer_unref (buf);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_time_limit)
+{
+  /* The packets are 10 ms apart */
+  GstHarness *h = setup_harness (100, 0);
+  GstBuffer *buf;
+
+  push_media (h, 1000, 50, 96);
+  fail_unless_equals_int (get_stat (h, "cached-packets"), 11);
+
+  request (h, 1038);
+  check_no_rtx (h);
+
+  request (h, 1039);
+  buf = pull_rtx (h);
+  check_rtx (buf, 1039);
+  gst_buffer_unref (buf);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_flush)
+{
+  GstHarness *h = setup_harness (0, 0);
+
+  push_media (h, 1000, 10, 96);
+  fail_unless (gst_harness_push_event (h, gst_event_new_flush_start ()));
+  fail_unless (gst_harness_push_event (h, gst_event_new_flush_stop (TRUE)));
+  fail_unless_equals_int (get_stat (h, "cached-packets"), 0);
+
+  request (h, 1005);
+  check_no_rtx (h);
+
+  /* Queued retransmissions are dropped too */
+  push_media (h, 1000, 10, 96);
+  request (h, 1005);
+  fail_unless (gst_harness_push_event (h, gst_event_new_flush_start ()));
+  fail_unless (gst_harness_push_event (h, gst_event_new_flush_stop (TRUE)));
+  check_no_rtx (h);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_eos)
+{
+  GstHarness *h = setup_harness (0, 0);
+  GstBuffer *buf;
+
+  push_media (h, 1000, 10, 96);
+  request (h, 1005);
+  /* Not pushed from the thread of the request */
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 0);
+
+  /* Nothing else comes, they go out before the EOS */
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+  buf = gst_harness_pull (h);
+  check_rtx (buf, 1005);
+  gst_buffer_unref (buf);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static Suite *
+rtprtxsend_suite (void)
+{
+  Suite *s = suite_create ("rtprtxsend");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_retransmit);
+  tcase_add_test (tc_chain, test_unmapped_pt);
+  tcase_add_test (tc_chain, test_byte_limit);
+  tcase_add_test (tc_chain, test_time_limit);
+  tcase_add_test (tc_chain, test_flush);
+  tcase_add_test (tc_chain, test_eos);
+
+  return s;
+}
+
+GST_CHECK_MAIN (rtprtxsend);
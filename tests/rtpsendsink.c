@@ -0,0 +1,341 @@
+/* GStreamer
+ * Copyright (C) <2018> Marc Leeman <marc.leeman@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gio/gio.h>
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+
+#define PACKET_SIZE 200
+
+static GSocket *
+setup_receiver (guint16 * port)
+{
+  GInetAddress *iaddr = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+  GSocketAddress *addr;
+  GSocket *socket;
+
+  socket = g_socket_new (G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_DATAGRAM,
+      G_SOCKET_PROTOCOL_UDP, NULL);
+  fail_unless (socket != NULL);
+  g_socket_set_timeout (socket, 5);
+
+  addr = g_inet_socket_address_new (iaddr, 0);
+  fail_unless (g_socket_bind (socket, addr, TRUE, NULL));
+  g_object_unref (addr);
+  g_object_unref (iaddr);
+
+  addr = g_socket_get_local_address (socket, NULL);
+  *port = g_inet_socket_address_get_port (G_INET_SOCKET_ADDRESS (addr));
+  g_object_unref (addr);
+
+  return socket;
+}
+
+static GstHarness *
+setup_sendsink (guint16 port, guint batch_size, guint batch_timeout)
+{
+  GstHarness *h;
+
+  h = gst_harness_new ("nrtp_sendsink");
+  g_object_set (h->element, "host", "127.0.0.1", "port", port,
+      "batch-size", batch_size, "batch-timeout", batch_timeout,
+      "sync", FALSE, NULL);
+  gst_harness_set_src_caps_str (h, "application/x-rtp");
+  gst_harness_play (h);
+
+  return h;
+}
+
+static GstBuffer *
+create_packet (guint16 seqnum, gsize size)
+{
+  GstBuffer *buf = gst_buffer_new_allocate (NULL, size, NULL);
+  GstMapInfo map;
+
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  memset (map.data, 0, map.size);
+  map.data[0] = 0x80;
+  map.data[1] = 96;
+  GST_WRITE_UINT16_BE (map.data + 2, seqnum);
+  gst_buffer_unmap (buf, &map);
+
+  return buf;
+}
+
+static void
+check_received (GSocket * socket, guint16 seqnum, gsize size)
+{
+  guint8 data[2048];
+  gssize len;
+
+  len = g_socket_receive (socket, (gchar *) data, sizeof (data), NULL, NULL);
+  fail_unless_equals_int (len, size);
+  fail_unless_equals_int (GST_READ_UINT16_BE (data + 2), seqnum);
+}
+
+GST_START_TEST (test_send_list)
+{
+  GstBufferList *list;
+  GstHarness *h;
+  GSocket *socket;
+  guint16 port;
+  guint i;
+
+  socket = setup_receiver (&port);
+  h = setup_sendsink (port, 16, 1000);
+
+  /* Equal sized packets with a shorter last one, as sent for a large
+   * frame; these can be sent as GSO datagrams */
+  list = gst_buffer_list_new ();
+  for (i = 0; i < 39; i++)
+    gst_buffer_list_add (list, create_packet (i, PACKET_SIZE));
+  gst_buffer_list_add (list, create_packet (39, PACKET_SIZE / 2));
+  fail_unless_equals_int (gst_pad_push_list (h->srcpad, list), GST_FLOW_OK);
+
+  for (i = 0; i < 39; i++)
+    check_received (socket, i, PACKET_SIZE);
+  check_received (socket, 39, PACKET_SIZE / 2);
+
+  gst_harness_teardown (h);
+  g_object_unref (socket);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_send_timeout)
+{
+  GstHarness *h;
+  GSocket *socket;
+  guint16 port;
+  guint i;
+
+  socket = setup_receiver (&port);
+  /* The batch never fills up, the timeout has to flush it */
+  h = setup_sendsink (port, 32, 2000);
+
+  for (i = 0; i < 3; i++)
+    fail_unless_equals_int (gst_harness_push (h, create_packet (i,
+                PACKET_SIZE)), GST_FLOW_OK);
+
+  for (i = 0; i < 3; i++)
+    check_received (socket, i, PACKET_SIZE);
+
+  gst_harness_teardown (h);
+  g_object_unref (socket);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_send_eos)
+{
+  GstHarness *h;
+  GSocket *socket;
+  guint16 port;
+
+  socket = setup_receiver (&port);
+  /* Without a timeout, only EOS can flush an incomplete batch */
+  h = setup_sendsink (port, 32, G_MAXUINT);
+
+  fail_unless_equals_int (gst_harness_push (h, create_packet (0,
+              PACKET_SIZE)), GST_FLOW_OK);
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  check_received (socket, 0, PACKET_SIZE);
+
+  gst_harness_teardown (h);
+  g_object_unref (socket);
+}
+
+GST_END_TEST;
+
+static void
+check_stats (GstElement * sink, guint16 port, guint64 packets, guint64 bytes)
+{
+  GstStructure *stats = NULL;
+  guint64 value;
+
+  g_signal_emit_by_name (sink, "get-stats", "127.0.0.1", (gint) port, &stats);
+  fail_unless (stats != NULL);
+  fail_unless (gst_structure_get_uint64 (stats, "packets-sent", &value));
+  fail_unless_equals_uint64 (value, packets);
+  fail_unless (gst_structure_get_uint64 (stats, "bytes-sent", &value));
+  fail_unless_equals_uint64 (value, bytes);
+  gst_structure_free (stats);
+}
+
+GST_START_TEST (test_send_destinations)
+{
+  GstBufferList *list;
+  GstHarness *h;
+  GSocket *socket1, *socket2;
+  guint16 port1, port2;
+  guint8 data[2048];
+  guint i;
+
+  socket1 = setup_receiver (&port1);
+  socket2 = setup_receiver (&port2);
+  h = setup_sendsink (port1, 16, 1000);
+
+  g_signal_emit_by_name (h->element, "add", "127.0.0.1", (gint) port2);
+
+  /* One batch goes to both destinations */
+  list = gst_buffer_list_new ();
+  for (i = 0; i < 4; i++)
+    gst_buffer_list_add (list, create_packet (i, PACKET_SIZE));
+  fail_unless_equals_int (gst_pad_push_list (h->srcpad, list), GST_FLOW_OK);
+
+  for (i = 0; i < 4; i++) {
+    check_received (socket1, i, PACKET_SIZE);
+    check_received (socket2, i, PACKET_SIZE);
+  }
+  check_stats (h->element, port1, 4, 4 * PACKET_SIZE);
+  check_stats (h->element, port2, 4, 4 * PACKET_SIZE);
+
+  /* After removing, only the first destination receives */
+  g_signal_emit_by_name (h->element, "remove", "127.0.0.1", (gint) port2);
+  list = gst_buffer_list_new ();
+  gst_buffer_list_add (list, create_packet (4, PACKET_SIZE));
+  fail_unless_equals_int (gst_pad_push_list (h->srcpad, list), GST_FLOW_OK);
+
+  check_received (socket1, 4, PACKET_SIZE);
+  g_socket_set_timeout (socket2, 1);
+  fail_unless (g_socket_receive (socket2, (gchar *) data, sizeof (data),
+          NULL, NULL) < 0);
+  check_stats (h->element, port1, 5, 5 * PACKET_SIZE);
+
+  gst_harness_teardown (h);
+  g_object_unref (socket1);
+  g_object_unref (socket2);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_change_port)
+{
+  GstHarness *h;
+  GSocket *socket1, *socket2;
+  guint16 port1, port2;
+  guint8 data[2048];
+
+  socket1 = setup_receiver (&port1);
+  socket2 = setup_receiver (&port2);
+  h = setup_sendsink (port1, 1, 1000);
+
+  fail_unless_equals_int (gst_harness_push (h, create_packet (0,
+              PACKET_SIZE)), GST_FLOW_OK);
+  check_received (socket1, 0, PACKET_SIZE);
+
+  /* The new port replaces the old one while playing */
+  g_object_set (h->element, "port", (gint) port2, NULL);
+  fail_unless_equals_int (gst_harness_push (h, create_packet (1,
+              PACKET_SIZE)), GST_FLOW_OK);
+  check_received (socket2, 1, PACKET_SIZE);
+  g_socket_set_timeout (socket1, 1);
+  fail_unless (g_socket_receive (socket1, (gchar *) data, sizeof (data),
+          NULL, NULL) < 0);
+
+  gst_harness_teardown (h);
+  g_object_unref (socket1);
+  g_object_unref (socket2);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_send_zerocopy)
+{
+  GstBufferList *list;
+  GstStructure *stats;
+  GstHarness *h;
+  GSocket *socket;
+  guint16 port;
+  guint64 zc_sends, copied_sends, completed;
+  guint in_flight;
+  gboolean enabled;
+  guint i;
+
+  socket = setup_receiver (&port);
+
+  /* A zero threshold sends every message with MSG_ZEROCOPY */
+  h = gst_harness_new ("nrtp_sendsink");
+  g_object_set (h->element, "host", "127.0.0.1", "port", port,
+      "batch-size", 16, "batch-timeout", 1000, "sync", FALSE,
+      "zerocopy", TRUE, "zerocopy-threshold", 0, NULL);
+  gst_harness_set_src_caps_str (h, "application/x-rtp");
+  gst_harness_play (h);
+
+  list = gst_buffer_list_new ();
+  for (i = 0; i < 32; i++)
+    gst_buffer_list_add (list, create_packet (i, PACKET_SIZE));
+  fail_unless_equals_int (gst_pad_push_list (h->srcpad, list), GST_FLOW_OK);
+  for (i = 0; i < 32; i++)
+    check_received (socket, i, PACKET_SIZE);
+
+  /* Above the threshold everything is copied, whatever the kernel supports */
+  g_object_set (h->element, "zerocopy-threshold", G_MAXUINT, NULL);
+  list = gst_buffer_list_new ();
+  for (i = 32; i < 48; i++)
+    gst_buffer_list_add (list, create_packet (i, PACKET_SIZE));
+  fail_unless_equals_int (gst_pad_push_list (h->srcpad, list), GST_FLOW_OK);
+  for (i = 32; i < 48; i++)
+    check_received (socket, i, PACKET_SIZE);
+  check_stats (h->element, port, 48, 48 * PACKET_SIZE);
+
+  g_object_get (h->element, "zerocopy-stats", &stats, NULL);
+  fail_unless (gst_structure_get (stats,
+          "enabled", G_TYPE_BOOLEAN, &enabled,
+          "zerocopy-sends", G_TYPE_UINT64, &zc_sends,
+          "copied-sends", G_TYPE_UINT64, &copied_sends,
+          "completed", G_TYPE_UINT64, &completed,
+          "in-flight", G_TYPE_UINT, &in_flight, NULL));
+  gst_structure_free (stats);
+
+  /* Kernels without SO_ZEROCOPY fall back to copying */
+  if (enabled) {
+    fail_unless (zc_sends > 0);
+    fail_unless (copied_sends > 0);
+  } else {
+    fail_unless_equals_uint64 (zc_sends, 0);
+  }
+  fail_unless_equals_uint64 (completed + in_flight, zc_sends);
+
+  /* Stopping waits for outstanding completions and releases the buffers */
+  gst_harness_teardown (h);
+  g_object_unref (socket);
+}
+
+GST_END_TEST;
+
+static Suite *
+rtpsendsink_suite (void)
+{
+  Suite *s = suite_create ("rtpsendsink");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_send_list);
+  tcase_add_test (tc_chain, test_send_timeout);
+  tcase_add_test (tc_chain, test_send_eos);
+  tcase_add_test (tc_chain, test_send_destinations);
+  tcase_add_test (tc_chain, test_change_port);
+  tcase_add_test (tc_chain, test_send_zerocopy);
+
+  return s;
+}
+
+GST_CHECK_MAIN (rtpsendsink);
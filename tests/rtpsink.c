@@ -17,30 +17,560 @@
  * Boston, MA 02110-1301, USA.
  */
 
+#include <gio/gio.h>
 #include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/rtp/gstrtpbuffer.h>
+
+/* A resolver that only answers once it is opened and counts the lookups,
+ * names ending in .invalid are not found */
+typedef struct
+{
+  GResolver parent;
+} TestResolver;
+
+typedef struct
+{
+  GResolverClass parent_class;
+} TestResolverClass;
+
+static GMutex resolver_lock;
+static GCond resolver_cond;
+static gboolean resolver_open;
+static guint resolver_lookups;
+
+G_DEFINE_TYPE (TestResolver, test_resolver, G_TYPE_RESOLVER);
+
+static GList *
+test_resolver_lookup_by_name (GResolver * resolver, const gchar * hostname,
+    GCancellable * cancellable, GError ** error)
+{
+  g_mutex_lock (&resolver_lock);
+  resolver_lookups++;
+  while (!resolver_open)
+    g_cond_wait (&resolver_cond, &resolver_lock);
+  g_mutex_unlock (&resolver_lock);
+
+  if (g_str_has_suffix (hostname, ".invalid")) {
+    g_set_error (error, G_RESOLVER_ERROR, G_RESOLVER_ERROR_NOT_FOUND,
+        "No such host %s", hostname);
+    return NULL;
+  }
+
+  return g_list_append (NULL,
+      g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4));
+}
+
+static void
+test_resolver_class_init (TestResolverClass * klass)
+{
+  G_RESOLVER_CLASS (klass)->lookup_by_name = test_resolver_lookup_by_name;
+}
+
+static void
+test_resolver_init (TestResolver * resolver)
+{
+}
+
+static void
+test_resolver_open (gboolean open)
+{
+  g_mutex_lock (&resolver_lock);
+  resolver_open = open;
+  g_cond_broadcast (&resolver_cond);
+  g_mutex_unlock (&resolver_lock);
+}
+
+static guint
+test_resolver_get_lookups (void)
+{
+  guint lookups;
+
+  g_mutex_lock (&resolver_lock);
+  lookups = resolver_lookups;
+  g_mutex_unlock (&resolver_lock);
+
+  return lookups;
+}
 
 GST_START_TEST (test_uri_to_properties)
 {
   GstElement *rtpsink;
 
   gint ttl, ttl_mc;
+  guint batch_size, batch_timeout;
+  gchar *destinations;
+  gboolean pacing;
+  guint64 pacing_bitrate;
+  gboolean zerocopy;
+  guint zerocopy_threshold;
+  gint buffer_size, busy_poll, priority, dscp, incoming_cpu;
+  gint realtime_priority;
+  gchar *cpu_affinity;
+  gboolean fec;
+  guint fec_columns, fec_rows;
+  gboolean rtx;
+  gchar *rtx_pt_map;
+  guint rtx_cache_time, rtx_cache_size;
 
   rtpsink = gst_element_factory_make ("nrtp_rtpsink", NULL);
 
   /* Sets properties to non-default values (make sure this stays in sync) */
-  g_object_set (rtpsink, "uri", "rtp://1.230.1.2:1234?" "ttl=8" "&ttl-mc=9",
-      NULL);
+  g_object_set (rtpsink, "uri", "rtp://1.230.1.2:1234?" "ttl=8" "&ttl-mc=9"
+      "&batch-size=16" "&batch-timeout=500"
+      "&destinations=1.230.1.3:1234,1236" "&pacing=true"
+      "&pacing-bitrate=5000000" "&zerocopy=true"
+      "&zerocopy-threshold=20000" "&buffer-size=4194304" "&busy-poll=50"
+      "&priority=6" "&dscp=46" "&incoming-cpu=2" "&cpu-affinity=2-3"
+      "&realtime-priority=10" "&fec=true" "&fec-columns=5" "&fec-rows=4"
+      "&rtx=true" "&rtx-pt-map=98:99" "&rtx-cache-time=200"
+      "&rtx-cache-size=1048576", NULL);
 
-  g_object_get (rtpsink, "ttl", &ttl, "ttl_mc", &ttl_mc, NULL);
+  g_object_get (rtpsink, "ttl", &ttl, "ttl_mc", &ttl_mc,
+      "batch-size", &batch_size, "batch-timeout", &batch_timeout,
+      "destinations", &destinations, "pacing", &pacing,
+      "pacing-bitrate", &pacing_bitrate, "zerocopy", &zerocopy,
+      "zerocopy-threshold", &zerocopy_threshold, "buffer-size", &buffer_size,
+      "busy-poll", &busy_poll, "priority", &priority, "dscp", &dscp,
+      "incoming-cpu", &incoming_cpu, "cpu-affinity", &cpu_affinity,
+      "realtime-priority", &realtime_priority, "fec", &fec,
+      "fec-columns", &fec_columns, "fec-rows", &fec_rows, "rtx", &rtx,
+      "rtx-pt-map", &rtx_pt_map, "rtx-cache-time", &rtx_cache_time,
+      "rtx-cache-size", &rtx_cache_size, NULL);
 
   /* Make sure these values are in sync with the one from the URI. */
   g_assert_cmpint (ttl, ==, 8);
   g_assert_cmpint (ttl_mc, ==, 9);
+  g_assert_cmpuint (batch_size, ==, 16);
+  g_assert_cmpuint (batch_timeout, ==, 500);
+  /* Destinations without an address use the one of the URI */
+  g_assert_cmpstr (destinations, ==, "1.230.1.3:1234,1.230.1.2:1236");
+
+  g_assert_true (pacing);
+  g_assert_cmpuint (pacing_bitrate, ==, 5000000);
+  g_assert_true (zerocopy);
+  g_assert_cmpuint (zerocopy_threshold, ==, 20000);
+  g_assert_cmpint (buffer_size, ==, 4194304);
+  g_assert_cmpint (busy_poll, ==, 50);
+  g_assert_cmpint (priority, ==, 6);
+  g_assert_cmpint (dscp, ==, 46);
+  g_assert_cmpint (incoming_cpu, ==, 2);
+  g_assert_cmpstr (cpu_affinity, ==, "2-3");
+  g_assert_cmpint (realtime_priority, ==, 10);
+  g_assert_true (fec);
+  g_assert_cmpuint (fec_columns, ==, 5);
+  g_assert_cmpuint (fec_rows, ==, 4);
+  g_assert_true (rtx);
+  g_assert_cmpstr (rtx_pt_map, ==, "98:99");
+  g_assert_cmpuint (rtx_cache_time, ==, 200);
+  g_assert_cmpuint (rtx_cache_size, ==, 1048576);
+
+  g_free (destinations);
+  g_free (cpu_affinity);
+  g_free (rtx_pt_map);
+
+  gst_object_unref (rtpsink);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_stats)
+{
+  GstHarness *h;
+  GstElement *rtpsink;
+  GstStructure *stats;
+  const GValue *sources;
+  const GstStructure *source;
+  guint64 packets, bytes;
+  guint ssrc, session;
+  guint i;
+
+  rtpsink = gst_object_ref_sink (gst_element_factory_make ("nrtp_rtpsink",
+          NULL));
+  g_object_set (rtpsink, "uri", "rtp://127.0.0.1:42400", NULL);
+  h = gst_harness_new_with_element (rtpsink, "sink_%u", NULL);
+  gst_harness_set_src_caps_str (h, "application/x-rtp, media=audio, "
+      "clock-rate=8000, encoding-name=PCMU, payload=0");
+
+  for (i = 0; i < 10; i++) {
+    GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+    GstBuffer *buf = gst_rtp_buffer_new_allocate (160, 0, 0);
+
+    gst_rtp_buffer_map (buf, GST_MAP_WRITE, &rtp);
+    gst_rtp_buffer_set_seq (&rtp, i);
+    gst_rtp_buffer_set_timestamp (&rtp, i * 160);
+    gst_rtp_buffer_set_ssrc (&rtp, 0x12345678);
+    gst_rtp_buffer_unmap (&rtp);
+
+    fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+  }
+
+  g_object_get (rtpsink, "stats", &stats, NULL);
+  fail_unless (gst_structure_get_uint64 (stats, "packets", &packets));
+  fail_unless (gst_structure_get_uint64 (stats, "bytes", &bytes));
+  fail_unless_equals_int (packets, 10);
+  fail_unless_equals_int (bytes, 10 * (12 + 160));
+
+  sources = gst_structure_get_value (stats, "sources");
+  fail_unless_equals_int (gst_value_array_get_size (sources), 1);
+  source = gst_value_get_structure (gst_value_array_get_value (sources, 0));
+  fail_unless (gst_structure_get_uint (source, "ssrc", &ssrc));
+  fail_unless_equals_int (ssrc, 0x12345678);
+  fail_unless (gst_structure_get_uint (source, "session", &session));
+  fail_unless_equals_int (session, 0);
+  gst_structure_free (stats);
+
+  gst_harness_teardown (h);
+  gst_object_unref (rtpsink);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_lazy_construction)
+{
+  GstElement *rtpsink;
+  GstPad *pad;
+  guint children;
+
+  rtpsink = gst_element_factory_make ("nrtp_rtpsink", NULL);
+  g_object_set (rtpsink, "uri", "rtp://127.0.0.1:42410?ttl=8",
+      "destinations", "127.0.0.1:42412", NULL);
+
+  /* Nothing is created before going to READY or requesting a pad */
+  fail_unless_equals_int (GST_BIN_NUMCHILDREN (rtpsink), 0);
+
+  pad = gst_element_get_request_pad (rtpsink, "sink_%u");
+  fail_unless (pad != NULL);
+  children = GST_BIN_NUMCHILDREN (rtpsink);
+  fail_unless (children > 0);
+
+  /* Going to READY only adds the RTP sink to the graph */
+  fail_unless_equals_int (gst_element_set_state (rtpsink, GST_STATE_READY),
+      GST_STATE_CHANGE_SUCCESS);
+  fail_unless_equals_int (GST_BIN_NUMCHILDREN (rtpsink), children + 1);
+  gst_element_set_state (rtpsink, GST_STATE_NULL);
+
+  gst_element_release_request_pad (rtpsink, pad);
+  gst_object_unref (pad);
+  gst_object_unref (rtpsink);
+}
+
+GST_END_TEST;
+
+/* The host the RTP udpsink sends to */
+static gchar *
+get_rtp_host (GstElement * rtpsink, gint port)
+{
+  gchar *host = NULL;
+  GList *l;
+
+  GST_OBJECT_LOCK (rtpsink);
+  for (l = GST_BIN_CHILDREN (rtpsink); l; l = l->next) {
+    GstElementFactory *factory = gst_element_get_factory (l->data);
+    gint sink_port;
+
+    if (g_strcmp0 (GST_OBJECT_NAME (factory), "udpsink") != 0)
+      continue;
+    g_object_get (l->data, "port", &sink_port, NULL);
+    if (sink_port == port)
+      g_object_get (l->data, "host", &host, NULL);
+  }
+  GST_OBJECT_UNLOCK (rtpsink);
+
+  return host;
+}
+
+GST_START_TEST (test_async_resolve)
+{
+  GResolver *resolver, *previous;
+  GstElement *rtpsink;
+  GstMessage *msg;
+  GstBus *bus;
+  gchar *host = NULL;
+  gint i;
+
+  previous = g_resolver_get_default ();
+  resolver = g_object_new (test_resolver_get_type (), NULL);
+  g_resolver_set_default (resolver);
+  test_resolver_open (FALSE);
+
+  rtpsink = gst_element_factory_make ("nrtp_rtpsink", NULL);
+  g_object_set (rtpsink, "uri", "rtp://stub.test:42420", NULL);
+
+  /* READY does not wait for the lookup, PAUSED completes asynchronously */
+  fail_unless_equals_int (gst_element_set_state (rtpsink, GST_STATE_READY),
+      GST_STATE_CHANGE_SUCCESS);
+  fail_unless_equals_int (gst_element_set_state (rtpsink, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_ASYNC);
+  fail_unless_equals_int (gst_element_get_state (rtpsink, NULL, NULL,
+          50 * GST_MSECOND), GST_STATE_CHANGE_ASYNC);
+  host = get_rtp_host (rtpsink, 42420);
+  fail_if (g_strcmp0 (host, "127.0.0.1") == 0);
+  g_free (host);
+
+  test_resolver_open (TRUE);
+  for (i = 0; i < 500; i++) {
+    host = get_rtp_host (rtpsink, 42420);
+    if (g_strcmp0 (host, "127.0.0.1") == 0)
+      break;
+    g_free (host);
+    host = NULL;
+    g_usleep (10000);
+  }
+  fail_unless_equals_string (host, "127.0.0.1");
+  g_free (host);
+  gst_element_set_state (rtpsink, GST_STATE_NULL);
+  fail_unless_equals_int (test_resolver_get_lookups (), 1);
+
+  /* The address is cached for all elements */
+  fail_unless_equals_int (gst_element_set_state (rtpsink, GST_STATE_READY),
+      GST_STATE_CHANGE_SUCCESS);
+  host = get_rtp_host (rtpsink, 42420);
+  fail_unless_equals_string (host, "127.0.0.1");
+  g_free (host);
+  gst_element_set_state (rtpsink, GST_STATE_NULL);
+  fail_unless_equals_int (test_resolver_get_lookups (), 1);
+
+  /* Unless the cache is disabled */
+  g_object_set (rtpsink, "dns-cache-ttl", 0, NULL);
+  gst_element_set_state (rtpsink, GST_STATE_READY);
+  gst_element_set_state (rtpsink, GST_STATE_NULL);
+  fail_unless_equals_int (test_resolver_get_lookups (), 2);
+
+  /* A failed lookup is an error */
+  bus = gst_bus_new ();
+  gst_element_set_bus (rtpsink, bus);
+  g_object_set (rtpsink, "uri", "rtp://stub.invalid:42420", NULL);
+  fail_unless_equals_int (gst_element_set_state (rtpsink, GST_STATE_READY),
+      GST_STATE_CHANGE_SUCCESS);
+  msg = gst_bus_timed_pop_filtered (bus, 5 * GST_SECOND, GST_MESSAGE_ERROR);
+  fail_unless (msg != NULL);
+  gst_message_unref (msg);
+  gst_element_set_state (rtpsink, GST_STATE_NULL);
+  gst_element_set_bus (rtpsink, NULL);
+  gst_object_unref (bus);
+
+  gst_object_unref (rtpsink);
+  g_resolver_set_default (previous);
+  g_object_unref (previous);
+  g_object_unref (resolver);
+}
+
+GST_END_TEST;
+
+/* The clients of the udpsink that sends to @port */
+static gchar *
+get_clients (GstElement * rtpsink, gint port)
+{
+  gchar *clients = NULL;
+  GList *l;
+
+  GST_OBJECT_LOCK (rtpsink);
+  for (l = GST_BIN_CHILDREN (rtpsink); l; l = l->next) {
+    GstElementFactory *factory = gst_element_get_factory (l->data);
+    gint sink_port;
+
+    if (g_strcmp0 (GST_OBJECT_NAME (factory), "udpsink") != 0)
+      continue;
+    g_object_get (l->data, "port", &sink_port, NULL);
+    if (sink_port == port)
+      g_object_get (l->data, "clients", &clients, NULL);
+  }
+  GST_OBJECT_UNLOCK (rtpsink);
+
+  return clients;
+}
+
+GST_START_TEST (test_fec_elements)
+{
+  GstElement *rtpsink;
+  GstPad *pad;
+  gchar *host, *clients;
+  guint i, encoders = 0;
+  GList *l;
+
+  rtpsink = gst_element_factory_make ("nrtp_rtpsink", NULL);
+  g_object_set (rtpsink, "uri", "rtp://127.0.0.1:42430?fec=true",
+      "destinations", "127.0.0.1:42440", NULL);
+  pad = gst_element_get_request_pad (rtpsink, "sink_%u");
+
+  fail_unless_equals_int (gst_element_set_state (rtpsink, GST_STATE_READY),
+      GST_STATE_CHANGE_SUCCESS);
+
+  GST_OBJECT_LOCK (rtpsink);
+  for (l = GST_BIN_CHILDREN (rtpsink); l; l = l->next) {
+    GstElementFactory *factory = gst_element_get_factory (l->data);
+
+    if (g_strcmp0 (GST_OBJECT_NAME (factory), "nrtp_fecenc") == 0)
+      encoders++;
+  }
+  GST_OBJECT_UNLOCK (rtpsink);
+  fail_unless_equals_int (encoders, 1);
+
+  /* The column and row FEC go two and four ports above the RTP port of
+   * every receiver */
+  for (i = 2; i <= 4; i += 2) {
+    gchar *expected = g_strdup_printf ("127.0.0.1:%u", 42440 + i);
+
+    host = get_rtp_host (rtpsink, 42430 + i);
+    fail_unless_equals_string (host, "127.0.0.1");
+    g_free (host);
+    clients = get_clients (rtpsink, 42430 + i);
+    fail_unless (clients && g_strrstr (clients, expected) != NULL);
+    g_free (clients);
+    g_free (expected);
+  }
+
+  /* And follow a change of the port */
+  g_object_set (rtpsink, "port", 42450, NULL);
+  for (i = 2; i <= 4; i += 2) {
+    host = get_rtp_host (rtpsink, 42450 + i);
+    fail_unless_equals_string (host, "127.0.0.1");
+    g_free (host);
+  }
+
+  fail_unless_equals_int (gst_element_set_state (rtpsink, GST_STATE_NULL),
+      GST_STATE_CHANGE_SUCCESS);
+  host = get_rtp_host (rtpsink, 42432);
+  fail_unless (host == NULL);
+
+  gst_element_release_request_pad (rtpsink, pad);
+  gst_object_unref (pad);
+  gst_object_unref (rtpsink);
+}
+
+GST_END_TEST;
+
+/* The FEC matrix cannot follow the SSRCs of more sessions */
+GST_START_TEST (test_fec_single_session)
+{
+  GstElement *rtpsink;
+  GstPad *pad;
+
+  rtpsink = gst_element_factory_make ("nrtp_rtpsink", NULL);
+  g_object_set (rtpsink, "uri", "rtp://127.0.0.1:42460?fec=true", NULL);
+
+  pad = gst_element_get_request_pad (rtpsink, "sink_%u");
+  fail_unless (pad != NULL);
+  fail_unless (gst_element_get_request_pad (rtpsink, "sink_%u") == NULL);
+
+  fail_unless_equals_int (gst_element_set_state (rtpsink, GST_STATE_READY),
+      GST_STATE_CHANGE_SUCCESS);
+  fail_unless_equals_int (gst_element_set_state (rtpsink, GST_STATE_NULL),
+      GST_STATE_CHANGE_SUCCESS);
+
+  gst_element_release_request_pad (rtpsink, pad);
+  gst_object_unref (pad);
+  gst_object_unref (rtpsink);
+}
+
+GST_END_TEST;
+
+#ifdef __linux__
+static GSocket *
+setup_receiver (const gchar * address, guint16 * port)
+{
+  GInetAddress *iaddr = g_inet_address_new_from_string (address);
+  GSocketAddress *addr;
+  GSocket *socket;
+
+  socket = g_socket_new (G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_DATAGRAM,
+      G_SOCKET_PROTOCOL_UDP, NULL);
+  fail_unless (socket != NULL);
+  g_socket_set_blocking (socket, FALSE);
+
+  addr = g_inet_socket_address_new (iaddr, *port);
+  fail_unless (g_socket_bind (socket, addr, TRUE, NULL));
+  g_object_unref (addr);
+  g_object_unref (iaddr);
+
+  addr = g_socket_get_local_address (socket, NULL);
+  *port = g_inet_socket_address_get_port (G_INET_SOCKET_ADDRESS (addr));
+  g_object_unref (addr);
+
+  return socket;
+}
+
+static void
+push_packet (GstHarness * h, guint16 seq)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  GstBuffer *buf = gst_rtp_buffer_new_allocate (160, 0, 0);
+
+  gst_rtp_buffer_map (buf, GST_MAP_WRITE, &rtp);
+  gst_rtp_buffer_set_seq (&rtp, seq);
+  gst_rtp_buffer_set_timestamp (&rtp, seq * 160);
+  gst_rtp_buffer_set_ssrc (&rtp, 0x12345678);
+  gst_rtp_buffer_unmap (&rtp);
+
+  fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+}
+
+/* Whether @socket receives the packet with @seq within @timeout, dropping
+ * the packets before it */
+static gboolean
+receive_packet (GSocket * socket, guint16 seq, gint64 timeout)
+{
+  gint64 end = g_get_monotonic_time () + timeout;
+  guint8 data[2048];
+
+  while (g_socket_condition_timed_wait (socket, G_IO_IN,
+          MAX (end - g_get_monotonic_time (), 0), NULL, NULL)) {
+    if (g_socket_receive (socket, (gchar *) data, sizeof (data), NULL,
+            NULL) >= 4 && GST_READ_UINT16_BE (data + 2) == seq)
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+GST_START_TEST (test_change_address)
+{
+  GstElement *rtpsink;
+  GstHarness *h;
+  GSocket *socket1, *socket2;
+  guint16 port = 0, seq = 0;
+  gboolean moved = FALSE;
+  gchar *uri;
+
+  socket1 = setup_receiver ("127.0.0.1", &port);
+  socket2 = setup_receiver ("127.0.0.2", &port);
+
+  /* Batching sends with nrtp_sendsink */
+  rtpsink = gst_object_ref_sink (gst_element_factory_make ("nrtp_rtpsink",
+          NULL));
+  uri = g_strdup_printf ("rtp://127.0.0.1:%u?batch-size=2"
+      "&batch-timeout=1000", port);
+  g_object_set (rtpsink, "uri", uri, NULL);
+  g_free (uri);
+  h = gst_harness_new_with_element (rtpsink, "sink_%u", NULL);
+  gst_harness_set_src_caps_str (h, "application/x-rtp, media=audio, "
+      "clock-rate=8000, encoding-name=PCMU, payload=0");
+
+  push_packet (h, seq);
+  fail_unless (receive_packet (socket1, seq, 5 * G_USEC_PER_SEC));
+
+  /* The new address is resolved asynchronously while playing */
+  g_object_set (rtpsink, "address", "127.0.0.2", NULL);
+  while (!moved && ++seq < 500) {
+    push_packet (h, seq);
+    moved = receive_packet (socket2, seq, 10 * G_TIME_SPAN_MILLISECOND);
+  }
+  fail_unless (moved);
+
+  /* From then on, only the new address receives */
+  push_packet (h, ++seq);
+  fail_unless (receive_packet (socket2, seq, 5 * G_USEC_PER_SEC));
+  fail_if (receive_packet (socket1, seq, 200 * G_TIME_SPAN_MILLISECOND));
 
+  gst_harness_teardown (h);
   gst_object_unref (rtpsink);
+  g_object_unref (socket1);
+  g_object_unref (socket2);
 }
 
 GST_END_TEST;
+#endif
 
 static Suite *
 rtpsink_suite (void)
@@ -50,6 +580,14 @@ rtpsink_suite (void)
 
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_uri_to_properties);
+  tcase_add_test (tc_chain, test_stats);
+  tcase_add_test (tc_chain, test_lazy_construction);
+  tcase_add_test (tc_chain, test_async_resolve);
+  tcase_add_test (tc_chain, test_fec_elements);
+  tcase_add_test (tc_chain, test_fec_single_session);
+#ifdef __linux__
+  tcase_add_test (tc_chain, test_change_address);
+#endif
 
   return s;
 }
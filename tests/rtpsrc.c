@@ -17,27 +17,955 @@
  * Boston, MA 02110-1301, USA.
  */
 
+#ifdef __linux__
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <sched.h>
+#endif
+
+#include <gio/gio.h>
 #include <gst/check/gstcheck.h>
+#include <gst/rtp/gstrtpbuffer.h>
+#include <gst/rtp/gstrtcpbuffer.h>
+
+#define RTCP_TEST_PORT 42300
 
 GST_START_TEST (test_uri_to_properties)
 {
   GstElement *rtpsrc;
-  guint latency, ttl, ttl_mc;
+  guint latency, ttl, ttl_mc, batch_size, pool_size, mtu, receive_threads;
+  guint min_latency, max_latency;
+  gboolean kernel_timestamps, io_uring, adaptive_latency, fec, rtx;
+  gchar *ports, *pt_map, *rtx_pt_map;
+  gint mode, buffer_size, busy_poll, priority, dscp, incoming_cpu;
+  gint realtime_priority;
+  gchar *cpu_affinity;
+  guint spin_time;
+  guint64 expected_bitrate;
 
   rtpsrc = gst_element_factory_make ("nrtp_rtpsrc", NULL);
 
   /* Sets properties to non-default values (make sure this stays in sync) */
   g_object_set (rtpsrc, "uri", "rtp://1.230.1.2:1234?"
-      "latency=300" "&ttl=8" "&ttl-mc=9", NULL);
+      "latency=300" "&ttl=8" "&ttl-mc=9" "&batch-size=32"
+      "&pool-size=512" "&mtu=9000" "&receive-threads=4"
+      "&ports=1236,239.1.1.2:1238" "&kernel-timestamps=true"
+      "&pt-map=96:H264/90000" "&io-uring=true" "&mode=low-latency"
+      "&adaptive-latency=true" "&min-latency=50" "&max-latency=500"
+      "&buffer-size=4194304" "&busy-poll=50" "&priority=6" "&dscp=46"
+      "&incoming-cpu=2" "&cpu-affinity=2-3" "&realtime-priority=10"
+      "&spin-time=20" "&expected-bitrate=20000000" "&fec=true"
+      "&rtx=true" "&rtx-pt-map=98:99", NULL);
 
   g_object_get (rtpsrc,
-      "latency", &latency, "ttl-mc", &ttl_mc, "ttl", &ttl, NULL);
+      "latency", &latency, "ttl-mc", &ttl_mc, "ttl", &ttl,
+      "batch-size", &batch_size, "pool-size", &pool_size, "mtu", &mtu,
+      "receive-threads", &receive_threads, "ports", &ports,
+      "kernel-timestamps", &kernel_timestamps, "pt-map", &pt_map,
+      "io-uring", &io_uring, "mode", &mode,
+      "adaptive-latency", &adaptive_latency, "min-latency", &min_latency,
+      "max-latency", &max_latency, "buffer-size", &buffer_size,
+      "busy-poll", &busy_poll, "priority", &priority, "dscp", &dscp,
+      "incoming-cpu", &incoming_cpu, "cpu-affinity", &cpu_affinity,
+      "realtime-priority", &realtime_priority, "spin-time", &spin_time,
+      "expected-bitrate", &expected_bitrate, "fec", &fec, "rtx", &rtx,
+      "rtx-pt-map", &rtx_pt_map, NULL);
 
   /* Make sure these values are in sync with the one from the URI. */
   g_assert_cmpuint (latency, ==, 300);
   g_assert_cmpint (ttl, ==, 8);
   g_assert_cmpint (ttl_mc, ==, 9);
+  g_assert_cmpuint (batch_size, ==, 32);
+  g_assert_cmpuint (pool_size, ==, 512);
+  g_assert_cmpuint (mtu, ==, 9000);
+  g_assert_cmpuint (receive_threads, ==, 4);
+  g_assert_cmpstr (ports, ==, "1236,239.1.1.2:1238");
+  g_assert_true (kernel_timestamps);
+  g_assert_cmpstr (pt_map, ==, "96:H264/90000");
+  g_assert_true (io_uring);
+  g_assert_cmpint (mode, ==, 1);
+  g_assert_true (adaptive_latency);
+  g_assert_cmpuint (min_latency, ==, 50);
+  g_assert_cmpuint (max_latency, ==, 500);
+  g_assert_cmpint (buffer_size, ==, 4194304);
+  g_assert_cmpint (busy_poll, ==, 50);
+  g_assert_cmpint (priority, ==, 6);
+  g_assert_cmpint (dscp, ==, 46);
+  g_assert_cmpint (incoming_cpu, ==, 2);
+  g_assert_cmpstr (cpu_affinity, ==, "2-3");
+  g_assert_cmpint (realtime_priority, ==, 10);
+  g_assert_cmpuint (spin_time, ==, 20);
+  g_assert_cmpuint (expected_bitrate, ==, 20000000);
+  g_assert_true (fec);
+  g_assert_true (rtx);
+  g_assert_cmpstr (rtx_pt_map, ==, "98:99");
+
+  g_free (ports);
+  g_free (rtx_pt_map);
+  g_free (pt_map);
+  g_free (cpu_affinity);
+
+  gst_object_unref (rtpsrc);
+}
+
+GST_END_TEST;
+
+static GstCaps *
+request_pt_map (GstElement * rtpsrc, guint pt)
+{
+  GstElement *rtpbin = NULL;
+  GstCaps *caps = NULL;
+  GList *l;
+
+  GST_OBJECT_LOCK (rtpsrc);
+  for (l = GST_BIN_CHILDREN (rtpsrc); l; l = l->next) {
+    GstElementFactory *factory = gst_element_get_factory (l->data);
+
+    if (g_strcmp0 (GST_OBJECT_NAME (factory), "rtpbin") == 0)
+      rtpbin = gst_object_ref (l->data);
+  }
+  GST_OBJECT_UNLOCK (rtpsrc);
+  fail_unless (rtpbin != NULL);
+
+  g_signal_emit_by_name (rtpbin, "request-pt-map", 0, pt, &caps);
+  gst_object_unref (rtpbin);
+
+  return caps;
+}
+
+static void
+check_pt_caps (GstCaps * caps, const gchar * encoding_name, gint clock_rate)
+{
+  GstStructure *s;
+  gint rate;
+
+  fail_unless (caps != NULL);
+  s = gst_caps_get_structure (caps, 0);
+  fail_unless_equals_string (gst_structure_get_string (s, "encoding-name"),
+      encoding_name);
+  fail_unless (gst_structure_get_int (s, "clock-rate", &rate));
+  fail_unless_equals_int (rate, clock_rate);
+}
+
+GST_START_TEST (test_pt_map)
+{
+  GstElement *rtpsrc;
+  GstCaps *caps, *again;
+  gchar *uri;
+
+  uri = g_strdup_printf ("rtp://127.0.0.1:%d", RTCP_TEST_PORT + 70);
+  rtpsrc = gst_element_factory_make ("nrtp_rtpsrc", NULL);
+  g_object_set (rtpsrc, "uri", uri, "pt-map", "97:opus/48000/2, 98:invalid",
+      NULL);
+  g_free (uri);
+  /* rtpbin is only created when going to READY */
+  fail_unless_equals_int (gst_element_set_state (rtpsrc, GST_STATE_READY),
+      GST_STATE_CHANGE_SUCCESS);
+
+  caps = request_pt_map (rtpsrc, 97);
+  check_pt_caps (caps, "OPUS", 48000);
+  fail_unless_equals_string (gst_structure_get_string
+      (gst_caps_get_structure (caps, 0), "encoding-params"), "2");
+  /* The caps come from the table and are not created for each request */
+  again = request_pt_map (rtpsrc, 97);
+  fail_unless (caps == again);
+  gst_caps_unref (again);
+  gst_caps_unref (caps);
+
+  caps = request_pt_map (rtpsrc, 0);
+  check_pt_caps (caps, "PCMU", 8000);
+  gst_caps_unref (caps);
+
+  fail_unless (request_pt_map (rtpsrc, 96) == NULL);
+  fail_unless (request_pt_map (rtpsrc, 98) == NULL);
+
+  /* The encoding-name applies to every payload type not in the map */
+  g_object_set (rtpsrc, "encoding-name", "H264", NULL);
+  caps = request_pt_map (rtpsrc, 96);
+  check_pt_caps (caps, "H264", 90000);
+  gst_caps_unref (caps);
+  caps = request_pt_map (rtpsrc, 0);
+  check_pt_caps (caps, "H264", 90000);
+  gst_caps_unref (caps);
+  caps = request_pt_map (rtpsrc, 97);
+  check_pt_caps (caps, "OPUS", 48000);
+  gst_caps_unref (caps);
+
+  gst_element_set_state (rtpsrc, GST_STATE_NULL);
+  gst_object_unref (rtpsrc);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_lazy_construction)
+{
+  GstElement *rtpsrc;
+  gchar *uri;
+  guint latency;
+
+  uri = g_strdup_printf ("rtp://127.0.0.1:%d?latency=300",
+      RTCP_TEST_PORT + 74);
+  rtpsrc = gst_element_factory_make ("nrtp_rtpsrc", NULL);
+  g_object_set (rtpsrc, "uri", uri, NULL);
+  g_free (uri);
+
+  /* Nothing is created before going to READY */
+  fail_unless_equals_int (GST_BIN_NUMCHILDREN (rtpsrc), 0);
+  g_object_get (rtpsrc, "latency", &latency, NULL);
+  fail_unless_equals_int (latency, 300);
+
+  fail_unless_equals_int (gst_element_set_state (rtpsrc, GST_STATE_READY),
+      GST_STATE_CHANGE_SUCCESS);
+  fail_unless (GST_BIN_NUMCHILDREN (rtpsrc) > 0);
+  g_object_get (rtpsrc, "latency", &latency, NULL);
+  fail_unless_equals_int (latency, 300);
+
+  /* And everything is removed again when going back to NULL */
+  gst_element_set_state (rtpsrc, GST_STATE_NULL);
+  fail_unless_equals_int (GST_BIN_NUMCHILDREN (rtpsrc), 0);
+  fail_unless_equals_int (GST_ELEMENT (rtpsrc)->numsrcpads, 0);
+
+  /* The graph can be built again */
+  fail_unless_equals_int (gst_element_set_state (rtpsrc, GST_STATE_READY),
+      GST_STATE_CHANGE_SUCCESS);
+  fail_unless (GST_BIN_NUMCHILDREN (rtpsrc) > 0);
+  gst_element_set_state (rtpsrc, GST_STATE_NULL);
+
+  gst_object_unref (rtpsrc);
+}
+
+GST_END_TEST;
+
+typedef struct
+{
+  guint32 ssrc;
+  guint port;
+  GSocket *rtp_socket;
+  GSocket *rtcp_socket;
+} TestSender;
+
+typedef struct
+{
+  TestSender senders[2];
+  volatile gint running;
+} TestSenders;
+
+static void
+test_sender_init (TestSender * sender, guint32 ssrc, guint port)
+{
+  GInetAddress *iaddr = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+  GSocketAddress *addr = g_inet_socket_address_new (iaddr, 0);
+
+  sender->ssrc = ssrc;
+  sender->port = port;
+  sender->rtp_socket = g_socket_new (G_SOCKET_FAMILY_IPV4,
+      G_SOCKET_TYPE_DATAGRAM, G_SOCKET_PROTOCOL_UDP, NULL);
+  sender->rtcp_socket = g_socket_new (G_SOCKET_FAMILY_IPV4,
+      G_SOCKET_TYPE_DATAGRAM, G_SOCKET_PROTOCOL_UDP, NULL);
+  fail_unless (g_socket_bind (sender->rtp_socket, addr, FALSE, NULL));
+  fail_unless (g_socket_bind (sender->rtcp_socket, addr, FALSE, NULL));
+
+  g_object_unref (addr);
+  g_object_unref (iaddr);
+}
+
+static void
+test_sender_clear (TestSender * sender)
+{
+  g_object_unref (sender->rtp_socket);
+  g_object_unref (sender->rtcp_socket);
+}
+
+static void
+test_sender_send (TestSender * sender, guint16 seqnum, gboolean with_sr)
+{
+  GInetAddress *iaddr = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  GSocketAddress *addr;
+  GstBuffer *buf;
+  GstMapInfo map;
+
+  buf = gst_rtp_buffer_new_allocate (160, 0, 0);
+  gst_rtp_buffer_map (buf, GST_MAP_WRITE, &rtp);
+  gst_rtp_buffer_set_payload_type (&rtp, 0);
+  gst_rtp_buffer_set_seq (&rtp, seqnum);
+  gst_rtp_buffer_set_timestamp (&rtp, seqnum * 160);
+  gst_rtp_buffer_set_ssrc (&rtp, sender->ssrc);
+  gst_rtp_buffer_unmap (&rtp);
+  addr = g_inet_socket_address_new (iaddr, sender->port);
+  gst_buffer_map (buf, &map, GST_MAP_READ);
+  g_socket_send_to (sender->rtp_socket, addr, (const gchar *) map.data,
+      map.size, NULL, NULL);
+  gst_buffer_unmap (buf, &map);
+  gst_buffer_unref (buf);
+  g_object_unref (addr);
+
+  if (with_sr) {
+    GstRTCPBuffer rtcp = GST_RTCP_BUFFER_INIT;
+    GstRTCPPacket packet;
+
+    buf = gst_rtcp_buffer_new (1400);
+    gst_rtcp_buffer_map (buf, GST_MAP_READWRITE, &rtcp);
+    gst_rtcp_buffer_add_packet (&rtcp, GST_RTCP_TYPE_SR, &packet);
+    gst_rtcp_packet_sr_set_sender_info (&packet, sender->ssrc, 0,
+        seqnum * 160, seqnum, seqnum * 160);
+    gst_rtcp_buffer_unmap (&rtcp);
+
+    addr = g_inet_socket_address_new (iaddr, sender->port + 1);
+    gst_buffer_map (buf, &map, GST_MAP_READ);
+    g_socket_send_to (sender->rtcp_socket, addr, (const gchar *) map.data,
+        map.size, NULL, NULL);
+    gst_buffer_unmap (buf, &map);
+    gst_buffer_unref (buf);
+    g_object_unref (addr);
+  }
+
+  g_object_unref (iaddr);
+}
+
+static gpointer
+test_senders_thread (TestSenders * senders)
+{
+  guint16 seqnum = 0;
+
+  while (g_atomic_int_get (&senders->running)) {
+    gboolean with_sr = (seqnum % 50) == 0;
+
+    test_sender_send (&senders->senders[0], seqnum, with_sr);
+    test_sender_send (&senders->senders[1], seqnum, with_sr);
+    seqnum++;
+    g_usleep (20 * 1000);
+  }
+
+  return NULL;
+}
+
+/* Wait for a receiver report with a report block about the sender */
+static gboolean
+test_sender_wait_for_report (TestSender * sender, gint64 deadline)
+{
+  gchar data[1500];
+
+  while (g_get_monotonic_time () < deadline) {
+    GstRTCPBuffer rtcp = GST_RTCP_BUFFER_INIT;
+    GstRTCPPacket packet;
+    GstBuffer *buf;
+    gboolean more, found = FALSE;
+    gssize len;
+
+    g_socket_set_timeout (sender->rtcp_socket, 1);
+    len = g_socket_receive (sender->rtcp_socket, data, sizeof (data), NULL,
+        NULL);
+    if (len <= 0)
+      continue;
+
+    buf = gst_buffer_new_allocate (NULL, len, NULL);
+    gst_buffer_fill (buf, 0, data, len);
+    gst_rtcp_buffer_map (buf, GST_MAP_READ, &rtcp);
+    for (more = gst_rtcp_buffer_get_first_packet (&rtcp, &packet); more;
+        more = gst_rtcp_packet_move_to_next (&packet)) {
+      GstRTCPType type = gst_rtcp_packet_get_type (&packet);
+      guint i;
+
+      if (type != GST_RTCP_TYPE_RR && type != GST_RTCP_TYPE_SR)
+        continue;
+
+      for (i = 0; i < gst_rtcp_packet_get_rb_count (&packet); i++) {
+        guint32 ssrc;
+
+        gst_rtcp_packet_get_rb (&packet, i, &ssrc, NULL, NULL, NULL, NULL,
+            NULL, NULL);
+        if (ssrc == sender->ssrc)
+          found = TRUE;
+      }
+    }
+    gst_rtcp_buffer_unmap (&rtcp);
+    gst_buffer_unref (buf);
+
+    if (found)
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+static void
+rtpsrc_pad_added_cb (GstElement * rtpsrc, GstPad * pad, GstElement * pipeline)
+{
+  GstElement *sink = gst_element_factory_make ("fakesink", NULL);
+  GstPad *sinkpad;
+
+  g_object_set (sink, "sync", FALSE, "async", FALSE, NULL);
+  gst_bin_add (GST_BIN (pipeline), sink);
+  gst_element_sync_state_with_parent (sink);
+
+  sinkpad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_link (pad, sinkpad);
+  gst_object_unref (sinkpad);
+}
+
+/* With two unicast senders on the same port, each one gets the receiver
+ * reports about itself on the port it sent its RTCP from. */
+GST_START_TEST (test_rtcp_per_sender)
+{
+  GstElement *pipeline, *rtpsrc;
+  TestSenders senders;
+  GThread *thread;
+  gint64 deadline;
+  gchar *uri;
+
+  pipeline = gst_pipeline_new (NULL);
+  rtpsrc = gst_element_factory_make ("nrtp_rtpsrc", NULL);
+  uri = g_strdup_printf ("rtp://127.0.0.1:%d", RTCP_TEST_PORT);
+  g_object_set (rtpsrc, "uri", uri, NULL);
+  g_free (uri);
+  gst_bin_add (GST_BIN (pipeline), rtpsrc);
+  g_signal_connect (rtpsrc, "pad-added", G_CALLBACK (rtpsrc_pad_added_cb),
+      pipeline);
+
+  test_sender_init (&senders.senders[0], 0x11111111, RTCP_TEST_PORT);
+  test_sender_init (&senders.senders[1], 0x22222222, RTCP_TEST_PORT);
+  senders.running = 1;
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+  thread = g_thread_new ("senders", (GThreadFunc) test_senders_thread,
+      &senders);
+
+  deadline = g_get_monotonic_time () + 20 * G_USEC_PER_SEC;
+  fail_unless (test_sender_wait_for_report (&senders.senders[0], deadline));
+  fail_unless (test_sender_wait_for_report (&senders.senders[1], deadline));
+
+  g_atomic_int_set (&senders.running, 0);
+  g_thread_join (thread);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  test_sender_clear (&senders.senders[0]);
+  test_sender_clear (&senders.senders[1]);
+}
+
+GST_END_TEST;
+
+static void
+count_pads_cb (GstElement * rtpsrc, GstPad * pad, gint * n_pads)
+{
+  g_atomic_int_inc (n_pads);
+}
+
+/* A sender on the port of the URI and one on the ports property each get
+ * their own session, stream and receiver reports. */
+GST_START_TEST (test_multiple_sessions)
+{
+  GstElement *pipeline, *rtpsrc;
+  TestSenders senders;
+  GThread *thread;
+  gint64 deadline;
+  gint n_pads = 0;
+  gchar *uri, *ports;
+  GstStructure *stats;
+  const GValue *sources;
+  guint64 packets;
+  guint i;
+
+  pipeline = gst_pipeline_new (NULL);
+  rtpsrc = gst_element_factory_make ("nrtp_rtpsrc", NULL);
+  uri = g_strdup_printf ("rtp://127.0.0.1:%d", RTCP_TEST_PORT + 10);
+  ports = g_strdup_printf ("%d", RTCP_TEST_PORT + 12);
+  g_object_set (rtpsrc, "uri", uri, "ports", ports, NULL);
+  g_free (ports);
+  g_free (uri);
+  gst_bin_add (GST_BIN (pipeline), rtpsrc);
+  g_signal_connect (rtpsrc, "pad-added", G_CALLBACK (rtpsrc_pad_added_cb),
+      pipeline);
+  g_signal_connect (rtpsrc, "pad-added", G_CALLBACK (count_pads_cb),
+      &n_pads);
+
+  test_sender_init (&senders.senders[0], 0x11111111, RTCP_TEST_PORT + 10);
+  test_sender_init (&senders.senders[1], 0x22222222, RTCP_TEST_PORT + 12);
+  senders.running = 1;
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+  thread = g_thread_new ("senders", (GThreadFunc) test_senders_thread,
+      &senders);
+
+  deadline = g_get_monotonic_time () + 20 * G_USEC_PER_SEC;
+  fail_unless (test_sender_wait_for_report (&senders.senders[0], deadline));
+  fail_unless (test_sender_wait_for_report (&senders.senders[1], deadline));
+  fail_unless_equals_int (g_atomic_int_get (&n_pads), 2);
+
+  /* Each sender is counted in its own session */
+  g_object_get (rtpsrc, "stats", &stats, NULL);
+  fail_unless (gst_structure_get_uint64 (stats, "packets", &packets));
+  fail_unless (packets > 0);
+  fail_unless (gst_structure_has_field (stats, "socket-drops"));
+  sources = gst_structure_get_value (stats, "sources");
+  fail_unless_equals_int (gst_value_array_get_size (sources), 2);
+  for (i = 0; i < 2; i++) {
+    const GstStructure *source =
+        gst_value_get_structure (gst_value_array_get_value (sources, i));
+    guint session, ssrc;
+
+    fail_unless (gst_structure_get_uint (source, "session", &session));
+    fail_unless (gst_structure_get_uint (source, "ssrc", &ssrc));
+    fail_unless_equals_int (ssrc, senders.senders[session].ssrc);
+  }
+  gst_structure_free (stats);
+
+  g_atomic_int_set (&senders.running, 0);
+  g_thread_join (thread);
+
+  /* The sessions are rebuilt from the properties on the next start */
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_READY) ==
+      GST_STATE_CHANGE_SUCCESS);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  test_sender_clear (&senders.senders[0]);
+  test_sender_clear (&senders.senders[1]);
+}
+
+GST_END_TEST;
+
+/* Packets that went through the jitterbuffer are counted in the histogram
+ * of their source pad. */
+GST_START_TEST (test_latency_histogram)
+{
+  GstElement *pipeline, *rtpsrc;
+  GstStructure *latency, *histogram = NULL;
+  TestSenders senders;
+  GThread *thread;
+  gint64 deadline;
+  guint64 count = 0, average;
+  gchar *uri;
+
+  pipeline = gst_pipeline_new (NULL);
+  rtpsrc = gst_element_factory_make ("nrtp_rtpsrc", NULL);
+  uri = g_strdup_printf ("rtp://127.0.0.1:%d?latency=50&kernel-timestamps=1",
+      RTCP_TEST_PORT + 20);
+  g_object_set (rtpsrc, "uri", uri, NULL);
+  g_free (uri);
+  gst_bin_add (GST_BIN (pipeline), rtpsrc);
+  g_signal_connect (rtpsrc, "pad-added", G_CALLBACK (rtpsrc_pad_added_cb),
+      pipeline);
+
+  test_sender_init (&senders.senders[0], 0x11111111, RTCP_TEST_PORT + 20);
+  test_sender_init (&senders.senders[1], 0x22222222, RTCP_TEST_PORT + 20);
+  senders.running = 1;
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+  thread = g_thread_new ("senders", (GThreadFunc) test_senders_thread,
+      &senders);
+
+  deadline = g_get_monotonic_time () + 20 * G_USEC_PER_SEC;
+  while (count == 0 && g_get_monotonic_time () < deadline) {
+    g_usleep (100 * 1000);
+    g_object_get (rtpsrc, "latency-histogram", &latency, NULL);
+    if (gst_structure_get (latency, "src_0", GST_TYPE_STRUCTURE, &histogram,
+            NULL)) {
+      fail_unless (gst_structure_get_uint64 (histogram, "count", &count));
+      fail_unless (gst_structure_get_uint64 (histogram, "average",
+              &average));
+      gst_structure_free (histogram);
+    }
+    gst_structure_free (latency);
+  }
+  fail_unless (count > 0);
+  fail_unless (average > 0);
+
+  g_atomic_int_set (&senders.running, 0);
+  g_thread_join (thread);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  test_sender_clear (&senders.senders[0]);
+  test_sender_clear (&senders.senders[1]);
+}
+
+GST_END_TEST;
+
+/* Without the jitterbuffer, every sender still gets its own pad and its
+ * receiver reports. */
+GST_START_TEST (test_low_latency)
+{
+  GstElement *pipeline, *rtpsrc;
+  GstIterator *it;
+  GValue item = G_VALUE_INIT;
+  TestSenders senders;
+  GThread *thread;
+  gint64 deadline;
+  gint n_pads = 0;
+  gchar *uri;
+
+  pipeline = gst_pipeline_new (NULL);
+  rtpsrc = gst_element_factory_make ("nrtp_rtpsrc", NULL);
+  uri = g_strdup_printf ("rtp://127.0.0.1:%d?mode=low-latency",
+      RTCP_TEST_PORT + 50);
+  g_object_set (rtpsrc, "uri", uri, NULL);
+  g_free (uri);
+  gst_bin_add (GST_BIN (pipeline), rtpsrc);
+  g_signal_connect (rtpsrc, "pad-added", G_CALLBACK (rtpsrc_pad_added_cb),
+      pipeline);
+  g_signal_connect (rtpsrc, "pad-added", G_CALLBACK (count_pads_cb),
+      &n_pads);
+
+  test_sender_init (&senders.senders[0], 0x11111111, RTCP_TEST_PORT + 50);
+  test_sender_init (&senders.senders[1], 0x22222222, RTCP_TEST_PORT + 50);
+  senders.running = 1;
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+  thread = g_thread_new ("senders", (GThreadFunc) test_senders_thread,
+      &senders);
+
+  deadline = g_get_monotonic_time () + 20 * G_USEC_PER_SEC;
+  fail_unless (test_sender_wait_for_report (&senders.senders[0], deadline));
+  fail_unless (test_sender_wait_for_report (&senders.senders[1], deadline));
+  fail_unless_equals_int (g_atomic_int_get (&n_pads), 2);
+
+  it = gst_bin_iterate_recurse (GST_BIN (rtpsrc));
+  while (gst_iterator_next (it, &item) == GST_ITERATOR_OK) {
+    GstElementFactory *factory =
+        gst_element_get_factory (g_value_get_object (&item));
+
+    fail_if (g_strcmp0 (GST_OBJECT_NAME (factory), "rtpjitterbuffer") == 0);
+    g_value_reset (&item);
+  }
+  g_value_unset (&item);
+  gst_iterator_free (it);
+
+  g_atomic_int_set (&senders.running, 0);
+  g_thread_join (thread);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  test_sender_clear (&senders.senders[0]);
+  test_sender_clear (&senders.senders[1]);
+}
+
+GST_END_TEST;
+
+/* On the loopback interface the jitter is far below the initial latency,
+ * which is lowered step by step and reported on the bus. */
+GST_START_TEST (test_adaptive_latency)
+{
+  GstElement *pipeline, *rtpsrc;
+  const GstStructure *s;
+  GstMessage *msg;
+  GstBus *bus;
+  TestSenders senders;
+  GThread *thread;
+  guint latency, previous, current;
+  guint64 late;
+  gchar *uri;
+
+  pipeline = gst_pipeline_new (NULL);
+  rtpsrc = gst_element_factory_make ("nrtp_rtpsrc", NULL);
+  uri = g_strdup_printf ("rtp://127.0.0.1:%d?latency=400"
+      "&adaptive-latency=true&min-latency=100&max-latency=800",
+      RTCP_TEST_PORT + 60);
+  g_object_set (rtpsrc, "uri", uri, NULL);
+  g_free (uri);
+  gst_bin_add (GST_BIN (pipeline), rtpsrc);
+  g_signal_connect (rtpsrc, "pad-added", G_CALLBACK (rtpsrc_pad_added_cb),
+      pipeline);
+  bus = gst_element_get_bus (pipeline);
+
+  test_sender_init (&senders.senders[0], 0x11111111, RTCP_TEST_PORT + 60);
+  test_sender_init (&senders.senders[1], 0x22222222, RTCP_TEST_PORT + 60);
+  senders.running = 1;
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+  thread = g_thread_new ("senders", (GThreadFunc) test_senders_thread,
+      &senders);
+
+  msg = NULL;
+  while (msg == NULL) {
+    msg = gst_bus_timed_pop_filtered (bus, 20 * GST_SECOND,
+        GST_MESSAGE_ELEMENT);
+    fail_unless (msg != NULL);
+    s = gst_message_get_structure (msg);
+    if (!gst_structure_has_name (s, "application/x-rtp-src-latency-changed"))
+      gst_clear_message (&msg);
+  }
+
+  fail_unless (GST_MESSAGE_SRC (msg) == GST_OBJECT (rtpsrc));
+  fail_unless (gst_structure_get (s, "latency", G_TYPE_UINT, &latency,
+          "previous-latency", G_TYPE_UINT, &previous,
+          "late", G_TYPE_UINT64, &late, NULL));
+  fail_unless (gst_structure_has_field_typed (s, "jitter", G_TYPE_UINT64));
+  fail_unless_equals_int (previous, 400);
+  fail_unless (latency < previous);
+  fail_unless (latency >= 100);
+  fail_unless_equals_uint64 (late, 0);
+  gst_message_unref (msg);
+
+  g_object_get (rtpsrc, "latency", &current, NULL);
+  fail_unless (current <= latency);
+
+  g_atomic_int_set (&senders.running, 0);
+  g_thread_join (thread);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+
+  test_sender_clear (&senders.senders[0]);
+  test_sender_clear (&senders.senders[1]);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_invalid_ports)
+{
+  GstElement *rtpsrc;
+
+  rtpsrc = gst_element_factory_make ("nrtp_rtpsrc", NULL);
+  g_object_set (rtpsrc, "uri", "rtp://127.0.0.1:42330", "ports", "5006,x:y",
+      NULL);
+
+  fail_unless (gst_element_set_state (rtpsrc, GST_STATE_READY) ==
+      GST_STATE_CHANGE_FAILURE);
+  gst_element_set_state (rtpsrc, GST_STATE_NULL);
+  gst_object_unref (rtpsrc);
+}
+
+GST_END_TEST;
+
+/* Only the sender in filter-ssrcs gets through the socket filter */
+static void
+check_kernel_filter (guint port, guint batch_size)
+{
+  GstElement *pipeline, *rtpsrc;
+  GstStructure *stats;
+  const GValue *sources;
+  const GstStructure *source;
+  TestSenders senders;
+  GThread *thread;
+  gint64 deadline;
+  guint ssrc;
+  gchar *uri;
+
+  pipeline = gst_pipeline_new (NULL);
+  rtpsrc = gst_element_factory_make ("nrtp_rtpsrc", NULL);
+  uri = g_strdup_printf ("rtp://127.0.0.1:%u?batch-size=%u", port,
+      batch_size);
+  g_object_set (rtpsrc, "uri", uri, "kernel-filter", TRUE,
+      "filter-ssrcs", "0x11111111", "filter-pts", "0", NULL);
+  g_free (uri);
+  gst_bin_add (GST_BIN (pipeline), rtpsrc);
+  g_signal_connect (rtpsrc, "pad-added", G_CALLBACK (rtpsrc_pad_added_cb),
+      pipeline);
+
+  test_sender_init (&senders.senders[0], 0x11111111, port);
+  test_sender_init (&senders.senders[1], 0x22222222, port);
+  senders.running = 1;
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+  thread = g_thread_new ("senders", (GThreadFunc) test_senders_thread,
+      &senders);
+
+  deadline = g_get_monotonic_time () + 20 * G_USEC_PER_SEC;
+  fail_unless (test_sender_wait_for_report (&senders.senders[0], deadline));
+
+  g_object_get (rtpsrc, "stats", &stats, NULL);
+  sources = gst_structure_get_value (stats, "sources");
+  fail_unless_equals_int (gst_value_array_get_size (sources), 1);
+  source = gst_value_get_structure (gst_value_array_get_value (sources, 0));
+  fail_unless (gst_structure_get_uint (source, "ssrc", &ssrc));
+  fail_unless_equals_int (ssrc, 0x11111111);
+  gst_structure_free (stats);
+
+  g_atomic_int_set (&senders.running, 0);
+  g_thread_join (thread);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  test_sender_clear (&senders.senders[0]);
+  test_sender_clear (&senders.senders[1]);
+}
+
+GST_START_TEST (test_kernel_filter)
+{
+  check_kernel_filter (RTCP_TEST_PORT + 30, 1);
+  check_kernel_filter (RTCP_TEST_PORT + 32, 8);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_invalid_filter)
+{
+  GstElement *rtpsrc;
+
+  rtpsrc = gst_element_factory_make ("nrtp_rtpsrc", NULL);
+  g_object_set (rtpsrc, "uri", "rtp://127.0.0.1:42340", "kernel-filter",
+      TRUE, "filter-pts", "96,128", NULL);
+
+  fail_unless (gst_element_set_state (rtpsrc, GST_STATE_READY) ==
+      GST_STATE_CHANGE_FAILURE);
+  gst_element_set_state (rtpsrc, GST_STATE_NULL);
+  gst_object_unref (rtpsrc);
+}
+
+GST_END_TEST;
+
+#ifdef __linux__
+typedef struct
+{
+  gint cpu;
+  gint entered;
+  gint unpinned;
+} ThreadCheck;
+
+/* Called in the thread that entered its loop, after the bin tuned it */
+static GstBusSyncReply
+check_thread_affinity (GstBus * bus, GstMessage * message,
+    ThreadCheck * check)
+{
+  GstStreamStatusType type;
+  cpu_set_t set;
+
+  if (GST_MESSAGE_TYPE (message) != GST_MESSAGE_STREAM_STATUS)
+    return GST_BUS_DROP;
+
+  gst_message_parse_stream_status (message, &type, NULL);
+  if (type != GST_STREAM_STATUS_TYPE_ENTER)
+    return GST_BUS_DROP;
+
+  if (sched_getaffinity (0, sizeof (set), &set) != 0
+      || CPU_COUNT (&set) != 1 || !CPU_ISSET (check->cpu, &set))
+    g_atomic_int_inc (&check->unpinned);
+  g_atomic_int_inc (&check->entered);
+
+  return GST_BUS_DROP;
+}
+
+GST_START_TEST (test_thread_affinity)
+{
+  ThreadCheck check = { -1, 0, 0 };
+  GstElement *rtpsrc;
+  cpu_set_t set;
+  GstBus *bus;
+  gchar *cpus;
+  gint i;
+
+  /* Pin to the first CPU the test may run on */
+  fail_unless (sched_getaffinity (0, sizeof (set), &set) == 0);
+  for (i = 0; i < CPU_SETSIZE && check.cpu < 0; i++)
+    if (CPU_ISSET (i, &set))
+      check.cpu = i;
+  cpus = g_strdup_printf ("%d", check.cpu);
+
+  rtpsrc = gst_element_factory_make ("nrtp_rtpsrc", NULL);
+  g_object_set (rtpsrc, "uri", "rtp://127.0.0.1:42380", "cpu-affinity", cpus,
+      "receive-threads", 2, "spin-time", 100, NULL);
+  g_free (cpus);
+
+  bus = gst_bus_new ();
+  gst_bus_set_sync_handler (bus, (GstBusSyncHandler) check_thread_affinity,
+      &check, NULL);
+  gst_element_set_bus (rtpsrc, bus);
+
+  fail_unless (gst_element_set_state (rtpsrc, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+
+  /* The two receive threads and the streaming threads of nrtp_recvsrc and
+   * of the RTCP udpsrc */
+  while (g_atomic_int_get (&check.entered) < 4)
+    g_usleep (G_USEC_PER_SEC / 100);
+  fail_unless_equals_int (g_atomic_int_get (&check.unpinned), 0);
+
+  gst_element_set_state (rtpsrc, GST_STATE_NULL);
+  gst_element_set_bus (rtpsrc, NULL);
+  gst_object_unref (bus);
+  gst_object_unref (rtpsrc);
+}
+
+GST_END_TEST;
+#endif
+
+GST_START_TEST (test_invalid_cpu_affinity)
+{
+  GstElement *rtpsrc;
+
+  rtpsrc = gst_element_factory_make ("nrtp_rtpsrc", NULL);
+  g_object_set (rtpsrc, "uri", "rtp://127.0.0.1:42390", "cpu-affinity",
+      "3-1", NULL);
+
+  fail_unless (gst_element_set_state (rtpsrc, GST_STATE_READY) ==
+      GST_STATE_CHANGE_FAILURE);
+  gst_element_set_state (rtpsrc, GST_STATE_NULL);
+  gst_object_unref (rtpsrc);
+}
+
+GST_END_TEST;
+
+/* The number of children of @bin made by @factory_name, the first one is
+ * returned in @first if it is not %NULL */
+static guint
+count_children (GstElement * bin, const gchar * factory_name,
+    GstElement ** first)
+{
+  guint count = 0;
+  GList *l;
+
+  GST_OBJECT_LOCK (bin);
+  for (l = GST_BIN_CHILDREN (bin); l; l = l->next) {
+    GstElementFactory *factory = gst_element_get_factory (l->data);
+
+    if (g_strcmp0 (GST_OBJECT_NAME (factory), factory_name) != 0)
+      continue;
+    if (first && count == 0)
+      *first = gst_object_ref (l->data);
+    count++;
+  }
+  GST_OBJECT_UNLOCK (bin);
+
+  return count;
+}
+
+static void
+check_pad_linked (GstElement * element, const gchar * name)
+{
+  GstPad *pad = gst_element_get_static_pad (element, name);
+
+  fail_unless (pad != NULL, "No pad %s", name);
+  fail_unless (gst_pad_is_linked (pad), "Pad %s is not linked", name);
+  gst_object_unref (pad);
+}
+
+GST_START_TEST (test_fec_elements)
+{
+  GstElement *rtpsrc, *fecdec;
+
+  rtpsrc = gst_element_factory_make ("nrtp_rtpsrc", NULL);
+  g_object_set (rtpsrc, "uri", "rtp://127.0.0.1:42400", "fec", TRUE, NULL);
+  fail_unless_equals_int (gst_element_set_state (rtpsrc, GST_STATE_READY),
+      GST_STATE_CHANGE_SUCCESS);
+
+  /* RTP, RTCP and the column and row FEC */
+  fail_unless_equals_int (count_children (rtpsrc, "udpsrc", NULL), 4);
+  fail_unless_equals_int (count_children (rtpsrc, "nrtp_fecdec", &fecdec),
+      1);
+
+  check_pad_linked (fecdec, "sink");
+  check_pad_linked (fecdec, "fec_0");
+  check_pad_linked (fecdec, "fec_1");
+  check_pad_linked (fecdec, "src");
+  gst_object_unref (fecdec);
 
+  gst_element_set_state (rtpsrc, GST_STATE_NULL);
+  fail_unless_equals_int (GST_BIN_NUMCHILDREN (rtpsrc), 0);
   gst_object_unref (rtpsrc);
 }
 
@@ -50,7 +978,25 @@ rtpsrc_suite (void)
   TCase *tc_chain = tcase_create ("general");
 
   suite_add_tcase (s, tc_chain);
+  tcase_set_timeout (tc_chain, 60);
   tcase_add_test (tc_chain, test_uri_to_properties);
+  tcase_add_test (tc_chain, test_pt_map);
+  tcase_add_test (tc_chain, test_lazy_construction);
+  tcase_add_test (tc_chain, test_rtcp_per_sender);
+  tcase_add_test (tc_chain, test_multiple_sessions);
+  tcase_add_test (tc_chain, test_invalid_ports);
+  tcase_add_test (tc_chain, test_latency_histogram);
+  tcase_add_test (tc_chain, test_low_latency);
+  tcase_add_test (tc_chain, test_adaptive_latency);
+#ifdef __linux__
+  tcase_add_test (tc_chain, test_kernel_filter);
+#endif
+  tcase_add_test (tc_chain, test_invalid_filter);
+#ifdef __linux__
+  tcase_add_test (tc_chain, test_thread_affinity);
+#endif
+  tcase_add_test (tc_chain, test_invalid_cpu_affinity);
+  tcase_add_test (tc_chain, test_fec_elements);
 
   return s;
 }